@@ -1028,6 +1028,11 @@ extern void *slurm_ctl_conf_2_key_pairs (slurm_ctl_conf_t* slurm_ctl_conf_ptr)
 	key_pair->value = xstrdup(slurm_ctl_conf_ptr->slurmd_logfile);
 	list_append(ret_list, key_pair);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("SlurmdParameters");
+	key_pair->value = xstrdup(slurm_ctl_conf_ptr->slurmd_params);
+	list_append(ret_list, key_pair);
+
 	key_pair = xmalloc(sizeof(config_key_pair_t));
 	key_pair->name = xstrdup("SlurmdPidFile");
 	key_pair->value = xstrdup(slurm_ctl_conf_ptr->slurmd_pidfile);
@@ -1364,6 +1369,7 @@ void slurm_print_slurmd_status (FILE* out,
 				slurmd_status_t * slurmd_status_ptr)
 {
 	char time_str[32];
+	uint32_t i;
 
 	if (slurmd_status_ptr == NULL )
 		return ;
@@ -1407,8 +1413,31 @@ void slurm_print_slurmd_status (FILE* out,
 		slurmd_status_ptr->slurmd_debug);
 	fprintf(out, "Slurmd Logfile           = %s\n",
 		slurmd_status_ptr->slurmd_logfile);
+	if (slurmd_status_ptr->stepd_pool_size) {
+		uint32_t launches = slurmd_status_ptr->stepd_pool_hits +
+				    slurmd_status_ptr->stepd_pool_misses;
+		fprintf(out, "Slurmstepd Pool Size     = %u (%u idle)\n",
+			slurmd_status_ptr->stepd_pool_size,
+			slurmd_status_ptr->stepd_pool_idle);
+		fprintf(out, "Slurmstepd Pool Hits     = %u of %u launches "
+			"(%.1f%%)\n", slurmd_status_ptr->stepd_pool_hits,
+			launches, launches ? (100.0 *
+			slurmd_status_ptr->stepd_pool_hits / launches) : 0.0);
+	}
 	fprintf(out, "Version                  = %s\n",
 		slurmd_status_ptr->version);
+
+	if (slurmd_status_ptr->rpc_type_size)
+		fprintf(out, "\nRemote Procedure Call statistics by message "
+			"type (latency in microseconds)\n");
+	for (i = 0; i < slurmd_status_ptr->rpc_type_size; i++) {
+		fprintf(out, "\tmsg_type:%-5u count:%-8u ave_time:%-8u "
+			"max_time:%u\n",
+			slurmd_status_ptr->rpc_type_id[i],
+			slurmd_status_ptr->rpc_type_cnt[i],
+			slurmd_status_ptr->rpc_type_ave_time[i],
+			slurmd_status_ptr->rpc_type_max_time[i]);
+	}
 	return;
 }
 
@@ -0,0 +1,197 @@
+/*****************************************************************************\
+ *  events.c - Subscribe to job and node events pushed by slurmctld
+ *****************************************************************************
+ *  Copyright (C) 2014 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#include "slurm/slurm.h"
+
+#include "src/common/slurm_auth.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+
+/*
+ * slurm_event_listen - open a socket on which to receive events pushed by
+ *	slurmctld, pass the port to slurm_event_subscribe()
+ * OUT port - port number assigned by the operating system
+ * RET file descriptor or -1 on error
+ */
+extern int slurm_event_listen(uint16_t *port)
+{
+	slurm_fd_t fd;
+	slurm_addr_t addr;
+
+	/* port "0" lets the operating system pick any port */
+	if ((fd = slurm_init_msg_engine_port(0)) < 0)
+		return -1;
+	if (slurm_get_stream_addr(fd, &addr) < 0) {
+		slurm_shutdown_msg_engine(fd);
+		return -1;
+	}
+	*port = ntohs(addr.sin_port);
+
+	return fd;
+}
+
+/*
+ * slurm_event_subscribe - register for job and node events, or renew an
+ *	existing subscription before its lease expires
+ * IN/OUT sub - subscription description, set sub_id to zero for a new
+ *	subscription. On return sub_id and the granted lease are set.
+ * RET 0 or a slurm error code
+ */
+extern int slurm_event_subscribe(event_subscribe_msg_t *sub)
+{
+	int rc;
+	slurm_msg_t req_msg, resp_msg;
+	event_subscribe_msg_t *resp;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+	req_msg.msg_type = REQUEST_EVENT_SUBSCRIBE;
+	req_msg.data     = sub;
+
+	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg) < 0)
+		return SLURM_ERROR;
+
+	switch (resp_msg.msg_type) {
+	case RESPONSE_EVENT_SUBSCRIBE:
+		resp = (event_subscribe_msg_t *) resp_msg.data;
+		sub->sub_id = resp->sub_id;
+		sub->lease  = resp->lease;
+		slurm_free_event_subscribe_msg(resp);
+		break;
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		if (rc)
+			slurm_seterrno_ret(rc);
+		break;
+	default:
+		slurm_seterrno_ret(SLURM_UNEXPECTED_MSG_ERROR);
+		break;
+	}
+
+	return SLURM_PROTOCOL_SUCCESS;
+}
+
+/*
+ * slurm_event_unsubscribe - cancel a subscription
+ * IN sub_id - subscription ID returned by slurm_event_subscribe()
+ * RET 0 or a slurm error code
+ */
+extern int slurm_event_unsubscribe(uint32_t sub_id)
+{
+	int rc;
+	slurm_msg_t msg;
+	event_subscribe_msg_t req;
+
+	slurm_msg_t_init(&msg);
+	memset(&req, 0, sizeof(event_subscribe_msg_t));
+	req.sub_id   = sub_id;
+	msg.msg_type = REQUEST_EVENT_UNSUBSCRIBE;
+	msg.data     = &req;
+
+	if (slurm_send_recv_controller_rc_msg(&msg, &rc) < 0)
+		return SLURM_FAILURE;
+
+	if (rc)
+		slurm_seterrno_ret(rc);
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * slurm_event_read - wait for and read the next batch of events
+ * IN fd - file descriptor returned by slurm_event_listen()
+ * OUT notify_pptr - the events, free with slurm_free_event_notify_msg()
+ * RET 0 or a slurm error code
+ */
+extern int slurm_event_read(int fd, event_notify_msg_t **notify_pptr)
+{
+	slurm_fd_t conn_fd;
+	slurm_addr_t cli_addr;
+	slurm_msg_t msg;
+	uid_t req_uid, slurm_uid = (uid_t) slurm_get_slurm_user_id();
+	int rc = SLURM_SUCCESS;
+
+	*notify_pptr = NULL;
+	while (1) {
+		conn_fd = slurm_accept_msg_conn(fd, &cli_addr);
+		if (conn_fd < 0) {
+			if (errno == EINTR)
+				continue;
+			return SLURM_ERROR;
+		}
+
+		slurm_msg_t_init(&msg);
+		if (slurm_receive_msg(conn_fd, &msg, 0) != 0) {
+			rc = errno;
+			slurm_close_accepted_conn(conn_fd);
+			break;
+		}
+		slurm_close_accepted_conn(conn_fd);
+
+		/* Only slurmctld may push events */
+		req_uid = g_slurm_auth_get_uid(msg.auth_cred, NULL);
+		if ((req_uid != slurm_uid) && (req_uid != 0)) {
+			error("Security violation, event message from uid %u",
+			      (unsigned int) req_uid);
+			slurm_free_msg_data(msg.msg_type, msg.data);
+		} else if (msg.msg_type != MESSAGE_EVENT_NOTIFY) {
+			error("received spurious message type: %u",
+			      msg.msg_type);
+			slurm_free_msg_data(msg.msg_type, msg.data);
+		} else {
+			*notify_pptr = (event_notify_msg_t *) msg.data;
+		}
+		if (msg.auth_cred)
+			(void) g_slurm_auth_destroy(msg.auth_cred);
+		if (*notify_pptr)
+			break;
+	}
+
+	if (rc)
+		slurm_seterrno_ret(rc);
+
+	return SLURM_SUCCESS;
+}
@@ -1103,6 +1103,155 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	return SLURM_PROTOCOL_SUCCESS;
 }
 
+static int _cmp_job_ptr_id(const void *x, const void *y)
+{
+	const job_info_t *job1 = *(job_info_t * const *) x;
+	const job_info_t *job2 = *(job_info_t * const *) y;
+
+	if (job1->job_id < job2->job_id)
+		return -1;
+	return (job1->job_id > job2->job_id);
+}
+
+static int _cmp_uint32(const void *x, const void *y)
+{
+	uint32_t val1 = *(const uint32_t *) x, val2 = *(const uint32_t *) y;
+
+	if (val1 < val2)
+		return -1;
+	return (val1 > val2);
+}
+
+/* Build a complete job table from the changes in delta applied to old,
+ * moving records out of both, and free delta. Changed jobs keep their
+ * position in the table, new ones are appended. */
+static job_info_msg_t *_merge_job_delta(job_info_msg_t *old,
+					job_info_delta_msg_t *delta)
+{
+	job_info_msg_t *msg;
+	job_info_t **changed, key, *key_ptr = &key, **found;
+	job_info_t *old_job;
+	bool *used;
+	uint32_t i, cnt = 0;
+
+	msg = xmalloc(sizeof(job_info_msg_t));
+	msg->last_update  = delta->last_update;
+	msg->change_epoch = delta->change_epoch;
+	msg->change_seq   = delta->change_seq;
+	if (delta->full || (old == NULL)) {
+		msg->record_count = delta->record_count;
+		msg->job_array = delta->job_array;
+		delta->job_array = NULL;
+		delta->record_count = 0;
+		slurm_free_job_info_delta_msg(delta);
+		return msg;
+	}
+
+	changed = xmalloc(sizeof(job_info_t *) * (delta->record_count + 1));
+	used = xmalloc(sizeof(bool) * (delta->record_count + 1));
+	for (i = 0; i < delta->record_count; i++)
+		changed[i] = &delta->job_array[i];
+	qsort(changed, delta->record_count, sizeof(job_info_t *),
+	      _cmp_job_ptr_id);
+	qsort(delta->removed_ids, delta->removed_cnt, sizeof(uint32_t),
+	      _cmp_uint32);
+
+	msg->job_array = xmalloc(sizeof(job_info_t) *
+				 (old->record_count + delta->record_count));
+	for (i = 0; i < old->record_count; i++) {
+		old_job = &old->job_array[i];
+		key.job_id = old_job->job_id;
+		found = bsearch(&key_ptr, changed, delta->record_count,
+				sizeof(job_info_t *), _cmp_job_ptr_id);
+		if (found) {
+			slurm_free_job_info_members(old_job);
+			memcpy(&msg->job_array[cnt++], *found,
+			       sizeof(job_info_t));
+			used[found - changed] = true;
+		} else if (bsearch(&old_job->job_id, delta->removed_ids,
+				   delta->removed_cnt, sizeof(uint32_t),
+				   _cmp_uint32)) {
+			slurm_free_job_info_members(old_job);
+		} else {
+			memcpy(&msg->job_array[cnt++], old_job,
+			       sizeof(job_info_t));
+		}
+	}
+	old->record_count = 0;		/* members now owned by msg */
+
+	for (i = 0; i < delta->record_count; i++) {
+		if (!used[i]) {
+			memcpy(&msg->job_array[cnt++], changed[i],
+			       sizeof(job_info_t));
+		}
+	}
+	msg->record_count = cnt;
+	delta->record_count = 0;	/* members now owned by msg */
+	slurm_free_job_info_delta_msg(delta);
+	xfree(changed);
+	xfree(used);
+
+	return msg;
+}
+
+/*
+ * slurm_load_jobs_delta - issue RPC to get only the jobs changed since
+ *	old_job_info was loaded and merge them into a complete new table
+ * IN old_job_info - job table from an earlier call of this function or
+ *	slurm_load_jobs with the same show_flags, or NULL
+ * OUT job_info_msg_pptr - place to store the new job table
+ * IN show_flags - job filtering options
+ * RET 0 or -1 on error (errno SLURM_NO_CHANGE_IN_DATA if nothing changed)
+ * NOTE: unchanged records are moved out of old_job_info rather than copied,
+ *	so once this succeeds old_job_info may only be passed to
+ *	slurm_free_job_info_msg. Free the response the same way.
+ */
+extern int
+slurm_load_jobs_delta (job_info_msg_t *old_job_info,
+		       job_info_msg_t **job_info_msg_pptr, uint16_t show_flags)
+{
+	int rc;
+	slurm_msg_t resp_msg;
+	slurm_msg_t req_msg;
+	delta_info_request_msg_t req;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+
+	memset(&req, 0, sizeof(delta_info_request_msg_t));
+	if (old_job_info) {
+		req.last_update  = old_job_info->last_update;
+		req.change_epoch = old_job_info->change_epoch;
+		req.change_seq   = old_job_info->change_seq;
+		req.record_count = old_job_info->record_count;
+	}
+	req.show_flags   = show_flags;
+	req_msg.msg_type = REQUEST_JOB_INFO_DELTA;
+	req_msg.data     = &req;
+
+	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg) < 0)
+		return SLURM_ERROR;
+
+	switch (resp_msg.msg_type) {
+	case RESPONSE_JOB_INFO_DELTA:
+		*job_info_msg_pptr = _merge_job_delta(old_job_info,
+						      (job_info_delta_msg_t *)
+						      resp_msg.data);
+		break;
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		if (rc)
+			slurm_seterrno_ret(rc);
+		break;
+	default:
+		slurm_seterrno_ret(SLURM_UNEXPECTED_MSG_ERROR);
+		break;
+	}
+
+	return SLURM_PROTOCOL_SUCCESS;
+}
+
 /*
  * slurm_load_job_user - issue RPC to get slurm information about all jobs
  *	to be run as the specified user
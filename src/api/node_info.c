@@ -443,6 +443,104 @@ extern int slurm_load_node (time_t update_time,
 	return SLURM_PROTOCOL_SUCCESS;
 }
 
+/* Build a complete node table from the changes in delta applied to old,
+ * moving records out of both, and free delta */
+static node_info_msg_t *_merge_node_delta(node_info_msg_t *old,
+					  node_info_delta_msg_t *delta)
+{
+	node_info_msg_t *msg;
+	node_info_t *node_ptr;
+	uint32_t i;
+
+	msg = xmalloc(sizeof(node_info_msg_t));
+	msg->last_update  = delta->last_update;
+	msg->node_scaling = delta->node_scaling;
+	msg->change_epoch = delta->change_epoch;
+	msg->change_seq   = delta->change_seq;
+	msg->record_count = delta->node_cnt;
+	if (delta->full) {
+		msg->node_array = xmalloc(sizeof(node_info_t) *
+					  delta->node_cnt);
+	} else {
+		msg->node_array = old->node_array;
+		old->node_array = NULL;
+		old->record_count = 0;
+	}
+
+	for (i = 0; i < delta->record_count; i++) {
+		node_ptr = &msg->node_array[delta->node_inx[i]];
+		slurm_free_node_info_members(node_ptr);
+		memcpy(node_ptr, &delta->node_array[i], sizeof(node_info_t));
+	}
+	delta->record_count = 0;	/* members now owned by msg */
+	slurm_free_node_info_delta_msg(delta);
+
+	return msg;
+}
+
+/*
+ * slurm_load_node_delta - issue RPC to get only the nodes changed since
+ *	old_node_info was loaded and merge them into a complete new table
+ * IN old_node_info - node table from an earlier call of this function or
+ *	slurm_load_node with the same show_flags, or NULL
+ * OUT resp - place to store the new node table
+ * IN show_flags - node filtering options
+ * RET 0 or a slurm error code (SLURM_NO_CHANGE_IN_DATA if nothing changed)
+ * NOTE: unchanged records are moved out of old_node_info rather than copied,
+ *	so once this succeeds old_node_info may only be passed to
+ *	slurm_free_node_info_msg. Free the response the same way.
+ */
+extern int slurm_load_node_delta (node_info_msg_t *old_node_info,
+				  node_info_msg_t **resp, uint16_t show_flags)
+{
+	int rc;
+	slurm_msg_t req_msg;
+	slurm_msg_t resp_msg;
+	delta_info_request_msg_t req;
+	node_info_delta_msg_t *delta;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+	memset(&req, 0, sizeof(delta_info_request_msg_t));
+	if (old_node_info) {
+		req.last_update  = old_node_info->last_update;
+		req.change_epoch = old_node_info->change_epoch;
+		req.change_seq   = old_node_info->change_seq;
+		req.record_count = old_node_info->record_count;
+	}
+	req.show_flags   = show_flags;
+	req_msg.msg_type = REQUEST_NODE_INFO_DELTA;
+	req_msg.data     = &req;
+
+	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg) < 0)
+		return SLURM_ERROR;
+
+	switch (resp_msg.msg_type) {
+	case RESPONSE_NODE_INFO_DELTA:
+		delta = (node_info_delta_msg_t *) resp_msg.data;
+		if (!delta->full &&
+		    (!old_node_info ||
+		     (old_node_info->record_count != delta->node_cnt))) {
+			slurm_free_node_info_delta_msg(delta);
+			slurm_seterrno_ret(SLURM_UNEXPECTED_MSG_ERROR);
+		}
+		*resp = _merge_node_delta(old_node_info, delta);
+		break;
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		if (rc)
+			slurm_seterrno_ret(rc);
+		*resp = NULL;
+		break;
+	default:
+		slurm_seterrno_ret(SLURM_UNEXPECTED_MSG_ERROR);
+		break;
+	}
+
+	return SLURM_PROTOCOL_SUCCESS;
+}
+
 /*
  * slurm_load_node_single - issue RPC to get slurm configuration information
  *	for a specific node
@@ -489,6 +587,53 @@ extern int slurm_load_node_single (node_info_msg_t **resp,
 	return SLURM_PROTOCOL_SUCCESS;
 }
 
+/*
+ * slurm_load_node_summary - issue RPC to get the nodes of each partition
+ *	grouped by state and features, if changed since update_time
+ * IN update_time - time of current node data
+ * OUT resp - place to store a node summary pointer
+ * IN show_flags - partition filtering options
+ * RET 0 or a slurm error code
+ * NOTE: free the response using slurm_free_node_summary_msg
+ */
+extern int slurm_load_node_summary (time_t update_time,
+				    node_summary_msg_t **resp,
+				    uint16_t show_flags)
+{
+	int rc;
+	slurm_msg_t req_msg;
+	slurm_msg_t resp_msg;
+	node_info_request_msg_t req;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+	req.last_update  = update_time;
+	req.show_flags   = show_flags;
+	req_msg.msg_type = REQUEST_NODE_INFO_SUMMARY;
+	req_msg.data     = &req;
+
+	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg) < 0)
+		return SLURM_ERROR;
+
+	switch (resp_msg.msg_type) {
+	case RESPONSE_NODE_INFO_SUMMARY:
+		*resp = (node_summary_msg_t *) resp_msg.data;
+		break;
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		if (rc)
+			slurm_seterrno_ret(rc);
+		*resp = NULL;
+		break;
+	default:
+		slurm_seterrno_ret(SLURM_UNEXPECTED_MSG_ERROR);
+		break;
+	}
+
+	return SLURM_PROTOCOL_SUCCESS;
+}
+
 /*
  * slurm_node_energy - issue RPC to get the energy data on this machine
  * IN  host  - name of node to query, NULL if localhost
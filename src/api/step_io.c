@@ -42,6 +42,7 @@
 #include <string.h>
 #include <time.h>
 #include <signal.h>
+#include <unistd.h>
 
 #include "src/common/fd.h"
 #include "src/common/hostlist.h"
@@ -64,6 +65,9 @@
 
 #define MAX_RETRIES 3
 #define STDIO_MAX_FREE_BUF 1024
+/* Wide steps spread their node connections over several IO threads */
+#define STDIO_NODES_PER_SHARD 512
+#define STDIO_MAX_SHARDS 8
 
 struct io_buf {
 	int ref_count;
@@ -83,11 +87,16 @@ static void     _free_io_buf(struct io_buf *buf);
 #endif
 static void	_init_stdio_eio_objs(slurm_step_io_fds_t fds,
 				     client_io_t *cio);
-static void	_handle_io_init_msg(int fd, client_io_t *cio);
-static int      _read_io_init_msg(int fd, client_io_t *cio, char *host);
+static void	_handle_io_init_msg(int fd, client_io_t *cio,
+				    eio_handle_t *eio);
+static int      _read_io_init_msg(int fd, client_io_t *cio, char *host,
+				  eio_handle_t *eio);
 static int      _wid(int n);
 static bool     _incoming_buf_free(client_io_t *cio);
 static bool     _outgoing_buf_free(client_io_t *cio);
+static void     _outgoing_buf_release(client_io_t *cio, struct io_buf *buf);
+static struct io_buf *_outgoing_buf_get(client_io_t *cio);
+static void     _wake_shards(client_io_t *cio);
 
 /**********************************************************************
  * Listening socket declarations
@@ -117,6 +126,7 @@ struct io_operations server_ops = {
 
 struct server_io_info {
 	client_io_t *cio;
+	eio_handle_t *eio;	/* eio handle of the shard serving the node */
 	int node_id;
 	bool testing_connection;
 
@@ -205,8 +215,16 @@ _listening_socket_read(eio_obj_t *obj, List objs)
 {
 	client_io_t *cio = (client_io_t *)obj->arg;
 
+	int i;
+
 	debug3("Called _listening_socket_read");
-	_handle_io_init_msg(obj->fd, cio);
+	/* Connections are served by the shard owning the listen socket */
+	for (i = 0; i < cio->num_listen; i++) {
+		if (cio->listensock[i] == obj->fd)
+			break;
+	}
+	_handle_io_init_msg(obj->fd, cio,
+			    cio->shard_eio[i % cio->num_shards]);
 
 	return (0);
 }
@@ -223,14 +241,15 @@ _set_listensocks_nonblocking(client_io_t *cio)
  * IO server socket functions
  **********************************************************************/
 static eio_obj_t *
-_create_server_eio_obj(int fd, client_io_t *cio, int nodeid,
-		       int stdout_objs, int stderr_objs)
+_create_server_eio_obj(int fd, client_io_t *cio, eio_handle_t *shard_eio,
+		       int nodeid, int stdout_objs, int stderr_objs)
 {
 	struct server_io_info *info = NULL;
 	eio_obj_t *eio = NULL;
 
 	info = (struct server_io_info *)xmalloc(sizeof(struct server_io_info));
 	info->cio = cio;
+	info->eio = shard_eio;
 	info->node_id = nodeid;
 	info->testing_connection = false;
 	info->in_msg = NULL;
@@ -287,6 +306,72 @@ _server_readable(eio_obj_t *obj)
 	return false;
 }
 
+/*
+ * The nodes whose stdio goes through this connection have all answered the
+ * connection test, see the stdio tree in slurmstepd's io.c.
+ */
+static void
+_server_clear_questionable_state(eio_obj_t *obj)
+{
+	struct server_io_info *s = (struct server_io_info *) obj->arg;
+	client_io_t *cio = s->cio;
+	int i;
+
+	for (i = 0; i < cio->num_nodes; i++) {
+		if (cio->ioserver[i] == obj)
+			step_launch_clear_questionable_state(cio->sls, i);
+	}
+}
+
+/*
+ * The io init message of a node whose stdio is relayed by the slurmstepd
+ * at the other end of this connection.  Its stdout and stderr eof messages
+ * arrive on this connection too.
+ */
+static void
+_server_node_init(eio_obj_t *obj, struct server_io_info *s)
+{
+	client_io_t *cio = s->cio;
+	struct slurm_io_init_msg msg;
+	Buf packbuf;
+	int rc;
+
+	packbuf = create_buf(s->in_msg->data, s->header.length);
+	rc = io_init_msg_unpack(&msg, packbuf);
+	/* free the Buf packbuf, but not the memory to which it points */
+	packbuf->head = NULL;
+	free_buf(packbuf);
+	if ((rc != SLURM_SUCCESS) ||
+	    (io_init_msg_validate(&msg, cio->io_key) < 0))
+		return;
+	if (msg.nodeid >= cio->num_nodes) {
+		error("Invalid nodeid %u relayed by node %d",
+		      msg.nodeid, s->node_id);
+		return;
+	}
+	debug2("Validated IO connection of node rank %u through node %d",
+	       msg.nodeid, s->node_id);
+
+	pthread_mutex_lock(&cio->ioservers_lock);
+	if (cio->ioserver[msg.nodeid] != NULL) {
+		error("IO: Node %d already established stream!", msg.nodeid);
+	} else if (bit_test(cio->ioservers_ready_bits, msg.nodeid)) {
+		error("IO: Hey, you told me node %d was down!", msg.nodeid);
+	}
+	cio->ioserver[msg.nodeid] = obj;
+	s->remote_stdout_objs += msg.stdout_objs;
+	s->remote_stderr_objs += msg.stderr_objs;
+	bit_set(cio->ioservers_ready_bits, msg.nodeid);
+	cio->ioservers_ready = bit_set_count(cio->ioservers_ready_bits);
+	/* stdin is read by the first shard once all nodes have connected */
+	if ((s->eio != cio->eio) && (cio->ioservers_ready == cio->num_nodes))
+		eio_signal_wakeup(cio->eio);
+	pthread_mutex_unlock(&cio->ioservers_lock);
+
+	if (cio->sls)
+		step_launch_clear_questionable_state(cio->sls, msg.nodeid);
+}
+
 static int
 _server_read(eio_obj_t *obj, List objs)
 {
@@ -296,9 +381,7 @@ _server_read(eio_obj_t *obj, List objs)
 
 	debug4("Entering _server_read");
 	if (s->in_msg == NULL) {
-		if (_outgoing_buf_free(s->cio)) {
-			s->in_msg = list_dequeue(s->cio->free_outgoing);
-		} else {
+		if (!(s->in_msg = _outgoing_buf_get(s->cio))) {
 			debug("List free_outgoing is empty!");
 			return SLURM_ERROR;
 		}
@@ -314,15 +397,14 @@ _server_read(eio_obj_t *obj, List objs)
 			obj->fd = -1;
 			s->in_eof = true;
 			s->out_eof = true;
-			list_enqueue(s->cio->free_outgoing, s->in_msg);
+			_outgoing_buf_release(s->cio, s->in_msg);
 			s->in_msg = NULL;
 			return SLURM_SUCCESS;
 		}
 		if (s->header.type == SLURM_IO_CONNECTION_TEST) {
 			if (s->cio->sls)
-				step_launch_clear_questionable_state(
-					s->cio->sls, s->node_id);
-			list_enqueue(s->cio->free_outgoing, s->in_msg);
+				_server_clear_questionable_state(obj);
+			_outgoing_buf_release(s->cio, s->in_msg);
 			s->in_msg = NULL;
 			s->testing_connection = false;
 			return SLURM_SUCCESS;
@@ -345,10 +427,31 @@ _server_read(eio_obj_t *obj, List objs)
 				&& s->remote_stderr_objs == 0) {
 				obj->shutdown = true;
 			}
-			list_enqueue(s->cio->free_outgoing, s->in_msg);
+			_outgoing_buf_release(s->cio, s->in_msg);
+			s->in_msg = NULL;
+			return SLURM_SUCCESS;
+		}
+		if (s->header.length > IO_LARGE_MSG_LEN) {
+			error("%s: fd %d message length of %u exceeds "
+			      "maximum of %u", __func__, obj->fd,
+			      s->header.length, IO_LARGE_MSG_LEN);
+			if (s->cio->sls)
+				step_launch_notify_io_failure(s->cio->sls,
+							      s->node_id);
+			close(obj->fd);
+			obj->fd = -1;
+			s->in_eof = true;
+			s->out_eof = true;
+			_outgoing_buf_release(s->cio, s->in_msg);
 			s->in_msg = NULL;
 			return SLURM_SUCCESS;
 		}
+		/* The slurmstepd sends frames of up to IO_LARGE_MSG_LEN
+		 * bytes when launched with TASK_LARGE_IO */
+		if (s->header.length > MAX_MSG_LEN) {
+			xrealloc_nz(s->in_msg->data, s->header.length +
+				    io_hdr_packed_size() + 1);
+		}
 		s->in_remaining = s->header.length;
 		s->in_msg->length = s->header.length;
 		s->in_msg->header = s->header;
@@ -389,7 +492,7 @@ _server_read(eio_obj_t *obj, List objs)
 			obj->fd = -1;
 			s->in_eof = true;
 			s->out_eof = true;
-			list_enqueue(s->cio->free_outgoing, s->in_msg);
+			_outgoing_buf_release(s->cio, s->in_msg);
 			s->in_msg = NULL;
 			return SLURM_SUCCESS;
 		}
@@ -402,6 +505,13 @@ _server_read(eio_obj_t *obj, List objs)
 		debug3("***** passing on eof message");
 	}
 
+	if (s->in_msg->header.type == SLURM_IO_NODE_INIT) {
+		_server_node_init(obj, s);
+		_outgoing_buf_release(s->cio, s->in_msg);
+		s->in_msg = NULL;
+		return SLURM_SUCCESS;
+	}
+
 	/*
 	 * Route the message to the proper output
 	 */
@@ -415,11 +525,25 @@ _server_read(eio_obj_t *obj, List objs)
 		else
 			obj = s->cio->stderr_obj;
 		info = (struct file_write_info *) obj->arg;
-		if (info->eof)
+		/* The output's eof flag and the empty to non-empty
+		 * transition of its queue are only seen under
+		 * ioservers_lock, so no wakeup is lost when several
+		 * shards queue output at once */
+		pthread_mutex_lock(&s->cio->ioservers_lock);
+		if (info->eof) {
 			/* this output is closed, discard message */
-			list_enqueue(s->cio->free_outgoing, s->in_msg);
-		else
+			pthread_mutex_unlock(&s->cio->ioservers_lock);
+			_outgoing_buf_release(s->cio, s->in_msg);
+		} else {
+			bool was_empty = list_is_empty(info->msg_queue);
+			/* Each node is served by a single shard, so a
+			 * task's output stays in order.  Wake the thread
+			 * writing the output if its queue was empty. */
 			list_enqueue(info->msg_queue, s->in_msg);
+			if (was_empty && (s->eio != s->cio->eio))
+				eio_signal_wakeup(s->cio->eio);
+			pthread_mutex_unlock(&s->cio->ioservers_lock);
+		}
 
 		s->in_msg = NULL;
 	}
@@ -507,15 +631,21 @@ again:
 		return SLURM_SUCCESS;
 
 	/*
-	 * Free the message and prepare to send the next one.
+	 * Free the message and prepare to send the next one.  A stdin
+	 * message may be queued to nodes served by several shards, so its
+	 * reference count is only changed under ioservers_lock.
 	 */
+	pthread_mutex_lock(&s->cio->ioservers_lock);
 	s->out_msg->ref_count--;
 	if (s->out_msg->ref_count == 0) {
-		pthread_mutex_lock(&s->cio->ioservers_lock);
 		list_enqueue(s->cio->free_incoming, s->out_msg);
-		pthread_mutex_unlock(&s->cio->ioservers_lock);
+		/* stdin may be waiting on a free buffer in another shard */
+		if ((s->eio != s->cio->eio) &&
+		    (list_count(s->cio->free_incoming) == 1))
+			eio_signal_wakeup(s->cio->eio);
 	} else
 		debug3("  Could not free msg!!");
+	pthread_mutex_unlock(&s->cio->ioservers_lock);
 	s->out_msg = NULL;
 
 	return SLURM_SUCCESS;
@@ -595,8 +725,12 @@ static int _file_write(eio_obj_t *obj, List objs)
 					        info->out_msg->header.gtaskid,
 					        info->cio->label,
 					        info->cio->label_width)) < 0) {
-			list_enqueue(info->cio->free_outgoing, info->out_msg);
+			_outgoing_buf_release(info->cio, info->out_msg);
+			info->out_msg = NULL;
+			/* _server_read() checks eof from other shards */
+			pthread_mutex_lock(&info->cio->ioservers_lock);
 			info->eof = true;
+			pthread_mutex_unlock(&info->cio->ioservers_lock);
 			return SLURM_ERROR;
 		}
 		debug3("  wrote %d bytes", n);
@@ -610,7 +744,7 @@ static int _file_write(eio_obj_t *obj, List objs)
 	 */
 	info->out_msg->ref_count--;
 	if (info->out_msg->ref_count == 0)
-		list_enqueue(info->cio->free_outgoing, info->out_msg);
+		_outgoing_buf_release(info->cio, info->out_msg);
 	info->out_msg = NULL;
 	debug2("Leaving  _file_write");
 
@@ -740,12 +874,20 @@ again:
 	debug3("  msg->length = %d", msg->length);
 
 	/*
-	 * Route the message to the correct IO servers
+	 * Route the message to the correct IO servers.  Servers in other
+	 * shards may send and release the message as soon as it is queued,
+	 * so hold ioservers_lock until its reference count is final.
 	 */
+	pthread_mutex_lock(&info->cio->ioservers_lock);
 	if (header.type == SLURM_IO_ALLSTDIN) {
 		int i;
 		struct server_io_info *server;
 		for (i = 0; i < info->cio->num_nodes; i++) {
+			/* A node relayed by another gets its copy from it */
+			if ((info->cio->ioserver[i] != NULL) &&
+			    (((struct server_io_info *)
+			      info->cio->ioserver[i]->arg)->node_id != i))
+				continue;
 			msg->ref_count++;
 			if (info->cio->ioserver[i] == NULL)
 				/* client_io_handler_abort() or
@@ -774,6 +916,8 @@ again:
 	} else {
 		fatal("Unsupported header.type");
 	}
+	pthread_mutex_unlock(&info->cio->ioservers_lock);
+	_wake_shards(info->cio);
 	msg = NULL;
 	return SLURM_SUCCESS;
 }
@@ -784,12 +928,12 @@ again:
  **********************************************************************/
 
 static void *
-_io_thr_internal(void *cio_arg)
+_io_thr_internal(void *eio_arg)
 {
-	client_io_t *cio  = (client_io_t *) cio_arg;
+	eio_handle_t *eio = (eio_handle_t *) eio_arg;
 	sigset_t set;
 
-	xassert(cio != NULL);
+	xassert(eio != NULL);
 
 	debug3("IO thread pid = %lu", (unsigned long) getpid());
 
@@ -800,10 +944,8 @@ _io_thr_internal(void *cio_arg)
 	sigaddset(&set, SIGHUP);
  	pthread_sigmask(SIG_BLOCK, &set, NULL);
 
-	_set_listensocks_nonblocking(cio);
-
 	/* start the eio engine */
-	eio_handle_mainloop(cio->eio);
+	eio_handle_mainloop(eio);
 
 	debug("IO thread exiting");
 
@@ -821,7 +963,7 @@ _create_listensock_eio(int fd, client_io_t *cio)
 }
 
 static int
-_read_io_init_msg(int fd, client_io_t *cio, char *host)
+_read_io_init_msg(int fd, client_io_t *cio, char *host, eio_handle_t *eio)
 {
 	struct slurm_io_init_msg msg;
 
@@ -849,7 +991,8 @@ _read_io_init_msg(int fd, client_io_t *cio, char *host)
 		error("IO: Hey, you told me node %d was down!", msg.nodeid);
 	}
 
-	cio->ioserver[msg.nodeid] = _create_server_eio_obj(fd, cio, msg.nodeid,
+	cio->ioserver[msg.nodeid] = _create_server_eio_obj(fd, cio, eio,
+							   msg.nodeid,
 							   msg.stdout_objs,
 							   msg.stderr_objs);
 	pthread_mutex_lock(&cio->ioservers_lock);
@@ -857,9 +1000,12 @@ _read_io_init_msg(int fd, client_io_t *cio, char *host)
 	cio->ioservers_ready = bit_set_count(cio->ioservers_ready_bits);
 	/* Normally using eio_new_initial_obj while the eio mainloop
 	 * is running is not safe, but since this code is running
-	 * inside of the eio mainloop there should be no problem.
+	 * inside of the shard's eio mainloop there should be no problem.
 	 */
-	eio_new_initial_obj(cio->eio, cio->ioserver[msg.nodeid]);
+	eio_new_initial_obj(eio, cio->ioserver[msg.nodeid]);
+	/* stdin is read by the first shard once all nodes have connected */
+	if ((eio != cio->eio) && (cio->ioservers_ready == cio->num_nodes))
+		eio_signal_wakeup(cio->eio);
 	pthread_mutex_unlock(&cio->ioservers_lock);
 
 	if (cio->sls)
@@ -889,7 +1035,7 @@ _is_fd_ready(int fd)
 
 
 static void
-_handle_io_init_msg(int fd, client_io_t *cio)
+_handle_io_init_msg(int fd, client_io_t *cio, eio_handle_t *eio)
 {
 	int j;
 	debug2("Activity on IO listening socket %d", fd);
@@ -937,7 +1083,7 @@ _handle_io_init_msg(int fd, client_io_t *cio)
 		/*
 		 * Read IO header and update cio structure appropriately
 		 */
-		if (_read_io_init_msg(sd, cio, buf) < 0)
+		if (_read_io_init_msg(sd, cio, buf, eio) < 0)
 			continue;
 
 		fd_set_nonblocking(sd);
@@ -1047,8 +1193,40 @@ _incoming_buf_free(client_io_t *cio)
 	return false;
 }
 
+static inline int
+_estimate_nports(int nclients, int cli_per_port)
+{
+	div_t d;
+	d = div(nclients, cli_per_port);
+	return d.rem > 0 ? d.quot + 1 : d.quot;
+}
+
+/*
+ * Return an outgoing buffer to the free list, shrinking one that was
+ * grown for a large message so that idle buffers stay small.
+ */
+static void
+_outgoing_buf_release(client_io_t *cio, struct io_buf *buf)
+{
+	int i;
+
+	if (buf->length > MAX_MSG_LEN) {
+		xrealloc_nz(buf->data, MAX_MSG_LEN + io_hdr_packed_size() + 1);
+		buf->length = 0;
+	}
+	pthread_mutex_lock(&cio->outgoing_lock);
+	list_enqueue(cio->free_outgoing, buf);
+	/* Shards may have stopped reading for lack of a buffer */
+	if (list_count(cio->free_outgoing) == 1) {
+		for (i = 1; i < cio->num_shards; i++)
+			eio_signal_wakeup(cio->shard_eio[i]);
+	}
+	pthread_mutex_unlock(&cio->outgoing_lock);
+}
+
+/* Callers of this function should already have locked cio->outgoing_lock */
 static bool
-_outgoing_buf_free(client_io_t *cio)
+_outgoing_buf_free_locked(client_io_t *cio)
 {
 	struct io_buf *buf;
 
@@ -1066,12 +1244,59 @@ _outgoing_buf_free(client_io_t *cio)
 	return false;
 }
 
-static inline int
-_estimate_nports(int nclients, int cli_per_port)
+static bool
+_outgoing_buf_free(client_io_t *cio)
 {
-	div_t d;
-	d = div(nclients, cli_per_port);
-	return d.rem > 0 ? d.quot + 1 : d.quot;
+	bool rc;
+
+	pthread_mutex_lock(&cio->outgoing_lock);
+	rc = _outgoing_buf_free_locked(cio);
+	pthread_mutex_unlock(&cio->outgoing_lock);
+
+	return rc;
+}
+
+/* Take a free outgoing buffer, or return NULL if there is none */
+static struct io_buf *
+_outgoing_buf_get(client_io_t *cio)
+{
+	struct io_buf *buf = NULL;
+
+	pthread_mutex_lock(&cio->outgoing_lock);
+	if (_outgoing_buf_free_locked(cio))
+		buf = list_dequeue(cio->free_outgoing);
+	pthread_mutex_unlock(&cio->outgoing_lock);
+
+	return buf;
+}
+
+/* Wake the shards other than the first, e.g. after queueing stdin */
+static void
+_wake_shards(client_io_t *cio)
+{
+	int i;
+
+	for (i = 1; i < cio->num_shards; i++)
+		eio_signal_wakeup(cio->shard_eio[i]);
+}
+
+/*
+ * Use one IO thread per STDIO_NODES_PER_SHARD nodes, but no more than
+ * there are listen sockets to divide among them or CPUs to run them.
+ */
+static int
+_estimate_nshards(int num_nodes, int num_listen)
+{
+	int nshards;
+	long ncpus;
+
+	nshards = _estimate_nports(num_nodes, STDIO_NODES_PER_SHARD);
+	nshards = MIN(nshards, STDIO_MAX_SHARDS);
+	nshards = MIN(nshards, num_listen);
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpus > 0)
+		nshards = MIN(nshards, ncpus);
+	return MAX(nshards, 1);
 }
 
 client_io_t *
@@ -1117,6 +1342,15 @@ client_io_handler_create(slurm_step_io_fds_t fds,
 	cio->listensock = (int *)xmalloc(cio->num_listen * sizeof(int));
 	cio->listenport = (uint16_t *)xmalloc(cio->num_listen*sizeof(uint16_t));
 
+	cio->num_shards = _estimate_nshards(num_nodes, cio->num_listen);
+	cio->shard_eio = xmalloc(cio->num_shards * sizeof(eio_handle_t *));
+	cio->shard_ioid = xmalloc(cio->num_shards * sizeof(pthread_t));
+	cio->shard_eio[0] = cio->eio;
+	for (i = 1; i < cio->num_shards; i++)
+		cio->shard_eio[i] = eio_handle_create();
+	if (cio->num_shards > 1)
+		debug("using %d stdio threads", cio->num_shards);
+
 	cio->ioserver = (eio_obj_t **)xmalloc(num_nodes*sizeof(eio_obj_t *));
 	cio->ioservers_ready_bits = bit_alloc(num_nodes);
 	cio->ioservers_ready = 0;
@@ -1135,7 +1369,7 @@ client_io_handler_create(slurm_step_io_fds_t fds,
 		      cio->listenport[i]);
 		/*net_set_low_water(cio->listensock[i], 140);*/
 		obj = _create_listensock_eio(cio->listensock[i], cio);
-		eio_new_initial_obj(cio->eio, obj);
+		eio_new_initial_obj(cio->shard_eio[i % cio->num_shards], obj);
 	}
 
 	cio->free_incoming = list_create(NULL); /* FIXME! Needs destructor */
@@ -1145,6 +1379,7 @@ client_io_handler_create(slurm_step_io_fds_t fds,
 	}
 	cio->free_outgoing = list_create(NULL); /* FIXME! Needs destructor */
 	cio->outgoing_count = 0;
+	pthread_mutex_init(&cio->outgoing_lock, NULL);
 	for (i = 0; i < STDIO_MAX_FREE_BUF; i++) {
 		list_enqueue(cio->free_outgoing, _alloc_io_buf());
 	}
@@ -1156,24 +1391,32 @@ client_io_handler_create(slurm_step_io_fds_t fds,
 int
 client_io_handler_start(client_io_t *cio)
 {
-	int retries = 0;
+	int i, retries = 0;
 	pthread_attr_t attr;
 
 	xsignal(SIGTTIN, SIG_IGN);
 
+	_set_listensocks_nonblocking(cio);
+
 	slurm_attr_init(&attr);
-	while ((errno = pthread_create(&cio->ioid, &attr,
-				      &_io_thr_internal, (void *) cio))) {
-		if (++retries > MAX_RETRIES) {
-			error ("pthread_create error %m");
-			cio->ioid = 0;
-			slurm_attr_destroy(&attr);
-			return SLURM_ERROR;
+	for (i = 0; i < cio->num_shards; i++) {
+		while ((errno = pthread_create(&cio->shard_ioid[i], &attr,
+					       &_io_thr_internal,
+					       (void *) cio->shard_eio[i]))) {
+			if (++retries > MAX_RETRIES) {
+				error ("pthread_create error %m");
+				cio->shard_ioid[i] = 0;
+				slurm_attr_destroy(&attr);
+				cio->ioid = cio->shard_ioid[0];
+				return SLURM_ERROR;
+			}
+			sleep(1);	/* sleep and try again */
 		}
-		sleep(1);	/* sleep and try again */
+		debug("Started IO server thread (%lu)",
+		      (unsigned long) cio->shard_ioid[i]);
 	}
 	slurm_attr_destroy(&attr);
-	debug("Started IO server thread (%lu)", (unsigned long) cio->ioid);
+	cio->ioid = cio->shard_ioid[0];
 
 	return SLURM_SUCCESS;
 }
@@ -1215,22 +1458,32 @@ static void _delay_kill_thread(pthread_t thread_id, int secs)
 int
 client_io_handler_finish(client_io_t *cio)
 {
+	int i, rc = SLURM_SUCCESS;
+
 	if (cio == NULL)
 		return SLURM_SUCCESS;
 
-	eio_signal_shutdown(cio->eio);
-	_delay_kill_thread(cio->ioid, 60);
-	if (pthread_join(cio->ioid, NULL) < 0) {
-		error("Waiting for client io pthread: %m");
-		return SLURM_ERROR;
+	/* The first shard writes the output read by the others, so it
+	 * is shut down last */
+	for (i = cio->num_shards - 1; i >= 0; i--) {
+		eio_signal_shutdown(cio->shard_eio[i]);
+		if (!cio->shard_ioid[i])
+			continue;
+		_delay_kill_thread(cio->shard_ioid[i], 60);
+		if (pthread_join(cio->shard_ioid[i], NULL) < 0) {
+			error("Waiting for client io pthread: %m");
+			rc = SLURM_ERROR;
+		}
 	}
 
-	return SLURM_SUCCESS;
+	return rc;
 }
 
 void
 client_io_handler_destroy(client_io_t *cio)
 {
+	int i;
+
 	if (cio == NULL)
 		return;
 
@@ -1238,10 +1491,15 @@ client_io_handler_destroy(client_io_t *cio)
 	   (by calling client_io_handler_finish()) before freeing anything */
 
 	pthread_mutex_destroy(&cio->ioservers_lock);
+	pthread_mutex_destroy(&cio->outgoing_lock);
 	FREE_NULL_BITMAP(cio->ioservers_ready_bits);
 	xfree(cio->ioserver); /* need to destroy the obj first? */
 	xfree(cio->listenport);
 	xfree(cio->listensock);
+	for (i = 1; i < cio->num_shards; i++)
+		eio_handle_destroy(cio->shard_eio[i]);
+	xfree(cio->shard_eio);
+	xfree(cio->shard_ioid);
 	eio_handle_destroy(cio->eio);
 	xfree(cio->io_key);
 	xfree(cio);
@@ -1268,6 +1526,10 @@ client_io_handler_downnodes(client_io_t *cio,
 		    && cio->ioserver[node_id] != NULL) {
 			tmp = cio->ioserver[node_id]->arg;
 			info = (struct server_io_info *)tmp;
+			/* Do not close the stdio of the other nodes relayed
+			 * by the same slurmstepd */
+			if (info->node_id != node_id)
+				continue;
 			info->remote_stdout_objs = 0;
 			info->remote_stderr_objs = 0;
 			info->testing_connection = false;
@@ -1281,6 +1543,7 @@ client_io_handler_downnodes(client_io_t *cio,
 	pthread_mutex_unlock(&cio->ioservers_lock);
 
 	eio_signal_wakeup(cio->eio);
+	_wake_shards(cio);
 }
 
 
@@ -1364,7 +1627,7 @@ int client_io_handler_send_test_message(client_io_t *cio, int node_id,
 
 		list_enqueue( server->msg_queue, msg );
 
-		if (eio_signal_wakeup(cio->eio) != SLURM_SUCCESS) {
+		if (eio_signal_wakeup(server->eio) != SLURM_SUCCESS) {
 			rc = SLURM_ERROR;
 			goto done;
 		}
@@ -55,6 +55,13 @@ struct client_io {
 	uint16_t *listenport;	/* Array of stdio listen port numbers */
 
 	eio_handle_t *eio;      /* Event IO handle for stdio traffic */
+	int num_shards;		/* Number of threads handling stdio, each
+				 * with its own share of the listen sockets
+				 * and the node connections they accept */
+	eio_handle_t **shard_eio; /* Event IO handle of each shard,
+				   * shard_eio[0] is eio */
+	pthread_t *shard_ioid;	/* Thread of each shard, shard_ioid[0] is
+				 * ioid */
 	pthread_mutex_t ioservers_lock; /* This lock protects
 				   ioservers_ready_bits, ioservers_ready,
 				   pointers in ioserver, all the msg_queues
@@ -85,6 +92,8 @@ struct client_io {
 			         * including free_incoming buffers and
 			         * buffers in use.
 			         */
+	pthread_mutex_t outgoing_lock; /* Protects free_outgoing and
+					* outgoing_count */
 
 	struct step_launch_state *sls; /* Used to notify the main thread of an
 				       I/O problem.  */
@@ -289,6 +289,10 @@ int slurm_step_launch (slurm_step_ctx_t *ctx,
 		launch.ifname = params->remote_input_filename;
 		launch.buffered_stdio = params->buffered_stdio ? 1 : 0;
 		launch.labelio = params->labelio ? 1 : 0;
+		if (params->large_io)
+			launch.task_flags |= TASK_LARGE_IO;
+		if (params->io_tree)
+			launch.task_flags |= TASK_IO_TREE;
 		ctx->launch_state->io.normal =
 			client_io_handler_create(params->local_fds,
 						 ctx->step_req->num_tasks,
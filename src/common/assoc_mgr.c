@@ -52,6 +52,7 @@
 slurmdb_association_rec_t *assoc_mgr_root_assoc = NULL;
 uint32_t g_qos_max_priority = 0;
 uint32_t g_qos_count = 0;
+uint32_t assoc_mgr_qos_update_cnt = 0;
 List assoc_mgr_association_list = NULL;
 List assoc_mgr_qos_list = NULL;
 List assoc_mgr_user_list = NULL;
@@ -632,6 +633,7 @@ static int _post_qos_list(List qos_list)
 
 	g_qos_count = 0;
 	g_qos_max_priority = 0;
+	assoc_mgr_qos_update_cnt++;
 
 	while ((qos = list_next(itr))) {
 		if (qos->flags & QOS_FLAG_NOTSET)
@@ -3169,6 +3171,7 @@ extern int assoc_mgr_update_qos(slurmdb_update_object_t *update)
 		_post_qos_list(assoc_mgr_qos_list);
 
 	list_iterator_destroy(itr);
+	assoc_mgr_qos_update_cnt++;
 
 	assoc_mgr_unlock(&locks);
 
@@ -97,10 +97,30 @@ typedef struct {
 	void (*update_resvs) ();
 } assoc_init_args_t;
 
+/* Room left under the group limits of an association (including its
+ * parents) or QOS, cached by slurmctld's accounting policy so pending
+ * jobs can be tested without walking the association tree */
+typedef struct {
+	uint32_t seq;		/* cache sequence the values belong to */
+	uint16_t flags;		/* limits already reached, no job can run */
+	int64_t cpus;		/* GrpCPUs left */
+	int64_t cpu_run_mins;	/* GrpCPURunMins left */
+	int64_t mem;		/* GrpMemory left */
+	int64_t nodes;		/* GrpNodes left */
+} assoc_mgr_limit_cache_t;
+
 struct assoc_mgr_association_usage {
 	List children_list;     /* list of children associations
 				 * (DON'T PACK) */
 
+	double fs_factor;	/* fairshare factor cached by the priority
+				 * plugin, computed from fs_usage_efctv and
+				 * fs_shares_norm (DON'T PACK) */
+	long double fs_usage_efctv; /* usage_efctv fs_factor is based upon
+				     * (DON'T PACK) */
+	double fs_shares_norm;	/* shares_norm fs_factor is based upon
+				 * (DON'T PACK) */
+
 	uint32_t grp_used_cpus; /* count of active jobs in the group
 				 * (DON'T PACK) */
 	uint32_t grp_used_mem; /* count of active memory in the group
@@ -115,6 +135,9 @@ struct assoc_mgr_association_usage {
 	uint32_t level_shares;  /* number of shares on this level of
 				 * the tree (DON'T PACK) */
 
+	assoc_mgr_limit_cache_t limit_cache; /* set in slurmctld
+					      * (DON'T PACK) */
+
 	slurmdb_association_rec_t *parent_assoc_ptr; /* ptr to parent acct
 						      * set in slurmctld
 						      * (DON'T PACK) */
@@ -155,6 +178,8 @@ struct assoc_mgr_qos_usage {
 					* (DON'T PACK) */
 	double grp_used_wall;   /* group count of time (minutes) used in
 				 * running jobs (DON'T PACK) */
+	assoc_mgr_limit_cache_t limit_cache; /* set in slurmctld
+					      * (DON'T PACK) */
 	double norm_priority;/* normalized priority (DON'T PACK) */
 	long double usage_raw;	/* measure of resource usage (DON'T PACK) */
 
@@ -166,6 +191,7 @@ extern List assoc_mgr_association_list;
 extern List assoc_mgr_qos_list;
 extern List assoc_mgr_user_list;
 extern List assoc_mgr_wckey_list;
+extern uint32_t assoc_mgr_qos_update_cnt; /* bumped on any QOS change */
 
 extern slurmdb_association_rec_t *assoc_mgr_root_assoc;
 
@@ -0,0 +1,335 @@
+/*****************************************************************************\
+ *  auth_session.c - session based message authentication
+ *****************************************************************************
+ *  Copyright (C) 2014 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * Each message normally carries its own authentication credential, which
+ * costs a round trip to the local munged to create and another to verify.
+ * On the persistent connections kept by SlurmdParameters=persist_conn,
+ * setting session_auth as well makes the sender generate a random session
+ * key when a connection is first used and send it inside the payload of
+ * that message's credential (SLURM_SESSION_INIT).  Later messages on the
+ * connection, in either direction, carry a token instead of a credential
+ * (SLURM_AUTH_SESSION): a sequence number and an HMAC-SHA256 of the
+ * header and body computed with the session key.  Sequence numbers must
+ * increase by one with each message, so tokens can not be replayed, and
+ * the sender's role is part of the HMAC, so they can not be reflected.
+ * The key is only valid for the life of the connection.
+ */
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "slurm/slurm_errno.h"
+
+#include "src/common/auth_session.h"
+#include "src/common/fd.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/slurm_auth.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+
+typedef struct auth_session {
+	slurm_addr_t peer;		/* peer the session was set up with */
+	bool initiator;			/* true if this side sent the key */
+	uid_t uid;			/* user of the session's credential */
+	gid_t gid;
+	uint32_t send_seq;		/* last sequence number sent */
+	uint32_t recv_seq;		/* last sequence number received */
+	hmac_sha256_ctx_t hmac;		/* HMAC context with key applied */
+} auth_session_t;
+
+static pthread_mutex_t session_mutex = PTHREAD_MUTEX_INITIALIZER;
+static auth_session_t **session_tbl = NULL;	/* indexed by fd */
+static int session_tbl_size = 0;
+
+static bool _same_peer(slurm_addr_t *a, slurm_addr_t *b)
+{
+	return ((a->sin_port == b->sin_port) &&
+		(a->sin_addr.s_addr == b->sin_addr.s_addr));
+}
+
+/*
+ * Return the session for a connection.  A file descriptor closed without
+ * auth_session_close() may have been reused for another connection, so
+ * the peer address must still match.
+ * NOTE: session_mutex must be locked
+ */
+static auth_session_t *_find_session(slurm_fd_t fd)
+{
+	auth_session_t *session;
+	slurm_addr_t peer;
+
+	if ((fd < 0) || (fd >= session_tbl_size) || !session_tbl[fd])
+		return NULL;
+	session = session_tbl[fd];
+	if (slurm_get_peer_addr(fd, &peer) ||
+	    !_same_peer(&peer, &session->peer)) {
+		xfree(session);
+		session_tbl[fd] = NULL;
+		return NULL;
+	}
+	return session;
+}
+
+/* NOTE: session_mutex must be locked */
+static int _add_session(slurm_fd_t fd, auth_session_t *session)
+{
+	if (slurm_get_peer_addr(fd, &session->peer)) {
+		error("auth_session: getpeername: %m");
+		return SLURM_ERROR;
+	}
+	if (fd >= session_tbl_size) {
+		int new_size = MAX(fd + 1, session_tbl_size * 2);
+		xrealloc(session_tbl, sizeof(auth_session_t *) * new_size);
+		session_tbl_size = new_size;
+	}
+	xfree(session_tbl[fd]);
+	session_tbl[fd] = session;
+	return SLURM_SUCCESS;
+}
+
+static int _random_key(char *key)
+{
+	int fd, len = 0, rc;
+
+	if ((fd = open("/dev/urandom", O_RDONLY)) < 0) {
+		error("auth_session: open(/dev/urandom): %m");
+		return SLURM_ERROR;
+	}
+	while (len < AUTH_SESSION_KEY_LEN) {
+		rc = read(fd, key + len, AUTH_SESSION_KEY_LEN - len);
+		if ((rc < 0) && (errno == EINTR))
+			continue;
+		if (rc <= 0) {
+			error("auth_session: read(/dev/urandom): %m");
+			close(fd);
+			return SLURM_ERROR;
+		}
+		len += rc;
+	}
+	close(fd);
+	return SLURM_SUCCESS;
+}
+
+static void _compute_mac(hmac_sha256_ctx_t *hmac, bool initiator,
+			 uint32_t seq, struct iovec *iov, int iovcnt,
+			 unsigned char *mac)
+{
+	unsigned char role = initiator ? 1 : 0;
+	uint32_t net_seq = htonl(seq);
+	int i;
+
+	hmac_sha256_update(hmac, &role, sizeof(role));
+	hmac_sha256_update(hmac, &net_seq, sizeof(net_seq));
+	for (i = 0; i < iovcnt; i++)
+		hmac_sha256_update(hmac, iov[i].iov_base, iov[i].iov_len);
+	hmac_sha256_final(hmac, mac);
+}
+
+static int _create_session(slurm_fd_t fd, char *key)
+{
+	auth_session_t *session;
+	int rc;
+
+	if (_random_key(key) != SLURM_SUCCESS)
+		return SLURM_ERROR;
+
+	session = xmalloc(sizeof(auth_session_t));
+	session->initiator = true;
+	session->uid = getuid();
+	session->gid = getgid();
+	hmac_sha256_init(&session->hmac, key, AUTH_SESSION_KEY_LEN);
+
+	slurm_mutex_lock(&session_mutex);
+	rc = _add_session(fd, session);
+	slurm_mutex_unlock(&session_mutex);
+	if (rc != SLURM_SUCCESS)
+		xfree(session);
+	return rc;
+}
+
+extern void *auth_session_init_cred(slurm_fd_t fd, char *auth_info)
+{
+	char key[AUTH_SESSION_KEY_LEN];
+	void *auth_cred = NULL;
+
+	if (_create_session(fd, key) == SLURM_SUCCESS) {
+		auth_cred = g_slurm_auth_create_data(
+			NULL, 2, auth_info, key, sizeof(key),
+			(uid_t) slurm_get_slurmd_user_id());
+		if (!auth_cred) {
+			debug("auth_session: can not send session key: %s",
+			      g_slurm_auth_errstr(g_slurm_auth_errno(NULL)));
+			auth_session_close(fd);
+		}
+	}
+	memset(key, 0, sizeof(key));
+	return auth_cred;
+}
+
+extern int auth_session_accept(slurm_fd_t fd, char *key, int key_len,
+			       uid_t uid, gid_t gid)
+{
+	auth_session_t *session;
+	int rc;
+
+	if (key_len != AUTH_SESSION_KEY_LEN) {
+		error("auth_session: invalid session key length %d", key_len);
+		return SLURM_ERROR;
+	}
+
+	session = xmalloc(sizeof(auth_session_t));
+	session->initiator = false;
+	session->uid = uid;
+	session->gid = gid;
+	hmac_sha256_init(&session->hmac, key, key_len);
+
+	slurm_mutex_lock(&session_mutex);
+	rc = _add_session(fd, session);
+	slurm_mutex_unlock(&session_mutex);
+	if (rc != SLURM_SUCCESS)
+		xfree(session);
+	else
+		debug3("auth_session: accepted session for uid %u on fd %d",
+		       (uint32_t) uid, fd);
+	return rc;
+}
+
+extern bool auth_session_exists(slurm_fd_t fd)
+{
+	bool found;
+
+	slurm_mutex_lock(&session_mutex);
+	found = (_find_session(fd) != NULL);
+	slurm_mutex_unlock(&session_mutex);
+	return found;
+}
+
+extern int auth_session_sign(slurm_fd_t fd, struct iovec *iov, int iovcnt,
+			     char *token)
+{
+	auth_session_t *session;
+	hmac_sha256_ctx_t hmac;
+	unsigned char mac[SHA256_DIGEST_LEN];
+	uint32_t seq, net_seq;
+	bool initiator;
+
+	slurm_mutex_lock(&session_mutex);
+	if (!(session = _find_session(fd))) {
+		slurm_mutex_unlock(&session_mutex);
+		return SLURM_ERROR;
+	}
+	seq = ++session->send_seq;
+	initiator = session->initiator;
+	hmac = session->hmac;
+	slurm_mutex_unlock(&session_mutex);
+
+	_compute_mac(&hmac, initiator, seq, iov, iovcnt, mac);
+	net_seq = htonl(seq);
+	memcpy(token, &net_seq, sizeof(net_seq));
+	memcpy(token + sizeof(net_seq), mac, sizeof(mac));
+	return SLURM_SUCCESS;
+}
+
+extern int auth_session_verify(slurm_fd_t fd, struct iovec *iov, int iovcnt,
+			       char *token, uid_t *uid, gid_t *gid)
+{
+	auth_session_t *session;
+	hmac_sha256_ctx_t hmac;
+	unsigned char mac[SHA256_DIGEST_LEN], *recv_mac;
+	unsigned char diff = 0;
+	uint32_t seq, net_seq;
+	bool initiator;
+	int i;
+
+	memcpy(&net_seq, token, sizeof(net_seq));
+	seq = ntohl(net_seq);
+	recv_mac = (unsigned char *) token + sizeof(net_seq);
+
+	slurm_mutex_lock(&session_mutex);
+	if (!(session = _find_session(fd))) {
+		slurm_mutex_unlock(&session_mutex);
+		error("auth_session: no session on fd %d", fd);
+		return SLURM_ERROR;
+	}
+	if (seq != session->recv_seq + 1) {
+		slurm_mutex_unlock(&session_mutex);
+		error("auth_session: sequence number %u, expected %u",
+		      seq, session->recv_seq + 1);
+		return SLURM_ERROR;
+	}
+	initiator = !session->initiator;	/* the peer's role */
+	hmac = session->hmac;
+	slurm_mutex_unlock(&session_mutex);
+
+	_compute_mac(&hmac, initiator, seq, iov, iovcnt, mac);
+	/* compare in constant time */
+	for (i = 0; i < SHA256_DIGEST_LEN; i++)
+		diff |= mac[i] ^ recv_mac[i];
+	if (diff) {
+		error("auth_session: invalid message authentication code");
+		return SLURM_ERROR;
+	}
+
+	slurm_mutex_lock(&session_mutex);
+	if (!(session = _find_session(fd)) || (seq != session->recv_seq + 1)) {
+		slurm_mutex_unlock(&session_mutex);
+		return SLURM_ERROR;
+	}
+	session->recv_seq = seq;
+	*uid = session->uid;
+	*gid = session->gid;
+	slurm_mutex_unlock(&session_mutex);
+	return SLURM_SUCCESS;
+}
+
+extern void auth_session_close(slurm_fd_t fd)
+{
+	if ((fd < 0) || (fd >= session_tbl_size))
+		return;
+
+	slurm_mutex_lock(&session_mutex);
+	if (fd < session_tbl_size)
+		xfree(session_tbl[fd]);
+	slurm_mutex_unlock(&session_mutex);
+}
@@ -0,0 +1,95 @@
+/*****************************************************************************\
+ *  auth_session.h - session based message authentication
+ *****************************************************************************
+ *  Copyright (C) 2014 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _AUTH_SESSION_H
+#define _AUTH_SESSION_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "src/common/sha256.h"
+#include "src/common/slurm_protocol_common.h"
+
+#define AUTH_SESSION_KEY_LEN	32
+/* A token is a sequence number followed by a SHA-256 HMAC */
+#define AUTH_SESSION_TOKEN_LEN	(sizeof(uint32_t) + SHA256_DIGEST_LEN)
+
+/*
+ * Start a session on a connection and return the credential which carries
+ * its key to the peer, only readable by SlurmdUser.
+ * IN auth_info - authentication plugin options
+ * RET credential or NULL if a session can not be started, in which case
+ *	messages carry their own credential as usual
+ */
+extern void *auth_session_init_cred(slurm_fd_t fd, char *auth_info);
+
+/*
+ * Accept a session started by the peer of a connection, once the
+ * credential carrying its key has been verified.
+ * IN uid, gid - user and group of that credential, which apply to all
+ *	messages authenticated by the session
+ * RET SLURM_SUCCESS or SLURM_ERROR
+ */
+extern int auth_session_accept(slurm_fd_t fd, char *key, int key_len,
+			       uid_t uid, gid_t gid);
+
+/* Return true if a session is established on the connection */
+extern bool auth_session_exists(slurm_fd_t fd);
+
+/*
+ * Compute the token for the next message sent on a connection.
+ * IN iov - message data covered by the token
+ * OUT token - AUTH_SESSION_TOKEN_LEN bytes
+ * RET SLURM_SUCCESS or SLURM_ERROR if there is no session
+ */
+extern int auth_session_sign(slurm_fd_t fd, struct iovec *iov, int iovcnt,
+			     char *token);
+
+/*
+ * Verify the token of a message received on a connection.  Tokens are
+ * only valid once and in the order they were issued.
+ * IN iov - message data covered by the token
+ * IN token - AUTH_SESSION_TOKEN_LEN bytes
+ * OUT uid, gid - user and group the session was established for
+ * RET SLURM_SUCCESS or SLURM_ERROR
+ */
+extern int auth_session_verify(slurm_fd_t fd, struct iovec *iov, int iovcnt,
+			       char *token, uid_t *uid, gid_t *gid);
+
+/* Discard any session on a connection which is being closed */
+extern void auth_session_close(slurm_fd_t fd);
+
+#endif /* !_AUTH_SESSION_H */
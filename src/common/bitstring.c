@@ -113,6 +113,7 @@ strong_alias(bit_free,		slurm_bit_free);
 strong_alias(bit_realloc,	slurm_bit_realloc);
 strong_alias(bit_size,		slurm_bit_size);
 strong_alias(bit_and,		slurm_bit_and);
+strong_alias(bit_and_not,	slurm_bit_and_not);
 strong_alias(bit_not,		slurm_bit_not);
 strong_alias(bit_or,		slurm_bit_or);
 strong_alias(bit_set_count,	slurm_bit_set_count);
@@ -595,6 +596,24 @@ bit_and(bitstr_t *b1, bitstr_t *b2)
 		b1[_bit_word(bit)] &= b2[_bit_word(bit)];
 }
 
+/*
+ * b1 &= ~b2
+ *   b1 (IN/OUT)	first string
+ *   b2 (IN)		second bitstring
+ */
+void
+bit_and_not(bitstr_t *b1, bitstr_t *b2)
+{
+	bitoff_t bit;
+
+	_assert_bitstr_valid(b1);
+	_assert_bitstr_valid(b2);
+	assert(_bitstr_bits(b1) == _bitstr_bits(b2));
+
+	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
+		b1[_bit_word(bit)] &= ~b2[_bit_word(bit)];
+}
+
 /*
  * b1 = ~b1		one's complement
  *   b1 (IN/OUT)	first bitmap
@@ -0,0 +1,204 @@
+/*****************************************************************************\
+ *  conn_cache.c - cache of idle connections for message forwarding
+ *****************************************************************************
+ *  Copyright (C) 2014 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * Messages fanned out through the forwarding tree (pings, job termination,
+ * job launch, etc.) normally open a new connection to each child for each
+ * message.  With SlurmdParameters=persist_conn, slurmctld and slurmd keep
+ * those connections open after the response is received and reuse them for
+ * the next message to the same node.  Messages sent on a cached connection
+ * carry the SLURM_PERSIST_CONN header flag, which tells the receiving slurmd
+ * to wait for another message rather than close the connection.  A
+ * connection that fails is simply closed, so the tree is rebuilt on demand
+ * using the existing forwarding failure handling.
+ */
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/common/conn_cache.h"
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+/* Maximum number of idle connections kept */
+#define CONN_CACHE_MAX 256
+
+typedef struct conn_cache_ent {
+	slurm_addr_t addr;
+	slurm_fd_t fd;
+	time_t last_used;
+} conn_cache_ent_t;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static List cache_list = NULL;
+static bool cache_enabled = false;
+static bool session_auth = false;
+
+static void _close_conn(slurm_fd_t fd)
+{
+	while ((slurm_shutdown_msg_conn(fd) < 0) && (errno == EINTR))
+		;
+}
+
+static void _destroy_ent(void *x)
+{
+	conn_cache_ent_t *ent = (conn_cache_ent_t *) x;
+
+	_close_conn(ent->fd);
+	xfree(ent);
+}
+
+static bool _same_addr(slurm_addr_t *a, slurm_addr_t *b)
+{
+	return ((a->sin_port == b->sin_port) &&
+		(a->sin_addr.s_addr == b->sin_addr.s_addr));
+}
+
+/* An idle connection has nothing to read, anything else means the peer
+ * closed it or it is out of sync */
+static bool _conn_usable(slurm_fd_t fd)
+{
+	struct pollfd pfd;
+
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	return (poll(&pfd, 1, 0) == 0);
+}
+
+extern void conn_cache_init(void)
+{
+	char *slurmd_params = slurm_get_slurmd_params();
+	bool enable = (slurmd_params &&
+		       strstr(slurmd_params, "persist_conn"));
+
+	session_auth = (enable && strstr(slurmd_params, "session_auth"));
+	xfree(slurmd_params);
+	slurm_mutex_lock(&cache_mutex);
+	if (!cache_list)
+		cache_list = list_create(_destroy_ent);
+	else if (!enable)
+		list_flush(cache_list);
+	cache_enabled = enable;
+	slurm_mutex_unlock(&cache_mutex);
+	if (enable)
+		debug("caching connections to slurmd%s",
+		      session_auth ? " with session authentication" : "");
+}
+
+extern void conn_cache_fini(void)
+{
+	slurm_mutex_lock(&cache_mutex);
+	cache_enabled = false;
+	session_auth = false;
+	if (cache_list) {
+		list_destroy(cache_list);
+		cache_list = NULL;
+	}
+	slurm_mutex_unlock(&cache_mutex);
+}
+
+extern bool conn_cache_enabled(void)
+{
+	return cache_enabled;
+}
+
+extern bool conn_cache_session_auth(void)
+{
+	return session_auth;
+}
+
+extern slurm_fd_t conn_cache_get(slurm_addr_t *addr)
+{
+	ListIterator iter;
+	conn_cache_ent_t *ent;
+	slurm_fd_t fd = -1;
+	time_t now = time(NULL);
+
+	slurm_mutex_lock(&cache_mutex);
+	if (!cache_enabled || !cache_list) {
+		slurm_mutex_unlock(&cache_mutex);
+		return -1;
+	}
+	iter = list_iterator_create(cache_list);
+	while ((ent = list_next(iter))) {
+		if ((difftime(now, ent->last_used) >= CONN_CACHE_IDLE) ||
+		    (_same_addr(&ent->addr, addr) && !_conn_usable(ent->fd))) {
+			list_delete_item(iter);
+			continue;
+		}
+		if (_same_addr(&ent->addr, addr)) {
+			fd = ent->fd;
+			ent->fd = -1;
+			xfree(ent);
+			list_remove(iter);
+			break;
+		}
+	}
+	list_iterator_destroy(iter);
+	slurm_mutex_unlock(&cache_mutex);
+
+	return fd;
+}
+
+extern void conn_cache_put(slurm_addr_t *addr, slurm_fd_t fd)
+{
+	conn_cache_ent_t *ent;
+
+	slurm_mutex_lock(&cache_mutex);
+	if (!cache_enabled || !cache_list ||
+	    (list_count(cache_list) >= CONN_CACHE_MAX)) {
+		slurm_mutex_unlock(&cache_mutex);
+		_close_conn(fd);
+		return;
+	}
+	ent = xmalloc(sizeof(conn_cache_ent_t));
+	memcpy(&ent->addr, addr, sizeof(slurm_addr_t));
+	ent->fd = fd;
+	ent->last_used = time(NULL);
+	list_prepend(cache_list, ent);
+	slurm_mutex_unlock(&cache_mutex);
+}
@@ -0,0 +1,83 @@
+/*****************************************************************************\
+ *  conn_cache.h - cache of idle connections for message forwarding
+ *****************************************************************************
+ *  Copyright (C) 2014 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _CONN_CACHE_H
+#define _CONN_CACHE_H
+
+#include <stdbool.h>
+
+#include "src/common/slurm_protocol_common.h"
+
+/*
+ * Seconds an idle connection stays in the cache.  The receiving slurmd
+ * keeps idle connections open for twice as long so the sender always
+ * discards them first.
+ */
+#define CONN_CACHE_IDLE 30
+
+/*
+ * Enable or disable the cache according to the persist_conn option of
+ * SlurmdParameters.  Called by daemons at startup and reconfiguration,
+ * the cache is never enabled in other processes.
+ */
+extern void conn_cache_init(void);
+
+/* Close all cached connections and disable the cache */
+extern void conn_cache_fini(void);
+
+/* Return true if connections to slurmd should be kept for reuse */
+extern bool conn_cache_enabled(void);
+
+/*
+ * Return true if messages on cached connections should be authenticated
+ * by a session (SlurmdParameters=session_auth), see auth_session.c
+ */
+extern bool conn_cache_session_auth(void);
+
+/*
+ * Take an idle connection to addr from the cache.  Connections which have
+ * been closed by the peer or idle too long are discarded.
+ * RET connection or -1 if none is available
+ */
+extern slurm_fd_t conn_cache_get(slurm_addr_t *addr);
+
+/*
+ * Return a connection to the cache once a request has been sent on it and
+ * its full response received.  The connection is closed instead if the
+ * cache is disabled or full.
+ */
+extern void conn_cache_put(slurm_addr_t *addr, slurm_fd_t fd);
+
+#endif /* !_CONN_CACHE_H */
@@ -40,6 +40,10 @@
 #endif
 
 #include <sys/poll.h>
+#ifdef HAVE_SYS_EPOLL_H
+#  include <sys/epoll.h>
+#endif
+#include <string.h>
 #include <unistd.h>
 #include <errno.h>
 
@@ -69,6 +73,14 @@ struct eio_handle_components {
 	int  fds[2];
 	List obj_list;
 	List new_objs;
+	uint16_t flags;			/* EIO_FLAG_* */
+	int  epfd;			/* epoll instance, or -1 for poll() */
+#ifdef HAVE_SYS_EPOLL_H
+	struct epoll_event *events;	/* epoll_wait() results */
+	int  max_events;
+	eio_obj_t **fd_owner;		/* object registered for each fd */
+	int  fd_owner_cnt;
+#endif
 };
 
 
@@ -76,20 +88,30 @@ struct eio_handle_components {
  */
 
 static int          _poll_internal(struct pollfd *pfds, unsigned int nfds);
+static int          _poll_timeout(struct pollfd *pfds, unsigned int nfds,
+				  int timeout);
 static unsigned int _poll_setup_pollfds(struct pollfd *, eio_obj_t **, List);
 static void         _poll_dispatch(struct pollfd *, unsigned int, eio_obj_t **,
 		                   List objList);
 static void         _poll_handle_event(short revents, eio_obj_t *obj,
 		                       List objList);
+static int          _poll_mainloop(eio_handle_t *eio);
+static short        _obj_events(eio_obj_t *obj);
+#ifdef HAVE_SYS_EPOLL_H
+static int          _epoll_mainloop(eio_handle_t *eio);
+#endif
 
 static time_t eio_shutdown_time = (time_t) 0;
 
-eio_handle_t *eio_handle_create(void)
+eio_handle_t *eio_handle_create_flags(uint16_t flags)
 {
 	eio_handle_t *eio = xmalloc(sizeof(*eio));
 
+	eio->flags = flags;
+	eio->epfd = -1;
 	if (pipe(eio->fds) < 0) {
 		error ("eio_create: pipe: %m");
+		eio->fds[0] = eio->fds[1] = -1;
 		eio_handle_destroy(eio);
 		return (NULL);
 	}
@@ -98,6 +120,29 @@ eio_handle_t *eio_handle_create(void)
 	fd_set_close_on_exec(eio->fds[0]);
 	fd_set_close_on_exec(eio->fds[1]);
 
+#ifdef HAVE_SYS_EPOLL_H
+	if (!(flags & EIO_FLAG_POLL)) {
+		struct epoll_event ev;
+
+		if ((eio->epfd = epoll_create(64)) < 0) {
+			error("eio_create: epoll_create: %m");
+		} else {
+			fd_set_close_on_exec(eio->epfd);
+			/* The signalling fd is always watched, its data
+			 * pointer is NULL */
+			memset(&ev, 0, sizeof(ev));
+			ev.events = EPOLLIN;
+			ev.data.ptr = NULL;
+			if (epoll_ctl(eio->epfd, EPOLL_CTL_ADD, eio->fds[0],
+				      &ev) < 0) {
+				error("eio_create: epoll_ctl: %m");
+				close(eio->epfd);
+				eio->epfd = -1;
+			}
+		}
+	}
+#endif
+
 	xassert(eio->magic = EIO_MAGIC);
 
 	eio->obj_list = list_create(eio_obj_destroy);
@@ -106,12 +151,23 @@ eio_handle_t *eio_handle_create(void)
 	return eio;
 }
 
+eio_handle_t *eio_handle_create(void)
+{
+	return eio_handle_create_flags(0);
+}
+
 void eio_handle_destroy(eio_handle_t *eio)
 {
 	xassert(eio != NULL);
 	xassert(eio->magic == EIO_MAGIC);
 	close(eio->fds[0]);
 	close(eio->fds[1]);
+	if (eio->epfd >= 0)
+		close(eio->epfd);
+#ifdef HAVE_SYS_EPOLL_H
+	xfree(eio->events);
+	xfree(eio->fd_owner);
+#endif
 	if (eio->obj_list)
 		list_destroy(eio->obj_list);
 
@@ -252,6 +308,18 @@ static int _eio_wakeup_handler(eio_handle_t *eio)
 }
 
 int eio_handle_mainloop(eio_handle_t *eio)
+{
+	xassert (eio != NULL);
+	xassert (eio->magic == EIO_MAGIC);
+
+#ifdef HAVE_SYS_EPOLL_H
+	if (eio->epfd >= 0)
+		return _epoll_mainloop(eio);
+#endif
+	return _poll_mainloop(eio);
+}
+
+static int _poll_mainloop(eio_handle_t *eio)
 {
 	int            retval  = 0;
 	struct pollfd *pollfds = NULL;
@@ -259,9 +327,6 @@ int eio_handle_mainloop(eio_handle_t *eio)
 	unsigned int   maxnfds = 0, nfds = 0;
 	unsigned int   n       = 0;
 
-	xassert (eio != NULL);
-	xassert (eio->magic == EIO_MAGIC);
-
 	for (;;) {
 
 		/* Alloc memory for pfds and map if needed */
@@ -315,15 +380,283 @@ int eio_handle_mainloop(eio_handle_t *eio)
 	return retval;
 }
 
+#ifdef HAVE_SYS_EPOLL_H
+/*
+ * epoll backend
+ *
+ * The readable() and writable() functions of every object are still
+ * called on each pass, since they decide which fds are watched, but an
+ * object's fd is only (re)registered with the kernel when the events it
+ * wants change.  The kernel then reports just the ready fds, so neither
+ * waiting nor dispatching costs time for the idle ones.
+ *
+ * Level triggered registrations are EPOLLONESHOT and re-armed after each
+ * event, so a registration left behind by an fd that an object closed
+ * fires at most once.  Events for an object whose fd no longer matches
+ * its registration are discarded.
+ */
+static uint32_t _poll_to_epoll(short events)
+{
+	uint32_t ev = 0;
+
+	if (events & POLLIN)
+		ev |= EPOLLIN;
+	if (events & POLLOUT)
+		ev |= EPOLLOUT;
+	if (events & POLLHUP)
+		ev |= EPOLLHUP;
+#ifdef POLLRDHUP
+	if (events & POLLRDHUP)
+		ev |= EPOLLRDHUP;
+#endif
+	return ev;
+}
+
+static short _epoll_to_poll(uint32_t ev)
+{
+	short revents = 0;
+
+	if (ev & EPOLLIN)
+		revents |= POLLIN;
+	if (ev & EPOLLOUT)
+		revents |= POLLOUT;
+	if (ev & EPOLLHUP)
+		revents |= POLLHUP;
+	if (ev & EPOLLERR)
+		revents |= POLLERR;
+#ifdef POLLRDHUP
+	if (ev & EPOLLRDHUP)
+		revents |= POLLRDHUP;
+#endif
+	return revents;
+}
+
+/* Remove an object's registration, if its fd still belongs to it */
+static void _epoll_unregister(eio_handle_t *eio, eio_obj_t *obj)
+{
+	if ((obj->reg_fd < eio->fd_owner_cnt) &&
+	    (eio->fd_owner[obj->reg_fd] == obj)) {
+		/* Fails harmlessly if the fd was closed */
+		(void) epoll_ctl(eio->epfd, EPOLL_CTL_DEL, obj->reg_fd, NULL);
+		eio->fd_owner[obj->reg_fd] = NULL;
+	}
+	obj->reg_fd = -1;
+	obj->reg_events = 0;
+}
+
+/*
+ * Register or re-arm an object's fd for "events".
+ * Return -1 if epoll can not watch the fd, so it must be polled.
+ */
+static int _epoll_register(eio_handle_t *eio, eio_obj_t *obj, short events)
+{
+	struct epoll_event ev;
+	eio_obj_t *owner;
+	int op;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = _poll_to_epoll(events);
+	if (eio->flags & EIO_FLAG_EDGE)
+		ev.events |= EPOLLET;
+	else
+		ev.events |= EPOLLONESHOT;
+	ev.data.ptr = obj;
+
+	if (obj->reg_fd == obj->fd) {
+		if (obj->reg_events == ev.events)
+			return 0;	/* still armed */
+		op = EPOLL_CTL_MOD;
+	} else {
+		op = EPOLL_CTL_ADD;
+		if (obj->fd >= eio->fd_owner_cnt) {
+			int cnt = MAX(obj->fd + 1, eio->fd_owner_cnt * 2);
+			xrealloc(eio->fd_owner, cnt * sizeof(eio_obj_t *));
+			eio->fd_owner_cnt = cnt;
+		}
+	}
+
+	if (epoll_ctl(eio->epfd, op, obj->fd, &ev) < 0) {
+		/* EPERM: regular file, EEXIST: fd shared by two objects,
+		 * EBADF: closed fd, left for poll() to report POLLNVAL */
+		if ((errno != EPERM) && (errno != EEXIST) && (errno != EBADF))
+			error("eio: epoll_ctl(%d): %m", obj->fd);
+		if (op == EPOLL_CTL_MOD)
+			_epoll_unregister(eio, obj);
+		obj->poll_fd = obj->fd;
+		return -1;
+	}
+
+	if (op == EPOLL_CTL_ADD) {
+		/* A previous owner of this fd number closed it */
+		if ((owner = eio->fd_owner[obj->fd]) && (owner != obj)) {
+			owner->reg_fd = -1;
+			owner->reg_events = 0;
+		}
+		eio->fd_owner[obj->fd] = obj;
+		obj->reg_fd = obj->fd;
+	}
+	obj->reg_events = ev.events;
+	return 0;
+}
+
+/*
+ * Bring the epoll registrations up to date with what each object wants.
+ * Objects epoll can not watch are returned in pfds/map for poll().
+ * Return the number of objects wanting events, with *npoll set to the
+ * number of entries in pfds.
+ */
+static int _epoll_setup(eio_handle_t *eio, struct pollfd **pfds,
+			eio_obj_t ***map, unsigned int *maxpoll,
+			unsigned int *npoll)
+{
+	ListIterator  i;
+	eio_obj_t    *obj;
+	short         events;
+	int           nwant = 0;
+
+	*npoll = 0;
+	i = list_iterator_create(eio->obj_list);
+	while ((obj = list_next(i))) {
+		events = _obj_events(obj);
+		if ((obj->reg_fd >= 0) && (!events || (obj->reg_fd != obj->fd)))
+			_epoll_unregister(eio, obj);
+		if (obj->poll_fd != obj->fd)
+			obj->poll_fd = -1;
+		if (!events)
+			continue;
+		nwant++;
+		if (obj->fd < 0)
+			continue;	/* poll() would ignore it too */
+		if ((obj->poll_fd == -1) &&
+		    (_epoll_register(eio, obj, events) == 0))
+			continue;
+
+		if (*maxpoll <= *npoll) {
+			*maxpoll = MAX(*maxpoll * 2, 8);
+			/* one extra slot for the epoll fd */
+			xrealloc(*pfds, (*maxpoll + 1) * sizeof(struct pollfd));
+			xrealloc(*map, *maxpoll * sizeof(eio_obj_t *));
+		}
+		(*pfds)[*npoll].fd      = obj->fd;
+		(*pfds)[*npoll].events  = events;
+		(*pfds)[*npoll].revents = 0;
+		(*map)[*npoll]          = obj;
+		(*npoll)++;
+	}
+	list_iterator_destroy(i);
+
+	return nwant;
+}
+
+static int _epoll_wait(eio_handle_t *eio, int timeout)
+{
+	int n;
+
+	while ((n = epoll_wait(eio->epfd, eio->events, eio->max_events,
+			       timeout)) < 0) {
+		switch (errno) {
+		case EINTR :
+			return 0;
+		case EAGAIN:
+			continue;
+		default:
+			error("epoll_wait: %m");
+			return -1;
+		}
+	}
+	return n;
+}
+
+static int _epoll_mainloop(eio_handle_t *eio)
+{
+	int            retval  = 0;
+	struct pollfd *pollfds = NULL;
+	eio_obj_t    **map     = NULL;
+	unsigned int   maxpoll = 0, npoll = 0;
+	int            i, n, nwant, timeout;
+	eio_obj_t     *obj;
+
+	for (;;) {
+		nwant = _epoll_setup(eio, &pollfds, &map, &maxpoll, &npoll);
+		if (nwant <= 0)
+			goto done;
+
+		n = list_count(eio->obj_list) + 1;
+		if (eio->max_events < n) {
+			eio->max_events = n;
+			xrealloc(eio->events,
+				 eio->max_events * sizeof(struct epoll_event));
+		}
+
+		if (eio_shutdown_time)
+			timeout = 1000;	/* Return every 1000 msec */
+		else
+			timeout = -1;
+		if (npoll) {
+			/* Wait on the polled fds and the epoll fd together */
+			pollfds[npoll].fd      = eio->epfd;
+			pollfds[npoll].events  = POLLIN;
+			pollfds[npoll].revents = 0;
+			if (_poll_timeout(pollfds, npoll + 1, timeout) < 0)
+				goto error;
+			timeout = 0;
+		}
+		if ((n = _epoll_wait(eio, timeout)) < 0)
+			goto error;
+
+		for (i = 0; i < n; i++) {
+			if (eio->events[i].data.ptr == NULL)
+				_eio_wakeup_handler(eio);
+		}
+		if (npoll)
+			_poll_dispatch(pollfds, npoll, map, eio->obj_list);
+		for (i = 0; i < n; i++) {
+			obj = eio->events[i].data.ptr;
+			if (obj == NULL)
+				continue;
+			if (!(eio->flags & EIO_FLAG_EDGE))
+				obj->reg_events = 0;	/* one shot fired */
+			if ((obj->reg_fd < 0) || (obj->reg_fd != obj->fd))
+				continue;		/* stale */
+			_poll_handle_event(_epoll_to_poll(
+						   eio->events[i].events),
+					   obj, eio->obj_list);
+		}
+
+		if (eio_shutdown_time &&
+		    (difftime(time(NULL), eio_shutdown_time) >=
+		     EIO_SHUTDOWN_WAIT)) {
+			error("Abandoning IO %d secs after job shutdown "
+			      "initiated", EIO_SHUTDOWN_WAIT);
+			break;
+		}
+	}
+  error:
+	retval = -1;
+  done:
+	xfree(pollfds);
+	xfree(map);
+	return retval;
+}
+#endif	/* HAVE_SYS_EPOLL_H */
+
 static int
 _poll_internal(struct pollfd *pfds, unsigned int nfds)
 {
-	int n, timeout;
+	int timeout;
 
 	if (eio_shutdown_time)
 		timeout = 1000;	/* Return every 1000 msec during shutdown */
 	else
 		timeout = -1;
+	return _poll_timeout(pfds, nfds, timeout);
+}
+
+static int
+_poll_timeout(struct pollfd *pfds, unsigned int nfds, int timeout)
+{
+	int n;
+
 	while ((n = poll(pfds, nfds, timeout)) < 0) {
 		switch (errno) {
 		case EINTR :
@@ -351,41 +684,46 @@ _is_readable(eio_obj_t *obj)
 	return (obj->ops->readable && (*obj->ops->readable)(obj));
 }
 
-static unsigned int
-_poll_setup_pollfds(struct pollfd *pfds, eio_obj_t *map[], List l)
+/* Return the poll() events wanted for an object, zero if none */
+static short
+_obj_events(eio_obj_t *obj)
 {
-	ListIterator  i    = list_iterator_create(l);
-	eio_obj_t    *obj  = NULL;
-	unsigned int  nfds = 0;
-	bool          readable, writable;
+	bool readable, writable;
 
-	while ((obj = list_next(i))) {
-		writable = _is_writable(obj);
-		readable = _is_readable(obj);
-		if (writable && readable) {
-			pfds[nfds].fd     = obj->fd;
+	writable = _is_writable(obj);
+	readable = _is_readable(obj);
+	if (writable && readable) {
 #ifdef POLLRDHUP
 /* Available since Linux 2.6.17 */
-			pfds[nfds].events = POLLOUT | POLLIN |
-					    POLLHUP | POLLRDHUP;
+		return POLLOUT | POLLIN | POLLHUP | POLLRDHUP;
 #else
-			pfds[nfds].events = POLLOUT | POLLIN | POLLHUP;
+		return POLLOUT | POLLIN | POLLHUP;
 #endif
-			map[nfds]         = obj;
-			nfds++;
-		} else if (readable) {
-			pfds[nfds].fd     = obj->fd;
+	} else if (readable) {
 #ifdef POLLRDHUP
 /* Available since Linux 2.6.17 */
-			pfds[nfds].events = POLLIN | POLLRDHUP;
+		return POLLIN | POLLRDHUP;
 #else
-			pfds[nfds].events = POLLIN;
+		return POLLIN;
 #endif
-			map[nfds]         = obj;
-			nfds++;
-		} else if (writable) {
+	} else if (writable) {
+		return POLLOUT | POLLHUP;
+	}
+	return 0;
+}
+
+static unsigned int
+_poll_setup_pollfds(struct pollfd *pfds, eio_obj_t *map[], List l)
+{
+	ListIterator  i    = list_iterator_create(l);
+	eio_obj_t    *obj  = NULL;
+	unsigned int  nfds = 0;
+	short         events;
+
+	while ((obj = list_next(i))) {
+		if ((events = _obj_events(obj))) {
 			pfds[nfds].fd     = obj->fd;
-			pfds[nfds].events = POLLOUT | POLLHUP;
+			pfds[nfds].events = events;
 			map[nfds]         = obj;
 			nfds++;
 		}
@@ -492,6 +830,8 @@ eio_obj_create(int fd, struct io_operations *ops, void *arg)
 	obj->arg = arg;
 	obj->ops = _ops_copy(ops);
 	obj->shutdown = false;
+	obj->reg_fd = -1;
+	obj->poll_fd = -1;
 	return obj;
 }
 
@@ -67,8 +67,25 @@ struct eio_obj {
 	void *arg;                        /* application-specific data       */
 	struct io_operations *ops;        /* pointer to ops struct for obj   */
 	bool shutdown;
+
+	/* Private to the eio engine */
+	int reg_fd;                       /* fd registered with epoll or -1  */
+	uint32_t reg_events;              /* epoll events armed for reg_fd   */
+	int poll_fd;                      /* fd epoll refused, polled or -1  */
 };
 
+/* eio_handle_create_flags() flags */
+#define EIO_FLAG_POLL	0x0001	/* use poll(), even if epoll is available */
+#define EIO_FLAG_EDGE	0x0002	/* edge triggered epoll, the handle_read()
+				 * and handle_write() functions of every
+				 * object must read or write until EAGAIN */
+
+/*
+ * Create an eio handle.  Where epoll is available it is used, level
+ * triggered, unless "flags" say otherwise.  Object fds epoll can not
+ * handle (e.g. regular files) are polled with poll().
+ */
+eio_handle_t *eio_handle_create_flags(uint16_t flags);
 eio_handle_t *eio_handle_create(void);
 void eio_handle_destroy(eio_handle_t *eio);
 
@@ -44,6 +44,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include "src/common/macros.h"
@@ -335,3 +337,80 @@ extern int wait_fd_readable(int fd, int time_limit)
 		}
 	}
 }
+
+/* Pass an open file descriptor to another process over a UNIX domain
+ * socket.  Return 0 on success or -1 on error */
+extern int send_fd_over_pipe(int socket, int fd)
+{
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	struct iovec iov;
+	char c = '\0';
+	char ctl[CMSG_SPACE(sizeof(int))];
+	int rc;
+
+	memset(&msg, 0, sizeof(msg));
+	memset(ctl, 0, sizeof(ctl));
+	iov.iov_base = &c;
+	iov.iov_len = sizeof(c);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = ctl;
+	msg.msg_controllen = sizeof(ctl);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &fd, sizeof(int));
+
+	while ((rc = sendmsg(socket, &msg, 0)) < 0) {
+		if (errno != EINTR) {
+			error("%s: sendmsg: %m", __func__);
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/* Receive a file descriptor sent with send_fd_over_pipe().
+ * Return the new file descriptor or -1 on error */
+extern int receive_fd_over_pipe(int socket)
+{
+	struct msghdr msg;
+	struct cmsghdr *cmsg;
+	struct iovec iov;
+	char c;
+	char ctl[CMSG_SPACE(sizeof(int))];
+	int fd, rc;
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base = &c;
+	iov.iov_len = sizeof(c);
+	msg.msg_iov = &iov;
+	msg.msg_iovlen = 1;
+	msg.msg_control = ctl;
+	msg.msg_controllen = sizeof(ctl);
+
+	while ((rc = recvmsg(socket, &msg, 0)) < 0) {
+		if (errno != EINTR) {
+			error("%s: recvmsg: %m", __func__);
+			return -1;
+		}
+	}
+	if (rc == 0) {
+		error("%s: EOF on socket", __func__);
+		return -1;
+	}
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || (cmsg->cmsg_level != SOL_SOCKET) ||
+	    (cmsg->cmsg_type != SCM_RIGHTS) ||
+	    (cmsg->cmsg_len != CMSG_LEN(sizeof(int)))) {
+		error("%s: no file descriptor received", __func__);
+		return -1;
+	}
+	memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+
+	return fd;
+}
@@ -163,4 +163,12 @@ extern int wait_fd_readable(int fd, int time_limit);
 /* Wait for a file descriptor to be readable (up to time_limit seconds).
  * Return 0 when readable or -1 on error */
 
+extern int send_fd_over_pipe(int socket, int fd);
+/* Pass an open file descriptor to another process over a UNIX domain
+ * socket.  Return 0 on success or -1 on error */
+
+extern int receive_fd_over_pipe(int socket);
+/* Receive a file descriptor sent with send_fd_over_pipe().
+ * Return the new file descriptor or -1 on error */
+
 #endif /* !_FD_H */
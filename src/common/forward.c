@@ -49,6 +49,8 @@
 
 #include "slurm/slurm.h"
 
+#include "src/common/auth_session.h"
+#include "src/common/conn_cache.h"
 #include "src/common/forward.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -100,10 +102,12 @@ void *_forward_thread(void *arg)
 	ret_data_info_t *ret_data_info = NULL;
 	char *name = NULL;
 	hostlist_t hl = hostlist_create(fwd_msg->header.forward.nodelist);
+	void *init_cred;
 	slurm_addr_t addr;
 	char *buf = NULL;
 	int steps = 0;
 	int start_timeout = fwd_msg->timeout;
+	bool cached;
 
 	/* repeat until we are sure the message was sent */
 	while ((name = hostlist_shift(hl))) {
@@ -120,7 +124,10 @@ void *_forward_thread(void *arg)
 			}
 			goto cleanup;
 		}
-		if ((fd = slurm_open_msg_conn(&addr)) < 0) {
+		fd = conn_cache_get(&addr);
+		cached = (fd >= 0);
+	retry:
+		if ((fd < 0) && ((fd = slurm_open_msg_conn(&addr)) < 0)) {
 			error("forward_thread to %s: %m", name);
 
 			slurm_mutex_lock(fwd_msg->forward_mutex);
@@ -148,13 +155,40 @@ void *_forward_thread(void *arg)
 		} else
 			debug3("forward: send to %s ", name);
 
+		if (conn_cache_enabled())
+			fwd_msg->header.flags |= SLURM_PERSIST_CONN;
+		else
+			fwd_msg->header.flags &= (~SLURM_PERSIST_CONN);
+		/* The forwarded message keeps its original credential,
+		 * but a session lets the child authenticate its response
+		 * without one */
+		fwd_msg->header.flags &= ~(SLURM_SESSION_INIT |
+					   SLURM_AUTH_SESSION);
+		init_cred = NULL;
+		if ((fwd_msg->header.flags & SLURM_PERSIST_CONN) &&
+		    !(fwd_msg->header.flags & SLURM_GLOBAL_AUTH_KEY) &&
+		    conn_cache_session_auth() && !auth_session_exists(fd)) {
+			char *auth_info = slurm_get_auth_info();
+			init_cred = auth_session_init_cred(fd, auth_info);
+			xfree(auth_info);
+		}
+		if (init_cred)
+			fwd_msg->header.flags |= SLURM_SESSION_INIT;
 		pack_header(&fwd_msg->header, buffer);
+		if (init_cred) {
+			if (g_slurm_auth_pack(init_cred, buffer)) {
+				/* carry on without a session */
+				auth_session_close(fd);
+				fwd_msg->header.flags &= (~SLURM_SESSION_INIT);
+				set_buf_offset(buffer, 0);
+				pack_header(&fwd_msg->header, buffer);
+			}
+			(void) g_slurm_auth_destroy(init_cred);
+		}
 
 		/* add forward data to buffer */
-		if (remaining_buf(buffer) < fwd_msg->buf_len) {
-			buffer->size += (fwd_msg->buf_len + BUF_SIZE);
-			xrealloc(buffer->head, buffer->size);
-		}
+		if (remaining_buf(buffer) < fwd_msg->buf_len)
+			grow_buf(buffer, fwd_msg->buf_len);
 		if (fwd_msg->buf_len) {
 			memcpy(&buffer->head[buffer->processed],
 			       fwd_msg->buf, fwd_msg->buf_len);
@@ -168,6 +202,13 @@ void *_forward_thread(void *arg)
 				     get_buf_data(buffer),
 				     get_buf_offset(buffer),
 				     SLURM_PROTOCOL_NO_SEND_RECV_FLAGS ) < 0) {
+			if (cached) {
+				/* The peer may have closed the cached
+				 * connection, retry once on a new one */
+				debug("forward_thread: cached connection to "
+				      "%s failed: %m, retrying", name);
+				goto retry_new;
+			}
 			error("forward_thread: slurm_msg_sendto: %m");
 
 			slurm_mutex_lock(fwd_msg->forward_mutex);
@@ -218,6 +259,15 @@ void *_forward_thread(void *arg)
 		}
 
 		ret_list = slurm_receive_msgs(fd, steps, fwd_msg->timeout);
+		if (!ret_list && cached &&
+		    (errno != SLURM_PROTOCOL_SOCKET_IMPL_TIMEOUT)) {
+			/* Closed rather than timed out, so the message most
+			 * likely was never read, retry once on a new
+			 * connection */
+			debug("forward_thread: cached connection to %s "
+			      "failed: %m, retrying", name);
+			goto retry_new;
+		}
 		/* info("sent %d forwards got %d back", */
 /* 		     fwd_msg->header.forward.cnt, list_count(ret_list)); */
 
@@ -285,7 +335,20 @@ void *_forward_thread(void *arg)
 						       SLURM_COMMUNICATIONS_CONNECTION_ERROR);
 			}
 		}
+		if (fwd_msg->header.flags & SLURM_PERSIST_CONN) {
+			/* response fully read, keep the connection */
+			conn_cache_put(&addr, fd);
+			fd = -1;
+		}
 		break;
+
+	retry_new:
+		slurm_close_accepted_conn(fd);
+		fd = -1;
+		cached = false;
+		free_buf(buffer);
+		buffer = init_buf(fwd_msg->buf_len);
+		goto retry;
 	}
 	slurm_mutex_lock(fwd_msg->forward_mutex);
 	if (ret_list) {
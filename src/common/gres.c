@@ -174,6 +174,8 @@ static int	_load_gres_plugin(char *plugin_name,
 				  slurm_gres_context_t *plugin_context);
 static int	_log_gres_slurmd_conf(void *x, void *arg);
 static void	_my_stat(char *file_name);
+static bitstr_t *_node_cpu_bitmap(bitstr_t *cpu_bitmap, int cpu_start_bit,
+				  int cpus_ctld);
 static int	_node_config_init(char *node_name, char *orig_config,
 				  slurm_gres_context_t *context_ptr,
 				  gres_state_t *gres_ptr);
@@ -2545,12 +2547,32 @@ static void _validate_gres_node_cpus(gres_node_state_t *node_gres_ptr,
 	}
 }
 
+/* Copy the bits of a node's CPUs out of a cluster-wide cpu_bitmap, so that
+ * they can be compared with the node's topo_cpus_bitmap a word at a time.
+ * If cpu_bitmap is NULL, all of the node's CPUs are set. */
+static bitstr_t *_node_cpu_bitmap(bitstr_t *cpu_bitmap, int cpu_start_bit,
+				  int cpus_ctld)
+{
+	bitstr_t *node_cpu_bitmap = bit_alloc(cpus_ctld);
+	int i;
+
+	if (!cpu_bitmap) {
+		bit_nset(node_cpu_bitmap, 0, cpus_ctld - 1);
+		return node_cpu_bitmap;
+	}
+	for (i = 0; i < cpus_ctld; i++) {
+		if (bit_test(cpu_bitmap, cpu_start_bit + i))
+			bit_set(node_cpu_bitmap, i);
+	}
+	return node_cpu_bitmap;
+}
+
 static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 				 bool use_total_gres, bitstr_t *cpu_bitmap,
 				 int cpu_start_bit, int cpu_end_bit,
 				 char *gres_name, char *node_name)
 {
-	int i, j, cpus_ctld;
+	int i, cpus_ctld;
 	gres_job_state_t  *job_gres_ptr  = (gres_job_state_t *)  job_gres_data;
 	gres_node_state_t *node_gres_ptr = (gres_node_state_t *) node_gres_data;
 	bitstr_t *avail_cpu_bitmap = NULL;
@@ -2559,9 +2581,13 @@ static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 	    !job_gres_ptr->gres_cnt_alloc)		/* No job GRES */
 		return;
 
+	cpus_ctld = cpu_end_bit - cpu_start_bit + 1;
+	if (cpus_ctld < 1)
+		return;
+	_validate_gres_node_cpus(node_gres_ptr, cpus_ctld, node_name);
+
 	/* Determine which specific CPUs can be used */
-	avail_cpu_bitmap = bit_copy(cpu_bitmap);
-	bit_nclear(avail_cpu_bitmap, cpu_start_bit, cpu_end_bit);
+	avail_cpu_bitmap = bit_alloc(cpus_ctld);
 	for (i = 0; i < node_gres_ptr->topo_cnt; i++) {
 		if (node_gres_ptr->topo_gres_cnt_avail[i] == 0)
 			continue;
@@ -2569,16 +2595,12 @@ static void	_job_core_filter(void *job_gres_data, void *node_gres_data,
 		    (node_gres_ptr->topo_gres_cnt_alloc[i] >=
 		     node_gres_ptr->topo_gres_cnt_avail[i]))
 			continue;
-		cpus_ctld = cpu_end_bit - cpu_start_bit + 1;
-		_validate_gres_node_cpus(node_gres_ptr, cpus_ctld, node_name);
-		cpus_ctld = bit_size(node_gres_ptr->topo_cpus_bitmap[i]);
-		for (j = 0; j < cpus_ctld; j++) {
-			if (bit_test(node_gres_ptr->topo_cpus_bitmap[i], j)) {
-				bit_set(avail_cpu_bitmap, cpu_start_bit + j);
-			}
-		}
+		bit_or(avail_cpu_bitmap, node_gres_ptr->topo_cpus_bitmap[i]);
+	}
+	for (i = 0; i < cpus_ctld; i++) {
+		if (!bit_test(avail_cpu_bitmap, i))
+			bit_clear(cpu_bitmap, cpu_start_bit + i);
 	}
-	bit_and(cpu_bitmap, avail_cpu_bitmap);
 	FREE_NULL_BITMAP(avail_cpu_bitmap);
 }
 
@@ -2611,23 +2633,19 @@ extern uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			cpus_ctld = bit_size(node_gres_ptr->
 					     topo_cpus_bitmap[0]);
 		}
+		alloc_cpu_bitmap = _node_cpu_bitmap(cpu_bitmap, cpu_start_bit,
+						    cpus_ctld);
 		for (i=0; i<node_gres_ptr->topo_cnt; i++) {
-			for (j=0; j<cpus_ctld; j++) {
-				if (cpu_bitmap &&
-				    !bit_test(cpu_bitmap, cpu_start_bit+j))
-					continue;
-				if (!bit_test(node_gres_ptr->
-					      topo_cpus_bitmap[i], j))
-					continue; /* not avail for this gres */
-				gres_avail += node_gres_ptr->
-					      topo_gres_cnt_avail[i];
-				if (!use_total_gres) {
-					gres_avail -= node_gres_ptr->
-						      topo_gres_cnt_alloc[i];
-				}
-				break;
+			if (!bit_overlap(alloc_cpu_bitmap,
+					 node_gres_ptr->topo_cpus_bitmap[i]))
+				continue; /* not avail for this gres */
+			gres_avail += node_gres_ptr->topo_gres_cnt_avail[i];
+			if (!use_total_gres) {
+				gres_avail -= node_gres_ptr->
+					      topo_gres_cnt_alloc[i];
 			}
 		}
+		FREE_NULL_BITMAP(alloc_cpu_bitmap);
 		if (job_gres_ptr->gres_cnt_alloc > gres_avail)
 			return (uint32_t) 0;	/* insufficient, gres to use */
 		return NO_VAL;
@@ -2653,15 +2671,8 @@ extern uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 					     topo_cpus_bitmap[0]);
 		}
 
-		alloc_cpu_bitmap = bit_alloc(cpus_ctld);
-		if (cpu_bitmap) {
-			for (j = 0; j < cpus_ctld; j++) {
-				if (bit_test(cpu_bitmap, cpu_start_bit+j))
-					bit_set(alloc_cpu_bitmap, j);
-			}
-		} else {
-			bit_nset(alloc_cpu_bitmap, 0, cpus_ctld - 1);
-		}
+		alloc_cpu_bitmap = _node_cpu_bitmap(cpu_bitmap, cpu_start_bit,
+						    cpus_ctld);
 
 		cpus_avail = xmalloc(sizeof(uint32_t)*node_gres_ptr->topo_cnt);
 		for (i=0; i<node_gres_ptr->topo_cnt; i++) {
@@ -2671,15 +2682,9 @@ extern uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 			    (node_gres_ptr->topo_gres_cnt_alloc[i] >=
 			     node_gres_ptr->topo_gres_cnt_avail[i]))
 				continue;
-			for (j=0; j<cpus_ctld; j++) {
-				if (cpu_bitmap &&
-				    !bit_test(cpu_bitmap, cpu_start_bit+j))
-					continue;
-				if (bit_test(node_gres_ptr->
-					     topo_cpus_bitmap[i], j)) {
-					cpus_avail[i]++;
-				}
-			}
+			cpus_avail[i] = bit_overlap(alloc_cpu_bitmap,
+						    node_gres_ptr->
+						    topo_cpus_bitmap[i]);
 		}
 
 		/* Pick the topology entries with the most CPUs available */
@@ -2750,6 +2755,61 @@ extern uint32_t _job_test(void *job_gres_data, void *node_gres_data,
 	}
 }
 
+/*
+ * Determine if a node has enough GRES for a job by count alone, ignoring
+ *	CPU topology
+ * IN job_gres_list  - job's gres_list built by gres_plugin_job_state_validate()
+ * IN node_gres_list - node's gres_list built by
+ *                     gres_plugin_node_config_validate()
+ * IN use_total_gres - if set then consider all gres resources as available,
+ *		       and none are commited to running jobs
+ * RET true if the node has enough of every GRES the job requests
+ */
+extern bool gres_plugin_job_count_test(List job_gres_list, List node_gres_list,
+				       bool use_total_gres)
+{
+	ListIterator job_gres_iter;
+	gres_state_t *job_gres_ptr, *node_gres_ptr;
+	gres_job_state_t  *job_data_ptr;
+	gres_node_state_t *node_data_ptr;
+	uint32_t gres_avail;
+	bool rc = true;
+
+	if (job_gres_list == NULL)
+		return true;
+	if (node_gres_list == NULL)
+		return false;
+
+	/* No plugin context is needed here, just the state of each GRES */
+	job_gres_iter = list_iterator_create(job_gres_list);
+	while ((job_gres_ptr = (gres_state_t *) list_next(job_gres_iter))) {
+		job_data_ptr = (gres_job_state_t *) job_gres_ptr->gres_data;
+		if (job_data_ptr->gres_cnt_alloc == 0)
+			continue;
+		node_gres_ptr = list_find_first(node_gres_list, _gres_find_id,
+						&job_gres_ptr->plugin_id);
+		if (node_gres_ptr == NULL) {
+			rc = false;
+			break;
+		}
+		node_data_ptr = (gres_node_state_t *) node_gres_ptr->gres_data;
+		gres_avail = node_data_ptr->gres_cnt_avail;
+		if (!use_total_gres) {
+			if (node_data_ptr->gres_cnt_alloc >= gres_avail)
+				gres_avail = 0;
+			else
+				gres_avail -= node_data_ptr->gres_cnt_alloc;
+		}
+		if (job_data_ptr->gres_cnt_alloc > gres_avail) {
+			rc = false;
+			break;
+		}
+	}
+	list_iterator_destroy(job_gres_iter);
+
+	return rc;
+}
+
 /*
  * Clear the cpu_bitmap for CPUs which are not usable by this job (i.e. for
  *	CPUs which are already bound to other jobs or lack GRES)
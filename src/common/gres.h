@@ -391,6 +391,20 @@ extern int gres_plugin_job_state_unpack(List *gres_list, Buf buffer,
 					uint32_t job_id,
 					uint16_t protocol_version);
 
+/*
+ * Determine if a node has enough GRES for a job by count alone, ignoring
+ *	CPU topology. This is much faster than gres_plugin_job_test() and a
+ *	node which fails this test can not pass that one.
+ * IN job_gres_list  - job's gres_list built by gres_plugin_job_state_validate()
+ * IN node_gres_list - node's gres_list built by
+ *                     gres_plugin_node_config_validate()
+ * IN use_total_gres - if set then consider all gres resources as available,
+ *		       and none are commited to running jobs
+ * RET true if the node has enough of every GRES the job requests
+ */
+extern bool gres_plugin_job_count_test(List job_gres_list, List node_gres_list,
+				       bool use_total_gres);
+
 /*
  * Clear the cpu_bitmap for CPUs which are not usable by this job (i.e. for
  *	CPUs which are already bound to other jobs or lack GRES)
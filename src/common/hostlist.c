@@ -107,12 +107,14 @@ strong_alias(hostlist_iterator_reset,	slurm_hostlist_iterator_reset);
 strong_alias(hostlist_next,		slurm_hostlist_next);
 strong_alias(hostlist_next_range,	slurm_hostlist_next_range);
 strong_alias(hostlist_nth,		slurm_hostlist_nth);
+strong_alias(hostlist_nth_range,	slurm_hostlist_nth_range);
 strong_alias(hostlist_pop,		slurm_hostlist_pop);
 strong_alias(hostlist_pop_range,	slurm_hostlist_pop_range);
 strong_alias(hostlist_push,		slurm_hostlist_push);
 strong_alias(hostlist_push_host_dims,	slurm_hostlist_push_host_dims);
 strong_alias(hostlist_push_host,	slurm_hostlist_push_host);
 strong_alias(hostlist_push_list,	slurm_hostlist_push_list);
+strong_alias(hostlist_push_numbered,	slurm_hostlist_push_numbered);
 strong_alias(hostlist_ranged_string_dims,
 	                                slurm_hostlist_ranged_string_dims);
 strong_alias(hostlist_ranged_string,	slurm_hostlist_ranged_string);
@@ -2059,6 +2061,22 @@ int hostlist_push_host(hostlist_t hl, const char *str)
 	return hostlist_push_host_dims(hl, str, dims);
 }
 
+int hostlist_push_numbered(hostlist_t hl, const char *prefix,
+			   unsigned long lo, unsigned long hi, int width)
+{
+	hostrange_t hr;
+	int retval;
+
+	if (!hl || !prefix || (hi < lo))
+		return 0;
+
+	hr = hostrange_create((char *) prefix, lo, hi, width);
+	retval = hostlist_push_range(hl, hr);
+	hostrange_destroy(hr);
+
+	return (retval < 0) ? 0 : (int) (hi - lo + 1);
+}
+
 int hostlist_push_list(hostlist_t h1, hostlist_t h2)
 {
 	int i, n = 0;
@@ -2188,6 +2206,32 @@ char *hostlist_pop_range(hostlist_t hl)
 }
 
 
+char *hostlist_nth_range(hostlist_t hl, int n, unsigned long *lo,
+			 unsigned long *hi, int *width)
+{
+	hostrange_t hr;
+	char *prefix = NULL;
+
+	if (!hl)
+		return NULL;
+
+	LOCK_HOSTLIST(hl);
+	if ((n >= 0) && (n < hl->nranges)) {
+		hr = hl->hr[n];
+		if (!(prefix = strdup(hr->prefix))) {
+			UNLOCK_HOSTLIST(hl);
+			out_of_memory("hostlist nth range");
+		}
+		*lo = hr->lo;
+		*hi = hr->hi;
+		*width = hr->singlehost ? 0 : hr->width;
+	}
+	UNLOCK_HOSTLIST(hl);
+
+	return prefix;
+}
+
+
 char *hostlist_shift_range(hostlist_t hl)
 {
 	int i;
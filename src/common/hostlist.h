@@ -206,6 +206,19 @@ int hostlist_push_host_dims(hostlist_t hl, const char *str, int dims);
 int hostlist_push_host(hostlist_t hl, const char *host);
 
 
+/* hostlist_push_numbered():
+ *
+ * Push the hosts "prefix""lo" through "prefix""hi" onto the hostlist hl,
+ * with the numeric suffixes zero padded to width digits. This is cheaper
+ * than pushing each host since no host name is formatted or parsed.
+ * Only meaningful for one dimensional host names.
+ *
+ * Returns the number of hosts pushed, or 0 on failure.
+ */
+int hostlist_push_numbered(hostlist_t hl, const char *prefix,
+			   unsigned long lo, unsigned long hi, int width);
+
+
 /* hostlist_push_list():
  *
  * Push a hostlist (hl2) onto another list (hl1)
@@ -262,6 +275,20 @@ char * hostlist_pop_range(hostlist_t hl);
  */
 char * hostlist_shift_range(hostlist_t hl);
 
+/* hostlist_nth_range():
+ *
+ * Describe the n'th range of hosts in the hostlist hl, counting from zero
+ * up to hostlist_nranges(), without formatting any host name. Returns the
+ * prefix shared by the hosts and sets lo, hi and width to describe their
+ * numeric suffixes, which are only meaningful for one dimensional host
+ * names. A host with no numeric suffix is returned whole, with width set
+ * to zero. Returns NULL if there is no such range.
+ *
+ * Caller is responsible for freeing returned memory.
+ */
+char * hostlist_nth_range(hostlist_t hl, int n, unsigned long *lo,
+			  unsigned long *hi, int *width);
+
 
 /* hostlist_find():
  *
@@ -174,7 +174,7 @@ io_init_msg_validate(struct slurm_io_init_msg *msg, const char *sig)
 }
 
 
-static int
+int
 io_init_msg_packed_size(void)
 {
 	int len;
@@ -187,7 +187,7 @@ io_init_msg_packed_size(void)
 	return len;
 }
 
-static void
+void
 io_init_msg_pack(struct slurm_io_init_msg *hdr, Buf buffer)
 {
 	pack16(hdr->version, buffer);
@@ -199,7 +199,7 @@ io_init_msg_pack(struct slurm_io_init_msg *hdr, Buf buffer)
 }
 
 
-static int
+int
 io_init_msg_unpack(struct slurm_io_init_msg *hdr, Buf buffer)
 {
 	uint32_t val;
@@ -58,6 +58,8 @@
 #include "src/common/xmalloc.h"
 
 #define MAX_MSG_LEN 1024
+/* Largest stdout/stderr frame, used when the client sets TASK_LARGE_IO */
+#define IO_LARGE_MSG_LEN (64 * 1024)
 #define SLURM_IO_KEY_SIZE 8
 
 #define SLURM_IO_STDIN 0
@@ -65,6 +67,8 @@
 #define SLURM_IO_STDERR 2
 #define SLURM_IO_ALLSTDIN 3
 #define SLURM_IO_CONNECTION_TEST 4
+/* io init msg of a node whose stdio is relayed through the stdio tree */
+#define SLURM_IO_NODE_INIT 5
 
 struct slurm_io_init_msg {
 	uint16_t      version;
@@ -94,6 +98,9 @@ int io_hdr_read_fd(int fd, io_hdr_t *hdr);
  * Validate io init msg
  */
 int io_init_msg_validate(struct slurm_io_init_msg *msg, const char *sig);
+int io_init_msg_packed_size(void);
+void io_init_msg_pack(struct slurm_io_init_msg *hdr, Buf buffer);
+int io_init_msg_unpack(struct slurm_io_init_msg *hdr, Buf buffer);
 int io_init_msg_write_to_fd(int fd, struct slurm_io_init_msg *msg);
 int io_init_msg_read_from_fd(int fd, struct slurm_io_init_msg *msg);
 
@@ -73,7 +73,9 @@
 #include "src/common/slurm_acct_gather_energy.h"
 #include "src/common/slurm_ext_sensors.h"
 #include "src/common/slurm_topology.h"
+#include "src/common/working_cluster.h"
 #include "src/common/xassert.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
@@ -82,6 +84,7 @@
 /* Global variables */
 List config_list  = NULL;	/* list of config_record entries */
 List feature_list = NULL;	/* list of features_record entries */
+static xhash_t *feature_hash = NULL;	/* feature_list indexed by name */
 List front_end_list = NULL;	/* list of slurm_conf_frontend_t entries */
 time_t last_node_update = (time_t) 0;	/* time of last update */
 struct node_record *node_record_table_ptr = NULL;	/* node records */
@@ -91,47 +94,76 @@ int node_record_count = 0;		/* count in node_record_table_ptr */
 uint16_t *cr_node_num_cores = NULL;
 uint32_t *cr_node_cores_offset = NULL;
 
+/* A run of node_record_table_ptr entries whose names share a prefix and
+ * have consecutive numeric suffixes of the same width (e.g. "tux[08-15]").
+ * Nodes are converted between bitmaps and host lists a run at a time
+ * rather than a name at a time. */
+typedef struct node_name_range {
+	int first_inx;		/* node table index of first node */
+	unsigned long lo;	/* numeric suffix of first node */
+	int node_cnt;		/* count of nodes in range */
+	char *prefix;		/* node name less any numeric suffix */
+	int width;		/* digits in numeric suffix, 0 if none */
+} node_name_range_t;
+
+static node_name_range_t *name_range_table = NULL; /* in node index order */
+static node_name_range_t **name_range_sorted = NULL; /* numbered ranges, by
+						      * prefix then suffix */
+static int name_range_cnt = 0;		/* size of name_range_table */
+static int name_range_sorted_cnt = 0;	/* size of name_range_sorted */
+
 static void	_add_config_feature(char *feature, bitstr_t *node_bitmap);
+static void	_build_name_ranges (void);
 static int	_build_single_nodeline_info(slurm_conf_node_t *node_ptr,
 					    struct config_record *config_ptr);
 static int	_delete_config_record (void);
 #if _DEBUG
 static void	_dump_hash (void);
 #endif
+static const char *_feature_hash_id (void *feature_entry);
 static struct node_record *_find_alias_node_record (char *name);
 static struct node_record *_find_node_record (char *name, bool test_alias);
+static void	_free_name_ranges (void);
 static int	_hash_index (char *name);
 static void	_list_delete_config (void *config_entry);
 static void	_list_delete_feature (void *feature_entry);
 static int	_list_find_config (void *config_entry, void *key);
 static int	_list_find_feature (void *feature_entry, void *key);
+static int	_name_range2bitmap (char *prefix, unsigned long lo,
+				    unsigned long hi, int width,
+				    bitstr_t *bitmap);
+static int	_name_range_cmp (const void *a, const void *b);
+static int	_node_name2bit (char *name, bool best_effort,
+				bitstr_t *bitmap);
 
 
 static void _add_config_feature(char *feature, bitstr_t *node_bitmap)
 {
 	struct features_record *feature_ptr;
-	ListIterator feature_iter;
-	bool match = false;
 
 	/* If feature already exists in feature_list, just update the bitmap */
-	feature_iter = list_iterator_create(feature_list);
-	while ((feature_ptr = (struct features_record *)
-			list_next(feature_iter))) {
-		if (strcmp(feature, feature_ptr->name))
-			continue;
+	feature_ptr = find_feature_record(feature);
+	if (feature_ptr) {
 		bit_or(feature_ptr->node_bitmap, node_bitmap);
-		match = true;
-		break;
+		return;
 	}
-	list_iterator_destroy(feature_iter);
 
-	if (!match) {	/* Need to create new feature_list record */
-		feature_ptr = xmalloc(sizeof(struct features_record));
-		feature_ptr->magic = FEATURE_MAGIC;
-		feature_ptr->name = xstrdup(feature);
-		feature_ptr->node_bitmap = bit_copy(node_bitmap);
-		list_append(feature_list, feature_ptr);
-	}
+	/* Need to create new feature_list record */
+	feature_ptr = xmalloc(sizeof(struct features_record));
+	feature_ptr->magic = FEATURE_MAGIC;
+	feature_ptr->name = xstrdup(feature);
+	feature_ptr->node_bitmap = bit_copy(node_bitmap);
+	list_append(feature_list, feature_ptr);
+	if (!feature_hash)
+		feature_hash = xhash_init(_feature_hash_id, NULL, 0);
+	xhash_add(feature_hash, feature_ptr);
+}
+
+static const char *_feature_hash_id (void *feature_entry)
+{
+	struct features_record *feature_ptr = (struct features_record *)
+					     feature_entry;
+	return feature_ptr->name;
 }
 
 
@@ -309,6 +341,65 @@ cleanup:
 	return error_code;
 }
 
+/*
+ * _build_name_ranges - split node_record_table_ptr into runs of node names
+ *	with a common prefix and consecutive numeric suffixes, parsing names
+ *	the same way as hostlist. Not built for multi-dimensional names.
+ */
+static void _build_name_ranges (void)
+{
+	struct node_record *node_ptr = node_record_table_ptr;
+	node_name_range_t *range = NULL;
+	unsigned long num;
+	int i, len, prefix_len, width;
+
+	_free_name_ranges();
+	if ((node_record_count == 0) ||
+	    (slurmdb_setup_cluster_name_dims() != 1))
+		return;
+
+	name_range_table = xmalloc(sizeof(node_name_range_t) *
+				   node_record_count);
+	for (i = 0; i < node_record_count; i++, node_ptr++) {
+		if ((node_ptr->name == NULL) || (node_ptr->name[0] == '\0')) {
+			/* vestigial record, use the hostlist logic */
+			_free_name_ranges();
+			return;
+		}
+		len = strlen(node_ptr->name);
+		for (prefix_len = len; prefix_len > 0; prefix_len--) {
+			if (!isdigit((int) node_ptr->name[prefix_len - 1]))
+				break;
+		}
+		width = len - prefix_len;
+		num = width ? strtoul(node_ptr->name + prefix_len, NULL, 10) : 0;
+		if (range && width && (range->width == width) &&
+		    (range->lo + range->node_cnt == num) &&
+		    (strlen(range->prefix) == prefix_len) &&
+		    !strncmp(range->prefix, node_ptr->name, prefix_len)) {
+			range->node_cnt++;
+			continue;
+		}
+		range = &name_range_table[name_range_cnt++];
+		range->first_inx = i;
+		range->lo = num;
+		range->node_cnt = 1;
+		range->prefix = xstrndup(node_ptr->name, prefix_len);
+		range->width = width;
+	}
+	xrealloc(name_range_table, sizeof(node_name_range_t) * name_range_cnt);
+
+	name_range_sorted = xmalloc(sizeof(node_name_range_t *) *
+				    name_range_cnt);
+	for (i = 0; i < name_range_cnt; i++) {
+		if (name_range_table[i].width)
+			name_range_sorted[name_range_sorted_cnt++] =
+				&name_range_table[i];
+	}
+	qsort(name_range_sorted, name_range_sorted_cnt,
+	      sizeof(node_name_range_t *), _name_range_cmp);
+}
+
 /*
  * _delete_config_record - delete all configuration records
  * RET 0 if no error, errno otherwise
@@ -318,6 +409,8 @@ static int _delete_config_record (void)
 {
 	last_node_update = time (NULL);
 	(void) list_delete_all (config_list,    &_list_find_config,  NULL);
+	xhash_free(feature_hash);
+	feature_hash = NULL;
 	(void) list_delete_all (feature_list,   &_list_find_feature, NULL);
 	(void) list_delete_all (front_end_list, &list_find_frontend, NULL);
 	return SLURM_SUCCESS;
@@ -407,6 +500,19 @@ static struct node_record *_find_alias_node_record (char *name)
 	return (struct node_record *) NULL;
 }
 
+/* _free_name_ranges - free the node name ranges */
+static void _free_name_ranges (void)
+{
+	int i;
+
+	for (i = 0; i < name_range_cnt; i++)
+		xfree(name_range_table[i].prefix);
+	xfree(name_range_table);
+	xfree(name_range_sorted);
+	name_range_cnt = 0;
+	name_range_sorted_cnt = 0;
+}
+
 /*
  * _hash_index - return a hash table index for the given node name
  * IN name = the node's name
@@ -478,6 +584,87 @@ static int _list_find_config (void *config_entry, void *key)
 	return 0;
 }
 
+/*
+ * _name_range2bitmap - set the bits of nodes named "prefix""lo" through
+ *	"prefix""hi", suffixes zero padded to width digits, using the node
+ *	name ranges rather than looking up each name
+ * RET count of nodes found
+ */
+static int _name_range2bitmap (char *prefix, unsigned long lo,
+			       unsigned long hi, int width, bitstr_t *bitmap)
+{
+	node_name_range_t *range;
+	unsigned long first, last, min_num;
+	int i, j, rc, low = 0, high = name_range_sorted_cnt;
+	int match_cnt = 0;
+
+	/* find the first range with this prefix ending at or after lo */
+	while (low < high) {
+		i = (low + high) / 2;
+		range = name_range_sorted[i];
+		rc = strcmp(range->prefix, prefix);
+		if ((rc < 0) ||
+		    ((rc == 0) && (range->lo + range->node_cnt - 1 < lo)))
+			low = i + 1;
+		else
+			high = i;
+	}
+
+	for (i = low; i < name_range_sorted_cnt; i++) {
+		range = name_range_sorted[i];
+		if (strcmp(range->prefix, prefix) || (range->lo > hi))
+			break;
+		first = MAX(lo, range->lo);
+		last  = MIN(hi, range->lo + range->node_cnt - 1);
+		if (range->width != width) {
+			/* "n1" is not "n01", names only match where
+			 * neither suffix is zero padded */
+			min_num = 1;
+			for (j = 1; j < MAX(width, range->width); j++)
+				min_num *= 10;
+			first = MAX(first, min_num);
+		}
+		if (first > last)
+			continue;
+		bit_nset(bitmap, range->first_inx + (first - range->lo),
+			 range->first_inx + (last - range->lo));
+		match_cnt += last - first + 1;
+	}
+
+	return match_cnt;
+}
+
+/* _name_range_cmp - order node name ranges by prefix then suffix */
+static int _name_range_cmp (const void *a, const void *b)
+{
+	node_name_range_t *range_a = *(node_name_range_t **) a;
+	node_name_range_t *range_b = *(node_name_range_t **) b;
+	int rc;
+
+	if ((rc = strcmp(range_a->prefix, range_b->prefix)))
+		return rc;
+	if (range_a->lo < range_b->lo)
+		return -1;
+	return (range_a->lo > range_b->lo);
+}
+
+/*
+ * _node_name2bit - set the bit of one named node
+ * RET 0 if found or best_effort, otherwise EINVAL
+ */
+static int _node_name2bit (char *name, bool best_effort, bitstr_t *bitmap)
+{
+	struct node_record *node_ptr;
+
+	node_ptr = _find_node_record(name, best_effort);
+	if (node_ptr) {
+		bit_set(bitmap, (bitoff_t) (node_ptr - node_record_table_ptr));
+		return SLURM_SUCCESS;
+	}
+	error("node_name2bitmap: invalid node specified %s", name);
+	return best_effort ? SLURM_SUCCESS : EINVAL;
+}
+
 /*
  * bitmap2node_name_sortable - given a bitmap, build a list of comma
  *	separated node names. names may include regular expressions
@@ -503,10 +690,38 @@ char * bitmap2node_name_sortable (bitstr_t *bitmap, bool sort)
 
 	last  = bit_fls(bitmap);
 	hl = hostlist_create("");
-	for (i = first; i <= last; i++) {
-		if (bit_test(bitmap, i) == 0)
-			continue;
-		hostlist_push(hl, node_record_table_ptr[i].name);
+	if (name_range_table) {
+		/* push each run of set bits within a name range at once */
+		node_name_range_t *range = name_range_table;
+		node_name_range_t *range_end = name_range_table +
+					       name_range_cnt;
+		int end, j;
+		for (i = first; i <= last; i++) {
+			if (bit_test(bitmap, i) == 0)
+				continue;
+			while ((range < range_end) &&
+			       (i >= range->first_inx + range->node_cnt))
+				range++;
+			if (range == range_end)
+				break;
+			end = MIN(last, range->first_inx + range->node_cnt - 1);
+			for (j = i; (j < end) && bit_test(bitmap, j + 1); j++)
+				;
+			if (range->width) {
+				hostlist_push_numbered(hl, range->prefix,
+					range->lo + (i - range->first_inx),
+					range->lo + (j - range->first_inx),
+					range->width);
+			} else
+				hostlist_push_host(hl, range->prefix);
+			i = j;
+		}
+	} else {
+		for (i = first; i <= last; i++) {
+			if (bit_test(bitmap, i) == 0)
+				continue;
+			hostlist_push(hl, node_record_table_ptr[i].name);
+		}
 	}
 	if (sort)
 		hostlist_sort(hl);
@@ -821,6 +1036,18 @@ extern struct node_record *find_node_record (char *name)
 	return _find_node_record(name, true);
 }
 
+/*
+ * find_feature_record - find the feature_list record for a node feature
+ * IN name - name of the feature
+ * RET pointer to the feature record or NULL if no node has the feature
+ */
+extern struct features_record *find_feature_record(char *name)
+{
+	if (!name)
+		return NULL;
+	return (struct features_record *) xhash_get(feature_hash, name);
+}
+
 /*
  * _find_node_record - find a record for node with specified name
  * IN: name - name of the desired node
@@ -894,6 +1121,7 @@ extern int init_node_conf (void)
 	node_record_count = 0;
 	xfree(node_record_table_ptr);
 	xfree(node_hash_table);
+	_free_name_ranges();
 
 	if (config_list)	/* delete defunct configuration entries */
 		(void) _delete_config_record ();
@@ -916,6 +1144,8 @@ extern void node_fini2 (void)
 	if (config_list) {
 		list_destroy(config_list);
 		config_list = NULL;
+		xhash_free(feature_hash);
+		feature_hash = NULL;
 		list_destroy(feature_list);
 		feature_list = NULL;
 		list_destroy(front_end_list);
@@ -928,6 +1158,7 @@ extern void node_fini2 (void)
 
 	xfree(node_record_table_ptr);
 	xfree(node_hash_table);
+	_free_name_ranges();
 	node_record_count = 0;
 }
 
@@ -945,7 +1176,7 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 			     bitstr_t **bitmap)
 {
 	int rc = SLURM_SUCCESS;
-	char *this_node_name;
+	char *prefix, *this_node_name;
 	bitstr_t *my_bitmap;
 	hostlist_t host_list;
 
@@ -965,18 +1196,39 @@ extern int node_name2bitmap (char *node_names, bool best_effort,
 		return rc;
 	}
 
-	while ( (this_node_name = hostlist_shift (host_list)) ) {
-		struct node_record *node_ptr;
-		node_ptr = _find_node_record(this_node_name, best_effort);
-		if (node_ptr) {
-			bit_set (my_bitmap, (bitoff_t) (node_ptr -
-							node_record_table_ptr));
-		} else {
-			error ("node_name2bitmap: invalid node specified %s",
-			       this_node_name);
-			if (!best_effort)
-				rc = EINVAL;
+	if (name_range_table) {
+		unsigned long lo, hi, num;
+		int i, width;
+		for (i = 0; (prefix = hostlist_nth_range(host_list, i, &lo, &hi,
+							 &width)); i++) {
+			if (width == 0) {
+				if (_node_name2bit(prefix, best_effort,
+						   my_bitmap))
+					rc = EINVAL;
+			} else if (_name_range2bitmap(prefix, lo, hi, width,
+						      my_bitmap) <
+				   (int) (hi - lo + 1)) {
+				/* some names not found by range (bad names
+				 * or aliases), look up each one */
+				for (num = lo; num <= hi; num++) {
+					this_node_name = xstrdup_printf(
+						"%s%0*lu", prefix, width, num);
+					if (_node_name2bit(this_node_name,
+							   best_effort,
+							   my_bitmap))
+						rc = EINVAL;
+					xfree(this_node_name);
+				}
+			}
+			free(prefix);
 		}
+		hostlist_destroy(host_list);
+		return rc;
+	}
+
+	while ( (this_node_name = hostlist_shift (host_list)) ) {
+		if (_node_name2bit(this_node_name, best_effort, my_bitmap))
+			rc = EINVAL;
 		free (this_node_name);
 	}
 	hostlist_destroy (host_list);
@@ -1026,6 +1278,7 @@ extern void rehash_node (void)
 		node_ptr->node_next = node_hash_table[inx];
 		node_hash_table[inx] = node_ptr;
 	}
+	_build_name_ranges();
 
 #if _DEBUG
 	_dump_hash();
@@ -158,7 +158,12 @@ struct node_record {
 						 * use select_g_get_nodeinfo()
 						 * to access contents */
 	uint32_t cpu_load;		/* CPU load * 100 */
-
+	uint32_t change_seq;		/* node change sequence number when
+					 * the packed record last changed,
+					 * no need to save/restore */
+	uint64_t pack_digest;		/* hash of the packed record as of
+					 * change_seq, no need to
+					 * save/restore */
 };
 extern struct node_record *node_record_table_ptr;  /* ptr to node records */
 extern int node_record_count;		/* count in node_record_table_ptr */
@@ -238,6 +243,13 @@ extern struct node_record *create_node_record (
  */
 extern struct node_record *find_node_record (char *name);
 
+/*
+ * find_feature_record - find the feature_list record for a node feature
+ * IN name - name of the feature
+ * RET pointer to the feature record or NULL if no node has the feature
+ */
+extern struct features_record *find_feature_record(char *name);
+
 /*
  * init_node_conf - initialize the node configuration tables and values.
  *	this should be called before creating any node or configuration
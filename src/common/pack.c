@@ -1,6 +1,6 @@
 /****************************************************************************\
  *  pack.c - lowest level un/pack functions
- *  NOTE: The memory buffer will expand as needed using xrealloc()
+ *  NOTE: The memory buffer will expand as needed using xrealloc_nz()
  *****************************************************************************
  *  Copyright (C) 2002-2007 The Regents of the University of California.
  *  Copyright (C) 2008 Lawrence Livermore National Security.
@@ -99,6 +99,37 @@ strong_alias(unpackstr_array,	slurm_unpackstr_array);
 strong_alias(packmem_array,	slurm_packmem_array);
 strong_alias(unpackmem_array,	slurm_unpackmem_array);
 
+/* Make room in a buffer for at least size more bytes beyond its current
+ * offset. The buffer at least doubles in size (up to MAX_BUF_SIZE) so that
+ * packing a large message only reallocates and copies its data a few times.
+ * RET SLURM_SUCCESS or SLURM_ERROR if the buffer would become too large */
+static int _extend_buf(Buf buffer, uint32_t size, const char *func)
+{
+	uint64_t need, new_size;
+
+	need = (uint64_t) buffer->processed + size;
+	if (need > MAX_BUF_SIZE) {
+		error("%s: buffer size too large", func);
+		return SLURM_ERROR;
+	}
+	new_size = MAX((uint64_t) buffer->size * 2, need + BUF_SIZE);
+	if (new_size > MAX_BUF_SIZE)
+		new_size = MAX_BUF_SIZE;
+
+	buffer->size = (uint32_t) new_size;
+	xrealloc_nz(buffer->head, buffer->size);
+	return SLURM_SUCCESS;
+}
+
+/* Allocate size zeroed bytes for unpacked data, from the buffer's arena
+ * if it has one. Either way the result may be released with xfree() */
+static void *_unpack_alloc(Buf buffer, size_t size)
+{
+	if (buffer->arena)
+		return xarena_alloc(buffer->arena, size);
+	return xmalloc(size);
+}
+
 /* Basic buffer management routines */
 /* create_buf - create a buffer with the supplied contents, contents must
  * be xalloc'ed */
@@ -138,7 +169,7 @@ void grow_buf (Buf buffer, int size)
 	}
 
 	buffer->size += size;
-	xrealloc(buffer->head, buffer->size);
+	xrealloc_nz(buffer->head, buffer->size);
 }
 
 /* init_buf - create an empty buffer of the given size */
@@ -156,7 +187,7 @@ Buf init_buf(int size)
 	my_buf->magic = BUF_MAGIC;
 	my_buf->size = size;
 	my_buf->processed = 0;
-	my_buf->head = xmalloc(sizeof(char)*size);
+	my_buf->head = xmalloc_nz(sizeof(char)*size);
 	return my_buf;
 }
 
@@ -172,6 +203,23 @@ void *xfer_buf_data(Buf my_buf)
 	return data_ptr;
 }
 
+/* get_buf_digest - return a 64-bit FNV-1a hash of the data packed into a
+ * buffer between offset and its current offset, used to detect whether a
+ * record packs differently than it did before */
+uint64_t get_buf_digest(Buf buffer, uint32_t offset)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	unsigned char *data = (unsigned char *) buffer->head;
+	uint32_t i;
+
+	assert(buffer->magic == BUF_MAGIC);
+	for (i = offset; i < buffer->processed; i++) {
+		hash ^= data[i];
+		hash *= 0x100000001b3ULL;
+	}
+	return hash;
+}
+
 /*
  * Given a time_t in host byte order, promote it to int64_t, convert to
  * network byte order, store in buffer and adjust buffer acc'd'ngly
@@ -181,12 +229,8 @@ void pack_time(time_t val, Buf buffer)
 	int64_t n64 = HTON_int64((int64_t) val);
 
 	if (remaining_buf(buffer) < sizeof(n64)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("pack_time: buffer size too large");
+		if (_extend_buf(buffer, sizeof(n64), "pack_time"))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &n64, sizeof(n64));
@@ -225,12 +269,8 @@ void 	packdouble(double val, Buf buffer)
 	uval.d =  (val * FLOAT_MULT);
 	nl =  HTON_uint64(uval.u);
 	if (remaining_buf(buffer) < sizeof(nl)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("packdouble: buffer size too large");
+		if (_extend_buf(buffer, sizeof(nl), "packdouble"))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
@@ -271,12 +311,8 @@ void pack64(uint64_t val, Buf buffer)
 	uint64_t nl =  HTON_uint64(val);
 
 	if (remaining_buf(buffer) < sizeof(nl)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("pack64: buffer size too large");
+		if (_extend_buf(buffer, sizeof(nl), "pack64"))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
@@ -308,12 +344,8 @@ void pack32(uint32_t val, Buf buffer)
 	uint32_t nl = htonl(val);
 
 	if (remaining_buf(buffer) < sizeof(nl)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("pack32: buffer size too large");
+		if (_extend_buf(buffer, sizeof(nl), "pack32"))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &nl, sizeof(nl));
@@ -357,7 +389,7 @@ int unpack16_array(uint16_t ** valp, uint32_t * size_val, Buf buffer)
 	if (unpack32(size_val, buffer))
 		return SLURM_ERROR;
 if (*size_val > 4000000) abort();
-	*valp = xmalloc((*size_val) * sizeof(uint16_t));
+	*valp = _unpack_alloc(buffer, (*size_val) * sizeof(uint16_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack16((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -386,7 +418,7 @@ int unpack32_array(uint32_t ** valp, uint32_t * size_val, Buf buffer)
 	if (unpack32(size_val, buffer))
 		return SLURM_ERROR;
 
-	*valp = xmalloc((*size_val) * sizeof(uint32_t));
+	*valp = _unpack_alloc(buffer, (*size_val) * sizeof(uint32_t));
 	for (i = 0; i < *size_val; i++) {
 		if (unpack32((*valp) + i, buffer))
 			return SLURM_ERROR;
@@ -403,12 +435,8 @@ void pack16(uint16_t val, Buf buffer)
 	uint16_t ns = htons(val);
 
 	if (remaining_buf(buffer) < sizeof(ns)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("pack16: buffer size too large");
+		if (_extend_buf(buffer, sizeof(ns), "pack16"))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
@@ -439,12 +467,8 @@ int unpack16(uint16_t * valp, Buf buffer)
 void pack8(uint8_t val, Buf buffer)
 {
 	if (remaining_buf(buffer) < sizeof(uint8_t)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("pack8: buffer size too large");
+		if (_extend_buf(buffer, sizeof(uint8_t), "pack8"))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &val, sizeof(uint8_t));
@@ -475,12 +499,8 @@ void packmem(char *valp, uint32_t size_val, Buf buffer)
 	uint32_t ns = htonl(size_val);
 
 	if (remaining_buf(buffer) < (sizeof(ns) + size_val)) {
-		if (buffer->size > (MAX_BUF_SIZE -  size_val - BUF_SIZE)) {
-			error("packmem: buffer size too large");
+		if (_extend_buf(buffer, sizeof(ns) + size_val, "packmem"))
 			return;
-		}
-		buffer->size += (size_val + BUF_SIZE);
-		xrealloc(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
@@ -581,7 +601,7 @@ int unpackmem_xmalloc(char **valp, uint32_t * size_valp, Buf buffer)
 	else if (*size_valp > 0) {
 		if (remaining_buf(buffer) < *size_valp)
 			return SLURM_ERROR;
-		*valp = xmalloc(*size_valp);
+		*valp = _unpack_alloc(buffer, *size_valp);
 		memcpy(*valp, &buffer->head[buffer->processed],
 		       *size_valp);
 		buffer->processed += *size_valp;
@@ -638,12 +658,8 @@ void packstr_array(char **valp, uint32_t size_val, Buf buffer)
 	uint32_t ns = htonl(size_val);
 
 	if (remaining_buf(buffer) < sizeof(ns)) {
-		if (buffer->size > (MAX_BUF_SIZE - BUF_SIZE)) {
-			error("packstr_array: buffer size too large");
+		if (_extend_buf(buffer, sizeof(ns), "packstr_array"))
 			return;
-		}
-		buffer->size += BUF_SIZE;
-		xrealloc(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], &ns, sizeof(ns));
@@ -679,7 +695,8 @@ int unpackstr_array(char ***valp, uint32_t * size_valp, Buf buffer)
 	if (*size_valp > MAX_PACK_ARRAY_LEN)
 		return SLURM_ERROR;
 	else if (*size_valp > 0) {
-		*valp = xmalloc(sizeof(char *) * (*size_valp + 1));
+		*valp = _unpack_alloc(buffer,
+				      sizeof(char *) * (*size_valp + 1));
 		for (i = 0; i < *size_valp; i++) {
 			if (unpackmem_xmalloc(&(*valp)[i], &uint32_tmp, buffer))
 				return SLURM_ERROR;
@@ -698,12 +715,8 @@ int unpackstr_array(char ***valp, uint32_t * size_valp, Buf buffer)
 void packmem_array(char *valp, uint32_t size_val, Buf buffer)
 {
 	if (remaining_buf(buffer) < size_val) {
-		if (buffer->size > (MAX_BUF_SIZE - size_val - BUF_SIZE)) {
-			error("packmem_array: buffer size too large");
+		if (_extend_buf(buffer, size_val, "packmem_array"))
 			return;
-		}
-		buffer->size += (size_val + BUF_SIZE);
-		xrealloc(buffer->head, buffer->size);
 	}
 
 	memcpy(&buffer->head[buffer->processed], valp, size_val);
@@ -58,6 +58,8 @@
 #include <time.h>
 #include <string.h>
 
+#include "src/common/xmalloc.h"
+
 #define BUF_MAGIC 0x42554545
 #define BUF_SIZE (16 * 1024)
 #define MAX_BUF_SIZE ((uint32_t) 0xffff0000)	/* avoid going over 32-bits */
@@ -68,6 +70,7 @@ struct slurm_buf {
 	char *head;
 	uint32_t size;
 	uint32_t processed;
+	xarena_t *arena;	/* if set, unpacked data is allocated here */
 };
 
 typedef struct slurm_buf * Buf;
@@ -83,6 +86,7 @@ void	free_buf(Buf my_buf);
 Buf	init_buf(int size);
 void    grow_buf (Buf my_buf, int size);
 void	*xfer_buf_data(Buf my_buf);
+uint64_t get_buf_digest(Buf buffer, uint32_t offset);
 
 void	pack_time(time_t val, Buf buffer);
 int	unpack_time(time_t *valp, Buf buffer);
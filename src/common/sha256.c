@@ -0,0 +1,237 @@
+/*****************************************************************************\
+ *  sha256.c - SHA-256 message digest and HMAC
+ *****************************************************************************
+ *  Copyright (C) 2014 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * A plain implementation of SHA-256 (FIPS 180-4) and HMAC-SHA256, so that
+ * message authentication codes are available without an external crypto
+ * library.
+ */
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <string.h>
+
+#include "src/common/sha256.h"
+
+#define ROTR(x, n)	(((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)	(((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z)	(((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define EP0(x)		(ROTR(x, 2) ^ ROTR(x, 13) ^ ROTR(x, 22))
+#define EP1(x)		(ROTR(x, 6) ^ ROTR(x, 11) ^ ROTR(x, 25))
+#define SIG0(x)		(ROTR(x, 7) ^ ROTR(x, 18) ^ ((x) >> 3))
+#define SIG1(x)		(ROTR(x, 17) ^ ROTR(x, 19) ^ ((x) >> 10))
+
+static const uint32_t k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static void _transform(sha256_ctx_t *ctx, const unsigned char *data)
+{
+	uint32_t a, b, c, d, e, f, g, h, t1, t2, w[64];
+	int i;
+
+	for (i = 0; i < 16; i++) {
+		w[i] = ((uint32_t) data[i * 4] << 24) |
+		       ((uint32_t) data[i * 4 + 1] << 16) |
+		       ((uint32_t) data[i * 4 + 2] << 8) |
+		       ((uint32_t) data[i * 4 + 3]);
+	}
+	for ( ; i < 64; i++)
+		w[i] = SIG1(w[i - 2]) + w[i - 7] + SIG0(w[i - 15]) + w[i - 16];
+
+	a = ctx->state[0];
+	b = ctx->state[1];
+	c = ctx->state[2];
+	d = ctx->state[3];
+	e = ctx->state[4];
+	f = ctx->state[5];
+	g = ctx->state[6];
+	h = ctx->state[7];
+
+	for (i = 0; i < 64; i++) {
+		t1 = h + EP1(e) + CH(e, f, g) + k[i] + w[i];
+		t2 = EP0(a) + MAJ(a, b, c);
+		h = g;
+		g = f;
+		f = e;
+		e = d + t1;
+		d = c;
+		c = b;
+		b = a;
+		a = t1 + t2;
+	}
+
+	ctx->state[0] += a;
+	ctx->state[1] += b;
+	ctx->state[2] += c;
+	ctx->state[3] += d;
+	ctx->state[4] += e;
+	ctx->state[5] += f;
+	ctx->state[6] += g;
+	ctx->state[7] += h;
+}
+
+extern void sha256_init(sha256_ctx_t *ctx)
+{
+	ctx->state[0] = 0x6a09e667;
+	ctx->state[1] = 0xbb67ae85;
+	ctx->state[2] = 0x3c6ef372;
+	ctx->state[3] = 0xa54ff53a;
+	ctx->state[4] = 0x510e527f;
+	ctx->state[5] = 0x9b05688c;
+	ctx->state[6] = 0x1f83d9ab;
+	ctx->state[7] = 0x5be0cd19;
+	ctx->count = 0;
+}
+
+extern void sha256_update(sha256_ctx_t *ctx, const void *data, size_t len)
+{
+	const unsigned char *ptr = data;
+	size_t used = ctx->count % SHA256_BLOCK_LEN;
+	size_t fill;
+
+	ctx->count += len;
+	if (used) {
+		fill = SHA256_BLOCK_LEN - used;
+		if (len < fill) {
+			memcpy(ctx->block + used, ptr, len);
+			return;
+		}
+		memcpy(ctx->block + used, ptr, fill);
+		_transform(ctx, ctx->block);
+		ptr += fill;
+		len -= fill;
+	}
+	while (len >= SHA256_BLOCK_LEN) {
+		_transform(ctx, ptr);
+		ptr += SHA256_BLOCK_LEN;
+		len -= SHA256_BLOCK_LEN;
+	}
+	if (len)
+		memcpy(ctx->block, ptr, len);
+}
+
+extern void sha256_final(sha256_ctx_t *ctx,
+			 unsigned char digest[SHA256_DIGEST_LEN])
+{
+	uint64_t bits = ctx->count * 8;
+	size_t used = ctx->count % SHA256_BLOCK_LEN;
+	int i;
+
+	ctx->block[used++] = 0x80;
+	if (used > SHA256_BLOCK_LEN - 8) {
+		memset(ctx->block + used, 0, SHA256_BLOCK_LEN - used);
+		_transform(ctx, ctx->block);
+		used = 0;
+	}
+	memset(ctx->block + used, 0, SHA256_BLOCK_LEN - 8 - used);
+	for (i = 0; i < 8; i++)
+		ctx->block[SHA256_BLOCK_LEN - 1 - i] = (bits >> (i * 8)) & 0xff;
+	_transform(ctx, ctx->block);
+
+	for (i = 0; i < 8; i++) {
+		digest[i * 4]     = (ctx->state[i] >> 24) & 0xff;
+		digest[i * 4 + 1] = (ctx->state[i] >> 16) & 0xff;
+		digest[i * 4 + 2] = (ctx->state[i] >> 8) & 0xff;
+		digest[i * 4 + 3] = ctx->state[i] & 0xff;
+	}
+	memset(ctx, 0, sizeof(sha256_ctx_t));
+}
+
+extern void hmac_sha256_init(hmac_sha256_ctx_t *ctx,
+			     const void *key, size_t key_len)
+{
+	unsigned char pad[SHA256_BLOCK_LEN];
+	unsigned char key_hash[SHA256_DIGEST_LEN];
+	const unsigned char *key_ptr = key;
+	int i;
+
+	if (key_len > SHA256_BLOCK_LEN) {
+		sha256_init(&ctx->inner);
+		sha256_update(&ctx->inner, key, key_len);
+		sha256_final(&ctx->inner, key_hash);
+		key_ptr = key_hash;
+		key_len = SHA256_DIGEST_LEN;
+	}
+
+	memset(pad, 0x36, sizeof(pad));
+	for (i = 0; i < key_len; i++)
+		pad[i] ^= key_ptr[i];
+	sha256_init(&ctx->inner);
+	sha256_update(&ctx->inner, pad, sizeof(pad));
+
+	memset(pad, 0x5c, sizeof(pad));
+	for (i = 0; i < key_len; i++)
+		pad[i] ^= key_ptr[i];
+	sha256_init(&ctx->outer);
+	sha256_update(&ctx->outer, pad, sizeof(pad));
+
+	memset(pad, 0, sizeof(pad));
+	memset(key_hash, 0, sizeof(key_hash));
+}
+
+extern void hmac_sha256_update(hmac_sha256_ctx_t *ctx,
+			       const void *data, size_t len)
+{
+	sha256_update(&ctx->inner, data, len);
+}
+
+extern void hmac_sha256_final(hmac_sha256_ctx_t *ctx,
+			      unsigned char digest[SHA256_DIGEST_LEN])
+{
+	unsigned char inner_digest[SHA256_DIGEST_LEN];
+
+	sha256_final(&ctx->inner, inner_digest);
+	sha256_update(&ctx->outer, inner_digest, sizeof(inner_digest));
+	sha256_final(&ctx->outer, digest);
+	memset(inner_digest, 0, sizeof(inner_digest));
+}
@@ -0,0 +1,84 @@
+/*****************************************************************************\
+ *  sha256.h - SHA-256 message digest and HMAC
+ *****************************************************************************
+ *  Copyright (C) 2014 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _SHA256_H
+#define _SHA256_H
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#  if HAVE_INTTYPES_H
+#    include <inttypes.h>
+#  else
+#    if HAVE_STDINT_H
+#      include <stdint.h>
+#    endif
+#  endif  /* HAVE_INTTYPES_H */
+#else   /* !HAVE_CONFIG_H */
+#  include <inttypes.h>
+#endif  /*  HAVE_CONFIG_H */
+
+#include <stddef.h>
+
+#define SHA256_BLOCK_LEN	64
+#define SHA256_DIGEST_LEN	32
+
+typedef struct sha256_ctx {
+	uint32_t state[8];
+	uint64_t count;			/* bytes hashed so far */
+	unsigned char block[SHA256_BLOCK_LEN];
+} sha256_ctx_t;
+
+typedef struct hmac_sha256_ctx {
+	sha256_ctx_t inner;
+	sha256_ctx_t outer;
+} hmac_sha256_ctx_t;
+
+extern void sha256_init(sha256_ctx_t *ctx);
+extern void sha256_update(sha256_ctx_t *ctx, const void *data, size_t len);
+extern void sha256_final(sha256_ctx_t *ctx,
+			 unsigned char digest[SHA256_DIGEST_LEN]);
+
+/*
+ * HMAC-SHA256 (RFC 2104).  An initialized context may be copied and the
+ * copy used for each message, saving the two key blocks per message.
+ */
+extern void hmac_sha256_init(hmac_sha256_ctx_t *ctx,
+			     const void *key, size_t key_len);
+extern void hmac_sha256_update(hmac_sha256_ctx_t *ctx,
+			       const void *data, size_t len);
+extern void hmac_sha256_final(hmac_sha256_ctx_t *ctx,
+			      unsigned char digest[SHA256_DIGEST_LEN]);
+
+#endif /* !_SHA256_H */
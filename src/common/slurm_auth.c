@@ -72,6 +72,11 @@ typedef struct slurm_auth_ops {
         int          (*print)     ( void *cred, FILE *fp );
         int          (*sa_errno)  ( void *cred );
         const char * (*sa_errstr) ( int slurm_errno );
+        void *       (*create_data) ( void *argv[], char *auth_info,
+				      char *data, int len, uid_t reader );
+        int          (*get_data)  ( void *cred, char **data, int *len,
+				    char *auth_info );
+        void *       (*create_trusted) ( uid_t uid, gid_t gid );
 } slurm_auth_ops_t;
 /*
  * These strings must be kept in the same order as the fields
@@ -87,7 +92,10 @@ static const char *syms[] = {
 	"slurm_auth_unpack",
 	"slurm_auth_print",
 	"slurm_auth_errno",
-	"slurm_auth_errstr"
+	"slurm_auth_errstr",
+	"slurm_auth_create_data",
+	"slurm_auth_get_data",
+	"slurm_auth_create_trusted"
 };
 
 /*
@@ -325,3 +333,46 @@ g_slurm_auth_errstr( int slurm_errno )
 
         return (*(ops.sa_errstr))( slurm_errno );
 }
+
+void *
+g_slurm_auth_create_data( void *hosts, int timeout, char *auth_info,
+			  char *data, int len, uid_t reader )
+{
+        void **argv;
+        void *ret;
+
+	if ( slurm_auth_init(NULL) < 0 )
+		return NULL;
+
+	if ( auth_dummy )
+		return xmalloc(0);
+
+        if ( ( argv = _slurm_auth_marshal_args(hosts, timeout) ) == NULL ) {
+                return NULL;
+        }
+
+        ret = (*(ops.create_data))( argv, auth_info, data, len, reader );
+        xfree( argv );
+        return ret;
+}
+
+int
+g_slurm_auth_get_data( void *cred, char **data, int *len, char *auth_info )
+{
+	if (( slurm_auth_init(NULL) < 0 ) || auth_dummy )
+                return SLURM_ERROR;
+
+        return (*(ops.get_data))( cred, data, len, auth_info );
+}
+
+void *
+g_slurm_auth_create_trusted( uid_t uid, gid_t gid )
+{
+	if ( slurm_auth_init(NULL) < 0 )
+		return NULL;
+
+	if ( auth_dummy )
+		return xmalloc(0);
+
+        return (*(ops.create_trusted))( uid, gid );
+}
@@ -163,4 +163,26 @@ int	g_slurm_auth_print( void *cred, FILE *fp );
 int	g_slurm_auth_errno( void *cred );
 const char *g_slurm_auth_errstr( int slurm_errno );
 
+/*
+ * Create a credential which also carries "len" bytes of application data
+ * to the peer, protected as well as the credential itself permits.
+ * IN reader - only this user should be able to retrieve the data
+ */
+extern void *	g_slurm_auth_create_data( void *hosts, int timeout,
+					  char *auth_info, char *data, int len,
+					  uid_t reader );
+/*
+ * Retrieve the application data carried by a verified credential.
+ * OUT data - xmalloc'd copy of the data, must be xfree'd by the caller
+ * OUT len - size of data
+ */
+extern int	g_slurm_auth_get_data( void *cred, char **data, int *len,
+				       char *auth_info );
+/*
+ * Create a credential for a message whose sender was authenticated by
+ * other means (e.g. an established session).  The credential is never
+ * packed, it only answers g_slurm_auth_get_uid/gid() for the message.
+ */
+extern void *	g_slurm_auth_create_trusted( uid_t uid, gid_t gid );
+
 #endif /*__SLURM_AUTHENTICATION_H__*/
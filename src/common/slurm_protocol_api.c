@@ -52,13 +52,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <time.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <arpa/inet.h>
 
 /* PROJECT INCLUDES */
+#include "src/common/auth_session.h"
+#include "src/common/conn_cache.h"
 #include "src/common/fd.h"
 #include "src/common/macros.h"
 #include "src/common/pack.h"
@@ -94,6 +98,9 @@ static char *_get_auth_info(void);
 static char *_global_auth_key(void);
 static void  _remap_slurmctld_errno(void);
 static int   _unpack_msg_uid(Buf buffer);
+static bool  _msg_use_arena(uint16_t msg_type);
+static void  _msg_arena_init(slurm_msg_t *msg, Buf buffer);
+static void  _msg_arena_fini(slurm_msg_t *msg);
 
 #if _DEBUG
 static void _print_data(char *data, int len);
@@ -778,6 +785,21 @@ char *slurm_get_auth_type(void)
 	return auth_type;
 }
 
+/* slurm_get_auth_info
+ * returns the authentication plugin options from slurmctld_conf object
+ * RET char *    - auth info, MUST be xfreed by caller
+ */
+char *slurm_get_auth_info(void)
+{
+	char *auth_info;
+	slurm_ctl_conf_t *conf;
+
+	conf = slurm_conf_lock();
+	auth_info = xstrdup(conf->authinfo);
+	slurm_conf_unlock();
+	return auth_info;
+}
+
 /* slurm_get_checkpoint_type
  * returns the checkpoint_type from slurmctld_conf object
  * RET char *    - checkpoint type, MUST be xfreed by caller
@@ -1074,6 +1096,23 @@ char *slurm_get_slurmctld_plugstack(void)
 	return slurmctld_plugstack;
 }
 
+/* slurm_get_slurmd_params
+ * get slurmd_params from slurmctld_conf object
+ * RET char *   - slurmd_params, MUST be xfreed by caller
+ */
+char *slurm_get_slurmd_params(void)
+{
+	char *slurmd_params = NULL;
+	slurm_ctl_conf_t *conf;
+
+	if (!slurmdbd_conf) {
+		conf = slurm_conf_lock();
+		slurmd_params = xstrdup(conf->slurmd_params);
+		slurm_conf_unlock();
+	}
+	return slurmd_params;
+}
+
 /* slurm_get_slurmd_plugstack
  * get slurmd_plugstack from slurmd_conf object from
  * slurmd_conf object
@@ -2254,6 +2293,7 @@ int slurm_shutdown_msg_engine(slurm_fd_t fd)
  */
 int slurm_shutdown_msg_conn(slurm_fd_t fd)
 {
+	auth_session_close(fd);
 	return _slurm_close(fd);
 }
 
@@ -2421,6 +2461,7 @@ slurm_fd_t slurm_accept_msg_conn(slurm_fd_t open_fd,
  */
 int slurm_close_accepted_conn(slurm_fd_t open_fd)
 {
+	auth_session_close(open_fd);
 	return _slurm_close_accepted_conn(open_fd);
 }
 
@@ -2428,6 +2469,111 @@ int slurm_close_accepted_conn(slurm_fd_t open_fd)
  * receive message functions
 \**********************************************************************/
 
+/*
+ * Establish the session announced by the credential which follows the
+ * header of a message with SLURM_SESSION_INIT set, see auth_session.c
+ * IN/OUT buffer - positioned after the header, left after the credential
+ */
+static int _unpack_session_init(slurm_fd_t fd, header_t *header, Buf buffer)
+{
+	void *auth_cred;
+	char *key = NULL;
+	int key_len = 0, rc = SLURM_SUCCESS;
+
+	/* A token only authenticates the message for this hop */
+	if ((header->flags & SLURM_AUTH_SESSION) && (header->forward.cnt > 0)) {
+		error("authentication: session token on message to forward");
+		return SLURM_PROTOCOL_AUTHENTICATION_ERROR;
+	}
+	if (!(header->flags & SLURM_SESSION_INIT))
+		return SLURM_SUCCESS;
+
+	if ((auth_cred = g_slurm_auth_unpack(buffer)) == NULL) {
+		error("authentication: %s ",
+		      g_slurm_auth_errstr(g_slurm_auth_errno(NULL)));
+		return ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+	}
+	if ((g_slurm_auth_verify(auth_cred, NULL, 2, _get_auth_info())
+	     != SLURM_SUCCESS) ||
+	    (g_slurm_auth_get_data(auth_cred, &key, &key_len,
+				   _get_auth_info()) != SLURM_SUCCESS)) {
+		error("authentication: %s ",
+		      g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
+		rc = SLURM_PROTOCOL_AUTHENTICATION_ERROR;
+	} else if (auth_session_accept(
+			   fd, key, key_len,
+			   g_slurm_auth_get_uid(auth_cred, _get_auth_info()),
+			   g_slurm_auth_get_gid(auth_cred, _get_auth_info()))
+		   != SLURM_SUCCESS) {
+		rc = SLURM_PROTOCOL_AUTHENTICATION_ERROR;
+	}
+	if (key) {
+		memset(key, 0, key_len);
+		xfree(key);
+	}
+	(void) g_slurm_auth_destroy(auth_cred);
+
+	return rc;
+}
+
+/*
+ * Unpack and verify the authentication of a message, either a credential
+ * or a session token covering the header and body.
+ * IN hdr_len - size of the header packed at the start of buffer
+ * IN/OUT buffer - positioned at the authentication, left at the body
+ * OUT auth_cred - credential for the message, to be destroyed by the caller
+ * RET SLURM_SUCCESS or error code
+ */
+static int _unpack_msg_auth(slurm_fd_t fd, header_t *header, uint32_t hdr_len,
+			    Buf buffer, void **auth_cred)
+{
+	struct iovec iov[2];
+	char *token;
+	uid_t uid;
+	gid_t gid;
+	int rc;
+
+	if (header->flags & SLURM_AUTH_SESSION) {
+		if (remaining_buf(buffer) < AUTH_SESSION_TOKEN_LEN)
+			return ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		token = &buffer->head[buffer->processed];
+		buffer->processed += AUTH_SESSION_TOKEN_LEN;
+		iov[0].iov_base = get_buf_data(buffer);
+		iov[0].iov_len  = hdr_len;
+		iov[1].iov_base = &buffer->head[buffer->processed];
+		iov[1].iov_len  = remaining_buf(buffer);
+		if (auth_session_verify(fd, iov, 2, token, &uid, &gid) !=
+		    SLURM_SUCCESS)
+			return SLURM_PROTOCOL_AUTHENTICATION_ERROR;
+		if ((*auth_cred = g_slurm_auth_create_trusted(uid, gid)) ==
+		    NULL)
+			return SLURM_PROTOCOL_AUTHENTICATION_ERROR;
+		return SLURM_SUCCESS;
+	}
+
+	if ((*auth_cred = g_slurm_auth_unpack(buffer)) == NULL) {
+		error( "authentication: %s ",
+		       g_slurm_auth_errstr(g_slurm_auth_errno(NULL)));
+		return ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+	}
+	if (header->flags & SLURM_GLOBAL_AUTH_KEY) {
+		rc = g_slurm_auth_verify( *auth_cred, NULL, 2,
+					  _global_auth_key() );
+	} else {
+		rc = g_slurm_auth_verify( *auth_cred, NULL, 2,
+					  _get_auth_info() );
+	}
+
+	if (rc != SLURM_SUCCESS) {
+		error( "authentication: %s ",
+		       g_slurm_auth_errstr(g_slurm_auth_errno(*auth_cred)));
+		(void) g_slurm_auth_destroy(*auth_cred);
+		*auth_cred = NULL;
+		return SLURM_PROTOCOL_AUTHENTICATION_ERROR;
+	}
+	return SLURM_SUCCESS;
+}
+
 /*
  * NOTE: memory is allocated for the returned msg must be freed at
  *       some point using the slurm_free_functions.
@@ -2441,6 +2587,7 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 	char *buf = NULL;
 	size_t buflen = 0;
 	header_t header;
+	uint32_t hdr_len;
 	int rc;
 	void *auth_cred = NULL;
 	Buf buffer;
@@ -2484,6 +2631,7 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 		rc = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
 		goto total_return;
 	}
+	hdr_len = get_buf_offset(buffer);
 
 	if (check_header_version(&header) < 0) {
 		slurm_addr_t resp_addr;
@@ -2520,27 +2668,15 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 		      "slurm_receive_msg_and_forward instead");
 	}
 
-	if ((auth_cred = g_slurm_auth_unpack(buffer)) == NULL) {
-		error( "authentication: %s ",
-		       g_slurm_auth_errstr(g_slurm_auth_errno(NULL)));
+	if ((rc = _unpack_session_init(fd, &header, buffer)) !=
+	    SLURM_SUCCESS) {
 		free_buf(buffer);
-		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		goto total_return;
 	}
-	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2,
-					  _global_auth_key() );
-	} else {
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2,
-					  _get_auth_info() );
-	}
 
-	if (rc != SLURM_SUCCESS) {
-		error( "authentication: %s ",
-		       g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
-		(void) g_slurm_auth_destroy(auth_cred);
+	if ((rc = _unpack_msg_auth(fd, &header, hdr_len, buffer,
+				   &auth_cred)) != SLURM_SUCCESS) {
 		free_buf(buffer);
-		rc = SLURM_PROTOCOL_AUTHENTICATION_ERROR;
 		goto total_return;
 	}
 
@@ -2549,12 +2685,14 @@ int slurm_receive_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 	 */
 	msg->protocol_version = header.version;
 	msg->msg_type = header.msg_type;
-	msg->flags = header.flags;
+	msg->flags = header.flags & ~(SLURM_SESSION_INIT | SLURM_AUTH_SESSION);
 
+	_msg_arena_init(msg, buffer);
 	if ((header.body_length > remaining_buf(buffer)) ||
 	    (unpack_msg(msg, buffer) != SLURM_SUCCESS)) {
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		(void) g_slurm_auth_destroy(auth_cred);
+		_msg_arena_fini(msg);
 		free_buf(buffer);
 		goto total_return;
 	}
@@ -2595,6 +2733,7 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
 	char *buf = NULL;
 	size_t buflen = 0;
 	header_t header;
+	uint32_t hdr_len;
 	int rc;
 	void *auth_cred = NULL;
 	slurm_msg_t msg;
@@ -2661,6 +2800,7 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
 		rc = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
 		goto total_return;
 	}
+	hdr_len = get_buf_offset(buffer);
 
 	if (check_header_version(&header) < 0) {
 		slurm_addr_t resp_addr;
@@ -2697,27 +2837,15 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
 		      "slurm_receive_msg_and_forward instead");
 	}
 
-	if ((auth_cred = g_slurm_auth_unpack(buffer)) == NULL) {
-		error( "authentication: %s ",
-		       g_slurm_auth_errstr(g_slurm_auth_errno(NULL)));
+	if ((rc = _unpack_session_init(fd, &header, buffer)) !=
+	    SLURM_SUCCESS) {
 		free_buf(buffer);
-		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		goto total_return;
 	}
-	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2,
-					  _global_auth_key() );
-	} else {
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2,
-					  _get_auth_info() );
-	}
 
-	if (rc != SLURM_SUCCESS) {
-		error("authentication: %s ",
-		      g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
-		(void) g_slurm_auth_destroy(auth_cred);
+	if ((rc = _unpack_msg_auth(fd, &header, hdr_len, buffer,
+				   &auth_cred)) != SLURM_SUCCESS) {
 		free_buf(buffer);
-		rc = SLURM_PROTOCOL_AUTHENTICATION_ERROR;
 		goto total_return;
 	}
 
@@ -2726,7 +2854,7 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout)
 	 */
 	msg.protocol_version = header.version;
 	msg.msg_type = header.msg_type;
-	msg.flags = header.flags;
+	msg.flags = header.flags & ~(SLURM_SESSION_INIT | SLURM_AUTH_SESSION);
 
 	if ((header.body_length > remaining_buf(buffer)) ||
 	    (unpack_msg(&msg, buffer) != SLURM_SUCCESS)) {
@@ -2772,6 +2900,41 @@ total_return:
 
 /* try to determine the UID associated with a message with different
  * message header version, return -1 if we can't tell */
+/*
+ * Message types whose data is unpacked into a per-message arena, which is
+ * released in one shot by slurm_free_msg() rather than piece by piece.
+ * Only list types which are received by daemons that call slurm_free_msg()
+ * and whose handlers keep no pointer into the message data beyond the RPC.
+ */
+static bool _msg_use_arena(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_LAUNCH_TASKS:
+	case REQUEST_STEP_COMPLETE:
+	case REQUEST_COMPLETE_BATCH_SCRIPT:
+	case MESSAGE_EPILOG_COMPLETE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static void _msg_arena_init(slurm_msg_t *msg, Buf buffer)
+{
+	if (!_msg_use_arena(msg->msg_type))
+		return;
+	msg->arena = xarena_create();
+	buffer->arena = msg->arena;
+}
+
+static void _msg_arena_fini(slurm_msg_t *msg)
+{
+	if (msg->arena) {
+		xarena_destroy(msg->arena);
+		msg->arena = NULL;
+	}
+}
+
 static int _unpack_msg_uid(Buf buffer)
 {
 	int uid = -1;
@@ -2801,6 +2964,7 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 	char *buf = NULL;
 	size_t buflen = 0;
 	header_t header;
+	uint32_t hdr_len;
 	int rc;
 	void *auth_cred = NULL;
 	Buf buffer;
@@ -2859,6 +3023,7 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 		rc = SLURM_COMMUNICATIONS_RECEIVE_ERROR;
 		goto total_return;
 	}
+	hdr_len = get_buf_offset(buffer);
 
 	if (check_header_version(&header) < 0) {
 		slurm_addr_t resp_addr;
@@ -2906,6 +3071,12 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 		memcpy(&header.orig_addr, orig_addr, sizeof(slurm_addr_t));
 	}
 
+	if ((rc = _unpack_session_init(fd, &header, buffer)) !=
+	    SLURM_SUCCESS) {
+		free_buf(buffer);
+		goto total_return;
+	}
+
 	/* Forward message to other nodes */
 	if (header.forward.cnt > 0) {
 		debug2("forwarding to %u", header.forward.cnt);
@@ -2939,27 +3110,9 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 		}
 	}
 
-	if ((auth_cred = g_slurm_auth_unpack(buffer)) == NULL) {
-		error( "authentication: %s ",
-		       g_slurm_auth_errstr(g_slurm_auth_errno(NULL)));
+	if ((rc = _unpack_msg_auth(fd, &header, hdr_len, buffer,
+				   &auth_cred)) != SLURM_SUCCESS) {
 		free_buf(buffer);
-		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
-		goto total_return;
-	}
-	if (header.flags & SLURM_GLOBAL_AUTH_KEY) {
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2,
-					  _global_auth_key() );
-	} else {
-		rc = g_slurm_auth_verify( auth_cred, NULL, 2,
-					  _get_auth_info() );
-	}
-
-	if (rc != SLURM_SUCCESS) {
-		error( "authentication: %s ",
-		       g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
-		(void) g_slurm_auth_destroy(auth_cred);
-		free_buf(buffer);
-		rc = SLURM_PROTOCOL_AUTHENTICATION_ERROR;
 		goto total_return;
 	}
 
@@ -2968,11 +3121,13 @@ int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 	 */
 	msg->protocol_version = header.version;
 	msg->msg_type = header.msg_type;
-	msg->flags = header.flags;
+	msg->flags = header.flags & ~(SLURM_SESSION_INIT | SLURM_AUTH_SESSION);
 
+	_msg_arena_init(msg, buffer);
 	if ( (header.body_length > remaining_buf(buffer)) ||
 	     (unpack_msg(msg, buffer) != SLURM_SUCCESS) ) {
 		(void) g_slurm_auth_destroy(auth_cred);
+		_msg_arena_fini(msg);
 		free_buf(buffer);
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		goto total_return;
@@ -3001,6 +3156,31 @@ total_return:
 
 }
 
+/*
+ * The message length sent by _slurm_msg_sendto_timeout() is followed by
+ * the header as packed by pack_header(): version, flags, then msg_type.
+ */
+int slurm_peek_msg_type(slurm_fd_t fd, uint16_t *msg_type)
+{
+	unsigned char buf[sizeof(uint32_t) + 3 * sizeof(uint16_t)];
+	uint16_t type;
+	ssize_t len;
+
+	len = recv(fd, buf, sizeof(buf), MSG_PEEK | MSG_DONTWAIT);
+	if (len == sizeof(buf)) {
+		memcpy(&type, buf + sizeof(uint32_t) + 2 * sizeof(uint16_t),
+		       sizeof(type));
+		*msg_type = ntohs(type);
+		return 1;
+	}
+	if (len > 0)
+		return 0;
+	if ((len < 0) &&
+	    ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)))
+		return 0;
+	return -1;
+}
+
 /**********************************************************************\
  * send message functions
 \**********************************************************************/
@@ -3015,8 +3195,12 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 	unsigned int tmplen, msglen;
 
 	tmplen = get_buf_offset(buffer);
-	pack_msg(msg, buffer);
-	msglen = get_buf_offset(buffer) - tmplen;
+	if (pack_msg_prepacked(msg))
+		msglen = msg->data_size;	/* sent as a separate segment */
+	else {
+		pack_msg(msg, buffer);
+		msglen = get_buf_offset(buffer) - tmplen;
+	}
 
 	/* update header with correct cred and msg lengths */
 	update_header(hdr, msglen);
@@ -3028,56 +3212,112 @@ _pack_msg(slurm_msg_t *msg, header_t *hdr, Buf buffer)
 	set_buf_offset(buffer, tmplen);
 }
 
+static int _send_node_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout);
+
 /*
  *  Send a slurm message over an open file descriptor `fd'
  *    Returns the size of the message sent in bytes, or -1 on failure.
  */
 int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
+{
+	return _send_node_msg(fd, msg, slurm_get_msg_timeout() * 1000);
+}
+
+/* As slurm_send_node_msg(), giving up after timeout milliseconds */
+static int _send_node_msg(slurm_fd_t fd, slurm_msg_t *msg, int timeout)
 {
 	header_t header;
 	Buf      buffer;
-	int      rc;
-	void *   auth_cred;
+	int      rc, iovcnt;
+	void *   auth_cred = NULL;
+	void *   init_cred = NULL;
+	uint32_t hdr_len, token_offset = 0, body_offset;
+	bool     use_session;
+	struct iovec iov[2];
+
+	if (msg->forward.init != FORWARD_INIT) {
+		forward_init(&msg->forward, NULL);
+		msg->ret_list = NULL;
+	}
+	forward_wait(msg);
+
+	init_header(&header, msg, msg->flags);
+	header.flags &= ~(SLURM_SESSION_INIT | SLURM_AUTH_SESSION);
+
+	/*
+	 * Messages on a persistent connection are authenticated by a session
+	 * rather than a credential each, see auth_session.c.  The sender of a
+	 * request asks for a session with SLURM_SESSION_INIT and one is
+	 * started if the connection has none yet.  A message to be forwarded
+	 * still needs a credential the next hop can pass along.
+	 */
+	if ((msg->flags & SLURM_SESSION_INIT) &&
+	    !(header.flags & SLURM_GLOBAL_AUTH_KEY) &&
+	    !auth_session_exists(fd) &&
+	    (init_cred = auth_session_init_cred(fd, _get_auth_info())))
+		header.flags |= SLURM_SESSION_INIT;
+	use_session = (!(header.flags & SLURM_GLOBAL_AUTH_KEY) &&
+		       (header.forward.cnt == 0) &&
+		       (init_cred || auth_session_exists(fd)));
 
 	/*
 	 * Initialize header with Auth credential and message type.
 	 */
-	if (msg->flags & SLURM_GLOBAL_AUTH_KEY)
+	if (use_session)
+		header.flags |= SLURM_AUTH_SESSION;
+	else if (msg->flags & SLURM_GLOBAL_AUTH_KEY)
 		auth_cred = g_slurm_auth_create(NULL, 2, _global_auth_key());
 	else
 		auth_cred = g_slurm_auth_create(NULL, 2, _get_auth_info());
 
-	if (auth_cred == NULL) {
+	if (!use_session && (auth_cred == NULL)) {
 		error("authentication: %s",
 		      g_slurm_auth_errstr(g_slurm_auth_errno(NULL)) );
+		if (init_cred)
+			(void) g_slurm_auth_destroy(init_cred);
 		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
 	}
 
-	if (msg->forward.init != FORWARD_INIT) {
-		forward_init(&msg->forward, NULL);
-		msg->ret_list = NULL;
-	}
-	forward_wait(msg);
-
-	init_header(&header, msg, msg->flags);
-
 	/*
 	 * Pack header into buffer for transmission
 	 */
 	buffer = init_buf(BUF_SIZE);
 	pack_header(&header, buffer);
+	hdr_len = get_buf_offset(buffer);
+
+	if (init_cred) {
+		rc = g_slurm_auth_pack(init_cred, buffer);
+		(void) g_slurm_auth_destroy(init_cred);
+		if (rc) {
+			error("authentication: %s",
+			      g_slurm_auth_errstr(g_slurm_auth_errno(NULL)));
+			if (auth_cred)
+				(void) g_slurm_auth_destroy(auth_cred);
+			free_buf(buffer);
+			slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+		}
+	}
 
-	/*
-	 * Pack auth credential
-	 */
-	rc = g_slurm_auth_pack(auth_cred, buffer);
-	(void) g_slurm_auth_destroy(auth_cred);
-	if (rc) {
-		error("authentication: %s",
-		      g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
-		free_buf(buffer);
-		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+	if (use_session) {
+		/* The token is filled in once the body is packed */
+		token_offset = get_buf_offset(buffer);
+		if (remaining_buf(buffer) < AUTH_SESSION_TOKEN_LEN)
+			grow_buf(buffer, AUTH_SESSION_TOKEN_LEN);
+		set_buf_offset(buffer, token_offset + AUTH_SESSION_TOKEN_LEN);
+	} else {
+		/*
+		 * Pack auth credential
+		 */
+		rc = g_slurm_auth_pack(auth_cred, buffer);
+		(void) g_slurm_auth_destroy(auth_cred);
+		if (rc) {
+			error("authentication: %s",
+			      g_slurm_auth_errstr(g_slurm_auth_errno(auth_cred)));
+			free_buf(buffer);
+			slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+		}
 	}
+	body_offset = get_buf_offset(buffer);
 
 	/*
 	 * Pack message into buffer
@@ -3088,11 +3328,35 @@ int slurm_send_node_msg(slurm_fd_t fd, slurm_msg_t * msg)
 	_print_data (get_buf_data(buffer),get_buf_offset(buffer));
 #endif
 	/*
-	 * Send message
+	 * Send message, along with any body that was packed in advance
 	 */
-	rc = _slurm_msg_sendto( fd, get_buf_data(buffer),
-				get_buf_offset(buffer),
-				SLURM_PROTOCOL_NO_SEND_RECV_FLAGS );
+	iov[0].iov_base = get_buf_data(buffer);
+	iov[0].iov_len  = get_buf_offset(buffer);
+	iovcnt = 1;
+	if (pack_msg_prepacked(msg) && msg->data_size) {
+		iov[1].iov_base = msg->data;
+		iov[1].iov_len  = msg->data_size;
+		iovcnt = 2;
+	}
+	if (use_session) {
+		struct iovec mac_iov[3];
+
+		mac_iov[0].iov_base = get_buf_data(buffer);
+		mac_iov[0].iov_len  = hdr_len;
+		mac_iov[1].iov_base = get_buf_data(buffer) + body_offset;
+		mac_iov[1].iov_len  = get_buf_offset(buffer) - body_offset;
+		if (iovcnt == 2)
+			mac_iov[2] = iov[1];
+		if (auth_session_sign(fd, mac_iov, iovcnt + 1,
+				      get_buf_data(buffer) + token_offset)) {
+			error("authentication: no session on connection");
+			free_buf(buffer);
+			slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
+		}
+	}
+	rc = _slurm_msg_sendv_timeout(fd, iov, iovcnt,
+				      SLURM_PROTOCOL_NO_SEND_RECV_FLAGS,
+				      timeout);
 
 	if ((rc < 0) && (errno == ENOTCONN)) {
 		debug3("slurm_msg_sendto: peer has disappeared for msg_type=%u",
@@ -3439,10 +3703,18 @@ unpack_error:
  * IN request_msg	- slurm_msg the request msg
  * IN rc		- the return_code to send back to the client
  */
+static void (*persist_conn_hook)(slurm_msg_t *msg) = NULL;
+
+extern void slurm_set_persist_conn_hook(void (*hook)(slurm_msg_t *msg))
+{
+	persist_conn_hook = hook;
+}
+
 int slurm_send_rc_msg(slurm_msg_t *msg, int rc)
 {
 	slurm_msg_t resp_msg;
 	return_code_msg_t rc_msg;
+	int ret;
 
 	if (msg->conn_fd < 0) {
 		slurm_seterrno(ENOTCONN);
@@ -3462,7 +3734,11 @@ int slurm_send_rc_msg(slurm_msg_t *msg, int rc)
 	resp_msg.orig_addr = msg->orig_addr;
 
 	/* send message */
-	return slurm_send_node_msg(msg->conn_fd, &resp_msg);
+	ret = slurm_send_node_msg(msg->conn_fd, &resp_msg);
+	if ((ret >= 0) && (msg->flags & SLURM_PERSIST_CONN) &&
+	    persist_conn_hook)
+		(*persist_conn_hook)(msg);
+	return ret;
 }
 
 /* slurm_send_rc_err_msg
@@ -3581,6 +3857,12 @@ _send_and_recv_msgs(slurm_fd_t fd, slurm_msg_t *req, int timeout)
 		ret_list = slurm_receive_msgs(fd, steps, timeout);
 	}
 
+	/* The response has been fully read, so the connection can be used
+	 * for another message */
+	if (ret_list && (req->flags & SLURM_PERSIST_CONN)) {
+		conn_cache_put(&req->address, fd);
+		return ret_list;
+	}
 
 	/*
 	 *  Attempt to close an open connection
@@ -3748,6 +4030,15 @@ cleanup:
  *   Returns SLURM_SUCCESS on success SLURM_FAILURE (< 0) for failure.
  */
 int slurm_send_only_node_msg(slurm_msg_t *req)
+{
+	return slurm_send_only_node_msg_timeout(req,
+						slurm_get_msg_timeout() * 1000);
+}
+
+/*
+ *  Same as above, but the send gives up after timeout milliseconds
+ */
+int slurm_send_only_node_msg_timeout(slurm_msg_t *req, int timeout)
 {
 	int      rc = SLURM_SUCCESS;
 	int      retry = 0;
@@ -3757,7 +4048,7 @@ int slurm_send_only_node_msg(slurm_msg_t *req)
 		return SLURM_SOCKET_ERROR;
 	}
 
-	if ((rc = slurm_send_node_msg(fd, req) < 0)) {
+	if ((rc = _send_node_msg(fd, req, timeout) < 0)) {
 		rc = SLURM_ERROR;
 	} else {
 		debug3("slurm_send_only_node_msg: sent %d", rc);
@@ -3824,13 +4115,23 @@ List slurm_send_addr_recv_msgs(slurm_msg_t *msg, char *name, int timeout)
 	slurm_fd_t fd = -1;
 	ret_data_info_t *ret_data_info = NULL;
 	ListIterator itr;
+	bool cached = false;
 	int i;
 
 	if (conn_timeout == (uint16_t) NO_VAL)
 		conn_timeout = MIN(slurm_get_msg_timeout(), 10);
+	msg->flags &= ~(SLURM_PERSIST_CONN | SLURM_SESSION_INIT);
+	if (conn_cache_enabled()) {
+		msg->flags |= SLURM_PERSIST_CONN;
+		if (conn_cache_session_auth())
+			msg->flags |= SLURM_SESSION_INIT;
+		fd = conn_cache_get(&msg->address);
+		cached = (fd >= 0);
+	}
+retry:
 	/* This connect retry logic permits Slurm hierarchical communications
 	 * to better survive slurmd restarts */
-	for (i = 0; i <= conn_timeout; i++) {
+	for (i = 0; (fd < 0) && (i <= conn_timeout); i++) {
 		if (i > 0)
 			sleep(1);
 		fd = slurm_open_msg_conn(&msg->address);
@@ -3849,6 +4150,16 @@ List slurm_send_addr_recv_msgs(slurm_msg_t *msg, char *name, int timeout)
 	msg->ret_list = NULL;
 	msg->forward_struct = NULL;
 	if (!(ret_list = _send_and_recv_msgs(fd, msg, timeout))) {
+		if (cached && (errno != SLURM_PROTOCOL_SOCKET_IMPL_TIMEOUT)) {
+			/* The peer may have closed the cached connection
+			 * (_send_and_recv_msgs() closed it), retry once on
+			 * a new one */
+			debug("cached connection to %s failed: %m, retrying",
+			      name);
+			cached = false;
+			fd = -1;
+			goto retry;
+		}
 		mark_as_failed_forward(&ret_list, name, errno);
 		errno = SLURM_COMMUNICATIONS_CONNECTION_ERROR;
 		return ret_list;
@@ -3935,6 +4246,10 @@ int slurm_send_recv_controller_rc_msg(slurm_msg_t *req, int *rc)
 
 extern int *set_span(int total,  uint16_t tree_width)
 {
+	static pthread_mutex_t span_mutex = PTHREAD_MUTEX_INITIALIZER;
+	static int last_total = -1;
+	static uint16_t last_width = 0;
+	static int *last_span = NULL;
 	int *span = NULL;
 	int left = total;
 	int i = 0;
@@ -3948,6 +4263,16 @@ extern int *set_span(int total,  uint16_t tree_width)
 		return span;
 	}
 
+	/* The same node count is typically fanned out over and over
+	 * (e.g. pinging all nodes), reuse the last result */
+	slurm_mutex_lock(&span_mutex);
+	if ((total == last_total) && (tree_width == last_width)) {
+		memcpy(span, last_span, sizeof(int) * tree_width);
+		slurm_mutex_unlock(&span_mutex);
+		return span;
+	}
+	slurm_mutex_unlock(&span_mutex);
+
 	while (left > 0) {
 		for(i = 0; i < tree_width; i++) {
 			if ((tree_width-i) >= left) {
@@ -3968,6 +4293,15 @@ extern int *set_span(int total,  uint16_t tree_width)
 			left -= tree_width;
 		}
 	}
+
+	slurm_mutex_lock(&span_mutex);
+	if (tree_width != last_width)
+		xrealloc(last_span, sizeof(int) * tree_width);
+	memcpy(last_span, span, sizeof(int) * tree_width);
+	last_total = total;
+	last_width = tree_width;
+	slurm_mutex_unlock(&span_mutex);
+
 	return span;
 }
 
@@ -3984,6 +4318,8 @@ extern void slurm_free_msg(slurm_msg_t * msg)
 		msg->ret_list = NULL;
 	}
 
+	/* The message data must already have been freed */
+	_msg_arena_fini(msg);
 	xfree(msg);
 }
 
@@ -233,6 +233,12 @@ char *slurm_get_job_submit_plugins(void);
  */
 char *slurm_get_slurmctld_plugstack(void);
 
+/* slurm_get_slurmd_params
+ * get slurmd_params from slurmctld_conf object
+ * RET char *   - slurmd_params, MUST be xfreed by caller
+ */
+char *slurm_get_slurmd_params(void);
+
 /* slurm_get_slurmd_plugstack
  * get slurmd_plugstack from slurmctld_conf object from
  * slurmd_conf object
@@ -336,6 +342,12 @@ char *slurm_get_state_save_location(void);
  */
 extern char *slurm_get_auth_type(void);
 
+/* slurm_get_auth_info
+ * returns the authentication plugin options from slurmctld_conf object
+ * RET char *    - auth info, MUST be xfreed by caller
+ */
+extern char *slurm_get_auth_info(void);
+
 /* slurm_set_auth_type
  * set the authentication type in slurmctld_conf object
  * used for security testing purposes
@@ -822,6 +834,18 @@ List slurm_receive_msgs(slurm_fd_t fd, int steps, int timeout);
 int slurm_receive_msg_and_forward(slurm_fd_t fd, slurm_addr_t *orig_addr,
 				  slurm_msg_t *resp, int timeout);
 
+/*
+ *  Determine the type of the message waiting on an accepted connection
+ *    without consuming any of it and without blocking, so that a daemon
+ *    can decide how to schedule the message before receiving it.
+ *
+ * IN fd	- accepted connection
+ * OUT msg_type	- type from the message header
+ * RET int	- 1 if msg_type was set, 0 if the header has not fully
+ *		  arrived yet, -1 if the connection was closed or failed
+ */
+int slurm_peek_msg_type(slurm_fd_t fd, uint16_t *msg_type);
+
 /**********************************************************************\
  * send message functions
 \**********************************************************************/
@@ -1081,6 +1105,16 @@ extern int slurm_unpack_slurm_addr_array(slurm_addr_t ** slurm_address,
  */
 int slurm_send_rc_msg(slurm_msg_t * request_msg, int rc);
 
+/* slurm_set_persist_conn_hook
+ * set a function called by slurm_send_rc_msg() once it has replied to a
+ *	request received on a persistent connection (SLURM_PERSIST_CONN).
+ *	The function may take over the connection, setting the request's
+ *	conn_fd to -1, so slurmd can wait for the next message on it while
+ *	the handler of the request carries on.
+ * IN hook	- function to call or NULL
+ */
+extern void slurm_set_persist_conn_hook(void (*hook)(slurm_msg_t *msg));
+
 /* slurm_send_rc_err_msg
  * given the original request message this function sends a
  *	slurm_return_code message back to the client that made the request
@@ -1167,6 +1201,15 @@ int slurm_send_only_controller_msg(slurm_msg_t * request_msg);
  */
 int slurm_send_only_node_msg(slurm_msg_t * request_msg);
 
+/* slurm_send_only_node_msg_timeout
+ * same as slurm_send_only_node_msg, but the send gives up after
+ * timeout milliseconds
+ * IN request_msg	- slurm_msg request
+ * IN timeout		- how long to wait in milliseconds
+ * RET int 		- return code
+ */
+int slurm_send_only_node_msg_timeout(slurm_msg_t * request_msg, int timeout);
+
 /* Slurm message functions */
 
 /* set_span
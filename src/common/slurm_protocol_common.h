@@ -70,6 +70,7 @@
  * In slurm_protocol_util.c check_header_version(), and init_header()
  * need to be updated also when changes are added */
 #define SLURM_PROTOCOL_VERSION ((SLURM_API_MAJOR << 8) | SLURM_API_AGE)
+#define SLURM_14_11_PROTOCOL_VERSION ((28 << 8) | 0)
 #define SLURM_14_03_PROTOCOL_VERSION ((27 << 8) | 0)
 #define SLURM_2_6_PROTOCOL_VERSION ((26 << 8) | 0)
 #define SLURM_2_5_PROTOCOL_VERSION ((25 << 8) | 0)
@@ -86,6 +87,11 @@
 /* used to set flags to empty */
 #define SLURM_PROTOCOL_NO_FLAGS 0
 #define SLURM_GLOBAL_AUTH_KEY   0x0001
+#define SLURM_PERSIST_CONN      0x0002	/* keep connection open for reuse */
+#define SLURM_SESSION_INIT      0x0004	/* start an auth session, its key
+					 * credential follows the header */
+#define SLURM_AUTH_SESSION      0x0008	/* session token instead of an
+					 * authentication credential */
 
 #include "src/common/slurm_protocol_socket_common.h"
 
@@ -372,6 +372,11 @@ extern void slurm_free_node_info_request_msg(node_info_request_msg_t *msg)
 	xfree(msg);
 }
 
+extern void slurm_free_delta_info_request_msg(delta_info_request_msg_t *msg)
+{
+	xfree(msg);
+}
+
 extern void slurm_free_node_info_single_msg(node_info_single_msg_t *msg)
 {
 	if (msg) {
@@ -2127,6 +2132,10 @@ extern void slurm_free_slurmd_status(slurmd_status_t* slurmd_status_ptr)
 		xfree(slurmd_status_ptr->slurmd_logfile);
 		xfree(slurmd_status_ptr->step_list);
 		xfree(slurmd_status_ptr->version);
+		xfree(slurmd_status_ptr->rpc_type_id);
+		xfree(slurmd_status_ptr->rpc_type_cnt);
+		xfree(slurmd_status_ptr->rpc_type_ave_time);
+		xfree(slurmd_status_ptr->rpc_type_max_time);
 		xfree(slurmd_status_ptr);
 	}
 }
@@ -2285,6 +2294,70 @@ extern void slurm_free_node_info_members(node_info_t * node)
 	}
 }
 
+/*
+ * slurm_free_node_summary_msg - free the node summary response message
+ * IN msg - pointer to node summary response message
+ * NOTE: buffer is loaded by slurm_load_node_summary
+ */
+extern void slurm_free_node_summary_msg(node_summary_msg_t * msg)
+{
+	int i;
+
+	if (msg) {
+		if (msg->summary_array) {
+			for (i = 0; i < msg->record_count; i++) {
+				xfree(msg->summary_array[i].features);
+				xfree(msg->summary_array[i].nodes);
+				xfree(msg->summary_array[i].partition);
+			}
+			xfree(msg->summary_array);
+		}
+		xfree(msg);
+	}
+}
+
+
+/*
+ * slurm_free_job_info_delta_msg - free the changed jobs response message
+ * IN msg - pointer to job delta response message
+ * NOTE: buffer is loaded by slurm_load_jobs_delta
+ */
+extern void slurm_free_job_info_delta_msg(job_info_delta_msg_t * msg)
+{
+	int i;
+
+	if (msg) {
+		if (msg->job_array) {
+			for (i = 0; i < msg->record_count; i++)
+				slurm_free_job_info_members(&msg->job_array[i]);
+			xfree(msg->job_array);
+		}
+		xfree(msg->removed_ids);
+		xfree(msg);
+	}
+}
+
+/*
+ * slurm_free_node_info_delta_msg - free the changed nodes response message
+ * IN msg - pointer to node delta response message
+ * NOTE: buffer is loaded by slurm_load_node_delta
+ */
+extern void slurm_free_node_info_delta_msg(node_info_delta_msg_t * msg)
+{
+	int i;
+
+	if (msg) {
+		if (msg->node_array) {
+			for (i = 0; i < msg->record_count; i++) {
+				slurm_free_node_info_members(
+					&msg->node_array[i]);
+			}
+			xfree(msg->node_array);
+		}
+		xfree(msg->node_inx);
+		xfree(msg);
+	}
+}
 
 /*
  * slurm_free_partition_info_msg - free the partition information
@@ -2507,6 +2580,30 @@ extern void slurm_free_trigger_msg(trigger_info_msg_t *msg)
 	xfree(msg);
 }
 
+extern void slurm_free_event_subscribe_msg(event_subscribe_msg_t *msg)
+{
+	if (msg) {
+		xfree(msg->partitions);
+		xfree(msg->users);
+		xfree(msg);
+	}
+}
+
+extern void slurm_free_event_notify_msg(event_notify_msg_t *msg)
+{
+	int i;
+
+	if (msg) {
+		for (i = 0; i < msg->event_cnt; i++) {
+			xfree(msg->event_array[i].partition);
+			xfree(msg->event_array[i].nodes);
+			xfree(msg->event_array[i].reason);
+		}
+		xfree(msg->event_array);
+		xfree(msg);
+	}
+}
+
 extern void slurm_free_set_debug_flags_msg(set_debug_flags_msg_t *msg)
 {
 	xfree(msg);
@@ -2606,8 +2703,30 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 		slurm_free_job_info_request_msg(data);
 		break;
 	case REQUEST_NODE_INFO:
+	case REQUEST_NODE_INFO_SUMMARY:
 		slurm_free_node_info_request_msg(data);
 		break;
+	case RESPONSE_NODE_INFO_SUMMARY:
+		slurm_free_node_summary_msg(data);
+		break;
+	case REQUEST_JOB_INFO_DELTA:
+	case REQUEST_NODE_INFO_DELTA:
+		slurm_free_delta_info_request_msg(data);
+		break;
+	case RESPONSE_JOB_INFO_DELTA:
+		slurm_free_job_info_delta_msg(data);
+		break;
+	case RESPONSE_NODE_INFO_DELTA:
+		slurm_free_node_info_delta_msg(data);
+		break;
+	case REQUEST_EVENT_SUBSCRIBE:
+	case RESPONSE_EVENT_SUBSCRIBE:
+	case REQUEST_EVENT_UNSUBSCRIBE:
+		slurm_free_event_subscribe_msg(data);
+		break;
+	case MESSAGE_EVENT_NOTIFY:
+		slurm_free_event_notify_msg(data);
+		break;
 	case REQUEST_NODE_INFO_SINGLE:
 		slurm_free_node_info_single_msg(data);
 		break;
@@ -2856,6 +2975,9 @@ extern uint32_t slurm_get_return_code(slurm_msg_type_t type, void *data)
 	case RESPONSE_ACCT_GATHER_UPDATE:
 		rc = SLURM_SUCCESS;
 		break;
+	case MESSAGE_NODE_REGISTRATION_STATUS:
+		rc = SLURM_SUCCESS;
+		break;
 	case RESPONSE_FORWARD_FAILED:
 		/* There may be other reasons for the failure, but
 		 * this may be a slurm_msg_t data type lacking the
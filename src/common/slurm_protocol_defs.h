@@ -164,8 +164,8 @@
  */
 enum task_flag_vals {
 	TASK_PARALLEL_DEBUG = 0x1,
-	TASK_UNUSED1 = 0x2,
-	TASK_UNUSED2 = 0x4
+	TASK_LARGE_IO = 0x2,	/* client accepts IO_LARGE_MSG_LEN stdio frames */
+	TASK_IO_TREE = 0x4	/* relay stdio through the step's reverse tree */
 };
 
 /*
@@ -239,6 +239,16 @@ typedef enum {
 	RESPONSE_STATS_RESET,
 	REQUEST_JOB_USER_INFO,
 	REQUEST_NODE_INFO_SINGLE,
+	REQUEST_NODE_INFO_SUMMARY,
+	RESPONSE_NODE_INFO_SUMMARY,
+	REQUEST_JOB_INFO_DELTA,
+	RESPONSE_JOB_INFO_DELTA,
+	REQUEST_NODE_INFO_DELTA,
+	RESPONSE_NODE_INFO_DELTA,
+	REQUEST_EVENT_SUBSCRIBE,
+	RESPONSE_EVENT_SUBSCRIBE,
+	REQUEST_EVENT_UNSUBSCRIBE,
+	MESSAGE_EVENT_NOTIFY,
 
 	REQUEST_UPDATE_JOB = 3001,
 	REQUEST_UPDATE_NODE,
@@ -330,6 +340,7 @@ typedef enum {
 	REQUEST_LAUNCH_PROLOG,
 	REQUEST_COMPLETE_PROLOG,
 	RESPONSE_PROLOG_EXECUTING,
+	REQUEST_STEP_IO_CONNECT,
 
 	SRUN_PING = 7001,
 	SRUN_TIMEOUT,
@@ -429,6 +440,8 @@ typedef struct slurm_msg {
 	forward_struct_t *forward_struct;
 	slurm_addr_t orig_addr;
 	List ret_list;
+	xarena_t *arena;	/* DON'T PACK! Holds the unpacked data of some
+				 * message types, see slurm_free_msg() */
 } slurm_msg_t;
 
 typedef struct ret_data_info {
@@ -543,6 +556,44 @@ typedef struct node_info_request_msg {
 	uint16_t show_flags;
 } node_info_request_msg_t;
 
+/* Request only the records changed since the client's copy was loaded */
+typedef struct delta_info_request_msg {
+	time_t last_update;	/* last_update of the client's copy */
+	time_t change_epoch;	/* change_epoch of the client's copy */
+	uint32_t change_seq;	/* change_seq of the client's copy */
+	uint32_t record_count;	/* record_count of the client's copy */
+	uint16_t show_flags;
+} delta_info_request_msg_t;
+
+/* Jobs changed since a delta_info_request_msg_t, merged into the client's
+ * copy by slurm_load_jobs_delta(). If full is set, job_array holds every
+ * job and replaces the client's copy. */
+typedef struct job_info_delta_msg {
+	time_t last_update;	/* time of latest info */
+	time_t change_epoch;	/* controller start time */
+	uint32_t change_seq;	/* last job change included */
+	uint16_t full;		/* job_array replaces the client's copy */
+	uint32_t removed_cnt;	/* number of removed_ids */
+	uint32_t *removed_ids;	/* jobs to drop from the client's copy */
+	uint32_t record_count;	/* number of records */
+	slurm_job_info_t *job_array;	/* new and changed jobs */
+} job_info_delta_msg_t;
+
+/* Nodes changed since a delta_info_request_msg_t, merged into the client's
+ * copy by slurm_load_node_delta(). If full is set, node_array holds every
+ * node and replaces the client's copy. */
+typedef struct node_info_delta_msg {
+	time_t last_update;	/* time of latest info */
+	time_t change_epoch;	/* controller start time */
+	uint32_t change_seq;	/* last node change included */
+	uint16_t full;		/* node_array replaces the client's copy */
+	uint32_t node_scaling;	/* as in node_info_msg_t */
+	uint32_t node_cnt;	/* size of the complete node table */
+	uint32_t record_count;	/* number of records */
+	uint32_t *node_inx;	/* table index of each record, if not full */
+	node_info_t *node_array;	/* changed nodes */
+} node_info_delta_msg_t;
+
 typedef struct node_info_single_msg {
 	char *node_name;
 	uint16_t show_flags;
@@ -1092,6 +1143,8 @@ extern void slurm_free_job_step_info_request_msg(
 extern void slurm_free_front_end_info_request_msg(
 		front_end_info_request_msg_t *msg);
 extern void slurm_free_node_info_request_msg(node_info_request_msg_t *msg);
+extern void slurm_free_delta_info_request_msg(delta_info_request_msg_t *msg);
+extern void slurm_free_event_subscribe_msg(event_subscribe_msg_t *msg);
 extern void slurm_free_node_info_single_msg(node_info_single_msg_t *msg);
 extern void slurm_free_part_info_request_msg(part_info_request_msg_t *msg);
 extern void slurm_free_stats_info_request_msg(stats_info_request_msg_t *msg);
@@ -1201,6 +1254,9 @@ extern void slurm_free_front_end_info_msg (front_end_info_msg_t * msg);
 extern void slurm_free_front_end_info_members(front_end_info_t * front_end);
 extern void slurm_free_node_info_msg(node_info_msg_t * msg);
 extern void slurm_free_node_info_members(node_info_t * node);
+extern void slurm_free_node_summary_msg(node_summary_msg_t * msg);
+extern void slurm_free_job_info_delta_msg(job_info_delta_msg_t * msg);
+extern void slurm_free_node_info_delta_msg(node_info_delta_msg_t * msg);
 extern void slurm_free_partition_info_msg(partition_info_msg_t * msg);
 extern void slurm_free_partition_info_members(partition_info_t * part);
 extern void slurm_free_reservation_info_msg(reserve_info_msg_t * msg);
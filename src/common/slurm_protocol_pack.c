@@ -75,6 +75,9 @@
 #define _pack_block_info_resp_msg(msg,buf)	_pack_buffer_msg(msg,buf)
 #define _pack_front_end_info_msg(msg,buf)	_pack_buffer_msg(msg,buf)
 #define _pack_node_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
+#define _pack_node_summary_msg(msg,buf)		_pack_buffer_msg(msg,buf)
+#define _pack_job_info_delta_msg(msg,buf)	_pack_buffer_msg(msg,buf)
+#define _pack_node_info_delta_msg(msg,buf)	_pack_buffer_msg(msg,buf)
 #define _pack_partition_info_msg(msg,buf)	_pack_buffer_msg(msg,buf)
 #define _pack_stats_response_msg(msg,buf)	_pack_buffer_msg(msg,buf)
 #define _pack_reserve_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
@@ -176,6 +179,17 @@ static int _unpack_node_info_msg(node_info_msg_t ** msg, Buf buffer,
 				 uint16_t protocol_version);
 static int _unpack_node_info_members(node_info_t * node, Buf buffer,
 				     uint16_t protocol_version);
+static int _unpack_node_summary_msg(node_summary_msg_t ** msg, Buf buffer,
+				    uint16_t protocol_version);
+static int _unpack_node_info_delta_msg(node_info_delta_msg_t ** msg,
+				       Buf buffer, uint16_t protocol_version);
+
+static void _pack_delta_info_request_msg(delta_info_request_msg_t * msg,
+					 Buf buffer,
+					 uint16_t protocol_version);
+static int _unpack_delta_info_request_msg(delta_info_request_msg_t ** msg,
+					  Buf buffer,
+					  uint16_t protocol_version);
 
 static void _pack_front_end_info_request_msg(
 	front_end_info_request_msg_t * msg,
@@ -431,6 +445,8 @@ static void _pack_job_desc_msg(job_desc_msg_t * job_desc_ptr, Buf buffer,
 static int _unpack_job_desc_msg(job_desc_msg_t ** job_desc_buffer_ptr,
 				Buf buffer,
 				uint16_t protocol_version);
+static int _unpack_job_info_delta_msg(job_info_delta_msg_t ** msg,
+				      Buf buffer, uint16_t protocol_version);
 static int _unpack_job_info_msg(job_info_msg_t ** msg, Buf buffer,
 				uint16_t protocol_version);
 
@@ -569,6 +585,15 @@ static void _pack_trigger_msg(trigger_info_msg_t *msg , Buf buffer,
 static int  _unpack_trigger_msg(trigger_info_msg_t ** msg_ptr , Buf buffer,
 				uint16_t protocol_version);
 
+static void _pack_event_subscribe_msg(event_subscribe_msg_t *msg, Buf buffer,
+				      uint16_t protocol_version);
+static int  _unpack_event_subscribe_msg(event_subscribe_msg_t **msg_ptr,
+					Buf buffer, uint16_t protocol_version);
+static void _pack_event_notify_msg(event_notify_msg_t *msg, Buf buffer,
+				   uint16_t protocol_version);
+static int  _unpack_event_notify_msg(event_notify_msg_t **msg_ptr,
+				     Buf buffer, uint16_t protocol_version);
+
 static void _pack_slurmd_status(slurmd_status_t *msg, Buf buffer,
 				uint16_t protocol_version);
 static int  _unpack_slurmd_status(slurmd_status_t **msg_ptr, Buf buffer,
@@ -750,6 +775,33 @@ unpack_error:
 }
 
 
+/* pack_msg_prepacked
+ * IN msg - message to be sent
+ * RET true if the message body is a buffer packed in advance, which
+ *	pack_msg() would only copy, so that the sender may transmit it as
+ *	a separate segment instead
+ */
+extern bool pack_msg_prepacked(slurm_msg_t const *msg)
+{
+	switch (msg->msg_type) {
+	case RESPONSE_JOB_INFO:
+	case RESPONSE_PARTITION_INFO:
+	case RESPONSE_NODE_INFO:
+	case RESPONSE_NODE_INFO_SUMMARY:
+	case RESPONSE_JOB_INFO_DELTA:
+	case RESPONSE_NODE_INFO_DELTA:
+	case RESPONSE_RESERVATION_INFO:
+	case RESPONSE_JOB_STEP_INFO:
+	case RESPONSE_BLOCK_INFO:
+	case RESPONSE_FRONT_END_INFO:
+	case RESPONSE_STATS_INFO:
+	case RESPONSE_LICENSE_INFO:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /* pack_msg
  * packs a generic slurm protocol message body
  * IN msg - the body structure to pack (note: includes message type)
@@ -762,6 +814,7 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 {
 	switch (msg->msg_type) {
 	case REQUEST_NODE_INFO:
+	case REQUEST_NODE_INFO_SUMMARY:
 		_pack_node_info_request_msg((node_info_request_msg_t *)
 					    msg->data, buffer,
 					    msg->protocol_version);
@@ -771,6 +824,12 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 					   msg->data, buffer,
 					   msg->protocol_version);
 		break;
+	case REQUEST_JOB_INFO_DELTA:
+	case REQUEST_NODE_INFO_DELTA:
+		_pack_delta_info_request_msg((delta_info_request_msg_t *)
+					     msg->data, buffer,
+					     msg->protocol_version);
+		break;
 	case REQUEST_PARTITION_INFO:
 		_pack_part_info_request_msg((part_info_request_msg_t *)
 					    msg->data, buffer,
@@ -801,6 +860,15 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 	case RESPONSE_NODE_INFO:
 		_pack_node_info_msg((slurm_msg_t *) msg, buffer);
 		break;
+	case RESPONSE_NODE_INFO_SUMMARY:
+		_pack_node_summary_msg((slurm_msg_t *) msg, buffer);
+		break;
+	case RESPONSE_JOB_INFO_DELTA:
+		_pack_job_info_delta_msg((slurm_msg_t *) msg, buffer);
+		break;
+	case RESPONSE_NODE_INFO_DELTA:
+		_pack_node_info_delta_msg((slurm_msg_t *) msg, buffer);
+		break;
 	case MESSAGE_NODE_REGISTRATION_STATUS:
 		_pack_node_registration_status_msg(
 			(slurm_node_registration_status_msg_t *) msg->data,
@@ -1004,6 +1072,7 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 	case REQUEST_STEP_LAYOUT:
 	case REQUEST_JOB_STEP_STAT:
 	case REQUEST_JOB_STEP_PIDS:
+	case REQUEST_STEP_IO_CONNECT:
 		_pack_job_step_id_msg((job_step_id_msg_t *)msg->data, buffer,
 				      msg->protocol_version);
 		break;
@@ -1236,6 +1305,16 @@ pack_msg(slurm_msg_t const *msg, Buf buffer)
 		_pack_trigger_msg((trigger_info_msg_t *) msg->data, buffer,
 				  msg->protocol_version);
 		break;
+	case REQUEST_EVENT_SUBSCRIBE:
+	case RESPONSE_EVENT_SUBSCRIBE:
+	case REQUEST_EVENT_UNSUBSCRIBE:
+		_pack_event_subscribe_msg((event_subscribe_msg_t *) msg->data,
+					  buffer, msg->protocol_version);
+		break;
+	case MESSAGE_EVENT_NOTIFY:
+		_pack_event_notify_msg((event_notify_msg_t *) msg->data,
+				       buffer, msg->protocol_version);
+		break;
 	case RESPONSE_SLURMD_STATUS:
 		_pack_slurmd_status((slurmd_status_t *) msg->data, buffer,
 				    msg->protocol_version);
@@ -1341,6 +1420,7 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 
 	switch (msg->msg_type) {
 	case REQUEST_NODE_INFO:
+	case REQUEST_NODE_INFO_SUMMARY:
 		rc = _unpack_node_info_request_msg((node_info_request_msg_t **)
 						   & (msg->data), buffer,
 						   msg->protocol_version);
@@ -1350,6 +1430,12 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 						  & (msg->data), buffer,
 						  msg->protocol_version);
 		break;
+	case REQUEST_JOB_INFO_DELTA:
+	case REQUEST_NODE_INFO_DELTA:
+		rc = _unpack_delta_info_request_msg(
+			(delta_info_request_msg_t **) & (msg->data), buffer,
+			msg->protocol_version);
+		break;
 	case REQUEST_PARTITION_INFO:
 		rc = _unpack_part_info_request_msg((part_info_request_msg_t **)
 						   & (msg->data), buffer,
@@ -1387,6 +1473,21 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 					   (msg->data), buffer,
 					   msg->protocol_version);
 		break;
+	case RESPONSE_NODE_INFO_SUMMARY:
+		rc = _unpack_node_summary_msg((node_summary_msg_t **) &
+					      (msg->data), buffer,
+					      msg->protocol_version);
+		break;
+	case RESPONSE_JOB_INFO_DELTA:
+		rc = _unpack_job_info_delta_msg((job_info_delta_msg_t **) &
+						(msg->data), buffer,
+						msg->protocol_version);
+		break;
+	case RESPONSE_NODE_INFO_DELTA:
+		rc = _unpack_node_info_delta_msg((node_info_delta_msg_t **) &
+						 (msg->data), buffer,
+						 msg->protocol_version);
+		break;
 	case MESSAGE_NODE_REGISTRATION_STATUS:
 		rc = _unpack_node_registration_status_msg(
 			(slurm_node_registration_status_msg_t **)
@@ -1602,6 +1703,7 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 	case REQUEST_STEP_LAYOUT:
 	case REQUEST_JOB_STEP_STAT:
 	case REQUEST_JOB_STEP_PIDS:
+	case REQUEST_STEP_IO_CONNECT:
 		_unpack_job_step_id_msg((job_step_id_msg_t **)&msg->data,
 					buffer,
 					msg->protocol_version);
@@ -1859,6 +1961,18 @@ unpack_msg(slurm_msg_t * msg, Buf buffer)
 					 &msg->data, buffer,
 					 msg->protocol_version);
 		break;
+	case REQUEST_EVENT_SUBSCRIBE:
+	case RESPONSE_EVENT_SUBSCRIBE:
+	case REQUEST_EVENT_UNSUBSCRIBE:
+		rc = _unpack_event_subscribe_msg((event_subscribe_msg_t **)
+						 &msg->data, buffer,
+						 msg->protocol_version);
+		break;
+	case MESSAGE_EVENT_NOTIFY:
+		rc = _unpack_event_notify_msg((event_notify_msg_t **)
+					      &msg->data, buffer,
+					      msg->protocol_version);
+		break;
 	case RESPONSE_SLURMD_STATUS:
 		rc = _unpack_slurmd_status((slurmd_status_t **)
 					   &msg->data, buffer,
@@ -2992,6 +3106,110 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* NOTE: The packing is done in pack_node_summary() in slurmctld/node_mgr.c */
+static int
+_unpack_node_summary_msg(node_summary_msg_t ** msg, Buf buffer,
+			 uint16_t protocol_version)
+{
+	int i;
+	uint32_t uint32_tmp;
+	node_summary_t *summary;
+
+	xassert(msg != NULL);
+	*msg = xmalloc(sizeof(node_summary_msg_t));
+
+	if (protocol_version >= SLURM_14_11_PROTOCOL_VERSION) {
+		safe_unpack32(&((*msg)->record_count), buffer);
+		safe_unpack_time(&((*msg)->last_update), buffer);
+
+		summary = (*msg)->summary_array =
+			xmalloc(sizeof(node_summary_t) * (*msg)->record_count);
+		for (i = 0; i < (*msg)->record_count; i++, summary++) {
+			safe_unpackstr_xmalloc(&summary->partition,
+					       &uint32_tmp, buffer);
+			safe_unpackstr_xmalloc(&summary->nodes,
+					       &uint32_tmp, buffer);
+			safe_unpackstr_xmalloc(&summary->features,
+					       &uint32_tmp, buffer);
+			safe_unpack16(&summary->node_state, buffer);
+			safe_unpack32(&summary->node_cnt, buffer);
+			safe_unpack32(&summary->cpus_alloc, buffer);
+			safe_unpack32(&summary->cpus_err, buffer);
+			safe_unpack32(&summary->cpus_total, buffer);
+			safe_unpack16(&summary->min_cpus, buffer);
+			safe_unpack16(&summary->max_cpus, buffer);
+			safe_unpack16(&summary->min_sockets, buffer);
+			safe_unpack16(&summary->max_sockets, buffer);
+			safe_unpack16(&summary->min_cores, buffer);
+			safe_unpack16(&summary->max_cores, buffer);
+			safe_unpack16(&summary->min_threads, buffer);
+			safe_unpack16(&summary->max_threads, buffer);
+			safe_unpack32(&summary->min_disk, buffer);
+			safe_unpack32(&summary->max_disk, buffer);
+			safe_unpack32(&summary->min_mem, buffer);
+			safe_unpack32(&summary->max_mem, buffer);
+			safe_unpack32(&summary->min_weight, buffer);
+			safe_unpack32(&summary->max_weight, buffer);
+		}
+	} else {
+		error("_unpack_node_summary_msg: protocol_version "
+		      "%hu not supported", protocol_version);
+		goto unpack_error;
+	}
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_node_summary_msg(*msg);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
+/* NOTE: The packing is done in pack_node_delta() in slurmctld/node_mgr.c */
+static int
+_unpack_node_info_delta_msg(node_info_delta_msg_t ** msg, Buf buffer,
+			    uint16_t protocol_version)
+{
+	int i;
+	node_info_t *node = NULL;
+
+	xassert(msg != NULL);
+	*msg = xmalloc(sizeof(node_info_delta_msg_t));
+
+	if (protocol_version >= SLURM_14_11_PROTOCOL_VERSION) {
+		safe_unpack32(&((*msg)->record_count), buffer);
+		safe_unpack32(&((*msg)->node_scaling), buffer);
+		safe_unpack_time(&((*msg)->last_update), buffer);
+		safe_unpack_time(&((*msg)->change_epoch), buffer);
+		safe_unpack32(&((*msg)->change_seq), buffer);
+		safe_unpack16(&((*msg)->full), buffer);
+		safe_unpack32(&((*msg)->node_cnt), buffer);
+		if ((*msg)->record_count > (*msg)->node_cnt)
+			goto unpack_error;
+
+		(*msg)->node_inx =
+			xmalloc(sizeof(uint32_t) * (*msg)->record_count);
+		node = (*msg)->node_array =
+			xmalloc(sizeof(node_info_t) * (*msg)->record_count);
+		for (i = 0; i < (*msg)->record_count; i++) {
+			safe_unpack32(&((*msg)->node_inx[i]), buffer);
+			if (((*msg)->node_inx[i] >= (*msg)->node_cnt) ||
+			    _unpack_node_info_members(&node[i], buffer,
+						      protocol_version))
+				goto unpack_error;
+		}
+	} else {
+		error("_unpack_node_info_delta_msg: protocol_version "
+		      "%hu not supported", protocol_version);
+		goto unpack_error;
+	}
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_node_info_delta_msg(*msg);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
 static int
 _unpack_node_info_members(node_info_t * node, Buf buffer,
 			  uint16_t protocol_version)
@@ -4360,6 +4578,46 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* NOTE: The packing is done in pack_jobs_delta() in slurmctld/job_mgr.c */
+static int
+_unpack_job_info_delta_msg(job_info_delta_msg_t ** msg, Buf buffer,
+			   uint16_t protocol_version)
+{
+	int i;
+	job_info_t *job = NULL;
+
+	xassert(msg != NULL);
+	*msg = xmalloc(sizeof(job_info_delta_msg_t));
+
+	if (protocol_version >= SLURM_14_11_PROTOCOL_VERSION) {
+		safe_unpack32(&((*msg)->record_count), buffer);
+		safe_unpack_time(&((*msg)->last_update), buffer);
+		safe_unpack_time(&((*msg)->change_epoch), buffer);
+		safe_unpack32(&((*msg)->change_seq), buffer);
+		safe_unpack16(&((*msg)->full), buffer);
+
+		job = (*msg)->job_array =
+			xmalloc(sizeof(job_info_t) * (*msg)->record_count);
+		for (i = 0; i < (*msg)->record_count; i++) {
+			if (_unpack_job_info_members(&job[i], buffer,
+						     protocol_version))
+				goto unpack_error;
+		}
+		safe_unpack32_array(&((*msg)->removed_ids),
+				    &((*msg)->removed_cnt), buffer);
+	} else {
+		error("_unpack_job_info_delta_msg: protocol_version "
+		      "%hu not supported", protocol_version);
+		goto unpack_error;
+	}
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_job_info_delta_msg(*msg);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
 /* _unpack_job_info_members
  * unpacks a set of slurm job info for one job
  * OUT job - pointer to the job info buffer
@@ -4975,6 +5233,8 @@ _pack_slurm_ctl_conf_msg(slurm_ctl_conf_info_msg_t * build_ptr, Buf buffer,
 
 		pack16(build_ptr->slurmd_debug, buffer);
 		packstr(build_ptr->slurmd_logfile, buffer);
+		if (protocol_version >= SLURM_14_11_PROTOCOL_VERSION)
+			packstr(build_ptr->slurmd_params, buffer);
 		packstr(build_ptr->slurmd_pidfile, buffer);
 		packstr(build_ptr->slurmd_plugstack, buffer);
 		if (!(cluster_flags & CLUSTER_FLAG_MULTSD))
@@ -5743,6 +6003,10 @@ _unpack_slurm_ctl_conf_msg(slurm_ctl_conf_info_msg_t **build_buffer_ptr,
 		safe_unpack16(&build_ptr->slurmd_debug, buffer);
 		safe_unpackstr_xmalloc(&build_ptr->slurmd_logfile, &uint32_tmp,
 				       buffer);
+		if (protocol_version >= SLURM_14_11_PROTOCOL_VERSION) {
+			safe_unpackstr_xmalloc(&build_ptr->slurmd_params,
+					       &uint32_tmp, buffer);
+		}
 		safe_unpackstr_xmalloc(&build_ptr->slurmd_pidfile, &uint32_tmp,
 				       buffer);
 		safe_unpackstr_xmalloc(&build_ptr->slurmd_plugstack,
@@ -9171,6 +9435,39 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void
+_pack_delta_info_request_msg(delta_info_request_msg_t * msg, Buf buffer,
+			     uint16_t protocol_version)
+{
+	pack_time(msg->last_update, buffer);
+	pack_time(msg->change_epoch, buffer);
+	pack32(msg->change_seq, buffer);
+	pack32(msg->record_count, buffer);
+	pack16(msg->show_flags, buffer);
+}
+
+static int
+_unpack_delta_info_request_msg(delta_info_request_msg_t ** msg, Buf buffer,
+			       uint16_t protocol_version)
+{
+	delta_info_request_msg_t *delta_info;
+
+	delta_info = xmalloc(sizeof(delta_info_request_msg_t));
+	*msg = delta_info;
+
+	safe_unpack_time(&delta_info->last_update, buffer);
+	safe_unpack_time(&delta_info->change_epoch, buffer);
+	safe_unpack32(&delta_info->change_seq, buffer);
+	safe_unpack32(&delta_info->record_count, buffer);
+	safe_unpack16(&delta_info->show_flags, buffer);
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_delta_info_request_msg(delta_info);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
 static void
 _pack_node_info_single_msg(node_info_single_msg_t * msg, Buf buffer,
 			   uint16_t protocol_version)
@@ -10670,6 +10967,95 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _pack_event_subscribe_msg(event_subscribe_msg_t *msg, Buf buffer,
+				      uint16_t protocol_version)
+{
+	pack32(msg->sub_id, buffer);
+	pack16(msg->port, buffer);
+	pack16(msg->event_mask, buffer);
+	packstr(msg->partitions, buffer);
+	packstr(msg->users, buffer);
+	pack16(msg->lease, buffer);
+}
+
+static int  _unpack_event_subscribe_msg(event_subscribe_msg_t **msg_ptr,
+					Buf buffer, uint16_t protocol_version)
+{
+	uint32_t uint32_tmp;
+	event_subscribe_msg_t *msg = xmalloc(sizeof(event_subscribe_msg_t));
+
+	safe_unpack32(&msg->sub_id, buffer);
+	safe_unpack16(&msg->port, buffer);
+	safe_unpack16(&msg->event_mask, buffer);
+	safe_unpackstr_xmalloc(&msg->partitions, &uint32_tmp, buffer);
+	safe_unpackstr_xmalloc(&msg->users, &uint32_tmp, buffer);
+	safe_unpack16(&msg->lease, buffer);
+	*msg_ptr = msg;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_event_subscribe_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
+static void _pack_event_notify_msg(event_notify_msg_t *msg, Buf buffer,
+				   uint16_t protocol_version)
+{
+	slurm_event_t *event;
+	int i;
+
+	pack32(msg->sub_id, buffer);
+	pack32(msg->lost, buffer);
+	pack32(msg->event_cnt, buffer);
+	for (i = 0, event = msg->event_array; i < msg->event_cnt;
+	     i++, event++) {
+		pack16(event->event_type, buffer);
+		pack_time(event->event_time, buffer);
+		pack32(event->job_id, buffer);
+		pack32(event->user_id, buffer);
+		pack16(event->state, buffer);
+		packstr(event->partition, buffer);
+		packstr(event->nodes, buffer);
+		packstr(event->reason, buffer);
+	}
+}
+
+static int  _unpack_event_notify_msg(event_notify_msg_t **msg_ptr,
+				     Buf buffer, uint16_t protocol_version)
+{
+	uint32_t uint32_tmp;
+	slurm_event_t *event;
+	int i;
+	event_notify_msg_t *msg = xmalloc(sizeof(event_notify_msg_t));
+
+	safe_unpack32(&msg->sub_id, buffer);
+	safe_unpack32(&msg->lost, buffer);
+	safe_unpack32(&uint32_tmp, buffer);
+	if (uint32_tmp > NO_VAL / sizeof(slurm_event_t))
+		goto unpack_error;
+	msg->event_array = xmalloc(sizeof(slurm_event_t) * uint32_tmp);
+	msg->event_cnt = uint32_tmp;
+	for (i = 0, event = msg->event_array; i < msg->event_cnt;
+	     i++, event++) {
+		safe_unpack16(&event->event_type, buffer);
+		safe_unpack_time(&event->event_time, buffer);
+		safe_unpack32(&event->job_id, buffer);
+		safe_unpack32(&event->user_id, buffer);
+		safe_unpack16(&event->state, buffer);
+		safe_unpackstr_xmalloc(&event->partition, &uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&event->nodes, &uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&event->reason, &uint32_tmp, buffer);
+	}
+	*msg_ptr = msg;
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_event_notify_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
 static void _pack_kvs_host_rec(struct kvs_hosts *msg_ptr, Buf buffer,
 			       uint16_t protocol_version)
 {
@@ -10905,7 +11291,37 @@ static void _pack_slurmd_status(slurmd_status_t *msg, Buf buffer,
 {
 	xassert(msg);
 
-	if (protocol_version >= SLURM_2_5_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_14_11_PROTOCOL_VERSION) {
+		pack_time(msg->booted, buffer);
+		pack_time(msg->last_slurmctld_msg, buffer);
+
+		pack16(msg->slurmd_debug, buffer);
+		pack16(msg->actual_cpus, buffer);
+		pack16(msg->actual_boards, buffer);
+		pack16(msg->actual_sockets, buffer);
+		pack16(msg->actual_cores, buffer);
+		pack16(msg->actual_threads, buffer);
+
+		pack32(msg->actual_real_mem, buffer);
+		pack32(msg->actual_tmp_disk, buffer);
+		pack32(msg->pid, buffer);
+
+		pack16(msg->stepd_pool_size, buffer);
+		pack16(msg->stepd_pool_idle, buffer);
+		pack32(msg->stepd_pool_hits, buffer);
+		pack32(msg->stepd_pool_misses, buffer);
+		pack16_array(msg->rpc_type_id, msg->rpc_type_size, buffer);
+		pack32_array(msg->rpc_type_cnt, msg->rpc_type_size, buffer);
+		pack32_array(msg->rpc_type_ave_time, msg->rpc_type_size,
+			     buffer);
+		pack32_array(msg->rpc_type_max_time, msg->rpc_type_size,
+			     buffer);
+
+		packstr(msg->hostname, buffer);
+		packstr(msg->slurmd_logfile, buffer);
+		packstr(msg->step_list, buffer);
+		packstr(msg->version, buffer);
+	} else if (protocol_version >= SLURM_2_5_PROTOCOL_VERSION) {
 		pack_time(msg->booted, buffer);
 		pack_time(msg->last_slurmctld_msg, buffer);
 
@@ -10940,7 +11356,48 @@ static int _unpack_slurmd_status(slurmd_status_t **msg_ptr, Buf buffer,
 
 	msg = xmalloc(sizeof(slurmd_status_t));
 
-	if (protocol_version >= SLURM_2_5_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_14_11_PROTOCOL_VERSION) {
+		safe_unpack_time(&msg->booted, buffer);
+		safe_unpack_time(&msg->last_slurmctld_msg, buffer);
+
+		safe_unpack16(&msg->slurmd_debug, buffer);
+		safe_unpack16(&msg->actual_cpus, buffer);
+		safe_unpack16(&msg->actual_boards, buffer);
+		safe_unpack16(&msg->actual_sockets, buffer);
+		safe_unpack16(&msg->actual_cores, buffer);
+		safe_unpack16(&msg->actual_threads, buffer);
+
+		safe_unpack32(&msg->actual_real_mem, buffer);
+		safe_unpack32(&msg->actual_tmp_disk, buffer);
+		safe_unpack32(&msg->pid, buffer);
+
+		safe_unpack16(&msg->stepd_pool_size, buffer);
+		safe_unpack16(&msg->stepd_pool_idle, buffer);
+		safe_unpack32(&msg->stepd_pool_hits, buffer);
+		safe_unpack32(&msg->stepd_pool_misses, buffer);
+		safe_unpack16_array(&msg->rpc_type_id, &msg->rpc_type_size,
+				    buffer);
+		safe_unpack32_array(&msg->rpc_type_cnt, &uint32_tmp, buffer);
+		if (uint32_tmp != msg->rpc_type_size)
+			goto unpack_error;
+		safe_unpack32_array(&msg->rpc_type_ave_time, &uint32_tmp,
+				    buffer);
+		if (uint32_tmp != msg->rpc_type_size)
+			goto unpack_error;
+		safe_unpack32_array(&msg->rpc_type_max_time, &uint32_tmp,
+				    buffer);
+		if (uint32_tmp != msg->rpc_type_size)
+			goto unpack_error;
+
+		safe_unpackstr_xmalloc(&msg->hostname,
+					&uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&msg->slurmd_logfile,
+					&uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&msg->step_list,
+					&uint32_tmp, buffer);
+		safe_unpackstr_xmalloc(&msg->version,
+					&uint32_tmp, buffer);
+	} else if (protocol_version >= SLURM_2_5_PROTOCOL_VERSION) {
 		safe_unpack_time(&msg->booted, buffer);
 		safe_unpack_time(&msg->last_slurmctld_msg, buffer);
 
@@ -11406,6 +11863,32 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 			safe_unpack32(&msg->bf_depth_try_sum,	buffer);
 			safe_unpack32(&msg->bf_queue_len_sum,	buffer);
 			safe_unpack32(&msg->bf_active,		buffer);
+
+			if (protocol_version >= SLURM_14_11_PROTOCOL_VERSION) {
+				safe_unpack32(&msg->job_submit_cnt, buffer);
+				safe_unpack32(&msg->job_submit_time_max,
+					      buffer);
+				safe_unpack32(&msg->job_submit_time_sum,
+					      buffer);
+				safe_unpack32(&msg->job_modify_cnt, buffer);
+				safe_unpack32(&msg->job_modify_time_max,
+					      buffer);
+				safe_unpack32(&msg->job_modify_time_sum,
+					      buffer);
+
+				safe_unpack32(&msg->acct_limit_eval_cnt,
+					      buffer);
+				safe_unpack32(&msg->acct_limit_eval_last,
+					      buffer);
+				safe_unpack32(&msg->acct_limit_cached_cnt,
+					      buffer);
+
+				safe_unpack32(&msg->gang_cycle_counter,
+					      buffer);
+				safe_unpack32(&msg->gang_cycle_last, buffer);
+				safe_unpack32(&msg->gang_cycle_max, buffer);
+				safe_unpack32(&msg->gang_cycle_sum, buffer);
+			}
 		}
 	} else {
 		error("_unpack_stats_response_msg: protocol_version "
@@ -91,6 +91,14 @@ extern int unpack_header ( header_t * header , Buf buffer );
  */
 extern int pack_msg ( slurm_msg_t const * msg , Buf buffer );
 
+/* pack_msg_prepacked
+ * IN msg - message to be sent
+ * RET true if the message body is a buffer packed in advance, which
+ *	pack_msg() would only copy, so that the sender may transmit it as
+ *	a separate segment instead
+ */
+extern bool pack_msg_prepacked(slurm_msg_t const *msg);
+
 /* unpack_msg
  * unpacks a generic slurm protocol message body
  * OUT msg - the body structure to unpack (note: includes message type)
@@ -52,6 +52,7 @@
 #include <sys/poll.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdarg.h>
@@ -212,8 +213,26 @@ ssize_t _slurm_msg_sendto(slurm_fd_t fd, char *buffer, size_t size,
 ssize_t _slurm_msg_sendto_timeout(slurm_fd_t fd, char *buffer, size_t size,
 				  uint32_t flags, int timeout)
 {
-	int   len;
-	uint32_t usize;
+	struct iovec iov;
+
+	iov.iov_base = buffer;
+	iov.iov_len  = size;
+	return _slurm_msg_sendv_timeout(fd, &iov, 1, flags, timeout);
+}
+
+ssize_t _slurm_msg_sendv(slurm_fd_t fd, struct iovec *iov, int iovcnt,
+			 uint32_t flags)
+{
+	return _slurm_msg_sendv_timeout(fd, iov, iovcnt, flags,
+					(slurm_get_msg_timeout() * 1000));
+}
+
+ssize_t _slurm_msg_sendv_timeout(slurm_fd_t fd, struct iovec *iov,
+				 int iovcnt, uint32_t flags, int timeout)
+{
+	int   i, len;
+	uint32_t usize = 0;
+	struct iovec *msg_iov;
 	SigFunc *ohandler;
 
 	/*
@@ -222,18 +241,22 @@ ssize_t _slurm_msg_sendto_timeout(slurm_fd_t fd, char *buffer, size_t size,
 	 */
 	ohandler = xsignal(SIGPIPE, SIG_IGN);
 
-	usize = htonl(size);
-
-	if ((len = _slurm_send_timeout(
-				fd, (char *)&usize, sizeof(usize), 0,
-				timeout)) < 0)
-		goto done;
-
-	if ((len = _slurm_send_timeout(fd, buffer, size, 0, timeout)) < 0)
-		goto done;
+	/* Send the length prefix and all segments with a single call
+	 * rather than one per segment */
+	msg_iov = xmalloc(sizeof(struct iovec) * (iovcnt + 1));
+	for (i = 0; i < iovcnt; i++) {
+		usize += iov[i].iov_len;
+		msg_iov[i + 1] = iov[i];
+	}
+	usize = htonl(usize);
+	msg_iov[0].iov_base = &usize;
+	msg_iov[0].iov_len  = sizeof(usize);
 
+	len = _slurm_sendv_timeout(fd, msg_iov, iovcnt + 1, 0, timeout);
+	if (len >= 0)
+		len -= sizeof(usize);
+	xfree(msg_iov);
 
-     done:
 	xsignal(SIGPIPE, ohandler);
 	return len;
 }
@@ -243,14 +266,35 @@ ssize_t _slurm_msg_sendto_timeout(slurm_fd_t fd, char *buffer, size_t size,
 int _slurm_send_timeout(slurm_fd_t fd, char *buf, size_t size,
 			uint32_t flags, int timeout)
 {
-	int rc;
+	struct iovec iov;
+
+	iov.iov_base = buf;
+	iov.iov_len  = size;
+	return _slurm_sendv_timeout(fd, &iov, 1, flags, timeout);
+}
+
+/* Send the segments of a slurm message with timeout, the contents of iov
+ * are modified as data is sent
+ * RET total size of all segments or SLURM_ERROR on error */
+int _slurm_sendv_timeout(slurm_fd_t fd, struct iovec *iov, int iovcnt,
+			 uint32_t flags, int timeout)
+{
+	int rc, i;
 	int sent = 0;
+	size_t size = 0;
 	int fd_flags;
 	struct pollfd ufds;
 	struct timeval tstart;
+	struct msghdr msg;
 	int timeleft = timeout;
 	char temp[2];
 
+	for (i = 0; i < iovcnt; i++)
+		size += iov[i].iov_len;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov    = iov;
+	msg.msg_iovlen = iovcnt;
+
 	ufds.fd     = fd;
 	ufds.events = POLLOUT;
 
@@ -307,7 +351,7 @@ int _slurm_send_timeout(slurm_fd_t fd, char *buf, size_t size,
 			      ufds.revents);
 		}
 
-		rc = _slurm_send(fd, &buf[sent], (size - sent), flags);
+		rc = sendmsg(fd, &msg, flags);
 		if (rc < 0) {
  			if (errno == EINTR)
 				continue;
@@ -331,6 +375,17 @@ int _slurm_send_timeout(slurm_fd_t fd, char *buf, size_t size,
 		}
 
 		sent += rc;
+		/* skip over the segments (or part thereof) just sent */
+		while (msg.msg_iovlen && (rc >= msg.msg_iov->iov_len)) {
+			rc -= msg.msg_iov->iov_len;
+			msg.msg_iov++;
+			msg.msg_iovlen--;
+		}
+		if (rc) {
+			msg.msg_iov->iov_base =
+				(char *) msg.msg_iov->iov_base + rc;
+			msg.msg_iov->iov_len -= rc;
+		}
 	}
 
     done:
@@ -50,6 +50,8 @@
 /* defined here but is really tree plugin related */
 struct switch_record *switch_record_table = NULL;
 int switch_record_cnt = 0;
+int *node_switch_inx = NULL;
+int *node_switch_offset = NULL;
 
 /* ************************************************************************ */
 /*  TAG(                        slurm_topo_ops_t                         )  */
@@ -180,3 +182,58 @@ slurm_topo_get_node_addr( char* node_name, char ** addr, char** pattern )
 	return (*(ops.get_node_addr))(node_name,addr,pattern);
 }
 
+
+/* *********************************************************************** */
+/*  TAG(                      build_node_switch_index                   )  */
+/* NOTE: Called by the topology plugin once switch_record_table is built   */
+/* *********************************************************************** */
+extern void
+build_node_switch_index( int node_cnt )
+{
+	int first, last, i, j;
+	int *fill;
+	struct switch_record *switch_ptr;
+
+	free_node_switch_index();
+	node_switch_offset = xmalloc(sizeof(int) * (node_cnt + 1));
+	switch_ptr = switch_record_table;
+	for (j = 0; j < switch_record_cnt; j++, switch_ptr++) {
+		if (!switch_ptr->node_bitmap ||
+		    ((first = bit_ffs(switch_ptr->node_bitmap)) < 0))
+			continue;
+		last = MIN(bit_fls(switch_ptr->node_bitmap), node_cnt - 1);
+		for (i = first; i <= last; i++) {
+			if (bit_test(switch_ptr->node_bitmap, i))
+				node_switch_offset[i+1]++;
+		}
+	}
+	for (i = 0; i < node_cnt; i++)
+		node_switch_offset[i+1] += node_switch_offset[i];
+
+	node_switch_inx = xmalloc(sizeof(int) *
+				  (node_switch_offset[node_cnt] + 1));
+	fill = xmalloc(sizeof(int) * (node_cnt + 1));
+	switch_ptr = switch_record_table;
+	for (j = 0; j < switch_record_cnt; j++, switch_ptr++) {
+		if (!switch_ptr->node_bitmap ||
+		    ((first = bit_ffs(switch_ptr->node_bitmap)) < 0))
+			continue;
+		last = MIN(bit_fls(switch_ptr->node_bitmap), node_cnt - 1);
+		for (i = first; i <= last; i++) {
+			if (bit_test(switch_ptr->node_bitmap, i))
+				node_switch_inx[node_switch_offset[i] +
+						fill[i]++] = j;
+		}
+	}
+	xfree(fill);
+}
+
+/* *********************************************************************** */
+/*  TAG(                      free_node_switch_index                    )  */
+/* *********************************************************************** */
+extern void
+free_node_switch_index( void )
+{
+	xfree(node_switch_inx);
+	xfree(node_switch_offset);
+}
@@ -61,6 +61,13 @@ struct switch_record {
 extern struct switch_record *switch_record_table;  /* ptr to switch records */
 extern int switch_record_cnt;		/* size of switch_record_table */
 
+/* Switches containing each node, built along with switch_record_table so
+ * that per-switch counts can be gathered in one pass over a node bitmap.
+ * The switch_record_table indexes for node i are node_switch_inx[k] for
+ * node_switch_offset[i] <= k < node_switch_offset[i+1]. */
+extern int *node_switch_inx;
+extern int *node_switch_offset;		/* node_record_count + 1 entries */
+
 /*****************************************************************************\
  *  Slurm topology functions
 \*****************************************************************************/
@@ -105,4 +112,14 @@ extern bool slurm_topo_generate_node_ranking( void );
 extern int slurm_topo_get_node_addr( char* node_name, char** addr,
 				     char** pattern );
 
+/*
+ * build_node_switch_index - build node_switch_inx and node_switch_offset
+ *	from the node_bitmap of every entry in switch_record_table
+ * IN node_cnt - number of nodes in the system
+ */
+extern void build_node_switch_index( int node_cnt );
+
+/* free_node_switch_index - free node_switch_inx and node_switch_offset */
+extern void free_node_switch_index( void );
+
 #endif /*__SLURM_CONTROLLER_TOPO_PLUGIN_API_H__*/
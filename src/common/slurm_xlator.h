@@ -90,6 +90,7 @@
 #define	bit_realloc		slurm_bit_realloc
 #define	bit_size		slurm_bit_size
 #define	bit_and			slurm_bit_and
+#define	bit_and_not		slurm_bit_and_not
 #define	bit_not			slurm_bit_not
 #define	bit_or			slurm_bit_or
 #define	bit_set_count		slurm_bit_set_count
@@ -142,11 +143,13 @@
 #define	hostlist_next		slurm_hostlist_next
 #define	hostlist_next_range	slurm_hostlist_next_range
 #define	hostlist_nth		slurm_hostlist_nth
+#define	hostlist_nth_range	slurm_hostlist_nth_range
 #define	hostlist_pop            slurm_hostlist_pop
 #define	hostlist_pop_range      slurm_hostlist_pop_range
 #define	hostlist_push		slurm_hostlist_push
 #define	hostlist_push_host	slurm_hostlist_push_host
 #define	hostlist_push_list	slurm_hostlist_push_list
+#define	hostlist_push_numbered	slurm_hostlist_push_numbered
 #define	hostlist_ranged_string	slurm_hostlist_ranged_string
 #define	hostlist_ranged_string_malloc \
 				slurm_hostlist_ranged_string_malloc
@@ -291,6 +294,11 @@
 /* xassert.[ch] functions */
 #define	__xassert_failed	slurm_xassert_failed
 
+/* xmalloc.[ch] functions */
+#define	xarena_create		slurm_xarena_create
+#define	xarena_count		slurm_xarena_count
+#define	xarena_destroy		slurm_xarena_destroy
+
 /* xsignal.[ch] functions */
 #define	xsignal			slurm_xsignal
 #define	xsignal_save_mask	slurm_xsignal_save_mask
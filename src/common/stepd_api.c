@@ -906,6 +906,30 @@ rwfail:
 	return -1;
 }
 
+/*
+ * Pass a connection from a slurmstepd lower in the step's stdio tree to
+ * the local slurmstepd.
+ *
+ * Returns SLURM_SUCCESS if the slurmstepd took the connection, a slurm
+ * error code if it refused it, or -1 on a communication error.
+ */
+int
+stepd_io_connect(int fd, int conn)
+{
+	int req = REQUEST_STEP_IO_CONNECT;
+	int rc;
+
+	safe_write(fd, &req, sizeof(int));
+	if (send_fd_over_pipe(fd, conn) < 0)
+		goto rwfail;
+
+	/* Receive the return code */
+	safe_read(fd, &rc, sizeof(int));
+	return rc;
+rwfail:
+	return -1;
+}
+
 /*
  *
  * Returns jobacctinfo_t struct on success, NULL on error.
@@ -234,6 +234,16 @@ int stepd_reconfig(int fd);
  */
 int stepd_completion(int fd, step_complete_msg_t *sent);
 
+/*
+ * Pass "conn", a connection from a slurmstepd lower in the step's stdio
+ * tree, to the local slurmstepd, which replies on it and relays the
+ * stdio of the remote node from then on.
+ *
+ * Returns SLURM_SUCCESS if the slurmstepd took the connection, a slurm
+ * error code if it refused it, or -1 on a communication error.
+ */
+int stepd_io_connect(int fd, int conn);
+
 /*
  *
  * Returns SLURM_SUCCESS on success or SLURM_ERROR on error.
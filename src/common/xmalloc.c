@@ -65,6 +65,16 @@
 #endif
 
 
+static int *_xarena_to_heap(void *item, size_t newsize, bool clear);
+
+/*
+ * Define slurm-specific aliases for use by plugins, see slurm_xlator.h
+ * for details.
+ */
+strong_alias(xarena_create,	slurm_xarena_create);
+strong_alias(xarena_count,	slurm_xarena_count);
+strong_alias(xarena_destroy,	slurm_xarena_destroy);
+
 #if NDEBUG
 #  define xmalloc_assert(expr)  ((void) (0))
 #else
@@ -81,9 +91,11 @@ static void malloc_assert_failed(char *, const char *, int,
 /*
  * "Safe" version of malloc().
  *   size (IN)	number of bytes to malloc
+ *   clear (IN)	initialize the memory to zero if set
  *   RETURN	pointer to allocate heap space
  */
-void *slurm_xmalloc(size_t size, const char *file, int line, const char *func)
+static void *_xmalloc(size_t size, bool clear,
+		      const char *file, int line, const char *func)
 {
 	void *new;
 	int *p;
@@ -102,10 +114,22 @@ void *slurm_xmalloc(size_t size, const char *file, int line, const char *func)
 	p[1] = (int)size;	/* store size in buffer */
 
 	new = &p[2];
-	memset(new, 0, size);
+	if (clear)
+		memset(new, 0, size);
 	return new;
 }
 
+void *slurm_xmalloc(size_t size, const char *file, int line, const char *func)
+{
+	return _xmalloc(size, true, file, line, func);
+}
+
+void *slurm_xmalloc_nz(size_t size, const char *file, int line,
+		       const char *func)
+{
+	return _xmalloc(size, false, file, line, func);
+}
+
 /*
  * same as above, except return NULL on malloc failure instead of exiting
  */
@@ -135,16 +159,21 @@ void *slurm_try_xmalloc(size_t size, const char *file, int line,
  * the object to be realloced instead of the object itself.
  *   item (IN/OUT)	double-pointer to allocated space
  *   newsize (IN)	requested size
+ *   clear (IN)	initialize any newly allocated memory to zero if set
  */
-void * slurm_xrealloc(void **item, size_t newsize,
-	              const char *file, int line, const char *func)
+static void *_xrealloc(void **item, size_t newsize, bool clear,
+		       const char *file, int line, const char *func)
 {
 	int *p = NULL;
 
 	/* xmalloc_assert(*item != NULL, file, line, func); */
 	xmalloc_assert(newsize >= 0 && (int)newsize <= INT_MAX);
 
-	if (*item != NULL) {
+	if ((*item != NULL) && (((int *)*item - 2)[0] == XMALLOC_ARENA_MAGIC)) {
+		/* arena memory can not grow in place, move it to the heap */
+		if (!(p = _xarena_to_heap(*item, newsize, clear)))
+			goto error;
+	} else if (*item != NULL) {
 		int old_size;
 		p = (int *)*item - 2;
 
@@ -159,7 +188,7 @@ void * slurm_xrealloc(void **item, size_t newsize,
 		if (p == NULL)
 			goto error;
 
-		if (old_size < newsize) {
+		if (clear && (old_size < newsize)) {
 			char *p_new = (char *)(&p[2]) + old_size;
 			memset(p_new, 0, (int)(newsize-old_size));
 		}
@@ -174,7 +203,8 @@ void * slurm_xrealloc(void **item, size_t newsize,
 		if (p == NULL)
 			goto error;
 
-		memset(&p[2], 0, newsize);
+		if (clear)
+			memset(&p[2], 0, newsize);
 		p[0] = XMALLOC_MAGIC;
 	}
 
@@ -187,6 +217,18 @@ void * slurm_xrealloc(void **item, size_t newsize,
 	abort();
 }
 
+void * slurm_xrealloc(void **item, size_t newsize,
+	              const char *file, int line, const char *func)
+{
+	return _xrealloc(item, newsize, true, file, line, func);
+}
+
+void * slurm_xrealloc_nz(void **item, size_t newsize,
+			 const char *file, int line, const char *func)
+{
+	return _xrealloc(item, newsize, false, file, line, func);
+}
+
 /*
  * same as above, but return <= 0 on malloc() failure instead of aborting.
  * `*item' will be unchanged.
@@ -199,7 +241,10 @@ int slurm_try_xrealloc(void **item, size_t newsize,
 	/* xmalloc_assert(*item != NULL, file, line, func); */
 	xmalloc_assert(newsize >= 0 && (int)newsize <= INT_MAX);
 
-	if (*item != NULL) {
+	if ((*item != NULL) && (((int *)*item - 2)[0] == XMALLOC_ARENA_MAGIC)) {
+		if (!(p = _xarena_to_heap(*item, newsize, true)))
+			return 0;
+	} else if (*item != NULL) {
 		int old_size;
 		p = (int *)*item - 2;
 
@@ -247,7 +292,8 @@ int slurm_xsize(void *item, const char *file, int line, const char *func)
 {
 	int *p = (int *)item - 2;
 	xmalloc_assert(item != NULL);
-	xmalloc_assert(p[0] == XMALLOC_MAGIC); /* CLANG false positive here */
+	xmalloc_assert((p[0] == XMALLOC_MAGIC) ||	/* CLANG false positive */
+		       (p[0] == XMALLOC_ARENA_MAGIC));
 	return p[1];
 }
 
@@ -260,6 +306,11 @@ void slurm_xfree(void **item, const char *file, int line, const char *func)
 {
 	if (*item != NULL) {
 		int *p = (int *)*item - 2;
+		/* released along with the rest of its arena */
+		if (p[0] == XMALLOC_ARENA_MAGIC) {
+			*item = NULL;
+			return;
+		}
 		/* magic cookie still there? */
 		xmalloc_assert(p[0] == XMALLOC_MAGIC);
 		p[0] = 0;	/* make sure xfree isn't called twice */
@@ -270,6 +321,133 @@ void slurm_xfree(void **item, const char *file, int line, const char *func)
 	}
 }
 
+/*
+ * Arena allocation. An arena is a list of large blocks from which
+ * allocations are carved out sequentially. Each allocation carries the same
+ * two int header as xmalloc() memory, but with XMALLOC_ARENA_MAGIC, so that
+ * xfree(), xrealloc() and xsize() work unchanged on it.
+ */
+#define XARENA_BLOCK_SIZE	8192
+#define XARENA_BLOCK_MAX	(256 * 1024)
+
+struct xarena_block {
+	struct xarena_block *next;
+	size_t size;		/* bytes of data following this header */
+	size_t used;		/* bytes of data handed out */
+};
+
+struct xarena {
+	struct xarena_block *block_list;
+	size_t block_size;	/* size of the next block to allocate */
+	uint32_t alloc_cnt;	/* number of allocations made */
+};
+
+/* Copy the contents of arena memory into a new heap allocation of newsize
+ * bytes. Returns the heap allocation's header or NULL on malloc failure */
+static int *_xarena_to_heap(void *item, size_t newsize, bool clear)
+{
+	int *old = (int *)item - 2, *p;
+	size_t old_size = old[1];
+
+	MALLOC_LOCK();
+	p = (int *)malloc(newsize + 2*sizeof(int));
+	MALLOC_UNLOCK();
+	if (p == NULL)
+		return NULL;
+
+	p[0] = XMALLOC_MAGIC;
+	memcpy(&p[2], item, MIN(old_size, newsize));
+	if (clear && (old_size < newsize))
+		memset((char *)(&p[2]) + old_size, 0, newsize - old_size);
+	return p;
+}
+
+xarena_t *xarena_create(void)
+{
+	xarena_t *arena;
+
+	MALLOC_LOCK();
+	arena = malloc(sizeof(xarena_t));
+	MALLOC_UNLOCK();
+	if (!arena) {
+		log_oom(__FILE__, __LINE__, __CURRENT_FUNC__);
+		abort();
+	}
+	arena->block_list = NULL;
+	arena->block_size = XARENA_BLOCK_SIZE;
+	arena->alloc_cnt = 0;
+	return arena;
+}
+
+void *slurm_xarena_alloc(xarena_t *arena, size_t size,
+			 const char *file, int line, const char *func)
+{
+	struct xarena_block *block = arena->block_list;
+	size_t need, block_size;
+	int *p;
+
+	xmalloc_assert(size >= 0 && size <= INT_MAX);
+	/* keep every allocation 8 byte aligned */
+	need = (size + 2*sizeof(int) + 7) & ~((size_t) 7);
+
+	if (!block || ((block->size - block->used) < need)) {
+		if (need > (arena->block_size / 4)) {
+			/* large allocation, give it a block of its own
+			 * behind the current one so its free space is kept */
+			block_size = need;
+		} else {
+			block_size = arena->block_size;
+			if (arena->block_size < XARENA_BLOCK_MAX)
+				arena->block_size *= 2;
+		}
+		MALLOC_LOCK();
+		block = malloc(sizeof(struct xarena_block) + block_size);
+		MALLOC_UNLOCK();
+		if (!block) {
+			log_oom(file, line, func);
+			abort();
+		}
+		block->size = block_size;
+		block->used = 0;
+		if ((block_size == need) && arena->block_list) {
+			block->next = arena->block_list->next;
+			arena->block_list->next = block;
+		} else {
+			block->next = arena->block_list;
+			arena->block_list = block;
+		}
+	}
+
+	p = (int *)((char *)(block + 1) + block->used);
+	block->used += need;
+	arena->alloc_cnt++;
+
+	p[0] = XMALLOC_ARENA_MAGIC;
+	p[1] = (int)size;
+	memset(&p[2], 0, size);
+	return &p[2];
+}
+
+uint32_t xarena_count(xarena_t *arena)
+{
+	return arena ? arena->alloc_cnt : 0;
+}
+
+void xarena_destroy(xarena_t *arena)
+{
+	struct xarena_block *block, *next;
+
+	if (!arena)
+		return;
+	MALLOC_LOCK();
+	for (block = arena->block_list; block; block = next) {
+		next = block->next;
+		free(block);
+	}
+	free(arena);
+	MALLOC_UNLOCK();
+}
+
 #ifndef NDEBUG
 static void malloc_assert_failed(char *expr, const char *file,
 		                 int line, const char *caller, const char *func)
@@ -43,16 +43,26 @@
  * Description:
  *
  * void *xmalloc(size_t size);
+ * void *xmalloc_nz(size_t size);
  * void *try_xmalloc(size_t size);
  * void xrealloc(void *p, size_t newsize);
+ * void xrealloc_nz(void *p, size_t newsize);
  * int  try_xrealloc(void *p, size_t newsize);
  * void xfree(void *p);
  * int  xsize(void *p);
  *
+ * xarena_t *xarena_create(void);
+ * void *xarena_alloc(xarena_t *arena, size_t size);
+ * uint32_t xarena_count(xarena_t *arena);
+ * void xarena_destroy(xarena_t *arena);
+ *
  * xmalloc(size) allocates size bytes and returns a pointer to the allocated
  * memory. The memory is set to zero. xmalloc() will not return unless
  * there are no errors. The memory must be freed using xfree().
  *
+ * xmalloc_nz(size) is the same as above, but the memory is not initialized.
+ * It is meant for buffers which are always written before they are read.
+ *
  * try_xmalloc(size) is the same as above, but a NULL pointer is returned
  * when there is an error allocating the memory.
  *
@@ -62,6 +72,9 @@
  * is not NULL, it is required to have been initialized with a call to
  * [try_]xmalloc() or [try_]xrealloc().
  *
+ * xrealloc_nz(p, newsize) is the same as above, but newly allocated memory
+ * is not initialized.
+ *
  * try_xrealloc(p, newsize) is the same as above, but returns <= 0 if the
  * there is an error allocating the requested memory.
  *
@@ -72,6 +85,14 @@
  * p. The memory must have been allocated with [try_]xmalloc() or
  * [try_]xrealloc().
  *
+ * xarena_create() returns an arena from which many short-lived allocations
+ * can be carved out of a few large blocks and released all at once with
+ * xarena_destroy(). xarena_alloc(arena, size) returns zeroed memory which
+ * may be passed to xfree(), xrealloc() and xsize() like any other xmalloc()
+ * memory: xfree() only clears the pointer and xrealloc() moves the data to
+ * the heap. Memory from an arena must not be referenced after the arena is
+ * destroyed. xarena_count() returns the number of allocations made from it.
+ *
 \*****************************************************************************/
 
 #ifndef _XMALLOC_H
@@ -81,11 +102,18 @@
 #  include <sys/types.h>
 #endif
 
+#include <inttypes.h>
+
 #include "macros.h"
 
+typedef struct xarena xarena_t;
+
 #define xmalloc(__sz) \
 	slurm_xmalloc (__sz, __FILE__, __LINE__, __CURRENT_FUNC__)
 
+#define xmalloc_nz(__sz) \
+	slurm_xmalloc_nz (__sz, __FILE__, __LINE__, __CURRENT_FUNC__)
+
 #define try_xmalloc(__sz) \
 	slurm_try_xmalloc(__sz, __FILE__, __LINE__, __CURRENT_FUNC__)
 
@@ -96,6 +124,10 @@
         slurm_xrealloc((void **)&(__p), __sz, \
                        __FILE__, __LINE__, __CURRENT_FUNC__)
 
+#define xrealloc_nz(__p, __sz) \
+	slurm_xrealloc_nz((void **)&(__p), __sz, \
+			  __FILE__, __LINE__, __CURRENT_FUNC__)
+
 #define try_xrealloc(__p, __sz) \
 	slurm_try_xrealloc((void **)&(__p), __sz, \
                            __FILE__, __LINE__,  __CURRENT_FUNC__)
@@ -103,13 +135,24 @@
 #define xsize(__p) \
 	slurm_xsize((void *)__p, __FILE__, __LINE__, __CURRENT_FUNC__)
 
+#define xarena_alloc(__a, __sz) \
+	slurm_xarena_alloc(__a, __sz, __FILE__, __LINE__, __CURRENT_FUNC__)
+
 void *slurm_xmalloc(size_t, const char *, int, const char *);
+void *slurm_xmalloc_nz(size_t, const char *, int, const char *);
 void *slurm_try_xmalloc(size_t , const char *, int , const char *);
 void slurm_xfree(void **, const char *, int, const char *);
 void *slurm_xrealloc(void **, size_t, const char *, int, const char *);
+void *slurm_xrealloc_nz(void **, size_t, const char *, int, const char *);
 int  slurm_try_xrealloc(void **, size_t, const char *, int, const char *);
 int  slurm_xsize(void *, const char *, int, const char *);
 
+xarena_t *xarena_create(void);
+void *slurm_xarena_alloc(xarena_t *, size_t, const char *, int, const char *);
+uint32_t xarena_count(xarena_t *);
+void xarena_destroy(xarena_t *);
+
 #define XMALLOC_MAGIC 0x42
+#define XMALLOC_ARENA_MAGIC 0x43
 
 #endif /* !_XMALLOC_H */
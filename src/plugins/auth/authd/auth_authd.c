@@ -368,3 +368,35 @@ slurm_auth_errstr( int slurm_errno )
 		if ( tbl[ i ].err == slurm_errno ) return tbl[ i ].msg;
 	}
 }
+
+/*
+ * authd credentials have no room for application data.
+ */
+slurm_auth_credential_t *
+slurm_auth_create_data( void *argv[], char *auth_info, char *data, int len,
+			uid_t reader )
+{
+	plugin_errno = SLURM_AUTH_BADARG;
+	return NULL;
+}
+
+int
+slurm_auth_get_data( slurm_auth_credential_t *cred, char **data, int *len,
+		     char *auth_info )
+{
+	plugin_errno = SLURM_AUTH_BADARG;
+	return SLURM_ERROR;
+}
+
+slurm_auth_credential_t *
+slurm_auth_create_trusted( uid_t uid, gid_t gid )
+{
+	slurm_auth_credential_t *cred;
+
+	cred = (slurm_auth_credential_t *)
+		xmalloc( sizeof( slurm_auth_credential_t ) );
+	cred->cr_errno = SLURM_SUCCESS;
+	cred->cred.uid = uid;
+	cred->cred.gid = gid;
+	return cred;
+}
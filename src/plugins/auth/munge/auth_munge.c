@@ -152,6 +152,8 @@ static void           cred_info_destroy(munge_info_t *);
 static void           _print_cred_info(munge_info_t *mi);
 static void           _print_cred(munge_ctx_t ctx);
 static int            _decode_cred(slurm_auth_credential_t *c, char *socket);
+static slurm_auth_credential_t *_create_cred(char *socket, char *data,
+					     int len, uid_t *reader);
 
 /*
  *  Munge plugin initialization
@@ -176,6 +178,73 @@ int init ( void )
  */
 slurm_auth_credential_t *
 slurm_auth_create( void *argv[], char *socket )
+{
+	return _create_cred(socket, NULL, 0, NULL);
+}
+
+/*
+ * Allocate a credential with application specific data included in
+ * the munge payload, which is encrypted along with the credential and
+ * which munged will only decode for the reader's uid.
+ */
+slurm_auth_credential_t *
+slurm_auth_create_data( void *argv[], char *socket, char *data, int len,
+			uid_t reader )
+{
+	return _create_cred(socket, data, len, &reader);
+}
+
+/*
+ * Return a copy of the application specific data from a credential,
+ * verifying the credential first if need be.
+ */
+int
+slurm_auth_get_data( slurm_auth_credential_t *cred, char **data, int *len,
+		     char *socket )
+{
+	if (!cred || !data || !len) {
+		plugin_errno = SLURM_AUTH_BADARG;
+		return SLURM_ERROR;
+	}
+
+	xassert(cred->magic == MUNGE_MAGIC);
+
+	if ((!cred->verified) && (_decode_cred(cred, socket) < 0))
+		return SLURM_ERROR;
+
+	if (cred->len > 0) {
+		*data = xmalloc(cred->len);
+		memcpy(*data, cred->buf, cred->len);
+	} else
+		*data = NULL;
+	*len = cred->len;
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Allocate a credential which is already verified for the given uid and
+ * gid.  Used for messages authenticated without a munge credential.
+ */
+slurm_auth_credential_t *
+slurm_auth_create_trusted( uid_t uid, gid_t gid )
+{
+	slurm_auth_credential_t *cred = xmalloc(sizeof(*cred));
+
+	cred->verified = true;
+	cred->m_str    = NULL;
+	cred->buf      = NULL;
+	cred->len      = 0;
+	cred->uid      = uid;
+	cred->gid      = gid;
+	cred->cr_errno = SLURM_SUCCESS;
+
+	xassert(cred->magic = MUNGE_MAGIC);
+
+	return cred;
+}
+
+static slurm_auth_credential_t *
+_create_cred(char *socket, char *data, int len, uid_t *reader)
 {
 	int retry = 2;
 	slurm_auth_credential_t *cred = NULL;
@@ -205,6 +274,13 @@ slurm_auth_create( void *argv[], char *socket )
 		munge_ctx_destroy(ctx);
 		return NULL;
 	}
+	if (reader &&
+	    (munge_ctx_set(ctx, MUNGE_OPT_UID_RESTRICTION, *reader) !=
+	     EMUNGE_SUCCESS)) {
+		error("munge_ctx_set failure");
+		munge_ctx_destroy(ctx);
+		return NULL;
+	}
 
 	cred = xmalloc(sizeof(*cred));
 	cred->verified = false;
@@ -224,7 +300,7 @@ slurm_auth_create( void *argv[], char *socket )
 	ohandler = xsignal(SIGALRM, SIG_BLOCK);
 
     again:
-	e = munge_encode(&cred->m_str, ctx, cred->buf, cred->len);
+	e = munge_encode(&cred->m_str, ctx, data, len);
 	if (e != EMUNGE_SUCCESS) {
 		if ((e == EMUNGE_SOCKET) && retry--) {
 			error ("Munge encode failed: %s (retrying ...)",
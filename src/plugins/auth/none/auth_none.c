@@ -97,6 +97,8 @@ const char plugin_name[]       	= "Null authentication plugin";
 const char plugin_type[]       	= "auth/none";
 const uint32_t plugin_version   = 100;
 const uint32_t min_plug_version = 90;
+/* Version used for credentials which carry application data */
+const uint32_t data_plug_version = 110;
 
 /*
  * An opaque type representing authentication credentials.  This type can be
@@ -132,6 +134,8 @@ const uint32_t min_plug_version = 90;
 typedef struct _slurm_auth_credential {
 	uid_t uid;
 	gid_t gid;
+	char *data;	/* application data, carried in the clear */
+	uint32_t len;
 	int cr_errno;
 } slurm_auth_credential_t;
 
@@ -195,6 +199,7 @@ slurm_auth_destroy( slurm_auth_credential_t *cred )
 		plugin_errno = SLURM_AUTH_MEMORY;
 		return SLURM_ERROR;
 	}
+	xfree( cred->data );
 	xfree( cred );
 	return SLURM_SUCCESS;
 }
@@ -257,12 +262,14 @@ slurm_auth_pack( slurm_auth_credential_t *cred, Buf buf )
 	 * type so that it can be sanity-checked at the receiving end.
 	 */
 	packmem( (char *) plugin_type, strlen( plugin_type ) + 1, buf );
-	pack32( plugin_version, buf );
+	pack32( cred->data ? data_plug_version : plugin_version, buf );
 	/*
 	 * Pack the data values.
 	 */
 	pack32( (uint32_t) cred->uid, buf );
 	pack32( (uint32_t) cred->gid, buf );
+	if ( cred->data )
+		packmem( cred->data, cred->len, buf );
 
 	return SLURM_SUCCESS;
 }
@@ -317,11 +324,15 @@ slurm_auth_unpack( Buf buf )
 	cred->uid = tmpint;
 	safe_unpack32( &tmpint, buf );
 	cred->gid = tmpint;
+	if ( version >= data_plug_version )
+		safe_unpackmem_xmalloc( &cred->data, &cred->len, buf );
 
 	return cred;
 
   unpack_error:
 	plugin_errno = SLURM_AUTH_UNPACK;
+	if ( cred )
+		xfree( cred->data );
 	xfree( cred );
 	return NULL;
 }
@@ -386,3 +397,53 @@ slurm_auth_errstr( int slurm_errno )
 		if ( tbl[ i ].err == slurm_errno ) return tbl[ i ].msg;
 	}
 }
+
+/*
+ * Application data is not protected in any way by this plugin, it is
+ * merely carried along so that users of the data can be tested without
+ * an authentication service.
+ */
+slurm_auth_credential_t *
+slurm_auth_create_data( void *argv[], char *auth_info, char *data, int len,
+			uid_t reader )
+{
+	slurm_auth_credential_t *cred = slurm_auth_create( argv, auth_info );
+
+	if ( len > 0 ) {
+		cred->data = xmalloc( len );
+		memcpy( cred->data, data, len );
+		cred->len = len;
+	}
+	return cred;
+}
+
+int
+slurm_auth_get_data( slurm_auth_credential_t *cred, char **data, int *len,
+		     char *auth_info )
+{
+	if ( ( cred == NULL ) || ( data == NULL ) || ( len == NULL ) ) {
+		plugin_errno = SLURM_AUTH_BADARG;
+		return SLURM_ERROR;
+	}
+
+	if ( cred->len ) {
+		*data = xmalloc( cred->len );
+		memcpy( *data, cred->data, cred->len );
+	} else
+		*data = NULL;
+	*len = cred->len;
+	return SLURM_SUCCESS;
+}
+
+slurm_auth_credential_t *
+slurm_auth_create_trusted( uid_t uid, gid_t gid )
+{
+	slurm_auth_credential_t *cred;
+
+	cred = ((slurm_auth_credential_t *)
+		xmalloc( sizeof( slurm_auth_credential_t ) ));
+	cred->cr_errno = SLURM_SUCCESS;
+	cred->uid = uid;
+	cred->gid = gid;
+	return cred;
+}
@@ -50,6 +50,7 @@
 #include <stdio.h>
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -102,8 +103,11 @@ const uint32_t plugin_version   = 110;
 const uint32_t min_plug_version = 100;
 
 static const char lua_script_path[] = DEFAULT_SCRIPT_DIR "/job_submit.lua";
+static time_t lua_script_last_check = (time_t) 0;
+static time_t lua_script_last_loaded = (time_t) 0;
 static lua_State *L = NULL;
 static char *user_msg;
+static time_t part_cache_update = (time_t) 0;
 
 /*
  *  Mutex for protecting multi-threaded access to this plugin.
@@ -216,7 +220,7 @@ static const struct luaL_Reg slurm_functions [] = {
 	{ NULL,		NULL        }
 };
 
-static void _register_lua_slurm_output_functions (void)
+static void _register_lua_slurm_output_functions (lua_State *L)
 {
 	/*
 	 *  Register slurm output functions in a global "slurm" table
@@ -688,7 +692,7 @@ static int _get_part_rec_field (lua_State *L)
 	uid_t *allow_uids;	/* zero terminated list of allowed users */
 #endif
 
-static void _register_lua_slurm_struct_functions (void)
+static void _register_lua_slurm_struct_functions (lua_State *L)
 {
 	lua_pushcfunction(L, _get_job_rec_field);
 	lua_setglobal(L, "_get_job_rec_field");
@@ -703,7 +707,7 @@ static void _register_lua_slurm_struct_functions (void)
 /*
  *  check that global symbol [name] in lua script is a function
  */
-static int _check_lua_script_function(const char *name)
+static int _check_lua_script_function(lua_State *L, const char *name)
 {
 	int rc = 0;
 	lua_getglobal(L, name);
@@ -716,7 +720,7 @@ static int _check_lua_script_function(const char *name)
 /*
  *   Verify all required functions are defined in the job_submit/lua script
  */
-static int _check_lua_script_functions(void)
+static int _check_lua_script_functions(lua_State *L)
 {
 	int rc = 0;
 	int i;
@@ -728,7 +732,7 @@ static int _check_lua_script_functions(void)
 
 	i = 0;
 	do {
-		if (_check_lua_script_function(fns[i]) < 0) {
+		if (_check_lua_script_function(L, fns[i]) < 0) {
 			error("job_submit/lua: %s: "
 			      "missing required function %s",
 			      lua_script_path, fns[i]);
@@ -763,21 +767,55 @@ static bool _user_can_use_part(uint32_t user_id, uint32_t submit_uid,
 	return false;
 }
 
+/*
+ *  Push the list of partitions which a user can use. The lists are kept
+ *   in the "part_cache" registry table, indexed by user ID and whether
+ *   the request comes from root, until the partition table next changes.
+ *   Each call gets its own copy of the cached list, so a script modifying
+ *   it does not affect later calls.
+ */
 static void _push_partition_list(uint32_t user_id, uint32_t submit_uid)
 {
-	int i = 1;
+	int i = 1, cnt;
 	ListIterator part_iterator;
 	struct part_record *part_ptr;
+	lua_Number key = ((lua_Number) user_id * 2) + (submit_uid == 0);
 
-	lua_newtable(L);
-	part_iterator = list_iterator_create(part_list);
-	while ((part_ptr = (struct part_record *) list_next(part_iterator))) {
-		if (!_user_can_use_part(user_id, submit_uid, part_ptr))
-			continue;
-		lua_pushlightuserdata (L, part_ptr);
-		lua_rawseti(L, -2, i++);
+	if (part_cache_update != last_part_update) {
+		lua_newtable(L);
+		lua_setfield(L, LUA_REGISTRYINDEX, "part_cache");
+		part_cache_update = last_part_update;
 	}
-	list_iterator_destroy(part_iterator);
+	lua_getfield(L, LUA_REGISTRYINDEX, "part_cache");
+	lua_pushnumber(L, key);
+	lua_rawget(L, -2);
+	if (lua_isnil(L, -1)) {
+		lua_pop(L, 1);
+		lua_newtable(L);
+		part_iterator = list_iterator_create(part_list);
+		while ((part_ptr = (struct part_record *)
+				   list_next(part_iterator))) {
+			if (!_user_can_use_part(user_id, submit_uid, part_ptr))
+				continue;
+			lua_pushlightuserdata (L, part_ptr);
+			lua_rawseti(L, -2, i++);
+		}
+		list_iterator_destroy(part_iterator);
+
+		lua_pushnumber(L, key);
+		lua_pushvalue(L, -2);
+		lua_rawset(L, -4);
+	}
+	lua_remove(L, -2);
+
+	/* Replace the cached list with a copy of it */
+	cnt = lua_objlen(L, -1);
+	lua_createtable(L, cnt, 0);
+	for (i = 1; i <= cnt; i++) {
+		lua_rawgeti(L, -2, i);
+		lua_rawseti(L, -2, i);
+	}
+	lua_remove(L, -2);
 }
 
 static void _push_job_desc(struct job_descriptor *job_desc)
@@ -794,6 +832,96 @@ static void _push_job_rec(struct job_record *job_ptr)
 	lua_setfield(L, -2, "job_rec_ptr");
 }
 
+/*
+ *  Load the job_submit/lua script into a new lua state.
+ *  RET the new state or NULL on error
+ */
+static lua_State *_load_script(void)
+{
+	lua_State *new_L;
+	int rc;
+
+	new_L = luaL_newstate();
+	luaL_openlibs(new_L);
+	if (luaL_loadfile(new_L, lua_script_path)) {
+		error("lua: %s: %s", lua_script_path, lua_tostring(new_L, -1));
+		lua_close(new_L);
+		return NULL;
+	}
+
+	/*
+	 *  Register SLURM functions in lua state:
+	 *  logging and slurm structure read/write functions
+	 */
+	_register_lua_slurm_output_functions(new_L);
+	_register_lua_slurm_struct_functions(new_L);
+
+	/*
+	 *  Run the user script:
+	 */
+	if (lua_pcall(new_L, 0, 1, 0) != 0) {
+		error("job_submit/lua: %s: %s",
+		      lua_script_path, lua_tostring (new_L, -1));
+		lua_close(new_L);
+		return NULL;
+	}
+
+	/*
+	 *  Get any return code from the lua script
+	 */
+	rc = (int) lua_tonumber(new_L, -1);
+	lua_pop (new_L, 1);
+	if (rc != SLURM_SUCCESS) {
+		error("job_submit/lua: %s: returned %d", lua_script_path, rc);
+		lua_close(new_L);
+		return NULL;
+	}
+
+	/*
+	 *  Check for required lua script functions:
+	 */
+	if (_check_lua_script_functions(new_L) < 0) {
+		lua_close(new_L);
+		return NULL;
+	}
+
+	lua_newtable(new_L);
+	lua_setfield(new_L, LUA_REGISTRYINDEX, "part_cache");
+
+	return new_L;
+}
+
+/*
+ *  Load the script again if it has been modified since it was loaded,
+ *   checking at most once per second. The current script stays in use
+ *   if the new one can not be loaded.
+ */
+static void _reload_script(void)
+{
+	struct stat st;
+	lua_State *new_L;
+	time_t now = time(NULL);
+
+	if (now == lua_script_last_check)
+		return;
+	lua_script_last_check = now;
+
+	if ((stat(lua_script_path, &st) != 0) ||
+	    (st.st_mtime == lua_script_last_loaded))
+		return;
+	lua_script_last_loaded = st.st_mtime;
+
+	if (!(new_L = _load_script())) {
+		error("job_submit/lua: %s: reload failed, previous script "
+		      "remains in use", lua_script_path);
+		return;
+	}
+	lua_close(L);
+	L = new_L;
+	part_cache_update = (time_t) 0;
+	info("job_submit/lua: %s: reloaded", lua_script_path);
+}
+
 /*
  *  NOTE: The init callback should never be called multiple times,
  *   let alone called from multiple threads. Therefore, locking
@@ -801,7 +929,7 @@ static void _push_job_rec(struct job_record *job_ptr)
  */
 int init (void)
 {
-	int rc = SLURM_SUCCESS;
+	struct stat st;
 
 	/*
 	 *  Need to dlopen() liblua.so with RTLD_GLOBAL in order to
@@ -818,45 +946,22 @@ int init (void)
 	/*
 	 *  Initilize lua
 	 */
-	L = luaL_newstate();
-	luaL_openlibs(L);
-	if (luaL_loadfile(L, lua_script_path)) {
-		return error("lua: %s: %s", lua_script_path,
-			     lua_tostring(L, -1));
-	}
-
-	/*
-	 *  Register SLURM functions in lua state:
-	 *  logging and slurm structure read/write functions
-	 */
-	_register_lua_slurm_output_functions();
-	_register_lua_slurm_struct_functions();
+	if (stat(lua_script_path, &st) == 0)
+		lua_script_last_loaded = st.st_mtime;
+	lua_script_last_check = time(NULL);
+	if (!(L = _load_script()))
+		return SLURM_ERROR;
 
-	/*
-	 *  Run the user script:
-	 */
-	if (lua_pcall(L, 0, 1, 0) != 0) {
-		return error("job_submit/lua: %s: %s",
-			     lua_script_path, lua_tostring (L, -1));
-	}
-
-	/*
-	 *  Get any return code from the lua script
-	 */
-	rc = (int) lua_tonumber(L, -1);
-	lua_pop (L, 1);
-	if (rc != SLURM_SUCCESS)
-		return rc;
-
-	/*
-	 *  Check for required lua script functions:
-	 */
-	return (_check_lua_script_functions());
+	return SLURM_SUCCESS;
 }
 
 int fini (void)
 {
-	lua_close (L);
+	if (L) {
+		lua_close (L);
+		L = NULL;
+	}
+	part_cache_update = (time_t) 0;
 	return SLURM_SUCCESS;
 }
 
@@ -868,6 +973,8 @@ extern int job_submit(struct job_descriptor *job_desc, uint32_t submit_uid,
 	int rc = SLURM_ERROR;
 	slurm_mutex_lock (&lua_lock);
 
+	_reload_script();
+
 	/*
 	 *  All lua script functions should have been verified during
 	 *   initialization:
@@ -912,6 +1019,8 @@ extern int job_modify(struct job_descriptor *job_desc,
 	int rc = SLURM_ERROR;
 	slurm_mutex_lock (&lua_lock);
 
+	_reload_script();
+
 	/*
 	 *  All lua script functions should have been verified during
 	 *   initialization:
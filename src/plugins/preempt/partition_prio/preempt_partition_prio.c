@@ -48,6 +48,7 @@
 #include "src/common/plugin.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/job_scheduler.h"
+#include "src/slurmctld/preempt.h"
 
 const char	plugin_name[]	= "Preempt by partition priority plugin";
 const char	plugin_type[]	= "preempt/partition_prio";
@@ -103,32 +104,29 @@ extern List find_preemptable_jobs(struct job_record *job_ptr)
 		return preemptee_job_list;
 	}
 
-	/* Build an array of pointers to preemption candidates */
-	job_iterator = list_iterator_create(job_list);
+	/* Running jobs in the partition's nodes, already in priority order */
+	preemptee_job_list = preempt_find_running_jobs(job_ptr->part_ptr->
+						       node_bitmap,
+						       _sort_by_prio);
+	if (preemptee_job_list == NULL)
+		return preemptee_job_list;
+
+	/* Remove the jobs which are not preemption candidates */
+	job_iterator = list_iterator_create(preemptee_job_list);
 	while ((job_p = (struct job_record *) list_next(job_iterator))) {
-		if (!IS_JOB_RUNNING(job_p) && !IS_JOB_SUSPENDED(job_p))
-			continue;
 		if ((job_p->part_ptr == NULL) ||
 		    (job_p->part_ptr->priority >= job_ptr->part_ptr->priority))
-			continue;
-		if ((job_p->node_bitmap == NULL) ||
-		    (bit_overlap(job_p->node_bitmap,
-				 job_ptr->part_ptr->node_bitmap) == 0))
-			continue;
-		if (job_ptr->details &&
-		    (job_ptr->details->expanding_jobid == job_p->job_id))
-			continue;
-
-		/* This job is a preemption candidate */
-		if (preemptee_job_list == NULL) {
-			preemptee_job_list = list_create(NULL);
-		}
-		list_append(preemptee_job_list, job_p);
+			list_delete_item(job_iterator);
+		else if (job_ptr->details &&
+			 (job_ptr->details->expanding_jobid == job_p->job_id))
+			list_delete_item(job_iterator);
 	}
 	list_iterator_destroy(job_iterator);
 
-	if (preemptee_job_list)
-		list_sort(preemptee_job_list, _sort_by_prio);
+	if (list_count(preemptee_job_list) == 0) {
+		list_destroy(preemptee_job_list);
+		preemptee_job_list = NULL;
+	}
 	return preemptee_job_list;
 }
 
@@ -81,6 +81,11 @@
 
 #define MIN_USAGE_FACTOR 0.01
 
+/* Pending jobs handled by each thread when recalculating priorities, and
+ * the most threads used for one pass */
+#define PRIO_JOBS_PER_THREAD	2000
+#define MAX_PRIO_THREADS	8
+
 /* These are defined here so when we link with something other than
  * the slurmctld we will have these symbols defined.  They will get
  * overwritten when linking with the slurmctld.
@@ -155,6 +160,25 @@ static uint32_t max_tickets; /* Maximum number of tickets given to a
 static time_t g_last_ran = 0; /* when the last poll ran */
 static double decay_factor = 1; /* The decay factor when decaying time. */
 
+/* A pending job's newly calculated priority, waiting to be stored in the
+ * job record by _update_job_priorities() */
+typedef struct prio_update {
+	struct job_record *job_ptr;
+	uint32_t job_id;
+	uint32_t priority;
+	uint32_t *priority_array;
+	int part_cnt;
+	bool unchanged;		/* priority unchanged, nothing to store */
+	priority_factors_object_t factors;
+} prio_update_t;
+
+typedef struct prio_calc_args {
+	prio_update_t *updates;
+	int begin;
+	int end;
+	time_t start_time;
+} prio_calc_args_t;
+
 extern void priority_p_set_assoc_usage(slurmdb_association_rec_t *assoc);
 extern double priority_p_calc_fs_factor(long double usage_efctv,
 					long double shares_norm);
@@ -502,10 +526,66 @@ static int _distribute_tickets(List children_list, uint32_t tickets)
 }
 
 
+/* Return the association whose usage determines the fairshare factor of
+ * job_assoc, i.e. the first ancestor not set to FairShare=parent.
+ *
+ * NOTE: acct_mgr_association_lock must be locked before this is called.
+ */
+static slurmdb_association_rec_t *_get_fs_assoc(
+	slurmdb_association_rec_t *job_assoc)
+{
+	slurmdb_association_rec_t *fs_assoc = job_assoc;
+
+	/* Use values from parent when FairShare=SLURMDB_FS_USE_PARENT */
+	while ((fs_assoc->shares_raw == SLURMDB_FS_USE_PARENT)
+	       && fs_assoc->usage->parent_assoc_ptr
+	       && (fs_assoc != assoc_mgr_root_assoc)) {
+		fs_assoc = fs_assoc->usage->parent_assoc_ptr;
+	}
+
+	return fs_assoc;
+}
+
+/* Make sure the effective usage a job's fairshare factor is based upon, and
+ * the factor itself, are current.  The effective usage is cached in the
+ * association until the decay thread invalidates it again, so every other
+ * job of the same association reuses it.  The fairshare factor is cached
+ * alongside and only recomputed when the effective usage or normalized
+ * shares it was computed from changed.
+ *
+ * NOTE: acct_mgr_association_lock must be write locked before this is called.
+ */
+static void _set_job_usage_efctv(struct job_record *job_ptr)
+{
+	slurmdb_association_rec_t *fs_assoc;
+	assoc_mgr_association_usage_t *usage;
+
+	if (!calc_fairshare || !job_ptr->assoc_ptr)
+		return;
+
+	fs_assoc = _get_fs_assoc(
+		(slurmdb_association_rec_t *)job_ptr->assoc_ptr);
+	usage = fs_assoc->usage;
+	if (fuzzy_equal(usage->usage_efctv, NO_VAL))
+		priority_p_set_assoc_usage(fs_assoc);
+
+	if ((usage->fs_usage_efctv != usage->usage_efctv) ||
+	    (usage->fs_shares_norm != usage->shares_norm)) {
+		usage->fs_factor = priority_p_calc_fs_factor(
+			usage->usage_efctv, (long double)usage->shares_norm);
+		usage->fs_usage_efctv = usage->usage_efctv;
+		usage->fs_shares_norm = usage->shares_norm;
+	}
+}
+
 /* job_ptr should already have the partition priority and such added
  * here before had we will be adding to it
+ *
+ * If assoc_locked is set the caller already holds the association lock
+ * and has called _set_job_usage_efctv() for this job.
  */
-static double _get_fairshare_priority( struct job_record *job_ptr)
+static double _get_fairshare_priority(struct job_record *job_ptr,
+				      bool assoc_locked)
 {
 	slurmdb_association_rec_t *job_assoc =
 		(slurmdb_association_rec_t *)job_ptr->assoc_ptr;
@@ -523,16 +603,10 @@ static double _get_fairshare_priority( struct job_record *job_ptr)
 		return 0;
 	}
 
-	fs_assoc = job_assoc;
+	if (!assoc_locked)
+		assoc_mgr_lock(&locks);
 
-	assoc_mgr_lock(&locks);
-
-	/* Use values from parent when FairShare=SLURMDB_FS_USE_PARENT */
-	while ((fs_assoc->shares_raw == SLURMDB_FS_USE_PARENT)
-	       && fs_assoc->usage->parent_assoc_ptr
-	       && (fs_assoc != assoc_mgr_root_assoc)) {
-		fs_assoc = fs_assoc->usage->parent_assoc_ptr;
-	}
+	fs_assoc = _get_fs_assoc(job_assoc);
 
 	if (fuzzy_equal(fs_assoc->usage->usage_efctv, NO_VAL))
 		priority_p_set_assoc_usage(fs_assoc);
@@ -551,6 +625,15 @@ static double _get_fairshare_priority( struct job_record *job_ptr)
 			     job_ptr->job_id, job_assoc->user, job_assoc->acct,
 			     priority_fs);
 		}
+	} else if (assoc_locked) {
+		priority_fs = fs_assoc->usage->fs_factor;
+		if (priority_debug) {
+			info("Fairshare priority of job %u for user %s in acct"
+			     " %s is 2**(-%Lf/%f) = %f",
+			     job_ptr->job_id, job_assoc->user, job_assoc->acct,
+			     fs_assoc->usage->usage_efctv,
+			     fs_assoc->usage->shares_norm, priority_fs);
+		}
 	} else {
 		priority_fs = priority_p_calc_fs_factor(
 				fs_assoc->usage->usage_efctv,
@@ -563,23 +646,22 @@ static double _get_fairshare_priority( struct job_record *job_ptr)
 			     fs_assoc->usage->shares_norm, priority_fs);
 		}
 	}
-	assoc_mgr_unlock(&locks);
+	if (!assoc_locked)
+		assoc_mgr_unlock(&locks);
 
 	return priority_fs;
 }
 
-static void _get_priority_factors(time_t start_time, struct job_record *job_ptr)
+static void _get_priority_factors(time_t start_time, struct job_record *job_ptr,
+				  priority_factors_object_t *factors,
+				  bool assoc_locked)
 {
 	slurmdb_qos_rec_t *qos_ptr = NULL;
 
 	xassert(job_ptr);
+	xassert(factors);
 
-	if (!job_ptr->prio_factors)
-		job_ptr->prio_factors =
-			xmalloc(sizeof(priority_factors_object_t));
-	else
-		memset(job_ptr->prio_factors, 0,
-		       sizeof(priority_factors_object_t));
+	memset(factors, 0, sizeof(priority_factors_object_t));
 
 	qos_ptr = (slurmdb_qos_rec_t *)job_ptr->qos_ptr;
 
@@ -600,22 +682,22 @@ static void _get_priority_factors(time_t start_time, struct job_record *job_ptr)
 
 		if (job_ptr->details->begin_time) {
 			if (diff < max_age) {
-				job_ptr->prio_factors->priority_age =
+				factors->priority_age =
 					(double)diff / (double)max_age;
 			} else
-				job_ptr->prio_factors->priority_age = 1.0;
+				factors->priority_age = 1.0;
 		} else if (flags & PRIORITY_FLAGS_ACCRUE_ALWAYS) {
 			if (diff < max_age) {
-				job_ptr->prio_factors->priority_age =
+				factors->priority_age =
 					(double)diff / (double)max_age;
 			} else
-				job_ptr->prio_factors->priority_age = 1.0;
+				factors->priority_age = 1.0;
 		}
 	}
 
 	if (job_ptr->assoc_ptr && weight_fs) {
-		job_ptr->prio_factors->priority_fs =
-			_get_fairshare_priority(job_ptr);
+		factors->priority_fs =
+			_get_fairshare_priority(job_ptr, assoc_locked);
 	}
 
 	if (weight_js) {
@@ -637,12 +719,12 @@ static void _get_priority_factors(time_t start_time, struct job_record *job_ptr)
 		if (flags & PRIORITY_FLAGS_SIZE_RELATIVE) {
 			uint32_t time_limit = 1;
 			/* Job size in CPUs (based upon average CPUs/Node */
-			job_ptr->prio_factors->priority_js =
+			factors->priority_js =
 				(double)min_nodes *
 				(double)cluster_cpus /
 				(double)node_record_count;
-			if (cpu_cnt > job_ptr->prio_factors->priority_js) {
-				job_ptr->prio_factors->priority_js =
+			if (cpu_cnt > factors->priority_js) {
+				factors->priority_js =
 					(double)cpu_cnt;
 			}
 			/* Divide by job time limit */
@@ -650,88 +732,94 @@ static void _get_priority_factors(time_t start_time, struct job_record *job_ptr)
 				time_limit = job_ptr->time_limit;
 			else if (job_ptr->part_ptr)
 				time_limit = job_ptr->part_ptr->max_time;
-			job_ptr->prio_factors->priority_js /= time_limit;
+			factors->priority_js /= time_limit;
 			/* Normalize to max value of 1.0 */
-			job_ptr->prio_factors->priority_js /= cluster_cpus;
+			factors->priority_js /= cluster_cpus;
 			if (favor_small) {
-				job_ptr->prio_factors->priority_js =
+				factors->priority_js =
 					(double) 1.0 -
-					job_ptr->prio_factors->priority_js;
+					factors->priority_js;
 			}
 		} else if (favor_small) {
-			job_ptr->prio_factors->priority_js =
+			factors->priority_js =
 				(double)(node_record_count - min_nodes)
 				/ (double)node_record_count;
 			if (cpu_cnt) {
-				job_ptr->prio_factors->priority_js +=
+				factors->priority_js +=
 					(double)(cluster_cpus - cpu_cnt)
 					/ (double)cluster_cpus;
-				job_ptr->prio_factors->priority_js /= 2;
+				factors->priority_js /= 2;
 			}
 		} else {	/* favor large */
-			job_ptr->prio_factors->priority_js =
+			factors->priority_js =
 				(double)min_nodes / (double)node_record_count;
 			if (cpu_cnt) {
-				job_ptr->prio_factors->priority_js +=
+				factors->priority_js +=
 					(double)cpu_cnt / (double)cluster_cpus;
-				job_ptr->prio_factors->priority_js /= 2;
+				factors->priority_js /= 2;
 			}
 		}
-		if (job_ptr->prio_factors->priority_js < .0)
-			job_ptr->prio_factors->priority_js = 0.0;
-		else if (job_ptr->prio_factors->priority_js > 1.0)
-			job_ptr->prio_factors->priority_js = 1.0;
+		if (factors->priority_js < .0)
+			factors->priority_js = 0.0;
+		else if (factors->priority_js > 1.0)
+			factors->priority_js = 1.0;
 	}
 
 	if (job_ptr->part_ptr && job_ptr->part_ptr->priority && weight_part) {
-		job_ptr->prio_factors->priority_part =
+		factors->priority_part =
 			job_ptr->part_ptr->norm_priority;
 	}
 
 	if (qos_ptr && qos_ptr->priority && weight_qos) {
-		job_ptr->prio_factors->priority_qos =
+		factors->priority_qos =
 			qos_ptr->usage->norm_priority;
 	}
 
 	if (job_ptr->details)
-		job_ptr->prio_factors->nice = job_ptr->details->nice;
+		factors->nice = job_ptr->details->nice;
 	else
-		job_ptr->prio_factors->nice = NICE_OFFSET;
+		factors->nice = NICE_OFFSET;
 }
 
-static uint32_t _get_priority_internal(time_t start_time,
-				       struct job_record *job_ptr)
+/* Apply the configured weights to a job's priority factors and return the
+ * resulting priority, before any partition specific priorities of jobs
+ * submitted to multiple partitions are applied */
+static double _weight_priority_factors(priority_factors_object_t *factors)
+{
+	factors->priority_age  *= (double)weight_age;
+	factors->priority_fs   *= (double)weight_fs;
+	factors->priority_js   *= (double)weight_js;
+	factors->priority_part *= (double)weight_part;
+	factors->priority_qos  *= (double)weight_qos;
+
+	return factors->priority_age
+		+ factors->priority_fs
+		+ factors->priority_js
+		+ factors->priority_part
+		+ factors->priority_qos
+		- (double)(factors->nice - NICE_OFFSET);
+}
+
+/* Calculate a job's priority without modifying the job record.  The
+ * weighted factors are returned in factors and, for jobs submitted to
+ * multiple partitions, the per partition priorities in *priority_array
+ * (allocated here if NULL).
+ *
+ * If assoc_locked is set the caller already holds the association lock
+ * and has called _set_job_usage_efctv() for this job.
+ */
+static uint32_t _calc_priority(time_t start_time, struct job_record *job_ptr,
+			       priority_factors_object_t *factors,
+			       uint32_t **priority_array, bool assoc_locked)
 {
 	double priority		= 0.0;
 	priority_factors_object_t pre_factors;
 
-	if (job_ptr->direct_set_prio && (job_ptr->priority > 0))
-		return job_ptr->priority;
-
-	if (!job_ptr->details) {
-		error("_get_priority_internal: job %u does not have a "
-		      "details symbol set, can't set priority",
-		      job_ptr->job_id);
-		return 0;
-	}
-
 	/* figure out the priority */
-	_get_priority_factors(start_time, job_ptr);
-	memcpy(&pre_factors, job_ptr->prio_factors,
-	       sizeof(priority_factors_object_t));
-
-	job_ptr->prio_factors->priority_age  *= (double)weight_age;
-	job_ptr->prio_factors->priority_fs   *= (double)weight_fs;
-	job_ptr->prio_factors->priority_js   *= (double)weight_js;
-	job_ptr->prio_factors->priority_part *= (double)weight_part;
-	job_ptr->prio_factors->priority_qos  *= (double)weight_qos;
-
-	priority = job_ptr->prio_factors->priority_age
-		+ job_ptr->prio_factors->priority_fs
-		+ job_ptr->prio_factors->priority_js
-		+ job_ptr->prio_factors->priority_part
-		+ job_ptr->prio_factors->priority_qos
-		- (double)(job_ptr->prio_factors->nice - NICE_OFFSET);
+	_get_priority_factors(start_time, job_ptr, factors, assoc_locked);
+	memcpy(&pre_factors, factors, sizeof(priority_factors_object_t));
+
+	priority = _weight_priority_factors(factors);
 
 	if (job_ptr->part_ptr_list) {
 		struct part_record *part_ptr;
@@ -739,9 +827,9 @@ static uint32_t _get_priority_internal(time_t start_time,
 		ListIterator part_iterator;
 		int i = 0;
 
-		if (!job_ptr->priority_array) {
-			job_ptr->priority_array = xmalloc(sizeof(uint32_t) *
-			                                  (list_count(job_ptr->part_ptr_list) + 1));
+		if (!*priority_array) {
+			*priority_array = xmalloc(sizeof(uint32_t) *
+				(list_count(job_ptr->part_ptr_list) + 1));
 		}
 		part_iterator = list_iterator_create(job_ptr->part_ptr_list);
 		while ((part_ptr = (struct part_record *)
@@ -749,17 +837,17 @@ static uint32_t _get_priority_internal(time_t start_time,
 			priority_part = part_ptr->priority /
 					(double)part_max_priority *
 					(double)weight_part;
-			job_ptr->priority_array[i] = (uint32_t)
-					(job_ptr->prio_factors->priority_age
-					+ job_ptr->prio_factors->priority_fs
-					+ job_ptr->prio_factors->priority_js
+			(*priority_array)[i] = (uint32_t)
+					(factors->priority_age
+					+ factors->priority_fs
+					+ factors->priority_js
 					+ priority_part
-					+ job_ptr->prio_factors->priority_qos
-					- (double)(job_ptr->prio_factors->nice
+					+ factors->priority_qos
+					- (double)(factors->nice
 					- NICE_OFFSET));
 			debug("Job %u has more than one partition (%s)(%u)",
 			      job_ptr->job_id, part_ptr->name,
-			      job_ptr->priority_array[i]);
+			      (*priority_array)[i]);
 			i++;
 		}
 	}
@@ -770,32 +858,53 @@ static uint32_t _get_priority_internal(time_t start_time,
 	if (priority_debug) {
 		info("Weighted Age priority is %f * %u = %.2f",
 		     pre_factors.priority_age, weight_age,
-		     job_ptr->prio_factors->priority_age);
+		     factors->priority_age);
 		info("Weighted Fairshare priority is %f * %u = %.2f",
 		     pre_factors.priority_fs, weight_fs,
-		     job_ptr->prio_factors->priority_fs);
+		     factors->priority_fs);
 		info("Weighted JobSize priority is %f * %u = %.2f",
 		     pre_factors.priority_js, weight_js,
-		     job_ptr->prio_factors->priority_js);
+		     factors->priority_js);
 		info("Weighted Partition priority is %f * %u = %.2f",
 		     pre_factors.priority_part, weight_part,
-		     job_ptr->prio_factors->priority_part);
+		     factors->priority_part);
 		info("Weighted QOS priority is %f * %u = %.2f",
 		     pre_factors.priority_qos, weight_qos,
-		     job_ptr->prio_factors->priority_qos);
+		     factors->priority_qos);
 		info("Job %u priority: %.2f + %.2f + %.2f + %.2f + %.2f - %d "
 		     "= %.2f",
-		     job_ptr->job_id, job_ptr->prio_factors->priority_age,
-		     job_ptr->prio_factors->priority_fs,
-		     job_ptr->prio_factors->priority_js,
-		     job_ptr->prio_factors->priority_part,
-		     job_ptr->prio_factors->priority_qos,
-		     (job_ptr->prio_factors->nice - NICE_OFFSET),
+		     job_ptr->job_id, factors->priority_age,
+		     factors->priority_fs,
+		     factors->priority_js,
+		     factors->priority_part,
+		     factors->priority_qos,
+		     (factors->nice - NICE_OFFSET),
 		     priority);
 	}
 	return (uint32_t)priority;
 }
 
+static uint32_t _get_priority_internal(time_t start_time,
+				       struct job_record *job_ptr)
+{
+	if (job_ptr->direct_set_prio && (job_ptr->priority > 0))
+		return job_ptr->priority;
+
+	if (!job_ptr->details) {
+		error("_get_priority_internal: job %u does not have a "
+		      "details symbol set, can't set priority",
+		      job_ptr->job_id);
+		return 0;
+	}
+
+	if (!job_ptr->prio_factors)
+		job_ptr->prio_factors =
+			xmalloc(sizeof(priority_factors_object_t));
+
+	return _calc_priority(start_time, job_ptr, job_ptr->prio_factors,
+			      &job_ptr->priority_array, false);
+}
+
 
 /* Mark an association and its parents as active (i.e. it may be given
  * tickets) during the current scheduling cycle.  The association
@@ -1136,6 +1245,201 @@ static int _apply_new_usage(struct job_record *job_ptr,
 	return 1;
 }
 
+/* Return true if a job's newly calculated priority matches the one stored in
+ * the job record, so there is nothing to store.  The age factor is left out
+ * of the comparison: it grows every cycle for jobs younger than
+ * PriorityMaxAge, but usually moves the priority by less than one.  Any
+ * change it makes to the priority itself is caught by comparing the
+ * priorities. */
+static bool _prio_unchanged(prio_update_t *upd, struct job_record *job_ptr)
+{
+	priority_factors_object_t *old_factors = job_ptr->prio_factors;
+
+	if (!old_factors || (upd->priority != job_ptr->priority))
+		return false;
+	if ((upd->factors.priority_fs   != old_factors->priority_fs) ||
+	    (upd->factors.priority_js   != old_factors->priority_js) ||
+	    (upd->factors.priority_part != old_factors->priority_part) ||
+	    (upd->factors.priority_qos  != old_factors->priority_qos) ||
+	    (upd->factors.nice          != old_factors->nice))
+		return false;
+	if (!upd->priority_array)
+		return (job_ptr->priority_array == NULL);
+	return (job_ptr->priority_array &&
+		!memcmp(upd->priority_array, job_ptr->priority_array,
+			sizeof(uint32_t) * upd->part_cnt));
+}
+
+static void *_calc_priorities(void *arg)
+{
+	prio_calc_args_t *args = (prio_calc_args_t *) arg;
+	prio_update_t *upd;
+	int i;
+
+	for (i = args->begin; i < args->end; i++) {
+		upd = &args->updates[i];
+		upd->priority = _calc_priority(args->start_time, upd->job_ptr,
+					       &upd->factors,
+					       &upd->priority_array, true);
+		upd->unchanged = _prio_unchanged(upd, upd->job_ptr);
+	}
+	return NULL;
+}
+
+/* Recalculate the priority of pending jobs.
+ *
+ * The priorities are calculated while only holding read locks, split across
+ * several threads for large queues, so the scheduler and RPCs reading job
+ * state are not blocked.  The job write lock is then taken just long enough
+ * to store the results of the jobs whose priority or non-age factors
+ * changed, and last_job_update is only changed if some job's priority
+ * actually changed.
+ */
+static void _update_job_priorities(time_t start_time)
+{
+	/* Read lock on jobs, nodes, and partitions */
+	slurmctld_lock_t job_read_lock =
+		{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK };
+	/* Write lock on jobs, read lock on nodes and partitions */
+	slurmctld_lock_t job_write_lock =
+		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
+	assoc_mgr_lock_t assoc_write_lock = { WRITE_LOCK, NO_LOCK,
+					      NO_LOCK, NO_LOCK, NO_LOCK };
+	assoc_mgr_lock_t assoc_read_lock = { READ_LOCK, NO_LOCK,
+					     NO_LOCK, NO_LOCK, NO_LOCK };
+	struct job_record *job_ptr;
+	ListIterator itr;
+	prio_update_t *updates, *upd;
+	prio_calc_args_t *args;
+	pthread_t *threads;
+	pthread_attr_t attr;
+	int i, upd_cnt = 0, thread_cnt, changed = 0, store_cnt = 0;
+
+	lock_slurmctld(job_read_lock);
+	if (!job_list || !(i = list_count(job_list))) {
+		unlock_slurmctld(job_read_lock);
+		return;
+	}
+	updates = xmalloc(sizeof(prio_update_t) * i);
+
+	/* Collect the pending jobs and compute the effective usage of their
+	 * associations, once per association, so the calculation below
+	 * only needs to read association data. */
+	assoc_mgr_lock(&assoc_write_lock);
+	itr = list_iterator_create(job_list);
+	while ((job_ptr = list_next(itr))) {
+		/*
+		 * Priority 0 is reserved for held
+		 * jobs. Also skip priority
+		 * calculation for non-pending jobs.
+		 */
+		if ((job_ptr->priority == 0) || !IS_JOB_PENDING(job_ptr))
+			continue;
+		/* Priority has been set elsewhere (e.g. by SlurmUser) */
+		if (job_ptr->direct_set_prio)
+			continue;
+		if (!job_ptr->details)
+			continue;
+
+		_set_job_usage_efctv(job_ptr);
+		upd = &updates[upd_cnt++];
+		upd->job_ptr = job_ptr;
+		upd->job_id = job_ptr->job_id;
+		if (job_ptr->part_ptr_list)
+			upd->part_cnt = list_count(job_ptr->part_ptr_list);
+	}
+	list_iterator_destroy(itr);
+	assoc_mgr_unlock(&assoc_write_lock);
+
+	thread_cnt = upd_cnt / PRIO_JOBS_PER_THREAD;
+	if (thread_cnt > MAX_PRIO_THREADS)
+		thread_cnt = MAX_PRIO_THREADS;
+	if (thread_cnt < 1)
+		thread_cnt = 1;
+	args = xmalloc(sizeof(prio_calc_args_t) * thread_cnt);
+	threads = xmalloc(sizeof(pthread_t) * thread_cnt);
+	for (i = 0; i < thread_cnt; i++) {
+		args[i].updates = updates;
+		args[i].begin = (upd_cnt * i) / thread_cnt;
+		args[i].end = (upd_cnt * (i + 1)) / thread_cnt;
+		args[i].start_time = start_time;
+	}
+
+	assoc_mgr_lock(&assoc_read_lock);
+	slurm_attr_init(&attr);
+	for (i = 1; i < thread_cnt; i++) {
+		if (pthread_create(&threads[i], &attr, _calc_priorities,
+				   &args[i])) {
+			error("priority/multifactor: pthread_create: %m");
+			_calc_priorities(&args[i]);
+			threads[i] = 0;
+		}
+	}
+	slurm_attr_destroy(&attr);
+	_calc_priorities(&args[0]);
+	for (i = 1; i < thread_cnt; i++) {
+		if (threads[i])
+			pthread_join(threads[i], NULL);
+	}
+	assoc_mgr_unlock(&assoc_read_lock);
+	unlock_slurmctld(job_read_lock);
+
+	for (i = 0; i < upd_cnt; i++) {
+		if (!updates[i].unchanged)
+			store_cnt++;
+	}
+	if (store_cnt == 0)
+		goto fini;
+
+	/* Jobs may have been purged or modified while no lock was held,
+	 * so validate each one again before storing its new priority. */
+	lock_slurmctld(job_write_lock);
+	for (i = 0; i < upd_cnt; i++) {
+		upd = &updates[i];
+		if (upd->unchanged)
+			continue;
+		job_ptr = find_job_record(upd->job_id);
+		if ((job_ptr != upd->job_ptr) || (job_ptr->priority == 0) ||
+		    !IS_JOB_PENDING(job_ptr) || job_ptr->direct_set_prio)
+			continue;
+
+		if (!job_ptr->prio_factors)
+			job_ptr->prio_factors =
+				xmalloc(sizeof(priority_factors_object_t));
+		memcpy(job_ptr->prio_factors, &upd->factors,
+		       sizeof(priority_factors_object_t));
+		if (upd->priority_array && job_ptr->part_ptr_list &&
+		    (list_count(job_ptr->part_ptr_list) == upd->part_cnt)) {
+			xfree(job_ptr->priority_array);
+			job_ptr->priority_array = upd->priority_array;
+			upd->priority_array = NULL;
+		}
+		if (job_ptr->priority == upd->priority)
+			continue;
+
+		job_ptr->priority = upd->priority;
+		changed++;
+		debug2("priority for job %u is now %u",
+		       job_ptr->job_id, job_ptr->priority);
+	}
+	if (changed)
+		last_job_update = time(NULL);
+	unlock_slurmctld(job_write_lock);
+
+fini:
+	if (priority_debug) {
+		info("priority: calculated %d pending jobs using %d threads, "
+		     "%d to store, %d changed", upd_cnt, thread_cnt,
+		     store_cnt, changed);
+	}
+
+	for (i = 0; i < upd_cnt; i++)
+		xfree(updates[i].priority_array);
+	xfree(updates);
+	xfree(args);
+	xfree(threads);
+}
+
 static void *_decay_thread(void *no_data)
 {
 	struct job_record *job_ptr = NULL;
@@ -1146,9 +1450,9 @@ static void *_decay_thread(void *no_data)
 	double decay_hl = (double)slurm_get_priority_decay_hl();
 	uint16_t reset_period = slurm_get_priority_reset_period();
 
-	/* Write lock on jobs, read lock on nodes and partitions */
-	slurmctld_lock_t job_write_lock =
-		{ NO_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
+	/* Read lock on jobs, nodes, and partitions */
+	slurmctld_lock_t job_read_lock =
+		{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK };
 	assoc_mgr_lock_t locks = { WRITE_LOCK, NO_LOCK,
 				   NO_LOCK, NO_LOCK, NO_LOCK };
 
@@ -1284,7 +1588,9 @@ static void *_decay_thread(void *no_data)
 		}
 
 		if (!(flags & PRIORITY_FLAGS_TICKET_BASED)) {
-			lock_slurmctld(job_write_lock);
+			/* Applying usage only modifies association data,
+			 * so a read lock on the jobs is sufficient. */
+			lock_slurmctld(job_read_lock);
 			itr = list_iterator_create(job_list);
 			while ((job_ptr = list_next(itr))) {
 				/* Don't need to handle finished jobs. */
@@ -1293,38 +1599,19 @@ static void *_decay_thread(void *no_data)
 					continue;
 				/* apply new usage */
 				if (!IS_JOB_PENDING(job_ptr) &&
-				    job_ptr->start_time && job_ptr->assoc_ptr) {
-					if (!_apply_new_usage(
-						    job_ptr,
-						    g_last_ran, start_time))
-						continue;
-				}
-
-				/*
-				 * Priority 0 is reserved for held
-				 * jobs. Also skip priority
-				 * calculation for non-pending jobs.
-				 */
-				if ((job_ptr->priority == 0)
-				    || !IS_JOB_PENDING(job_ptr))
-					continue;
-
-				job_ptr->priority = _get_priority_internal(
-					start_time, job_ptr);
-				last_job_update = time(NULL);
-				debug2("priority for job %u is now %u",
-				       job_ptr->job_id, job_ptr->priority);
+				    job_ptr->start_time && job_ptr->assoc_ptr)
+					_apply_new_usage(job_ptr,
+							 g_last_ran,
+							 start_time);
 			}
 			list_iterator_destroy(itr);
-			unlock_slurmctld(job_write_lock);
+			unlock_slurmctld(job_read_lock);
+
+			_update_job_priorities(start_time);
 		}
 
 	get_usage:
 		if (flags & PRIORITY_FLAGS_TICKET_BASED) {
-			/* Read lock on jobs, nodes, and partitions */
-			slurmctld_lock_t job_read_lock =
-				{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK };
-
 			/* Multifactor Ticket Based core algo
 			 * 1/3. Iterate through all jobs, mark parent
 			 * associations with the current
@@ -1384,27 +1671,7 @@ static void *_decay_thread(void *no_data)
 			 * list again, give priorities proportional to the
 			 * maximum number of tickets given to any user.
 			 */
-			lock_slurmctld(job_write_lock);
-			itr = list_iterator_create(job_list);
-			while ((job_ptr = list_next(itr))) {
-				/*
-				 * Priority 0 is reserved for held
-				 * jobs. Also skip priority
-				 * calculation for non-pending jobs.
-				 */
-				if ((job_ptr->priority == 0)
-				    || !IS_JOB_PENDING(job_ptr))
-					continue;
-
-				job_ptr->priority = _get_priority_internal(
-					start_time, job_ptr);
-				last_job_update = time(NULL);
-				debug2("priority for job %u is now %u",
-				       job_ptr->job_id, job_ptr->priority);
-			}
-			list_iterator_destroy(itr);
-			unlock_slurmctld(job_write_lock);
-
+			_update_job_priorities(start_time);
 		}
 
 		g_last_ran = start_time;
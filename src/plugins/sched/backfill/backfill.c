@@ -104,11 +104,18 @@
 
 #define SLURMCTLD_THREAD_LIMIT	5
 
+/* The backfill plan is an array of these records, sorted by time and
+ * covering the backfill window without gaps. Under consumable resources
+ * pending jobs reserve cores and memory on a node, the node is only removed
+ * from avail_bitmap once nothing of it remains. */
 typedef struct node_space_map {
 	time_t begin_time;
 	time_t end_time;
-	bitstr_t *avail_bitmap;
-	int next;	/* next record, by time, zero termination */
+	bitstr_t *avail_bitmap;		/* nodes with resources left */
+	bitstr_t *resv_core_bitmap;	/* cores reserved for pending jobs,
+					 * NULL if none */
+	uint32_t *resv_mem;		/* memory reserved on each node for
+					 * pending jobs in MB, NULL if none */
 } node_space_map_t;
 
 /* Diag statistics */
@@ -129,23 +136,48 @@ static int max_backfill_job_cnt = 100;
 static int max_backfill_job_per_part = 0;
 static int max_backfill_job_per_user = 0;
 static bool backfill_continue = false;
+static bool bf_core_map = false;	/* reserve cores, not whole nodes */
+static bool bf_mem_map = false;		/* also reserve memory */
+static bitstr_t *bf_busy_cores = NULL;	/* cores of running jobs */
 
 /*********************** local functions *********************/
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
-			     bitstr_t *res_bitmap,
+			     struct job_record *job_ptr, bitstr_t *res_bitmap,
 			     node_space_map_t *node_space,
 			     int *node_space_recs);
 static int  _attempt_backfill(void);
 static bool _job_is_completing(void);
+static uint32_t _job_node_cores(struct job_record *job_ptr, int node_inx,
+				uint32_t cpus);
+static uint32_t _job_node_cpus(struct job_record *job_ptr, uint32_t node_cnt);
+static uint32_t _job_node_mem(struct job_record *job_ptr, int node_inx,
+			      uint32_t cpus);
+static bool _job_whole_node(struct job_record *job_ptr);
 static void _load_config(void);
 static bool _many_pending_rpcs(void);
 static bool _more_work(time_t last_backfill_time);
 static void _my_sleep(int secs);
+static uint32_t _node_cores(int node_inx);
+static uint32_t _node_mem(int node_inx);
+static uint16_t _node_threads(int node_inx);
+static void _ns_avail(node_space_map_t *ns_ptr, struct job_record *job_ptr,
+		      bitstr_t *avail_bitmap, bitstr_t **core_bitmap);
+static int  _ns_find(node_space_map_t *node_space, int node_space_recs,
+		     time_t when);
+static bool _ns_fits(node_space_map_t *ns_ptr, struct job_record *job_ptr,
+		     bitstr_t *node_bitmap, uint32_t cpus);
+static void _ns_split(node_space_map_t *node_space, int *node_space_recs,
+		      time_t when);
 static int  _num_feature_count(struct job_record *job_ptr);
 static void _reset_job_time_limit(struct job_record *job_ptr, time_t now,
-				  node_space_map_t *node_space);
+				  node_space_map_t *node_space,
+				  int node_space_recs);
+static void _reserve_node(node_space_map_t *node_space, int first, int last,
+			  int node_inx, uint32_t cores, uint32_t mem);
+static void _set_map_granularity(void);
 static int  _start_job(struct job_record *job_ptr, bitstr_t *avail_bitmap);
 static bool _test_resv_overlap(node_space_map_t *node_space,
+			       int node_space_recs, struct job_record *job_ptr,
 			       bitstr_t *use_bitmap, uint32_t start_time,
 			       uint32_t end_reserve);
 static int  _try_sched(struct job_record *job_ptr, bitstr_t **avail_bitmap,
@@ -182,23 +214,29 @@ static void _dump_job_test(struct job_record *job_ptr, bitstr_t *avail_bitmap)
 }
 
 /* Log resource allocate table */
-static void _dump_node_space_table(node_space_map_t *node_space_ptr)
+static void _dump_node_space_table(node_space_map_t *node_space_ptr,
+				   int node_space_recs)
 {
-	int i = 0;
+	int i;
 	char begin_buf[32], end_buf[32], *node_list;
 
 	info("=========================================");
-	while (1) {
+	for (i = 0; i < node_space_recs; i++) {
 		slurm_make_time_str(&node_space_ptr[i].begin_time,
 				    begin_buf, sizeof(begin_buf));
 		slurm_make_time_str(&node_space_ptr[i].end_time,
 				    end_buf, sizeof(end_buf));
 		node_list = bitmap2node_name(node_space_ptr[i].avail_bitmap);
-		info("Begin:%s End:%s Nodes:%s",
-		     begin_buf, end_buf, node_list);
+		if (node_space_ptr[i].resv_core_bitmap) {
+			info("Begin:%s End:%s Nodes:%s ReservedCores:%d",
+			     begin_buf, end_buf, node_list,
+			     bit_set_count(node_space_ptr[i].
+					   resv_core_bitmap));
+		} else {
+			info("Begin:%s End:%s Nodes:%s",
+			     begin_buf, end_buf, node_list);
+		}
 		xfree(node_list);
-		if ((i = node_space_ptr[i].next) == 0)
-			break;
 	}
 	info("=========================================");
 }
@@ -643,15 +681,15 @@ static int _attempt_backfill(void)
 	slurmctld_diag_stats.bf_when_last_cycle = now;
 	slurmctld_diag_stats.bf_active = 1;
 
+	_set_map_granularity();
 	node_space = xmalloc(sizeof(node_space_map_t) *
 			     (max_backfill_job_cnt + 3));
 	node_space[0].begin_time = sched_start;
 	node_space[0].end_time = sched_start + backfill_window;
 	node_space[0].avail_bitmap = bit_copy(avail_node_bitmap);
-	node_space[0].next = 0;
 	node_space_recs = 1;
 	if (debug_flags & DEBUG_FLAG_BACKFILL)
-		_dump_node_space_table(node_space);
+		_dump_node_space_table(node_space, node_space_recs);
 
 	if (max_backfill_job_per_part) {
 		ListIterator part_iterator;
@@ -902,19 +940,16 @@ static int _attempt_backfill(void)
 		/* Identify usable nodes for this job */
 		bit_and(avail_bitmap, part_ptr->node_bitmap);
 		bit_and(avail_bitmap, up_node_bitmap);
-		for (j=0; ; ) {
-			if ((node_space[j].end_time > start_res) &&
-			     node_space[j].next && (later_start == 0))
-				later_start = node_space[j].end_time;
+		for (j = _ns_find(node_space, node_space_recs, start_res);
+		     j < node_space_recs; j++) {
 			if (node_space[j].end_time <= start_res)
-				;
-			else if (node_space[j].begin_time <= end_time) {
-				bit_and(avail_bitmap,
-					node_space[j].avail_bitmap);
-			} else
 				break;
-			if ((j = node_space[j].next) == 0)
+			if ((later_start == 0) && (j + 1 < node_space_recs))
+				later_start = node_space[j].end_time;
+			if (node_space[j].begin_time > end_time)
 				break;
+			_ns_avail(&node_space[j], job_ptr, avail_bitmap,
+				  &exc_core_bitmap);
 		}
 		if ((resv_end++) &&
 		    ((later_start == 0) || (resv_end < later_start))) {
@@ -992,7 +1027,8 @@ static int _attempt_backfill(void)
 				job_ptr->end_time = job_ptr->start_time +
 						    (comp_time_limit * 60);
 				_reset_job_time_limit(job_ptr, now,
-						      node_space);
+						      node_space,
+						      node_space_recs);
 				time_limit = job_ptr->time_limit;
 			} else {
 				job_ptr->time_limit = orig_time_limit;
@@ -1038,8 +1074,9 @@ static int _attempt_backfill(void)
 		}
 
 		end_reserve = job_ptr->start_time + (time_limit * 60);
-		if (_test_resv_overlap(node_space, avail_bitmap,
-				       job_ptr->start_time, end_reserve)) {
+		if (_test_resv_overlap(node_space, node_space_recs, job_ptr,
+				       avail_bitmap, job_ptr->start_time,
+				       end_reserve)) {
 			/* This job overlaps with an existing reservation for
 			 * job to be backfill scheduled, which the sched
 			 * plugin does not know about. Try again later. */
@@ -1056,11 +1093,10 @@ static int _attempt_backfill(void)
 		reject_array_job_id = 0;
 		if (debug_flags & DEBUG_FLAG_BACKFILL)
 			_dump_job_sched(job_ptr, end_reserve, avail_bitmap);
-		bit_not(avail_bitmap);
-		_add_reservation(job_ptr->start_time, end_reserve,
+		_add_reservation(job_ptr->start_time, end_reserve, job_ptr,
 				 avail_bitmap, node_space, &node_space_recs);
 		if (debug_flags & DEBUG_FLAG_BACKFILL)
-			_dump_node_space_table(node_space);
+			_dump_node_space_table(node_space, node_space_recs);
 	}
 	xfree(bf_part_jobs);
 	xfree(bf_part_ptr);
@@ -1070,12 +1106,13 @@ static int _attempt_backfill(void)
 	FREE_NULL_BITMAP(exc_core_bitmap);
 	FREE_NULL_BITMAP(resv_bitmap);
 
-	for (i=0; ; ) {
+	for (i = 0; i < node_space_recs; i++) {
 		FREE_NULL_BITMAP(node_space[i].avail_bitmap);
-		if ((i = node_space[i].next) == 0)
-			break;
+		FREE_NULL_BITMAP(node_space[i].resv_core_bitmap);
+		xfree(node_space[i].resv_mem);
 	}
 	xfree(node_space);
+	FREE_NULL_BITMAP(bf_busy_cores);
 	list_destroy(job_queue);
 	gettimeofday(&bf_time2, NULL);
 	_do_diag_stats(&bf_time1, &bf_time2, yield_sleep);
@@ -1147,24 +1184,26 @@ static int _start_job(struct job_record *job_ptr, bitstr_t *resv_bitmap)
  *	Avoid using resources reserved for pending jobs or in resource
  *	reservations */
 static void _reset_job_time_limit(struct job_record *job_ptr, time_t now,
-				  node_space_map_t *node_space)
+				  node_space_map_t *node_space,
+				  int node_space_recs)
 {
 	int32_t j, resv_delay;
 	uint32_t orig_time_limit = job_ptr->time_limit;
+	uint32_t cpus;
 
-	for (j=0; ; ) {
+	cpus = _job_node_cpus(job_ptr, bit_set_count(job_ptr->node_bitmap));
+	for (j = 0; j < node_space_recs; j++) {
+		if (node_space[j].begin_time >= job_ptr->end_time)
+			break;
 		if ((node_space[j].begin_time != now) &&
-		    (node_space[j].begin_time < job_ptr->end_time) &&
-		    (!bit_super_set(job_ptr->node_bitmap,
-				    node_space[j].avail_bitmap))) {
+		    !_ns_fits(&node_space[j], job_ptr, job_ptr->node_bitmap,
+			      cpus)) {
 			/* Job overlaps pending job's resource reservation */
 			resv_delay = difftime(node_space[j].begin_time, now);
 			resv_delay /= 60;	/* seconds to minutes */
 			if (resv_delay < job_ptr->time_limit)
 				job_ptr->time_limit = resv_delay;
 		}
-		if ((j = node_space[j].next) == 0)
-			break;
 	}
 	job_ptr->time_limit = MAX(job_ptr->time_min, job_ptr->time_limit);
 	job_ptr->end_time = job_ptr->start_time + (job_ptr->time_limit * 60);
@@ -1192,66 +1231,351 @@ static bool _more_work (time_t last_backfill_time)
 	return rc;
 }
 
-/* Create a reservation for a job in the future */
+/* Set the granularity of the backfill plan: cores and memory under
+ * consumable resources, whole nodes otherwise. Note the cores running
+ * jobs hold for _reserve_node(). */
+static void _set_map_granularity(void)
+{
+	ListIterator job_iterator;
+	struct job_record *job_ptr;
+
+	static uint32_t cr_enabled = NO_VAL;
+
+	if (cr_enabled == NO_VAL) {
+		cr_enabled = 0;	/* select/linear and bluegene are no-ops */
+		if (select_g_get_info_from_plugin(SELECT_CR_PLUGIN, NULL,
+						  &cr_enabled)) {
+			cr_enabled = NO_VAL;	/* error, try again later */
+		}
+	}
+	bf_core_map = (cr_enabled == 1);
+	bf_mem_map  = bf_core_map &&
+		      (slurmctld_conf.select_type_param & CR_MEMORY);
+
+	FREE_NULL_BITMAP(bf_busy_cores);
+	if (!bf_core_map)
+		return;
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+		if ((IS_JOB_RUNNING(job_ptr) || IS_JOB_SUSPENDED(job_ptr)) &&
+		    job_ptr->job_resrcs) {
+			add_job_to_cores(job_ptr->job_resrcs, &bf_busy_cores,
+					 cr_node_num_cores);
+		}
+	}
+	list_iterator_destroy(job_iterator);
+}
+
+static uint32_t _node_cores(int node_inx)
+{
+	return cr_get_coremap_offset(node_inx + 1) -
+	       cr_get_coremap_offset(node_inx);
+}
+
+static uint32_t _node_mem(int node_inx)
+{
+	struct node_record *node_ptr = node_record_table_ptr + node_inx;
+
+	if (slurmctld_conf.fast_schedule)
+		return node_ptr->config_ptr->real_memory;
+	return node_ptr->real_memory;
+}
+
+static uint16_t _node_threads(int node_inx)
+{
+	struct node_record *node_ptr = node_record_table_ptr + node_inx;
+
+	if (slurmctld_conf.fast_schedule)
+		return node_ptr->config_ptr->threads;
+	return node_ptr->threads;
+}
+
+/* Return true if a job can only be given whole nodes */
+static bool _job_whole_node(struct job_record *job_ptr)
+{
+	if (!bf_core_map || (job_ptr->details->shared == 0))
+		return true;
+	if (job_ptr->part_ptr && (job_ptr->part_ptr->max_share == 0))
+		return true;
+	/* GRES are not tracked by the plan, so reserve whole nodes */
+	if (job_ptr->gres_list && list_count(job_ptr->gres_list))
+		return true;
+	return false;
+}
+
+/* Estimate the CPUs needed on each node by a job spread over node_cnt */
+static uint32_t _job_node_cpus(struct job_record *job_ptr, uint32_t node_cnt)
+{
+	struct job_details *details_ptr = job_ptr->details;
+	uint32_t cpus;
+
+	node_cnt = MAX(node_cnt, 1);
+	cpus = (details_ptr->min_cpus + node_cnt - 1) / node_cnt;
+	cpus = MAX(cpus, details_ptr->pn_min_cpus);
+	if (details_ptr->ntasks_per_node) {
+		cpus = MAX(cpus, details_ptr->ntasks_per_node *
+				 MAX(details_ptr->cpus_per_task, 1));
+	}
+	return MAX(cpus, 1);
+}
+
+/* Return the count of cores a job needs on a node given its CPU count */
+static uint32_t _job_node_cores(struct job_record *job_ptr, int node_inx,
+				uint32_t cpus)
+{
+	uint32_t node_cores = _node_cores(node_inx);
+	uint16_t threads;
+
+	if (_job_whole_node(job_ptr))
+		return node_cores;
+	threads = MAX(_node_threads(node_inx), 1);
+	return MIN((cpus + threads - 1) / threads, node_cores);
+}
+
+/* Return the memory in MB a job needs on a node given its CPU count */
+static uint32_t _job_node_mem(struct job_record *job_ptr, int node_inx,
+			      uint32_t cpus)
+{
+	uint32_t mem = job_ptr->details->pn_min_memory;
+
+	if (!bf_mem_map)
+		return 0;
+	if (mem & MEM_PER_CPU)
+		mem = (mem & (~MEM_PER_CPU)) * cpus;
+	return MIN(mem, _node_mem(node_inx));
+}
+
+/* Return the index of the first record ending after "when", or the last
+ * record if none does. The records are sorted by time */
+static int _ns_find(node_space_map_t *node_space, int node_space_recs,
+		    time_t when)
+{
+	int lo = 0, hi = node_space_recs - 1, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (node_space[mid].end_time > when)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
+/* Split the record spanning "when" so that a record begins at that time */
+static void _ns_split(node_space_map_t *node_space, int *node_space_recs,
+		      time_t when)
+{
+	node_space_map_t *old_ptr, *new_ptr;
+	int i;
+
+	i = _ns_find(node_space, *node_space_recs, when);
+	old_ptr = &node_space[i];
+	if ((old_ptr->begin_time >= when) || (old_ptr->end_time <= when))
+		return;
+
+	memmove(old_ptr + 2, old_ptr + 1,
+		sizeof(node_space_map_t) * (*node_space_recs - i - 1));
+	new_ptr = old_ptr + 1;
+	new_ptr->begin_time = when;
+	new_ptr->end_time = old_ptr->end_time;
+	old_ptr->end_time = when;
+	new_ptr->avail_bitmap = bit_copy(old_ptr->avail_bitmap);
+	if (old_ptr->resv_core_bitmap)
+		new_ptr->resv_core_bitmap = bit_copy(old_ptr->resv_core_bitmap);
+	else
+		new_ptr->resv_core_bitmap = NULL;
+	if (old_ptr->resv_mem) {
+		new_ptr->resv_mem = xmalloc(sizeof(uint32_t) *
+					    node_record_count);
+		memcpy(new_ptr->resv_mem, old_ptr->resv_mem,
+		       sizeof(uint32_t) * node_record_count);
+	} else
+		new_ptr->resv_mem = NULL;
+	(*node_space_recs)++;
+}
+
+/* Remove from avail_bitmap the nodes which a record leaves unusable by
+ * job_ptr and add the cores it reserves to core_bitmap */
+static void _ns_avail(node_space_map_t *ns_ptr, struct job_record *job_ptr,
+		      bitstr_t *avail_bitmap, bitstr_t **core_bitmap)
+{
+	uint32_t cpus, mem;
+	int i, i_first, i_last;
+
+	bit_and(avail_bitmap, ns_ptr->avail_bitmap);
+	if (ns_ptr->resv_core_bitmap) {
+		if (*core_bitmap)
+			bit_or(*core_bitmap, ns_ptr->resv_core_bitmap);
+		else
+			*core_bitmap = bit_copy(ns_ptr->resv_core_bitmap);
+	}
+	if (!ns_ptr->resv_mem)
+		return;
+
+	/* Every node gets at least pn_min_cpus, the smallest share */
+	cpus = MAX(job_ptr->details->pn_min_cpus, 1);
+	i_first = bit_ffs(avail_bitmap);
+	i_last  = (i_first < 0) ? -2 : bit_fls(avail_bitmap);
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(avail_bitmap, i) || !ns_ptr->resv_mem[i])
+			continue;
+		mem = _job_node_mem(job_ptr, i, cpus);
+		if ((ns_ptr->resv_mem[i] + mem) > _node_mem(i))
+			bit_clear(avail_bitmap, i);
+	}
+}
+
+/* Test if a job needing "cpus" CPUs on each node of node_bitmap fits
+ * beside the resources reserved in a record */
+static bool _ns_fits(node_space_map_t *ns_ptr, struct job_record *job_ptr,
+		     bitstr_t *node_bitmap, uint32_t cpus)
+{
+	uint32_t core_begin, node_cores, resv_cores;
+	int i, i_first, i_last;
+
+	if (!bit_super_set(node_bitmap, ns_ptr->avail_bitmap))
+		return false;
+	if (!ns_ptr->resv_core_bitmap && !ns_ptr->resv_mem)
+		return true;
+
+	i_first = bit_ffs(node_bitmap);
+	i_last  = (i_first < 0) ? -2 : bit_fls(node_bitmap);
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(node_bitmap, i))
+			continue;
+		if (ns_ptr->resv_core_bitmap) {
+			core_begin = cr_get_coremap_offset(i);
+			node_cores = _node_cores(i);
+			resv_cores = bit_set_count_range(
+					ns_ptr->resv_core_bitmap, core_begin,
+					core_begin + node_cores);
+			if (resv_cores &&
+			    ((resv_cores + _job_node_cores(job_ptr, i, cpus)) >
+			     node_cores))
+				return false;
+		}
+		if (ns_ptr->resv_mem && ns_ptr->resv_mem[i] &&
+		    ((ns_ptr->resv_mem[i] + _job_node_mem(job_ptr, i, cpus)) >
+		     _node_mem(i)))
+			return false;
+	}
+	return true;
+}
+
+/* Reserve cores and memory on one node in records first through last-1.
+ * The node is reserved whole if the job needs all of its cores or if
+ * that many cores are not free throughout those records. */
+static void _reserve_node(node_space_map_t *node_space, int first, int last,
+			  int node_inx, uint32_t cores, uint32_t mem)
+{
+	uint32_t core_begin, node_cores, total_cores;
+	bool busy;
+	int c, j, pass;
+
+	node_cores = _node_cores(node_inx);
+	core_begin = cr_get_coremap_offset(node_inx);
+	total_cores = cr_get_coremap_offset(node_record_count);
+
+	/* Prefer cores held by running jobs, which jobs backfilled now can
+	 * not use anyway, leaving idle cores to them */
+	for (pass = 0; (pass < 2) && cores && (cores < node_cores); pass++) {
+		for (c = 0; (c < node_cores) && cores; c++) {
+			busy = bf_busy_cores &&
+			       bit_test(bf_busy_cores, core_begin + c);
+			if (busy != (pass == 0))
+				continue;
+			for (j = first; j < last; j++) {
+				if (node_space[j].resv_core_bitmap &&
+				    bit_test(node_space[j].resv_core_bitmap,
+					     core_begin + c))
+					break;
+			}
+			if (j < last)
+				continue;	/* reserved for another job */
+			for (j = first; j < last; j++) {
+				if (!node_space[j].resv_core_bitmap) {
+					node_space[j].resv_core_bitmap =
+						bit_alloc(total_cores);
+				}
+				bit_set(node_space[j].resv_core_bitmap,
+					core_begin + c);
+			}
+			cores--;
+		}
+	}
+
+	for (j = first; j < last; j++) {
+		if (cores) {
+			/* Whole node, or too few free cores left */
+			bit_clear(node_space[j].avail_bitmap, node_inx);
+			continue;
+		}
+		if (mem) {
+			if (!node_space[j].resv_mem) {
+				node_space[j].resv_mem =
+					xmalloc(sizeof(uint32_t) *
+						node_record_count);
+			}
+			node_space[j].resv_mem[node_inx] += mem;
+			if (node_space[j].resv_mem[node_inx] >=
+			    _node_mem(node_inx)) {
+				bit_clear(node_space[j].avail_bitmap,
+					  node_inx);
+				continue;
+			}
+		}
+		if (node_space[j].resv_core_bitmap &&
+		    (bit_set_count_range(node_space[j].resv_core_bitmap,
+					 core_begin, core_begin + node_cores) >=
+		     node_cores))
+			bit_clear(node_space[j].avail_bitmap, node_inx);
+	}
+}
+
+/* Create a reservation for a job in the future on the nodes of res_bitmap.
+ * Under consumable resources only the cores and memory the job needs are
+ * reserved, so other jobs can still be backfilled on the rest of a node. */
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
-			     bitstr_t *res_bitmap,
+			     struct job_record *job_ptr, bitstr_t *res_bitmap,
 			     node_space_map_t *node_space,
 			     int *node_space_recs)
 {
-	bool placed = false;
-	int i, j;
+	uint32_t cpus;
+	int first, last, i, i_first, i_last;
 
 	/* If we decrease the resolution of our timing information, this can
 	 * decrease the number of records managed and increase performance */
 	start_time = (start_time / backfill_resolution) * backfill_resolution;
 	end_reserve = (end_reserve / backfill_resolution) * backfill_resolution;
 
-	for (j=0; ; ) {
-		if (node_space[j].end_time > start_time) {
-			/* insert start entry record */
-			i = *node_space_recs;
-			node_space[i].begin_time = start_time;
-			node_space[i].end_time = node_space[j].end_time;
-			node_space[j].end_time = start_time;
-			node_space[i].avail_bitmap =
-				bit_copy(node_space[j].avail_bitmap);
-			node_space[i].next = node_space[j].next;
-			node_space[j].next = i;
-			(*node_space_recs)++;
-			placed = true;
-		}
-		if (node_space[j].end_time == start_time) {
-			/* no need to insert new start entry record */
-			placed = true;
-		}
-		if (placed == true) {
-			j = node_space[j].next;
-			if (j && (end_reserve < node_space[j].end_time)) {
-				/* insert end entry record */
-				i = *node_space_recs;
-				node_space[i].begin_time = end_reserve;
-				node_space[i].end_time = node_space[j].
-							 end_time;
-				node_space[j].end_time = end_reserve;
-				node_space[i].avail_bitmap =
-					bit_copy(node_space[j].avail_bitmap);
-				node_space[i].next = node_space[j].next;
-				node_space[j].next = i;
-				(*node_space_recs)++;
-			}
-			break;
-		}
-		if ((j = node_space[j].next) == 0)
+	_ns_split(node_space, node_space_recs, start_time);
+	_ns_split(node_space, node_space_recs, end_reserve);
+	first = _ns_find(node_space, *node_space_recs, start_time);
+	if (node_space[first].end_time <= start_time)
+		return;		/* beyond the backfill window */
+	for (last = first; last < *node_space_recs; last++) {
+		if (node_space[last].begin_time >= end_reserve)
 			break;
 	}
-
-	for (j=0; ; ) {
-		if ((node_space[j].begin_time >= start_time) &&
-		    (node_space[j].end_time <= end_reserve))
-			bit_and(node_space[j].avail_bitmap, res_bitmap);
-		if ((node_space[j].begin_time >= end_reserve) ||
-		    ((j = node_space[j].next) == 0))
-			break;
+	if (first == last)
+		return;
+
+	cpus = _job_node_cpus(job_ptr, bit_set_count(res_bitmap));
+	i_first = bit_ffs(res_bitmap);
+	i_last  = (i_first < 0) ? -2 : bit_fls(res_bitmap);
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(res_bitmap, i))
+			continue;
+		if (!bf_core_map) {
+			int j;
+			for (j = first; j < last; j++)
+				bit_clear(node_space[j].avail_bitmap, i);
+			continue;
+		}
+		_reserve_node(node_space, first, last, i,
+			      _job_node_cores(job_ptr, i, cpus),
+			      _job_node_mem(job_ptr, i, cpus));
 	}
 }
 
@@ -1259,26 +1583,27 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
  * Determine if the resource specification for a new job overlaps with a
  *	reservation that the backfill scheduler has made for a job to be
  *	started in the future.
+ * IN job_ptr - job to be started
  * IN use_bitmap - nodes to be allocated
  * IN start_time - start time of job
  * IN end_reserve - end time of job
  */
 static bool _test_resv_overlap(node_space_map_t *node_space,
+			       int node_space_recs, struct job_record *job_ptr,
 			       bitstr_t *use_bitmap, uint32_t start_time,
 			       uint32_t end_reserve)
 {
-	bool overlap = false;
+	uint32_t cpus;
 	int j;
 
-	for (j=0; ; ) {
-		if ((node_space[j].end_time   > start_time) &&
-		    (node_space[j].begin_time < end_reserve) &&
-		    (!bit_super_set(use_bitmap, node_space[j].avail_bitmap))) {
-			overlap = true;
-			break;
-		}
-		if ((j = node_space[j].next) == 0)
+	cpus = _job_node_cpus(job_ptr, bit_set_count(use_bitmap));
+	for (j = _ns_find(node_space, node_space_recs, start_time);
+	     j < node_space_recs; j++) {
+		if ((node_space[j].end_time <= start_time) ||
+		    (node_space[j].begin_time >= end_reserve))
 			break;
+		if (!_ns_fits(&node_space[j], job_ptr, use_bitmap, cpus))
+			return true;
 	}
-	return overlap;
+	return false;
 }
@@ -489,6 +489,13 @@ uint16_t _can_job_run_on_node(struct job_record *job_ptr, bitstr_t *core_map,
 	else
 		gres_list = node_ptr->gres_list;
 
+	/* Skip the per-core work on nodes which lack the job's GRES count */
+	if (!gres_plugin_job_count_test(job_ptr->gres_list, gres_list,
+					test_only)) {
+		bit_nclear(core_map, core_start_bit, core_end_bit);
+		return (uint16_t) 0;
+	}
+
 	gres_plugin_job_core_filter(job_ptr->gres_list, gres_list, test_only,
 				    core_map, core_start_bit, core_end_bit,
 				    node_ptr->name);
@@ -1355,7 +1362,7 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 	int min_rem_nodes;	/* remaining resources desired */
 	int avail_cpus;
 	int total_cpus = 0;	/* #CPUs allocated to job */
-	int i, j, rc = SLURM_SUCCESS;
+	int i, j, k, rc = SLURM_SUCCESS;
 	int best_fit_inx, first, last;
 	int best_fit_nodes, best_fit_cpus;
 	int best_fit_location = 0, best_fit_sufficient;
@@ -1397,11 +1404,28 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 		switches_bitmap[i] = bit_copy(switch_record_table[i].
 					      node_bitmap);
 		bit_and(switches_bitmap[i], bitmap);
-		bit_or(avail_nodes_bitmap, switches_bitmap[i]);
-		switches_node_cnt[i] = bit_set_count(switches_bitmap[i]);
-		if (req_nodes_bitmap &&
-		    bit_overlap(req_nodes_bitmap, switches_bitmap[i])) {
-			switches_required[i] = 1;
+	}
+
+	/* Count nodes and CPUs on every switch in one pass over the
+	 * candidate nodes. CPUs on required nodes are not counted here,
+	 * they are accumulated into switches_required below. */
+	xassert(node_switch_offset);
+	first = bit_ffs(bitmap);
+	last  = bit_fls(bitmap);
+	for (i=first; ((i<=last) && (first>=0)); i++) {
+		bool required;
+		if (!bit_test(bitmap, i) ||
+		    (node_switch_offset[i] == node_switch_offset[i+1]))
+			continue;
+		bit_set(avail_nodes_bitmap, i);
+		required = req_nodes_bitmap && bit_test(req_nodes_bitmap, i);
+		avail_cpus = required ? 0 : _get_cpu_cnt(job_ptr, i, cpu_cnt);
+		for (k=node_switch_offset[i]; k<node_switch_offset[i+1]; k++) {
+			j = node_switch_inx[k];
+			switches_node_cnt[j]++;
+			switches_cpu_cnt[j] += avail_cpus;
+			if (required)
+				switches_required[j] = 1;
 		}
 	}
 	bit_nclear(bitmap, 0, cr_node_cnt - 1);
@@ -1474,9 +1498,9 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 			max_nodes--;
 			total_cpus += avail_cpus;
 			rem_cpus   -= avail_cpus;
-			for (j=0; j<switch_record_cnt; j++) {
-				if (!bit_test(switches_bitmap[j], i))
-					continue;
+			for (k=node_switch_offset[i];
+			     k<node_switch_offset[i+1]; k++) {
+				j = node_switch_inx[k];
 				bit_clear(switches_bitmap[j], i);
 				switches_node_cnt[j]--;
 				/* keep track of the accumulated resources */
@@ -1493,43 +1517,6 @@ static int _eval_nodes_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 		}
 		if ((rem_nodes <= 0) && (rem_cpus <= 0))
 			goto fini;
-
-		/* Update bitmaps and node counts for higher-level switches */
-		for (j=0; j<switch_record_cnt; j++) {
-			if (switches_node_cnt[j] == 0)
-				continue;
-			first = bit_ffs(switches_bitmap[j]);
-			if (first < 0)
-				continue;
-			last  = bit_fls(switches_bitmap[j]);
-			for (i=first; i<=last; i++) {
-				if (!bit_test(switches_bitmap[j], i))
-					continue;
-				if (!bit_test(avail_nodes_bitmap, i)) {
-					/* cleared from lower level */
-					bit_clear(switches_bitmap[j], i);
-					switches_node_cnt[j]--;
-				} else {
-					switches_cpu_cnt[j] +=
-						_get_cpu_cnt(job_ptr, i,
-							     cpu_cnt);
-				}
-			}
-		}
-	} else {
-		/* No specific required nodes, calculate CPU counts */
-		for (j=0; j<switch_record_cnt; j++) {
-			first = bit_ffs(switches_bitmap[j]);
-			if (first < 0)
-				continue;
-			last  = bit_fls(switches_bitmap[j]);
-			for (i=first; i<=last; i++) {
-				if (!bit_test(switches_bitmap[j], i))
-					continue;
-				switches_cpu_cnt[j] +=
-					_get_cpu_cnt(job_ptr, i, cpu_cnt);
-			}
-		}
 	}
 
 	/* Determine lowest level switch satisfying request with best fit 
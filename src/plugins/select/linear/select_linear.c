@@ -94,6 +94,8 @@ int node_record_count __attribute__((weak_import));
 time_t last_node_update __attribute__((weak_import));
 struct switch_record *switch_record_table __attribute__((weak_import));
 int switch_record_cnt __attribute__((weak_import));
+int *node_switch_inx __attribute__((weak_import));
+int *node_switch_offset __attribute__((weak_import));
 #else
 slurm_ctl_conf_t slurmctld_conf;
 struct node_record *node_record_table_ptr;
@@ -103,6 +105,8 @@ int node_record_count;
 time_t last_node_update;
 struct switch_record *switch_record_table;
 int switch_record_cnt;
+int *node_switch_inx;
+int *node_switch_offset;
 #endif
 
 struct select_nodeinfo {
@@ -1110,7 +1114,7 @@ static int _job_test_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 	int rem_cpus;			/* remaining resources desired */
 	int avail_cpus, total_cpus = 0;
 	uint32_t want_nodes, alloc_nodes = 0;
-	int i, j, rc = SLURM_SUCCESS;
+	int i, j, k, rc = SLURM_SUCCESS;
 	int best_fit_inx, first, last;
 	int best_fit_nodes, best_fit_cpus;
 	int best_fit_location = 0, best_fit_sufficient;
@@ -1154,20 +1158,41 @@ static int _job_test_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 #if SELECT_DEBUG
 	debug5("_job_test_topo: phase 1");
 #endif
-	sufficient = false;
 	for (i=0; i<switch_record_cnt; i++) {
 		switches_bitmap[i] = bit_copy(switch_record_table[i].
 					      node_bitmap);
 		bit_and(switches_bitmap[i], bitmap);
+	}
+
+	/* phase 2: accumulate node and cpu resources for each switch
+	 * in one pass over the available nodes */
+#if SELECT_DEBUG
+	debug5("_job_test_topo: phase 2");
+#endif
+	xassert(node_switch_offset);
+	first = bit_ffs(bitmap);
+	last  = bit_fls(bitmap);
+	for (i=first; ((i<=last) && (first>=0)); i++) {
+		if (!bit_test(bitmap, i) ||
+		    (node_switch_offset[i] == node_switch_offset[i+1]))
+			continue;
+		avail_cpus = _get_avail_cpus(job_ptr, i);
+		for (k=node_switch_offset[i]; k<node_switch_offset[i+1]; k++) {
+			j = node_switch_inx[k];
+			switches_node_cnt[j]++;
+			switches_cpu_cnt[j] += avail_cpus;
+		}
+	}
+	bit_nclear(bitmap, 0, node_record_count - 1);
+
+	sufficient = false;
+	for (i=0; i<switch_record_cnt; i++) {
 		if (req_nodes_bitmap &&
 		    !bit_super_set(req_nodes_bitmap, switches_bitmap[i]))
 			switches_node_cnt[i] = 0;
-		else {
-			switches_node_cnt[i] = bit_set_count(switches_bitmap[i]);
+		else
 			sufficient = true;
-		}
 	}
-	bit_nclear(bitmap, 0, node_record_count - 1);
 
 #if SELECT_DEBUG
 	/* Don't compile this, it slows things down too much */
@@ -1191,19 +1216,6 @@ static int _job_test_topo(struct job_record *job_ptr, bitstr_t *bitmap,
 		goto fini;
 	}
 
-	/* phase 2: accumulate all cpu resources for each switch */
-#if SELECT_DEBUG
-	debug5("_job_test_topo: phase 2");
-#endif
-	for (i = 0; i < node_record_count; i++) {
-		avail_cpus = _get_avail_cpus(job_ptr, i);
-		for (j=0; j<switch_record_cnt; j++) {
-			if (bit_test(switches_bitmap[j], i)) {
-				switches_cpu_cnt[j] += avail_cpus;
-			}
-		}
-	}
-
 	/* phase 3 */
 #if SELECT_DEBUG
 	debug5("_job_test_topo: phase 3");
@@ -376,6 +376,7 @@ static void _validate_switches(void)
 	FREE_NULL_BITMAP(multi_homed_bitmap);
 
 	s_p_hashtbl_destroy(conf_hashtbl);
+	build_node_switch_index(node_record_count);
 	_log_switches();
 }
 
@@ -426,6 +427,7 @@ static void _free_switch_record_table(void)
 		xfree(switch_record_table);
 		switch_record_cnt = 0;
 	}
+	free_node_switch_index();
 }
 
 /* Return count of switch configuration entries read */
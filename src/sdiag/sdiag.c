@@ -133,6 +133,13 @@ static int _print_info(void)
 		       ((buf->req_time - buf->req_time_start) / 60)));
 	}
 	printf("\tLast queue length: %u\n", buf->schedule_queue_len);
+	if (buf->acct_limit_eval_cnt || buf->acct_limit_cached_cnt) {
+		printf("\tLimit tests last cycle: %u\n",
+		       buf->acct_limit_eval_last);
+		printf("\tLimit tests:       %u\n", buf->acct_limit_eval_cnt);
+		printf("\tLimit cache holds: %u\n",
+		       buf->acct_limit_cached_cnt);
+	}
 
 	if (buf->bf_active) {
 		printf("\nBackfilling stats (WARNING: data obtained"
@@ -165,6 +172,31 @@ static int _print_info(void)
 		printf("\tQueue length mean: %u\n",
 		       buf->bf_queue_len_sum / buf->bf_cycle_counter);
 	}
+
+	if (buf->gang_cycle_counter) {
+		printf("\nGang scheduling statistics (microseconds):\n");
+		printf("\tTotal cycles: %u\n", buf->gang_cycle_counter);
+		printf("\tLast cycle:   %u\n", buf->gang_cycle_last);
+		printf("\tMax cycle:    %u\n", buf->gang_cycle_max);
+		printf("\tMean cycle:   %u\n",
+		       buf->gang_cycle_sum / buf->gang_cycle_counter);
+	}
+
+	if (buf->job_submit_cnt || buf->job_modify_cnt) {
+		printf("\nJob submit plugin statistics (microseconds):\n");
+		printf("\tSubmit calls: %u\n", buf->job_submit_cnt);
+		printf("\tSubmit max:   %u\n", buf->job_submit_time_max);
+		if (buf->job_submit_cnt > 0) {
+			printf("\tSubmit mean:  %u\n",
+			       buf->job_submit_time_sum / buf->job_submit_cnt);
+		}
+		printf("\tModify calls: %u\n", buf->job_modify_cnt);
+		printf("\tModify max:   %u\n", buf->job_modify_time_max);
+		if (buf->job_modify_cnt > 0) {
+			printf("\tModify mean:  %u\n",
+			       buf->job_modify_time_sum / buf->job_modify_cnt);
+		}
+	}
 	return 0;
 }
 
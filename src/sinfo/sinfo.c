@@ -66,6 +66,21 @@ static int sinfo_cnt;	/* thread count */
 static pthread_mutex_t sinfo_cnt_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  sinfo_cnt_cond  = PTHREAD_COND_INITIALIZER;
 
+/* sinfo records hashed on the fields they are matched on, so that adding a
+ * node need not compare it with every record built so far */
+static sinfo_data_t **sinfo_hash = NULL;
+static int sinfo_hash_size = 0;
+/* Records made for each partition before any node is added, by index */
+static sinfo_data_t **sinfo_empty = NULL;
+static int sinfo_empty_cnt = 0;
+static pthread_mutex_t sinfo_hash_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* Set if the controller can not report node summaries */
+static bool summary_unavailable = false;
+
+/* Set if the controller can not report only the changed nodes */
+static bool delta_unavailable = false;
+
 /************
  * Funtions *
  ************/
@@ -74,11 +89,29 @@ void *      _build_part_info(void *args);
 static int  _build_sinfo_data(List sinfo_list,
 			      partition_info_msg_t *partition_msg,
 			      node_info_msg_t *node_msg);
+static int  _build_sinfo_summary(List sinfo_list,
+				 partition_info_msg_t *partition_msg,
+				 node_summary_msg_t *summary_msg);
+static void _create_part_sinfo(List sinfo_list,
+			       partition_info_msg_t *partition_msg);
 static sinfo_data_t *_create_sinfo(partition_info_t* part_ptr,
 				   uint16_t part_inx, node_info_t *node_ptr,
 				   uint32_t node_scaling);
 static bool _filter_out(node_info_t *node_ptr);
+static bool _filter_out_state(node_info_t *node_ptr, bool alloc, bool err);
+static sinfo_data_t *_find_sinfo(uint16_t part_num,
+				 partition_info_t *part_ptr,
+				 node_info_t *node_ptr, uint32_t *hash);
 static int  _get_info(bool clear_old);
+static void _hash_add_sinfo(sinfo_data_t *sinfo_ptr, uint32_t hash);
+static void _hash_fini(void);
+static void _hash_init(int rec_cnt, int part_cnt);
+static uint32_t _hash_sinfo_key(partition_info_t *part_ptr,
+				node_info_t *node_ptr);
+static int  _load_nodes(node_info_msg_t *old_node_ptr,
+			node_info_msg_t **new_node_ptr, uint16_t show_flags);
+static int  _load_partitions(partition_info_msg_t **part_pptr,
+			     bool clear_old);
 static void _sinfo_list_delete(void *data);
 static bool _match_node_data(sinfo_data_t *sinfo_ptr,
 			     node_info_t *node_ptr);
@@ -89,11 +122,16 @@ static int  _query_server(partition_info_msg_t ** part_pptr,
 			  node_info_msg_t ** node_pptr,
 			  block_info_msg_t ** block_pptr,
 			  reserve_info_msg_t ** reserv_pptr, bool clear_old);
+static int  _query_summary(partition_info_msg_t **part_pptr,
+			   node_summary_msg_t **summary_pptr, bool clear_old);
 static int _reservation_report(reserve_info_msg_t *resv_ptr);
 static void _sort_hostlist(List sinfo_list);
 static int  _strcmp(char *data1, char *data2);
 static void _update_sinfo(sinfo_data_t *sinfo_ptr, node_info_t *node_ptr,
 			  uint32_t node_scaling);
+static void _update_sinfo_summary(sinfo_data_t *sinfo_ptr,
+				  node_summary_t *summary);
+static bool _use_summary(void);
 
 static int _insert_node_ptr(List sinfo_list, uint16_t part_num,
 			    partition_info_t *part_ptr,
@@ -162,11 +200,27 @@ static int _get_info(bool clear_old)
 {
 	partition_info_msg_t *partition_msg = NULL;
 	node_info_msg_t *node_msg = NULL;
+	node_summary_msg_t *summary_msg = NULL;
 	block_info_msg_t *block_msg = NULL;
 	reserve_info_msg_t *reserv_msg = NULL;
 	List sinfo_list = NULL;
 	int rc = 0;
 
+	if (_use_summary()) {
+		if (_query_summary(&partition_msg, &summary_msg, clear_old))
+			return 1;
+		if (summary_msg) {
+			sinfo_list = list_create(_sinfo_list_delete);
+			_build_sinfo_summary(sinfo_list, partition_msg,
+					     summary_msg);
+			sort_sinfo_list(sinfo_list);
+			print_sinfo_list(sinfo_list);
+			FREE_NULL_LIST(sinfo_list);
+			return rc;
+		}
+		/* else fall back to loading every node */
+	}
+
 	if (_query_server(&partition_msg, &node_msg, &block_msg, &reserv_msg,
 			  clear_old))
 		rc = 1;
@@ -252,7 +306,6 @@ _query_server(partition_info_msg_t ** part_pptr,
 	      reserve_info_msg_t ** reserv_pptr,
 	      bool clear_old)
 {
-	static partition_info_msg_t *old_part_ptr = NULL, *new_part_ptr;
 	static node_info_msg_t *old_node_ptr = NULL, *new_node_ptr;
 	static block_info_msg_t *old_bg_ptr = NULL, *new_bg_ptr;
 	static reserve_info_msg_t *old_resv_ptr = NULL, *new_resv_ptr;
@@ -263,28 +316,9 @@ _query_server(partition_info_msg_t ** part_pptr,
 	if (params.all_flag)
 		show_flags |= SHOW_ALL;
 
-	if (old_part_ptr) {
-		if (clear_old)
-			old_part_ptr->last_update = 0;
-		error_code = slurm_load_partitions(old_part_ptr->last_update,
-						   &new_part_ptr, show_flags);
-		if (error_code == SLURM_SUCCESS)
-			slurm_free_partition_info_msg(old_part_ptr);
-		else if (slurm_get_errno() == SLURM_NO_CHANGE_IN_DATA) {
-			error_code = SLURM_SUCCESS;
-			new_part_ptr = old_part_ptr;
-		}
-	} else {
-		error_code = slurm_load_partitions((time_t) NULL, &new_part_ptr,
-						   show_flags);
-	}
-	if (error_code) {
-		slurm_perror("slurm_load_partitions");
+	error_code = _load_partitions(part_pptr, clear_old);
+	if (error_code)
 		return error_code;
-	}
-
-	old_part_ptr = new_part_ptr;
-	*part_pptr = new_part_ptr;
 
 	if (old_node_ptr) {
 		if (clear_old)
@@ -294,8 +328,8 @@ _query_server(partition_info_msg_t ** part_pptr,
 							    params.nodes,
 							    show_flags);
 		} else {
-			error_code = slurm_load_node(old_node_ptr->last_update,
-						     &new_node_ptr, show_flags);
+			error_code = _load_nodes(clear_old ? NULL : old_node_ptr,
+						 &new_node_ptr, show_flags);
 		}
 		if (error_code == SLURM_SUCCESS)
 			slurm_free_node_info_msg(old_node_ptr);
@@ -307,8 +341,7 @@ _query_server(partition_info_msg_t ** part_pptr,
 		error_code = slurm_load_node_single(&new_node_ptr, params.nodes,
 						    show_flags);
 	} else {
-		error_code = slurm_load_node((time_t) NULL, &new_node_ptr,
-					     show_flags);
+		error_code = _load_nodes(NULL, &new_node_ptr, show_flags);
 	}
 
 	if (error_code) {
@@ -373,6 +406,162 @@ _query_server(partition_info_msg_t ** part_pptr,
 	return SLURM_SUCCESS;
 }
 
+/*
+ * _load_nodes - download current node state information, only the nodes
+ *	changed since old_node_ptr was loaded if the controller supports it
+ * IN old_node_ptr - node information from the last call or NULL, its records
+ *	may be moved to new_node_ptr but it must still be freed
+ * OUT new_node_ptr - the node information
+ * IN show_flags - node filtering options
+ * RET zero or error code
+ */
+static int _load_nodes(node_info_msg_t *old_node_ptr,
+		       node_info_msg_t **new_node_ptr, uint16_t show_flags)
+{
+	int error_code;
+
+	if (!delta_unavailable) {
+		error_code = slurm_load_node_delta(old_node_ptr, new_node_ptr,
+						   show_flags);
+		if ((error_code == SLURM_SUCCESS) ||
+		    (slurm_get_errno() == SLURM_NO_CHANGE_IN_DATA))
+			return error_code;
+		/* Likely an older slurmctld, use slurm_load_node() */
+		if (params.verbose)
+			slurm_perror("slurm_load_node_delta");
+		delta_unavailable = true;
+	}
+
+	return slurm_load_node(old_node_ptr ? old_node_ptr->last_update : 0,
+			       new_node_ptr, show_flags);
+}
+
+/*
+ * _load_partitions - download current partition state information
+ * OUT part_pptr - the partition information, kept for the next call
+ * IN clear_old - if set then don't preserve old info
+ * RET zero or error code
+ */
+static int _load_partitions(partition_info_msg_t **part_pptr, bool clear_old)
+{
+	static partition_info_msg_t *old_part_ptr = NULL, *new_part_ptr;
+	int error_code;
+	uint16_t show_flags = 0;
+
+	if (params.all_flag)
+		show_flags |= SHOW_ALL;
+
+	if (old_part_ptr) {
+		if (clear_old)
+			old_part_ptr->last_update = 0;
+		error_code = slurm_load_partitions(old_part_ptr->last_update,
+						   &new_part_ptr, show_flags);
+		if (error_code == SLURM_SUCCESS)
+			slurm_free_partition_info_msg(old_part_ptr);
+		else if (slurm_get_errno() == SLURM_NO_CHANGE_IN_DATA) {
+			error_code = SLURM_SUCCESS;
+			new_part_ptr = old_part_ptr;
+		}
+	} else {
+		error_code = slurm_load_partitions((time_t) NULL, &new_part_ptr,
+						   show_flags);
+	}
+	if (error_code) {
+		slurm_perror("slurm_load_partitions");
+		return error_code;
+	}
+
+	old_part_ptr = new_part_ptr;
+	*part_pptr = new_part_ptr;
+	return SLURM_SUCCESS;
+}
+
+/*
+ * _use_summary - report if the output can be built from the node groups
+ *	returned by slurm_load_node_summary() rather than from every node
+ */
+static bool _use_summary(void)
+{
+	struct sinfo_match_flags *flags = &params.match_flags;
+
+	if (summary_unavailable || params.bg_flag || params.reservation_flag ||
+	    (params.cluster_flags & CLUSTER_FLAG_BG))
+		return false;
+
+	/* Selects or reports individual nodes */
+	if (params.node_flag || params.node_name_single || params.nodes ||
+	    params.exact_match || flags->hostnames_flag ||
+	    flags->node_addr_flag)
+		return false;
+
+	/* Needs fields which are not part of the summary */
+	if (flags->gres_flag || flags->reason_flag ||
+	    flags->reason_timestamp_flag || flags->reason_user_flag ||
+	    flags->cpu_load_flag)
+		return false;
+
+	/* A node in several partitions is only counted once in a record
+	 * spanning those partitions, which the summary can not tell */
+	if (!flags->partition_flag)
+		return false;
+
+	return true;
+}
+
+/*
+ * _query_summary - download partition information and the nodes of each
+ *	partition grouped by state and features
+ * OUT part_pptr - the partition information
+ * OUT summary_pptr - the node groups, NULL if the controller can not
+ *	provide them
+ * IN clear_old - if set then don't preserve old info
+ * RET zero or error code
+ */
+static int _query_summary(partition_info_msg_t **part_pptr,
+			  node_summary_msg_t **summary_pptr, bool clear_old)
+{
+	static node_summary_msg_t *old_summary_ptr = NULL, *new_summary_ptr;
+	int error_code;
+	uint16_t show_flags = 0;
+
+	if (params.all_flag)
+		show_flags |= SHOW_ALL;
+
+	*summary_pptr = NULL;
+	error_code = _load_partitions(part_pptr, clear_old);
+	if (error_code)
+		return error_code;
+
+	if (old_summary_ptr) {
+		if (clear_old)
+			old_summary_ptr->last_update = 0;
+		error_code = slurm_load_node_summary(
+			old_summary_ptr->last_update,
+			&new_summary_ptr, show_flags);
+		if (error_code == SLURM_SUCCESS)
+			slurm_free_node_summary_msg(old_summary_ptr);
+		else if (slurm_get_errno() == SLURM_NO_CHANGE_IN_DATA) {
+			error_code = SLURM_SUCCESS;
+			new_summary_ptr = old_summary_ptr;
+		}
+	} else {
+		error_code = slurm_load_node_summary((time_t) NULL,
+						     &new_summary_ptr,
+						     show_flags);
+	}
+
+	if (error_code) {
+		/* Likely an older slurmctld, use slurm_load_node() */
+		if (params.verbose)
+			slurm_perror("slurm_load_node_summary");
+		summary_unavailable = true;
+		return SLURM_SUCCESS;
+	}
+	old_summary_ptr = new_summary_ptr;
+	*summary_pptr = new_summary_ptr;
+	return SLURM_SUCCESS;
+}
+
 /* Build information about a partition using one pthread per partition */
 void *_build_part_info(void *args)
 {
@@ -453,20 +642,10 @@ static int _build_sinfo_data(List sinfo_list,
 	int j;
 
 	g_node_scaling = node_msg->node_scaling;
+	_hash_init(node_msg->record_count, partition_msg->record_count);
 
 	/* by default every partition is shown, even if no nodes */
-	if ((!params.node_flag) && params.match_flags.partition_flag) {
-		part_ptr = partition_msg->partition_array;
-		for (j=0; j<partition_msg->record_count; j++, part_ptr++) {
-			if ((!params.partition) ||
-			    (_strcmp(params.partition, part_ptr->name) == 0)) {
-				list_append(sinfo_list, _create_sinfo(
-						    part_ptr, (uint16_t) j,
-						    NULL,
-						    node_msg->node_scaling));
-			}
-		}
-	}
+	_create_part_sinfo(sinfo_list, partition_msg);
 
 	if (params.filtering) {
 		for (j = 0; j < node_msg->record_count; j++) {
@@ -551,10 +730,97 @@ static int _build_sinfo_data(List sinfo_list,
 	}
 	slurm_mutex_unlock(&sinfo_cnt_mutex);
 
+	_hash_fini();
+	_sort_hostlist(sinfo_list);
+	return SLURM_SUCCESS;
+}
+
+/*
+ * _build_sinfo_summary - make sinfo_data entries from the node groups
+ *	returned by slurm_load_node_summary(), merging groups which are
+ *	reported together and add them to the sinfo_list for later printing.
+ * sinfo_list IN/OUT - list of unique sinfo_data records to report
+ * partition_msg IN - partition info message
+ * summary_msg IN - node summary message
+ * RET zero or error code
+ */
+static int _build_sinfo_summary(List sinfo_list,
+				partition_info_msg_t *partition_msg,
+				node_summary_msg_t *summary_msg)
+{
+	node_summary_t *summary = summary_msg->summary_array;
+	partition_info_t *part_ptr;
+	sinfo_data_t *sinfo_ptr;
+	node_info_t node;
+	uint32_t hash;
+	int i, j;
+
+	g_node_scaling = 1;
+	_hash_init(summary_msg->record_count, partition_msg->record_count);
+	_create_part_sinfo(sinfo_list, partition_msg);
+
+	/* Just what _match_node_data() and _filter_out_state() look at */
+	memset(&node, 0, sizeof(node_info_t));
+	for (i = 0; i < summary_msg->record_count; i++, summary++) {
+		if (params.partition &&
+		    _strcmp(params.partition, summary->partition))
+			continue;
+		part_ptr = partition_msg->partition_array;
+		for (j = 0; j < partition_msg->record_count; j++, part_ptr++) {
+			if (!_strcmp(part_ptr->name, summary->partition))
+				break;
+		}
+		if (j >= partition_msg->record_count)
+			continue;	/* partition changed or not shown */
+
+		node.node_state = summary->node_state;
+		node.features   = summary->features;
+		if (_filter_out_state(&node, (summary->cpus_alloc != 0),
+				      (summary->cpus_err != 0)))
+			continue;
+
+		sinfo_ptr = _find_sinfo((uint16_t) j, part_ptr, &node, &hash);
+		if (sinfo_ptr == NULL) {
+			sinfo_ptr = _create_sinfo(part_ptr, (uint16_t) j,
+						  NULL, 0);
+			list_append(sinfo_list, sinfo_ptr);
+			_hash_add_sinfo(sinfo_ptr, hash);
+		}
+		_update_sinfo_summary(sinfo_ptr, summary);
+	}
+
+	_hash_fini();
 	_sort_hostlist(sinfo_list);
 	return SLURM_SUCCESS;
 }
 
+/*
+ * _create_part_sinfo - make an empty sinfo_data entry for every partition
+ *	to be reported, so that partitions are shown even if they have no
+ *	nodes
+ */
+static void _create_part_sinfo(List sinfo_list,
+			       partition_info_msg_t *partition_msg)
+{
+	partition_info_t *part_ptr;
+	sinfo_data_t *sinfo_ptr;
+	int j;
+
+	if (params.node_flag || !params.match_flags.partition_flag)
+		return;
+
+	part_ptr = partition_msg->partition_array;
+	for (j = 0; j < partition_msg->record_count; j++, part_ptr++) {
+		if ((!params.partition) ||
+		    (_strcmp(params.partition, part_ptr->name) == 0)) {
+			sinfo_ptr = _create_sinfo(part_ptr, (uint16_t) j,
+						  NULL, g_node_scaling);
+			list_append(sinfo_list, sinfo_ptr);
+			sinfo_empty[j] = sinfo_ptr;
+		}
+	}
+}
+
 /*
  * _filter_out - Determine if the specified node should be filtered out or
  *	reported.
@@ -564,6 +830,7 @@ static int _build_sinfo_data(List sinfo_list,
 static bool _filter_out(node_info_t *node_ptr)
 {
 	static hostlist_t host_list = NULL;
+	uint16_t alloc_cpus = 0, err_cpus = 0;
 
 	if (params.nodes) {
 		if (host_list == NULL)
@@ -572,6 +839,31 @@ static bool _filter_out(node_info_t *node_ptr)
 			return true;
 	}
 
+	if (params.state_list) {
+		slurm_get_select_nodeinfo(node_ptr->select_nodeinfo,
+					  SELECT_NODEDATA_SUBCNT,
+					  NODE_STATE_ALLOCATED,
+					  &alloc_cpus);
+		slurm_get_select_nodeinfo(node_ptr->select_nodeinfo,
+					  SELECT_NODEDATA_SUBCNT,
+					  NODE_STATE_ERROR,
+					  &err_cpus);
+	}
+
+	return _filter_out_state(node_ptr, (alloc_cpus != 0),
+				 (err_cpus != 0));
+}
+
+/*
+ * _filter_out_state - Determine if nodes in the given state should be
+ *	filtered out or reported.
+ * node_ptr IN - node to consider filtering out, only its state is used
+ * alloc IN - set if the node has allocated CPUs
+ * err IN - set if the node has CPUs in an error state
+ * RET - true if node should not be reported, false otherwise
+ */
+static bool _filter_out_state(node_info_t *node_ptr, bool alloc, bool err)
+{
 	if (params.dead_nodes && !IS_NODE_NO_RESPOND(node_ptr))
 		return true;
 
@@ -583,7 +875,6 @@ static bool _filter_out(node_info_t *node_ptr)
 		bool match = false;
 		uint16_t base_state;
 		ListIterator iterator;
-		uint16_t cpus = 0;
 		node_info_t tmp_node, *tmp_node_ptr = &tmp_node;
 
 		iterator = list_iterator_create(params.state_list);
@@ -616,22 +907,12 @@ static bool _filter_out(node_info_t *node_ptr)
 					break;
 				}
 			} else if (*node_state == NODE_STATE_ERROR) {
-				slurm_get_select_nodeinfo(
-					node_ptr->select_nodeinfo,
-					SELECT_NODEDATA_SUBCNT,
-					NODE_STATE_ERROR,
-					&cpus);
-				if (cpus) {
+				if (err) {
 					match = true;
 					break;
 				}
 			} else if (*node_state == NODE_STATE_ALLOCATED) {
-				slurm_get_select_nodeinfo(
-					node_ptr->select_nodeinfo,
-					SELECT_NODEDATA_SUBCNT,
-					NODE_STATE_ALLOCATED,
-					&cpus);
-				if (cpus) {
+				if (alloc) {
 					match = true;
 					break;
 				}
@@ -978,13 +1259,99 @@ static void _update_sinfo(sinfo_data_t *sinfo_ptr, node_info_t *node_ptr,
 		sinfo_ptr->cpus_idle += total_cpus;
 }
 
+/* Add a group of nodes from slurm_load_node_summary() to an sinfo record,
+ * counting them as _update_sinfo() would count each node */
+static void _update_sinfo_summary(sinfo_data_t *sinfo_ptr,
+				  node_summary_t *summary)
+{
+	node_info_t node, *node_ptr = &node;	/* for the state macros */
+	uint16_t base_state = summary->node_state & NODE_STATE_BASE;
+	uint32_t cpus_left;
+
+	if (sinfo_ptr->nodes_total == 0) {	/* first group added */
+		sinfo_ptr->node_state  = summary->node_state;
+		sinfo_ptr->features    = summary->features;
+		sinfo_ptr->min_cpus    = summary->min_cpus;
+		sinfo_ptr->max_cpus    = summary->max_cpus;
+		sinfo_ptr->min_sockets = summary->min_sockets;
+		sinfo_ptr->max_sockets = summary->max_sockets;
+		sinfo_ptr->min_cores   = summary->min_cores;
+		sinfo_ptr->max_cores   = summary->max_cores;
+		sinfo_ptr->min_threads = summary->min_threads;
+		sinfo_ptr->max_threads = summary->max_threads;
+		sinfo_ptr->min_disk    = summary->min_disk;
+		sinfo_ptr->max_disk    = summary->max_disk;
+		sinfo_ptr->min_mem     = summary->min_mem;
+		sinfo_ptr->max_mem     = summary->max_mem;
+		sinfo_ptr->min_weight  = summary->min_weight;
+		sinfo_ptr->max_weight  = summary->max_weight;
+		sinfo_ptr->max_cpus_per_node = sinfo_ptr->part_info->
+					       max_cpus_per_node;
+	} else {
+		sinfo_ptr->min_cpus = MIN(sinfo_ptr->min_cpus,
+					  summary->min_cpus);
+		sinfo_ptr->max_cpus = MAX(sinfo_ptr->max_cpus,
+					  summary->max_cpus);
+		sinfo_ptr->min_sockets = MIN(sinfo_ptr->min_sockets,
+					     summary->min_sockets);
+		sinfo_ptr->max_sockets = MAX(sinfo_ptr->max_sockets,
+					     summary->max_sockets);
+		sinfo_ptr->min_cores = MIN(sinfo_ptr->min_cores,
+					   summary->min_cores);
+		sinfo_ptr->max_cores = MAX(sinfo_ptr->max_cores,
+					   summary->max_cores);
+		sinfo_ptr->min_threads = MIN(sinfo_ptr->min_threads,
+					     summary->min_threads);
+		sinfo_ptr->max_threads = MAX(sinfo_ptr->max_threads,
+					     summary->max_threads);
+		sinfo_ptr->min_disk = MIN(sinfo_ptr->min_disk,
+					  summary->min_disk);
+		sinfo_ptr->max_disk = MAX(sinfo_ptr->max_disk,
+					  summary->max_disk);
+		sinfo_ptr->min_mem = MIN(sinfo_ptr->min_mem,
+					 summary->min_mem);
+		sinfo_ptr->max_mem = MAX(sinfo_ptr->max_mem,
+					 summary->max_mem);
+		sinfo_ptr->min_weight = MIN(sinfo_ptr->min_weight,
+					    summary->min_weight);
+		sinfo_ptr->max_weight = MAX(sinfo_ptr->max_weight,
+					    summary->max_weight);
+	}
+
+	hostlist_push(sinfo_ptr->nodes, summary->nodes);
+
+	node.node_state = summary->node_state;
+	if ((base_state == NODE_STATE_ALLOCATED) ||
+	    IS_NODE_COMPLETING(node_ptr))
+		sinfo_ptr->nodes_alloc += summary->node_cnt;
+	else if (IS_NODE_DRAIN(node_ptr) || (base_state == NODE_STATE_DOWN))
+		sinfo_ptr->nodes_other += summary->node_cnt;
+	else
+		sinfo_ptr->nodes_idle += summary->node_cnt;
+	sinfo_ptr->nodes_total += summary->node_cnt;
+
+	sinfo_ptr->cpus_alloc += summary->cpus_alloc;
+	sinfo_ptr->cpus_total += summary->cpus_total;
+	cpus_left = summary->cpus_total -
+		    (summary->cpus_alloc + summary->cpus_err);
+
+	if (summary->cpus_err) {
+		sinfo_ptr->cpus_idle += cpus_left;
+		sinfo_ptr->cpus_other += summary->cpus_err;
+	} else if (IS_NODE_DRAIN(node_ptr) ||
+		   (base_state == NODE_STATE_DOWN)) {
+		sinfo_ptr->cpus_other += cpus_left;
+	} else
+		sinfo_ptr->cpus_idle += cpus_left;
+}
+
 static int _insert_node_ptr(List sinfo_list, uint16_t part_num,
 			    partition_info_t *part_ptr,
 			    node_info_t *node_ptr, uint32_t node_scaling)
 {
 	int rc = SLURM_SUCCESS;
 	sinfo_data_t *sinfo_ptr = NULL;
-	ListIterator itr = NULL;
+	uint32_t hash;
 
 	if (params.cluster_flags & CLUSTER_FLAG_BG) {
 		uint16_t error_cpus = 0;
@@ -997,27 +1364,169 @@ static int _insert_node_ptr(List sinfo_list, uint16_t part_num,
 			node_ptr->reason = xstrdup("Block(s) in error state");
 	}
 
-	itr = list_iterator_create(sinfo_list);
-	while ((sinfo_ptr = list_next(itr))) {
-		if (!_match_part_data(sinfo_ptr, part_ptr))
-			continue;
-		if (sinfo_ptr->nodes_total &&
-		    (!_match_node_data(sinfo_ptr, node_ptr)))
-			continue;
+	/* Each partition is processed by its own thread */
+	slurm_mutex_lock(&sinfo_hash_mutex);
+	sinfo_ptr = _find_sinfo(part_num, part_ptr, node_ptr, &hash);
+	if (sinfo_ptr) {
 		_update_sinfo(sinfo_ptr, node_ptr, node_scaling);
-		break;
+	} else {
+		/* if no match, create new sinfo_data entry */
+		sinfo_ptr = _create_sinfo(part_ptr, part_num,
+					  node_ptr, node_scaling);
+		list_append(sinfo_list, sinfo_ptr);
+		_hash_add_sinfo(sinfo_ptr, hash);
 	}
-	list_iterator_destroy(itr);
-
-	/* if no match, create new sinfo_data entry */
-	if (!sinfo_ptr)
-		list_append(sinfo_list,
-			    _create_sinfo(part_ptr, part_num,
-					  node_ptr, node_scaling));
+	slurm_mutex_unlock(&sinfo_hash_mutex);
 
 	return rc;
 }
 
+/* Hash the fields which _match_part_data() and _match_node_data() compare,
+ * so that records which match always have the same key */
+static uint32_t _hash_str(uint32_t hash, char *str)
+{
+	static char null_str[] = "(null)";	/* as used by _strcmp() */
+
+	if (str == NULL)
+		str = null_str;
+	while (*str)
+		hash = (hash * 31) + *str++;
+	return (hash * 31);
+}
+
+static uint32_t _hash_sinfo_key(partition_info_t *part_ptr,
+				node_info_t *node_ptr)
+{
+	struct sinfo_match_flags *flags = &params.match_flags;
+	uint32_t hash = 0;
+
+	if (flags->avail_flag)
+		hash = (hash * 31) + part_ptr->state_up;
+	if (flags->groups_flag)
+		hash = _hash_str(hash, part_ptr->allow_groups);
+	if (flags->job_size_flag) {
+		hash = (hash * 31) + part_ptr->min_nodes;
+		hash = (hash * 31) + part_ptr->max_nodes;
+	}
+	if (flags->default_time_flag)
+		hash = (hash * 31) + part_ptr->default_time;
+	if (flags->max_time_flag)
+		hash = (hash * 31) + part_ptr->max_time;
+	if (flags->partition_flag)
+		hash = _hash_str(hash, part_ptr->name);
+	if (flags->root_flag)
+		hash = (hash * 31) + (part_ptr->flags & PART_FLAG_ROOT_ONLY);
+	if (flags->share_flag)
+		hash = (hash * 31) + part_ptr->max_share;
+	if (flags->preempt_mode_flag)
+		hash = (hash * 31) + part_ptr->preempt_mode;
+	if (flags->priority_flag)
+		hash = (hash * 31) + part_ptr->priority;
+	if (flags->max_cpus_per_node_flag)
+		hash = (hash * 31) + part_ptr->max_cpus_per_node;
+
+	if (flags->features_flag)
+		hash = _hash_str(hash, node_ptr->features);
+	if (flags->gres_flag)
+		hash = _hash_str(hash, node_ptr->gres);
+	if (flags->reason_flag)
+		hash = _hash_str(hash, node_ptr->reason);
+	if (flags->reason_timestamp_flag)
+		hash = (hash * 31) + node_ptr->reason_time;
+	if (flags->reason_user_flag)
+		hash = (hash * 31) + node_ptr->reason_uid;
+	if (flags->state_flag) {
+		hash = _hash_str(hash,
+				 node_state_string(node_ptr->node_state));
+	}
+
+	if (!params.exact_match)
+		return hash;
+
+	if (flags->cpus_flag)
+		hash = (hash * 31) + node_ptr->cpus;
+	if (flags->sockets_flag || flags->sct_flag)
+		hash = (hash * 31) + node_ptr->sockets;
+	if (flags->cores_flag || flags->sct_flag)
+		hash = (hash * 31) + node_ptr->cores;
+	if (flags->threads_flag || flags->sct_flag)
+		hash = (hash * 31) + node_ptr->threads;
+	if (flags->disk_flag)
+		hash = (hash * 31) + node_ptr->tmp_disk;
+	if (flags->memory_flag)
+		hash = (hash * 31) + node_ptr->real_memory;
+	if (flags->weight_flag)
+		hash = (hash * 31) + node_ptr->weight;
+	if (flags->cpu_load_flag)
+		hash = (hash * 31) + node_ptr->cpu_load;
+
+	return hash;
+}
+
+/* Size the hash table for about one record per node (or node group) */
+static void _hash_init(int rec_cnt, int part_cnt)
+{
+	sinfo_hash_size = rec_cnt + part_cnt + 1;
+	sinfo_hash = xmalloc(sizeof(sinfo_data_t *) * sinfo_hash_size);
+	sinfo_empty_cnt = part_cnt;
+	sinfo_empty = xmalloc(sizeof(sinfo_data_t *) * (part_cnt + 1));
+}
+
+static void _hash_fini(void)
+{
+	xfree(sinfo_hash);
+	sinfo_hash_size = 0;
+	xfree(sinfo_empty);
+	sinfo_empty_cnt = 0;
+}
+
+static void _hash_add_sinfo(sinfo_data_t *sinfo_ptr, uint32_t hash)
+{
+	sinfo_ptr->hash_next = sinfo_hash[hash];
+	sinfo_hash[hash] = sinfo_ptr;
+}
+
+/*
+ * _find_sinfo - find the sinfo record to which a node should be added
+ * part_num IN - index of the node's partition
+ * part_ptr IN - the node's partition
+ * node_ptr IN - the node to add
+ * hash OUT - hash table index at which to add a new record for the node
+ * RET the matching record or NULL if a new one is needed
+ */
+static sinfo_data_t *_find_sinfo(uint16_t part_num,
+				 partition_info_t *part_ptr,
+				 node_info_t *node_ptr, uint32_t *hash)
+{
+	sinfo_data_t *sinfo_ptr;
+
+	*hash = _hash_sinfo_key(part_ptr, node_ptr) % sinfo_hash_size;
+
+	/* The records made for each partition before any nodes were added
+	 * are first in sinfo_list, so any node of the partition goes there
+	 * first, and then the record is matched like any other */
+	if ((part_num < sinfo_empty_cnt) && sinfo_empty[part_num] &&
+	    _match_part_data(sinfo_empty[part_num], part_ptr)) {
+		sinfo_ptr = sinfo_empty[part_num];
+		sinfo_empty[part_num] = NULL;
+		_hash_add_sinfo(sinfo_ptr, *hash);
+		return sinfo_ptr;
+	}
+
+	/* Every node is reported by itself */
+	if (params.match_flags.hostnames_flag ||
+	    params.match_flags.node_addr_flag)
+		return NULL;
+
+	for (sinfo_ptr = sinfo_hash[*hash]; sinfo_ptr;
+	     sinfo_ptr = sinfo_ptr->hash_next) {
+		if (_match_part_data(sinfo_ptr, part_ptr) &&
+		    _match_node_data(sinfo_ptr, node_ptr))
+			return sinfo_ptr;
+	}
+	return NULL;
+}
+
 static int _handle_subgrps(List sinfo_list, uint16_t part_num,
 			   partition_info_t *part_ptr,
 			   node_info_t *node_ptr, uint32_t node_scaling)
@@ -71,7 +71,7 @@
 #include "src/common/slurmdb_defs.h"
 
 /* Collection of data for printing reports. Like data is combined here */
-typedef struct {
+typedef struct sinfo_data {
 	uint16_t node_state;
 
 	uint32_t nodes_alloc;
@@ -118,6 +118,8 @@ typedef struct {
 	 * root, share, groups, priority */
 	partition_info_t* part_info;
 	uint16_t part_inx;
+
+	struct sinfo_data *hash_next;	/* next record with same hash */
 } sinfo_data_t;
 
 /* Identify what fields must match for a node's information to be
@@ -59,6 +59,18 @@ enum {
 	ACCT_POLICY_JOB_FINI
 };
 
+/* assoc_mgr_limit_cache_t flags, limits reached no matter the job size */
+#define LIMIT_GRP_CPU_MINS	0x0001
+#define LIMIT_GRP_JOBS		0x0002
+#define LIMIT_GRP_WALL		0x0004
+#define LIMIT_MAX_JOBS		0x0008
+
+/* Cached limit headroom is valid while its seq matches limit_cache_seq.
+ * The sequence advances when jobs begin or end, when limits change and
+ * once per second so that usage decay is picked up. */
+static uint32_t limit_cache_seq = 1;
+static time_t   limit_cache_time = 0;
+
 static slurmdb_used_limits_t *_get_used_limits_for_user(
 	List user_limit_list, uint32_t user_id)
 {
@@ -110,6 +122,145 @@ static bool _valid_job_assoc(struct job_record *job_ptr)
 	return true;
 }
 
+/* Room left under a group limit, INT64_MAX if there is no limit */
+static int64_t _limit_left(uint32_t limit, uint32_t used)
+{
+	if (limit == INFINITE)
+		return INT64_MAX;
+	return (int64_t) limit - (int64_t) used;
+}
+
+/* Refresh the limit headroom cached in the QOS record */
+static void _qos_limit_cache(slurmdb_qos_rec_t *qos_ptr)
+{
+	assoc_mgr_limit_cache_t *cache = &qos_ptr->usage->limit_cache;
+	uint64_t usage_mins, cpu_run_mins;
+	uint32_t wall_mins;
+
+	if (cache->seq == limit_cache_seq)
+		return;
+
+	usage_mins = (uint64_t)(qos_ptr->usage->usage_raw / 60.0);
+	wall_mins = qos_ptr->usage->grp_used_wall / 60;
+	cpu_run_mins = qos_ptr->usage->grp_used_cpu_run_secs / 60;
+
+	cache->seq = limit_cache_seq;
+	cache->flags = 0;
+	if ((qos_ptr->grp_cpu_mins != (uint64_t)INFINITE) &&
+	    (usage_mins >= qos_ptr->grp_cpu_mins))
+		cache->flags |= LIMIT_GRP_CPU_MINS;
+	if ((qos_ptr->grp_jobs != INFINITE) &&
+	    (qos_ptr->usage->grp_used_jobs >= qos_ptr->grp_jobs))
+		cache->flags |= LIMIT_GRP_JOBS;
+	if ((qos_ptr->grp_wall != INFINITE) &&
+	    (wall_mins >= qos_ptr->grp_wall))
+		cache->flags |= LIMIT_GRP_WALL;
+
+	cache->cpus = _limit_left(qos_ptr->grp_cpus,
+				  qos_ptr->usage->grp_used_cpus);
+	cache->mem = _limit_left(qos_ptr->grp_mem,
+				 qos_ptr->usage->grp_used_mem);
+	cache->nodes = _limit_left(qos_ptr->grp_nodes,
+				   qos_ptr->usage->grp_used_nodes);
+	if (qos_ptr->grp_cpu_run_mins == INFINITE)
+		cache->cpu_run_mins = INT64_MAX;
+	else
+		cache->cpu_run_mins = (int64_t) qos_ptr->grp_cpu_run_mins -
+				      (int64_t) cpu_run_mins;
+}
+
+/* Refresh the limit headroom cached in the association record, this is
+ * the least room left at any level up to the root of the tree */
+static void _assoc_limit_cache(slurmdb_association_rec_t *assoc_ptr)
+{
+	assoc_mgr_limit_cache_t *cache = &assoc_ptr->usage->limit_cache;
+	slurmdb_association_rec_t *parent_ptr;
+	uint64_t usage_mins, cpu_run_mins;
+	uint32_t wall_mins;
+	int64_t left;
+
+	if (cache->seq == limit_cache_seq)
+		return;
+
+	cache->seq = limit_cache_seq;
+	cache->flags = 0;
+	cache->cpus = INT64_MAX;
+	cache->cpu_run_mins = INT64_MAX;
+	cache->mem = INT64_MAX;
+	cache->nodes = INT64_MAX;
+
+	/* Per-job and per-user limits apply to this association only */
+	if ((assoc_ptr->max_jobs != INFINITE) &&
+	    (assoc_ptr->usage->used_jobs >= assoc_ptr->max_jobs))
+		cache->flags |= LIMIT_MAX_JOBS;
+
+	for (parent_ptr = assoc_ptr; parent_ptr;
+	     parent_ptr = parent_ptr->usage->parent_assoc_ptr) {
+		usage_mins = (uint64_t)(parent_ptr->usage->usage_raw / 60.0);
+		wall_mins = parent_ptr->usage->grp_used_wall / 60;
+		cpu_run_mins = parent_ptr->usage->grp_used_cpu_run_secs / 60;
+
+		if ((parent_ptr->grp_cpu_mins != (uint64_t)INFINITE) &&
+		    (usage_mins >= parent_ptr->grp_cpu_mins))
+			cache->flags |= LIMIT_GRP_CPU_MINS;
+		if ((parent_ptr->grp_jobs != INFINITE) &&
+		    (parent_ptr->usage->used_jobs >= parent_ptr->grp_jobs))
+			cache->flags |= LIMIT_GRP_JOBS;
+		if ((parent_ptr->grp_wall != INFINITE) &&
+		    (wall_mins >= parent_ptr->grp_wall))
+			cache->flags |= LIMIT_GRP_WALL;
+
+		left = _limit_left(parent_ptr->grp_cpus,
+				   parent_ptr->usage->grp_used_cpus);
+		cache->cpus = MIN(cache->cpus, left);
+		left = _limit_left(parent_ptr->grp_mem,
+				   parent_ptr->usage->grp_used_mem);
+		cache->mem = MIN(cache->mem, left);
+		left = _limit_left(parent_ptr->grp_nodes,
+				   parent_ptr->usage->grp_used_nodes);
+		cache->nodes = MIN(cache->nodes, left);
+		if (parent_ptr->grp_cpu_run_mins != INFINITE) {
+			left = (int64_t) parent_ptr->grp_cpu_run_mins -
+			       (int64_t) cpu_run_mins;
+			cache->cpu_run_mins = MIN(cache->cpu_run_mins, left);
+		}
+	}
+}
+
+/* Memory required by a job for group memory limits, zero if none */
+static uint32_t _get_job_memory(struct job_record *job_ptr,
+				bool *admin_set_memory_limit)
+{
+	uint32_t job_memory = 0;
+
+	*admin_set_memory_limit = false;
+	if (!job_ptr->details->pn_min_memory)
+		return job_memory;
+
+	if (job_ptr->details->pn_min_memory & MEM_PER_CPU) {
+		job_memory = (job_ptr->details->pn_min_memory
+			      & (~MEM_PER_CPU))
+			* job_ptr->details->min_cpus;
+		*admin_set_memory_limit =
+			(job_ptr->limit_set_pn_min_memory == ADMIN_SET_LIMIT)
+			|| (job_ptr->limit_set_min_cpus == ADMIN_SET_LIMIT);
+		debug3("acct_policy_job_runnable: job %u: MPC: "
+		       "job_memory set to %u", job_ptr->job_id,
+		       job_memory);
+	} else {
+		job_memory = (job_ptr->details->pn_min_memory)
+			* job_ptr->details->min_nodes;
+		*admin_set_memory_limit =
+			(job_ptr->limit_set_pn_min_memory == ADMIN_SET_LIMIT)
+			|| (job_ptr->limit_set_min_nodes == ADMIN_SET_LIMIT);
+		debug3("acct_policy_job_runnable: job %u: MPN: "
+		       "job_memory set to %u", job_ptr->job_id,
+		       job_memory);
+	}
+
+	return job_memory;
+}
+
 static void _adjust_limit_usage(int type, struct job_record *job_ptr)
 {
 	slurmdb_association_rec_t *assoc_ptr = NULL;
@@ -159,6 +310,8 @@ static void _adjust_limit_usage(int type, struct job_record *job_ptr)
 	}
 
 	assoc_mgr_lock(&locks);
+	if ((type == ACCT_POLICY_JOB_BEGIN) || (type == ACCT_POLICY_JOB_FINI))
+		acct_policy_limits_changed();
 	if (job_ptr->qos_ptr) {
 		slurmdb_qos_rec_t *qos_ptr = NULL;
 		slurmdb_used_limits_t *used_limits = NULL;
@@ -1064,6 +1217,8 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 	if (!(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
 		return true;
 
+	slurmctld_diag_stats.acct_limit_eval_cnt++;
+
 	/* check to see if we should be using safe limits, if so we
 	 * will only start a job if there are sufficient remaining
 	 * cpu-minutes for it to run to completion */
@@ -1077,32 +1232,7 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr)
 	job_cpu_time_limit = (uint64_t)job_ptr->time_limit
 		* (uint64_t)job_ptr->details->min_cpus;
 
-	if (job_ptr->details->pn_min_memory) {
-		if (job_ptr->details->pn_min_memory & MEM_PER_CPU) {
-			job_memory = (job_ptr->details->pn_min_memory
-				      & (~MEM_PER_CPU))
-				* job_ptr->details->min_cpus;
-			admin_set_memory_limit =
-				(job_ptr->limit_set_pn_min_memory
-				 == ADMIN_SET_LIMIT)
-				|| (job_ptr->limit_set_min_cpus
-				    == ADMIN_SET_LIMIT);
-			debug3("acct_policy_job_runnable: job %u: MPC: "
-			       "job_memory set to %u", job_ptr->job_id,
-			       job_memory);
-		} else {
-			job_memory = (job_ptr->details->pn_min_memory)
-				* job_ptr->details->min_nodes;
-			admin_set_memory_limit =
-				(job_ptr->limit_set_pn_min_memory
-				 == ADMIN_SET_LIMIT)
-				|| (job_ptr->limit_set_min_nodes
-				    == ADMIN_SET_LIMIT);
-			debug3("acct_policy_job_runnable: job %u: MPN: "
-			       "job_memory set to %u", job_ptr->job_id,
-			       job_memory);
-		}
-	}
+	job_memory = _get_job_memory(job_ptr, &admin_set_memory_limit);
 
 	assoc_mgr_lock(&locks);
 	qos_ptr = job_ptr->qos_ptr;
@@ -1875,6 +2005,136 @@ end_it:
 	return rc;
 }
 
+/*
+ * acct_policy_limits_changed - Note that association or QOS usage or
+ *	limits changed, discarding the limit headroom cached for
+ *	acct_policy_job_runnable_cached()
+ */
+extern void acct_policy_limits_changed(void)
+{
+	if (++limit_cache_seq == 0)
+		limit_cache_seq = 1;
+}
+
+/*
+ * acct_policy_job_runnable_cached - Test a pending job against the room
+ *	left under its association and QOS group limits, cached once per
+ *	association and QOS rather than evaluated for every job. A job that
+ *	passes may still be held by acct_policy_job_runnable(), which tests
+ *	per-job and per-user limits as well.
+ * RET false and set the job's state_reason if a limit prevents it from
+ *	running now
+ * NOTE: Called with the job write lock held, which serializes updates of
+ *	the cache under the assoc_mgr read lock
+ */
+extern bool acct_policy_job_runnable_cached(struct job_record *job_ptr)
+{
+	slurmdb_qos_rec_t *qos_ptr;
+	slurmdb_association_rec_t *assoc_ptr;
+	assoc_mgr_limit_cache_t *cache;
+	uint64_t job_cpu_time_limit;
+	uint32_t job_memory, min_cpus, min_nodes;
+	uint16_t flags;
+	bool admin_set_memory_limit = false;
+	bool check_cpus, check_mem, check_nodes;
+	uint16_t reason = WAIT_NO_REASON;
+	time_t now;
+	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK,
+				   READ_LOCK, NO_LOCK, NO_LOCK };
+
+	if (!(accounting_enforce & ACCOUNTING_ENFORCE_LIMITS) ||
+	    !job_ptr->details)
+		return true;
+
+	/* acct_policy_job_runnable() revalidates a stale association */
+	assoc_ptr = (slurmdb_association_rec_t *)job_ptr->assoc_ptr;
+	if (!assoc_ptr || (assoc_ptr->id != job_ptr->assoc_id))
+		return true;
+
+	now = time(NULL);
+	if (now != limit_cache_time) {
+		limit_cache_time = now;
+		acct_policy_limits_changed();
+	}
+
+	min_cpus = job_ptr->details->min_cpus;
+	min_nodes = job_ptr->details->min_nodes;
+	check_cpus = (job_ptr->limit_set_min_cpus != ADMIN_SET_LIMIT);
+	check_nodes = (job_ptr->limit_set_min_nodes != ADMIN_SET_LIMIT);
+	job_cpu_time_limit = (uint64_t)job_ptr->time_limit * (uint64_t)min_cpus;
+	job_memory = _get_job_memory(job_ptr, &admin_set_memory_limit);
+	check_mem = !admin_set_memory_limit;
+
+	assoc_mgr_lock(&locks);
+	qos_ptr = (slurmdb_qos_rec_t *)job_ptr->qos_ptr;
+	if (qos_ptr) {
+		_qos_limit_cache(qos_ptr);
+		cache = &qos_ptr->usage->limit_cache;
+		if (cache->flags)
+			reason = WAIT_QOS_JOB_LIMIT;
+		else if (check_cpus && (qos_ptr->grp_cpus != INFINITE) &&
+			 (min_cpus > qos_ptr->grp_cpus))
+			reason = WAIT_QOS_JOB_LIMIT;
+		else if (check_nodes && (qos_ptr->grp_nodes != INFINITE) &&
+			 (min_nodes > qos_ptr->grp_nodes))
+			reason = WAIT_QOS_JOB_LIMIT;
+		else if (check_mem && (qos_ptr->grp_mem != INFINITE) &&
+			 (job_memory > qos_ptr->grp_mem))
+			reason = WAIT_QOS_JOB_LIMIT;
+		else if ((check_cpus && (min_cpus > cache->cpus)) ||
+			 (check_nodes && (min_nodes > cache->nodes)) ||
+			 (check_mem && (job_memory > cache->mem)) ||
+			 ((int64_t) job_cpu_time_limit > cache->cpu_run_mins))
+			reason = WAIT_QOS_RESOURCE_LIMIT;
+	}
+
+	if (reason == WAIT_NO_REASON) {
+		_assoc_limit_cache(assoc_ptr);
+		cache = &assoc_ptr->usage->limit_cache;
+
+		/* QOS limits take the place of association limits */
+		flags = cache->flags;
+		if (qos_ptr) {
+			if (qos_ptr->grp_cpu_mins != (uint64_t)INFINITE)
+				flags &= (~LIMIT_GRP_CPU_MINS);
+			if (qos_ptr->grp_jobs != INFINITE)
+				flags &= (~LIMIT_GRP_JOBS);
+			if (qos_ptr->grp_wall != INFINITE)
+				flags &= (~LIMIT_GRP_WALL);
+			if (qos_ptr->max_jobs_pu != INFINITE)
+				flags &= (~LIMIT_MAX_JOBS);
+			if (qos_ptr->grp_cpus != INFINITE)
+				check_cpus = false;
+			if (qos_ptr->grp_nodes != INFINITE)
+				check_nodes = false;
+			if (qos_ptr->grp_mem != INFINITE)
+				check_mem = false;
+		}
+
+		if (flags & (LIMIT_GRP_CPU_MINS | LIMIT_MAX_JOBS))
+			reason = WAIT_ASSOC_JOB_LIMIT;
+		else if (flags ||
+			 (check_cpus && (min_cpus > cache->cpus)) ||
+			 (check_nodes && (min_nodes > cache->nodes)) ||
+			 (check_mem && (job_memory > cache->mem)) ||
+			 ((!qos_ptr ||
+			   (qos_ptr->grp_cpu_run_mins == INFINITE)) &&
+			  ((int64_t) job_cpu_time_limit > cache->cpu_run_mins)))
+			reason = WAIT_ASSOC_RESOURCE_LIMIT;
+	}
+	assoc_mgr_unlock(&locks);
+
+	if (reason == WAIT_NO_REASON)
+		return true;
+
+	slurmctld_diag_stats.acct_limit_cached_cnt++;
+	xfree(job_ptr->state_desc);
+	job_ptr->state_reason = reason;
+	debug3("sched: JobId=%u held by cached accounting limits, reason %s",
+	       job_ptr->job_id, job_reason_string(reason));
+	return false;
+}
+
 /*
  * acct_policy_update_pending_job - Make sure the limits imposed on a job on
  *	submission are correct after an update to a qos or association.  If
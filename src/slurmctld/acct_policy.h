@@ -99,6 +99,22 @@ extern bool acct_policy_job_runnable(struct job_record *job_ptr);
  */
 extern bool acct_policy_job_runnable_state(struct job_record *job_ptr);
 
+/*
+ * acct_policy_job_runnable_cached - Test a pending job against the room
+ *	left under its association and QOS group limits, cached once per
+ *	association and QOS. A job that passes may still be held by
+ *	acct_policy_job_runnable().
+ * RET false and set the job's state_reason if a limit prevents it from
+ *	running now
+ */
+extern bool acct_policy_job_runnable_cached(struct job_record *job_ptr);
+
+/*
+ * acct_policy_limits_changed - Note that association or QOS usage or
+ *	limits changed, discarding cached limit headroom
+ */
+extern void acct_policy_limits_changed(void);
+
 /*
  * acct_policy_update_pending_job - Make sure the limits imposed on a
  *	job on submission are correct after an update to a qos or
@@ -176,11 +176,13 @@ static void _notify_slurmctld_nodes(agent_info_t *agent_ptr,
 		int no_resp_cnt, int retry_cnt);
 static void _purge_agent_args(agent_arg_t *agent_arg_ptr);
 static void _queue_agent_retry(agent_info_t * agent_info_ptr, int count);
+static void _reset_node_loads(List ret_list);
 static int _setup_requeue(agent_arg_t *agent_arg_ptr, thd_t *thread_ptr,
 			  int count, int *spot);
 static void _spawn_retry_agent(agent_arg_t * agent_arg_ptr);
 static void *_thread_per_group_rpc(void *args);
 static int   _valid_agent_arg(agent_arg_t *agent_arg_ptr);
+static void _validate_node_regs(List ret_list);
 static void *_wdog(void *args);
 
 static mail_info_t *_mail_alloc(void);
@@ -762,6 +764,69 @@ static inline int _comm_err(char *node_name, slurm_msg_type_t msg_type)
 	return rc;
 }
 
+/* Record the CPU load reported in each node's ping response */
+static void _reset_node_loads(List ret_list)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	ping_slurmd_resp_msg_t *ping_resp;
+	/* Lock: Write node */
+	slurmctld_lock_t node_write_lock = {
+		NO_LOCK, NO_LOCK, WRITE_LOCK, NO_LOCK };
+
+	lock_slurmctld(node_write_lock);
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		if (ret_data_info->type != RESPONSE_PING_SLURMD)
+			continue;
+		ping_resp = (ping_slurmd_resp_msg_t *) ret_data_info->data;
+		reset_node_load(ret_data_info->node_name, ping_resp->cpu_load);
+	}
+	list_iterator_destroy(itr);
+	unlock_slurmctld(node_write_lock);
+}
+
+/* Validate the registrations returned in response to
+ * REQUEST_NODE_REGISTRATION_STATUS. Older slurmd daemons reply with a
+ * return code and send their registration as a separate RPC instead. */
+static void _validate_node_regs(List ret_list)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	slurm_node_registration_status_msg_t **reg_msgs;
+	int *rc, i, reg_cnt = 0;
+	/* Locks: Read config, write job, write node */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK };
+
+	reg_msgs = xmalloc(sizeof(slurm_node_registration_status_msg_t *) *
+			   list_count(ret_list));
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		if (ret_data_info->type == MESSAGE_NODE_REGISTRATION_STATUS)
+			reg_msgs[reg_cnt++] = ret_data_info->data;
+	}
+	list_iterator_destroy(itr);
+	if (reg_cnt == 0) {
+		xfree(reg_msgs);
+		return;
+	}
+
+	rc = xmalloc(sizeof(int) * reg_cnt);
+	lock_slurmctld(job_write_lock);
+	validate_node_reg_msgs(reg_cnt, reg_msgs, rc);
+	unlock_slurmctld(job_write_lock);
+	for (i = 0; i < reg_cnt; i++) {
+		if (rc[i]) {
+			error("_validate_node_regs node=%s: %s",
+			      reg_msgs[i]->node_name, slurm_strerror(rc[i]));
+		}
+	}
+	debug2("validated %d node registrations", reg_cnt);
+	xfree(reg_msgs);
+	xfree(rc);
+}
+
 /* return a value for wihc WEXITSTATUS returns 1 */
 static int _wif_status(void)
 {
@@ -899,20 +964,18 @@ static void *_thread_per_group_rpc(void *args)
 	}
 
 	//info("got %d messages back", list_count(ret_list));
+	/* SPECIAL CASE: Record nodes' CPU load and registrations. Responses
+	 * from a whole branch of the forwarding tree arrive together, so
+	 * process them all under one lock rather than once per node */
+	if (msg_type == REQUEST_PING)
+		_reset_node_loads(ret_list);
+	else if (msg_type == REQUEST_NODE_REGISTRATION_STATUS)
+		_validate_node_regs(ret_list);
+
 	itr = list_iterator_create(ret_list);
 	while ((ret_data_info = list_next(itr)) != NULL) {
 		rc = slurm_get_return_code(ret_data_info->type,
 					   ret_data_info->data);
-		/* SPECIAL CASE: Record node's CPU load */
-		if (ret_data_info->type == RESPONSE_PING_SLURMD) {
-			ping_slurmd_resp_msg_t *ping_resp;
-			ping_resp = (ping_slurmd_resp_msg_t *)
-				    ret_data_info->data;
-			lock_slurmctld(node_write_lock);
-			reset_node_load(ret_data_info->node_name,
-					ping_resp->cpu_load);
-			unlock_slurmctld(node_write_lock);
-		}
 		/* SPECIAL CASE: Mark node as IDLE if job already complete */
 		if (is_kill_msg &&
 		    (rc == ESLURMD_KILL_JOB_ALREADY_COMPLETE)) {
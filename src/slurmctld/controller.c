@@ -63,6 +63,7 @@
 
 #include "src/common/assoc_mgr.h"
 #include "src/common/checkpoint.h"
+#include "src/common/conn_cache.h"
 #include "src/common/daemonize.h"
 #include "src/common/fd.h"
 #include "src/common/gres.h"
@@ -90,6 +91,7 @@
 
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/event_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/job_submit.h"
@@ -673,6 +675,7 @@ int main(int argc, char *argv[])
 	purge_front_end_state();
 	resv_fini();
 	trigger_fini();
+	event_fini();
 	dir_name = slurm_get_state_save_location();
 	assoc_mgr_fini(dir_name);
 	xfree(dir_name);
@@ -690,6 +693,7 @@ int main(int argc, char *argv[])
 	slurm_select_fini();
 	slurm_topo_fini();
 	checkpoint_fini();
+	conn_cache_fini();
 	slurm_auth_fini();
 	switch_fini();
 
@@ -1236,6 +1240,7 @@ static void _update_assoc(slurmdb_association_rec_t *rec)
 		return;
 
 	lock_slurmctld(job_write_lock);
+	acct_policy_limits_changed();
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
 		if ((rec != job_ptr->assoc_ptr) || (!IS_JOB_PENDING(job_ptr)))
@@ -1260,6 +1265,7 @@ static void _update_qos(slurmdb_qos_rec_t *rec)
 		return;
 
 	lock_slurmctld(job_write_lock);
+	acct_policy_limits_changed();
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
 		if ((rec != job_ptr->qos_ptr) || (!IS_JOB_PENDING(job_ptr)))
@@ -0,0 +1,663 @@
+/*****************************************************************************\
+ *  event_mgr.c - push job and node events to subscribed clients
+ *
+ *  Clients register a filter with REQUEST_EVENT_SUBSCRIBE and a port they
+ *  listen on. Events are queued per subscription as they happen and an
+ *  agent thread hands each subscriber its pending events in one
+ *  MESSAGE_EVENT_NOTIFY about once a second, sent by a thread of its own
+ *  with a short timeout. Subscriptions carry a lease which the client
+ *  renews by subscribing again with its sub_id; they are dropped when the
+ *  lease runs out or an event message can not be sent.  Subscribers other
+ *  than operators only see the jobs and nodes that squeue and sinfo would
+ *  show them.
+ *****************************************************************************
+ *  Copyright (C) 2014 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#ifdef WITH_PTHREADS
+#  include <pthread.h>
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "src/common/assoc_mgr.h"
+#include "src/common/list.h"
+#include "src/common/macros.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/uid.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmctld/event_mgr.h"
+#include "src/slurmctld/slurmctld.h"
+
+#define EVENT_LEASE_DEFAULT	300	/* seconds */
+#define EVENT_LEASE_MAX		3600	/* seconds */
+#define EVENT_QUEUE_MAX		10000	/* pending events per subscription */
+#define EVENT_SUB_MAX		1024	/* subscriptions */
+#define EVENT_SEND_THREADS	16	/* concurrent event sends */
+#define EVENT_SEND_TIMEOUT	2000	/* milliseconds */
+
+typedef struct event_sub {
+	uint32_t sub_id;
+	uid_t uid;			/* user who subscribed */
+	slurm_addr_t addr;		/* where to send events */
+	uint16_t event_mask;		/* EVENT_* */
+	char **part_array;		/* partition filter */
+	int part_cnt;
+	uid_t *uid_array;		/* user filter */
+	int uid_cnt;
+	bool is_operator;		/* sees everything */
+	bool own_jobs_only;		/* PrivateData=jobs */
+	bool no_nodes;			/* PrivateData=nodes */
+	bool sending;			/* event message being sent */
+	time_t expire;			/* end of lease */
+	List event_list;		/* slurm_event_t, oldest first */
+	uint32_t lost;			/* events discarded as queue full */
+} event_sub_t;
+
+typedef struct event_send {
+	uint32_t sub_id;
+	slurm_addr_t addr;
+	event_notify_msg_t *msg;
+} event_send_t;
+
+static pthread_mutex_t event_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  event_cond  = PTHREAD_COND_INITIALIZER;
+static List sub_list = NULL;
+static int sub_cnt = 0;			/* read without lock as a hint */
+static uint32_t next_sub_id = 1;
+static pthread_t event_thread = 0;
+static bool event_shutdown = false;
+static int send_thread_cnt = 0;
+
+static void  _del_event(void *x);
+static void  _del_sub(void *x);
+static void *_event_agent(void *args);
+static int   _find_sub_id(void *x, void *key);
+static void  _free_filter(event_sub_t *sub);
+static void  _job_event(uint16_t event_type, struct job_record *job_ptr);
+static void  _node_event(uint16_t event_type, struct node_record *node_ptr);
+static bool  _job_hidden(event_sub_t *sub, struct job_record *job_ptr);
+static bool  _node_hidden(event_sub_t *sub, struct node_record *node_ptr);
+static bool  _part_match(event_sub_t *sub, char *name);
+static void  _queue_event(event_sub_t *sub, uint16_t event_type,
+			  uint32_t job_id, uint32_t user_id, uint16_t state,
+			  char *partition, char *nodes, char *reason);
+static void *_send_events(void *args);
+static int   _set_filter(event_sub_t *sub, event_subscribe_msg_t *msg);
+
+static void _del_event(void *x)
+{
+	slurm_event_t *event = (slurm_event_t *) x;
+
+	xfree(event->partition);
+	xfree(event->nodes);
+	xfree(event->reason);
+	xfree(event);
+}
+
+static void _free_filter(event_sub_t *sub)
+{
+	int i;
+
+	for (i = 0; i < sub->part_cnt; i++)
+		xfree(sub->part_array[i]);
+	xfree(sub->part_array);
+	sub->part_cnt = 0;
+	xfree(sub->uid_array);
+	sub->uid_cnt = 0;
+}
+
+static void _del_sub(void *x)
+{
+	event_sub_t *sub = (event_sub_t *) x;
+
+	_free_filter(sub);
+	if (sub->event_list)
+		list_destroy(sub->event_list);
+	xfree(sub);
+	sub_cnt--;
+}
+
+static int _find_sub_id(void *x, void *key)
+{
+	event_sub_t *sub = (event_sub_t *) x;
+	uint32_t *sub_id = (uint32_t *) key;
+
+	return (sub->sub_id == *sub_id);
+}
+
+/* Set the filter of an empty subscription record from the request. On
+ * error the caller must still _free_filter() the record.
+ * RET 0 or a slurm error code */
+static int _set_filter(event_sub_t *sub, event_subscribe_msg_t *msg)
+{
+	char *tmp_str, *tok, *save_ptr = NULL;
+	uid_t uid;
+	int rc = SLURM_SUCCESS;
+
+	sub->event_mask = msg->event_mask;
+
+	if (msg->partitions && msg->partitions[0]) {
+		tmp_str = xstrdup(msg->partitions);
+		tok = strtok_r(tmp_str, ",", &save_ptr);
+		while (tok) {
+			xrealloc(sub->part_array,
+				 sizeof(char *) * (sub->part_cnt + 1));
+			sub->part_array[sub->part_cnt++] = xstrdup(tok);
+			tok = strtok_r(NULL, ",", &save_ptr);
+		}
+		xfree(tmp_str);
+	}
+
+	if (msg->users && msg->users[0]) {
+		tmp_str = xstrdup(msg->users);
+		tok = strtok_r(tmp_str, ",", &save_ptr);
+		while (tok) {
+			if (uid_from_string(tok, &uid) < 0) {
+				rc = ESLURM_USER_ID_MISSING;
+				break;
+			}
+			xrealloc(sub->uid_array,
+				 sizeof(uid_t) * (sub->uid_cnt + 1));
+			sub->uid_array[sub->uid_cnt++] = uid;
+			tok = strtok_r(NULL, ",", &save_ptr);
+		}
+		xfree(tmp_str);
+	}
+
+	return rc;
+}
+
+/*
+ * event_subscribe - add or renew a subscription
+ * IN uid - user making the request
+ * IN addr - address the request came from, events go to this host
+ * IN/OUT msg - subscription request, sub_id and lease set on return
+ * RET 0 or a slurm error code
+ */
+extern int event_subscribe(uid_t uid, slurm_addr_t *addr,
+			   event_subscribe_msg_t *msg)
+{
+	event_sub_t *sub, filter;
+	bool is_operator = validate_operator(uid);
+	time_t now = time(NULL);
+	int rc = SLURM_SUCCESS;
+
+	if ((msg->port == 0) || (msg->event_mask == 0))
+		return EINVAL;
+	if (msg->lease == 0)
+		msg->lease = EVENT_LEASE_DEFAULT;
+	else if (msg->lease > EVENT_LEASE_MAX)
+		msg->lease = EVENT_LEASE_MAX;
+
+	/* Check the filter before touching any subscription, so a bad
+	 * renewal leaves the existing one in place */
+	memset(&filter, 0, sizeof(event_sub_t));
+	rc = _set_filter(&filter, msg);
+	if (rc != SLURM_SUCCESS) {
+		_free_filter(&filter);
+		return rc;
+	}
+
+	slurm_mutex_lock(&event_mutex);
+	if (!sub_list)
+		sub_list = list_create(_del_sub);
+
+	if (msg->sub_id) {
+		sub = list_find_first(sub_list, _find_sub_id, &msg->sub_id);
+		if (!sub) {
+			_free_filter(&filter);
+			rc = ESRCH;
+			goto fini;
+		}
+		if ((sub->uid != uid) && !is_operator) {
+			_free_filter(&filter);
+			rc = ESLURM_ACCESS_DENIED;
+			goto fini;
+		}
+	} else {
+		if (sub_cnt >= EVENT_SUB_MAX) {
+			_free_filter(&filter);
+			rc = EAGAIN;
+			goto fini;
+		}
+		sub = xmalloc(sizeof(event_sub_t));
+		sub->sub_id = next_sub_id++;
+		if (next_sub_id == 0)
+			next_sub_id = 1;
+		sub->uid = uid;
+		sub->event_list = list_create(_del_event);
+		list_append(sub_list, sub);
+		sub_cnt++;
+	}
+
+	memcpy(&sub->addr, addr, sizeof(slurm_addr_t));
+	sub->addr.sin_port = htons(msg->port);
+	sub->is_operator = is_operator;
+	sub->own_jobs_only = !is_operator &&
+		(slurmctld_conf.private_data & PRIVATE_DATA_JOBS);
+	sub->no_nodes = !is_operator &&
+		(slurmctld_conf.private_data & PRIVATE_DATA_NODES);
+	sub->expire = now + msg->lease;
+	_free_filter(sub);
+	sub->event_mask = filter.event_mask;
+	sub->part_array = filter.part_array;
+	sub->part_cnt   = filter.part_cnt;
+	sub->uid_array  = filter.uid_array;
+	sub->uid_cnt    = filter.uid_cnt;
+	msg->sub_id = sub->sub_id;
+	debug("event subscription %u for uid %d, mask 0x%x, lease %u",
+	      sub->sub_id, (int) uid, sub->event_mask, msg->lease);
+
+	if (!event_thread) {
+		pthread_attr_t attr;
+
+		event_shutdown = false;
+		slurm_attr_init(&attr);
+		if (pthread_create(&event_thread, &attr, _event_agent, NULL)) {
+			error("pthread_create event agent: %m");
+			event_thread = 0;
+		}
+		slurm_attr_destroy(&attr);
+	}
+
+fini:	slurm_mutex_unlock(&event_mutex);
+	return rc;
+}
+
+/*
+ * event_unsubscribe - remove a subscription
+ * IN uid - user making the request
+ * IN msg - request identifying the subscription
+ * RET 0 or a slurm error code
+ */
+extern int event_unsubscribe(uid_t uid, event_subscribe_msg_t *msg)
+{
+	event_sub_t *sub;
+	int rc = SLURM_SUCCESS;
+
+	slurm_mutex_lock(&event_mutex);
+	if (!sub_list ||
+	    !(sub = list_find_first(sub_list, _find_sub_id, &msg->sub_id)))
+		rc = ESRCH;
+	else if ((sub->uid != uid) && !validate_operator(uid))
+		rc = ESLURM_ACCESS_DENIED;
+	else
+		list_delete_all(sub_list, _find_sub_id, &msg->sub_id);
+	slurm_mutex_unlock(&event_mutex);
+
+	return rc;
+}
+
+static bool _part_match(event_sub_t *sub, char *name)
+{
+	int i;
+
+	if (!name)
+		return false;
+	for (i = 0; i < sub->part_cnt; i++) {
+		if (!strcmp(sub->part_array[i], name))
+			return true;
+	}
+	return false;
+}
+
+/* Return true if a job would not be shown to the subscriber by squeue,
+ * see _job_visible() in job_mgr.c */
+static bool _job_hidden(event_sub_t *sub, struct job_record *job_ptr)
+{
+	struct part_record *part_ptr = job_ptr->part_ptr;
+
+	if (sub->is_operator)
+		return false;
+	if (part_ptr && (sub->uid != 0) &&
+	    ((part_ptr->flags & PART_FLAG_HIDDEN) ||
+	     (validate_group(part_ptr, sub->uid) == 0)))
+		return true;
+	if (sub->own_jobs_only && (sub->uid != job_ptr->user_id) &&
+	    !assoc_mgr_is_user_acct_coord(acct_db_conn, sub->uid,
+					  job_ptr->account))
+		return true;
+	return false;
+}
+
+/* Return true if a node would not be shown to the subscriber by sinfo,
+ * that is all of its partitions are hidden from the subscriber */
+static bool _node_hidden(event_sub_t *sub, struct node_record *node_ptr)
+{
+	struct part_record *part_ptr;
+	int i;
+
+	if (sub->is_operator)
+		return false;
+	if (sub->no_nodes)
+		return true;
+	if ((sub->uid == 0) || (node_ptr->part_cnt == 0))
+		return false;
+	for (i = 0; i < node_ptr->part_cnt; i++) {
+		part_ptr = node_ptr->part_pptr[i];
+		if (!(part_ptr->flags & PART_FLAG_HIDDEN) &&
+		    validate_group(part_ptr, sub->uid))
+			return false;
+	}
+	return true;
+}
+
+/* Append an event to a subscription's queue. Caller holds event_mutex */
+static void _queue_event(event_sub_t *sub, uint16_t event_type,
+			 uint32_t job_id, uint32_t user_id, uint16_t state,
+			 char *partition, char *nodes, char *reason)
+{
+	slurm_event_t *event;
+
+	if (list_count(sub->event_list) >= EVENT_QUEUE_MAX) {
+		sub->lost++;
+		return;
+	}
+	event = xmalloc(sizeof(slurm_event_t));
+	event->event_type = event_type;
+	event->event_time = time(NULL);
+	event->job_id     = job_id;
+	event->user_id    = user_id;
+	event->state      = state;
+	event->partition  = xstrdup(partition);
+	event->nodes      = xstrdup(nodes);
+	event->reason     = xstrdup(reason);
+	list_append(sub->event_list, event);
+}
+
+static void _job_event(uint16_t event_type, struct job_record *job_ptr)
+{
+	ListIterator iter;
+	event_sub_t *sub;
+	char *tmp_str, *tok, *save_ptr = NULL;
+	bool match;
+	int i;
+
+	if (sub_cnt == 0)
+		return;
+
+	slurm_mutex_lock(&event_mutex);
+	iter = list_iterator_create(sub_list);
+	while ((sub = (event_sub_t *) list_next(iter))) {
+		if (!(sub->event_mask & event_type))
+			continue;
+		if (_job_hidden(sub, job_ptr))
+			continue;
+		if (sub->uid_cnt) {
+			for (i = 0; i < sub->uid_cnt; i++) {
+				if (sub->uid_array[i] == job_ptr->user_id)
+					break;
+			}
+			if (i >= sub->uid_cnt)
+				continue;
+		}
+		if (sub->part_cnt) {
+			/* Pending jobs may list several partitions */
+			match = false;
+			tmp_str = xstrdup(job_ptr->partition);
+			tok = tmp_str ? strtok_r(tmp_str, ",", &save_ptr) : NULL;
+			while (tok && !match) {
+				match = _part_match(sub, tok);
+				tok = strtok_r(NULL, ",", &save_ptr);
+			}
+			xfree(tmp_str);
+			if (!match)
+				continue;
+		}
+		_queue_event(sub, event_type, job_ptr->job_id,
+			     job_ptr->user_id, job_ptr->job_state,
+			     job_ptr->partition, job_ptr->nodes, NULL);
+	}
+	list_iterator_destroy(iter);
+	slurm_mutex_unlock(&event_mutex);
+}
+
+static void _node_event(uint16_t event_type, struct node_record *node_ptr)
+{
+	ListIterator iter;
+	event_sub_t *sub;
+	int i;
+
+	if (sub_cnt == 0)
+		return;
+
+	slurm_mutex_lock(&event_mutex);
+	iter = list_iterator_create(sub_list);
+	while ((sub = (event_sub_t *) list_next(iter))) {
+		if (!(sub->event_mask & event_type) ||
+		    _node_hidden(sub, node_ptr))
+			continue;
+		if (sub->part_cnt) {
+			for (i = 0; i < node_ptr->part_cnt; i++) {
+				if (_part_match(sub,
+						node_ptr->part_pptr[i]->name))
+					break;
+			}
+			if (i >= node_ptr->part_cnt)
+				continue;
+		}
+		_queue_event(sub, event_type, 0, 0, node_ptr->node_state,
+			     NULL, node_ptr->name,
+			     (event_type == EVENT_NODE_UP) ?
+			     NULL : node_ptr->reason);
+	}
+	list_iterator_destroy(iter);
+	slurm_mutex_unlock(&event_mutex);
+}
+
+extern void event_job_submit(struct job_record *job_ptr)
+{
+	_job_event(EVENT_JOB_SUBMIT, job_ptr);
+}
+
+extern void event_job_start(struct job_record *job_ptr)
+{
+	_job_event(EVENT_JOB_START, job_ptr);
+}
+
+extern void event_job_fini(struct job_record *job_ptr)
+{
+	_job_event(EVENT_JOB_FINI, job_ptr);
+}
+
+extern void event_node_down(struct node_record *node_ptr)
+{
+	_node_event(EVENT_NODE_DOWN, node_ptr);
+}
+
+extern void event_node_drained(struct node_record *node_ptr)
+{
+	_node_event(EVENT_NODE_DRAINED, node_ptr);
+}
+
+extern void event_node_up(struct node_record *node_ptr)
+{
+	_node_event(EVENT_NODE_UP, node_ptr);
+}
+
+/* Thread to send one subscriber its events, dropping the subscription on
+ * failure so the client learns at its next renewal that it missed events */
+static void *_send_events(void *args)
+{
+	event_send_t *send = (event_send_t *) args;
+	event_sub_t *sub;
+	slurm_msg_t msg;
+	int rc;
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = MESSAGE_EVENT_NOTIFY;
+	msg.address  = send->addr;
+	msg.data     = send->msg;
+	rc = slurm_send_only_node_msg_timeout(&msg, EVENT_SEND_TIMEOUT);
+	if (rc != SLURM_SUCCESS) {
+		info("event subscription %u: can not send events: %m",
+		     send->sub_id);
+	}
+
+	slurm_mutex_lock(&event_mutex);
+	if (sub_list) {
+		if (rc != SLURM_SUCCESS) {
+			list_delete_all(sub_list, _find_sub_id,
+					&send->sub_id);
+		} else if ((sub = list_find_first(sub_list, _find_sub_id,
+						  &send->sub_id))) {
+			sub->sending = false;
+		}
+	}
+	send_thread_cnt--;
+	pthread_cond_broadcast(&event_cond);
+	slurm_mutex_unlock(&event_mutex);
+
+	slurm_free_event_notify_msg(send->msg);
+	xfree(send);
+	return NULL;
+}
+
+/* Collect each subscription's pending events about once a second and send
+ * them in threads of their own outside of event_mutex, so a slow client
+ * never delays the hooks or the other clients. A client whose previous
+ * message is still being sent keeps its events queued for the next pass. */
+static void *_event_agent(void *args)
+{
+	ListIterator iter;
+	event_sub_t *sub;
+	event_send_t *send;
+	slurm_event_t *event;
+	List send_list;
+	pthread_attr_t attr;
+	pthread_t thread_id;
+	struct timespec ts = {0, 0};
+	time_t now;
+	int i;
+
+	send_list = list_create(NULL);
+	slurm_attr_init(&attr);
+	if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED))
+		error("pthread_attr_setdetachstate error %m");
+	while (1) {
+		slurm_mutex_lock(&event_mutex);
+		if (!event_shutdown) {
+			ts.tv_sec = time(NULL) + 1;
+			pthread_cond_timedwait(&event_cond, &event_mutex, &ts);
+		}
+		if (event_shutdown) {
+			slurm_mutex_unlock(&event_mutex);
+			break;
+		}
+
+		now = time(NULL);
+		iter = list_iterator_create(sub_list);
+		while ((sub = (event_sub_t *) list_next(iter))) {
+			if (sub->expire <= now) {
+				debug("event subscription %u expired",
+				      sub->sub_id);
+				list_delete_item(iter);
+				continue;
+			}
+			if (sub->sending)
+				continue;
+			i = list_count(sub->event_list);
+			if ((i == 0) && (sub->lost == 0))
+				continue;
+			if (send_thread_cnt >= EVENT_SEND_THREADS)
+				break;
+			send = xmalloc(sizeof(event_send_t));
+			send->sub_id = sub->sub_id;
+			send->addr   = sub->addr;
+			send->msg    = xmalloc(sizeof(event_notify_msg_t));
+			send->msg->sub_id = sub->sub_id;
+			send->msg->lost   = sub->lost;
+			send->msg->event_array =
+				xmalloc(sizeof(slurm_event_t) * i);
+			while ((event = list_pop(sub->event_list))) {
+				memcpy(&send->msg->event_array[
+					       send->msg->event_cnt++],
+				       event, sizeof(slurm_event_t));
+				xfree(event);	/* strings moved */
+			}
+			sub->lost = 0;
+			sub->sending = true;
+			send_thread_cnt++;
+			list_append(send_list, send);
+		}
+		list_iterator_destroy(iter);
+		slurm_mutex_unlock(&event_mutex);
+
+		while ((send = list_pop(send_list))) {
+			if (pthread_create(&thread_id, &attr, _send_events,
+					   send)) {
+				error("pthread_create event send: %m");
+				_send_events(send);
+			}
+		}
+	}
+	slurm_attr_destroy(&attr);
+	list_destroy(send_list);
+
+	return NULL;
+}
+
+/* Stop the event agent thread and free all allocated memory */
+extern void event_fini(void)
+{
+	pthread_t thread;
+
+	slurm_mutex_lock(&event_mutex);
+	thread = event_thread;
+	event_shutdown = true;
+	pthread_cond_broadcast(&event_cond);
+	slurm_mutex_unlock(&event_mutex);
+
+	if (thread)
+		pthread_join(thread, NULL);
+
+	slurm_mutex_lock(&event_mutex);
+	while (send_thread_cnt > 0)
+		pthread_cond_wait(&event_cond, &event_mutex);
+	event_thread = 0;
+	if (sub_list) {
+		list_destroy(sub_list);
+		sub_list = NULL;
+	}
+	slurm_mutex_unlock(&event_mutex);
+}
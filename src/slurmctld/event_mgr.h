@@ -0,0 +1,62 @@
+/*****************************************************************************\
+ *  event_mgr.h - header to push job and node events to subscribed clients
+ *****************************************************************************
+ *  Copyright (C) 2014 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_EVENT_MGR_H
+#define _HAVE_EVENT_MGR_H
+
+#include <unistd.h>
+#include <sys/types.h>
+#include "src/common/slurm_protocol_defs.h"
+#include "src/slurmctld/slurmctld.h"
+
+/* User RPC processing to add, renew and remove subscriptions.
+ * event_subscribe() sets msg->sub_id and msg->lease on success */
+extern int event_subscribe(uid_t uid, slurm_addr_t *addr,
+			   event_subscribe_msg_t *msg);
+extern int event_unsubscribe(uid_t uid, event_subscribe_msg_t *msg);
+
+/* Note that some event has occurred and queue it for subscribers.
+ * These return at once if there are no subscriptions. */
+extern void event_job_submit(struct job_record *job_ptr);
+extern void event_job_start(struct job_record *job_ptr);
+extern void event_job_fini(struct job_record *job_ptr);
+extern void event_node_down(struct node_record *node_ptr);
+extern void event_node_drained(struct node_record *node_ptr);
+extern void event_node_up(struct node_record *node_ptr);
+
+/* Stop the event agent thread and free all allocated memory */
+extern void event_fini(void);
+
+#endif /* !_HAVE_EVENT_MGR_H */
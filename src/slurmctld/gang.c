@@ -56,6 +56,7 @@
 #include "src/common/list.h"
 #include "src/common/node_select.h"
 #include "src/common/slurm_protocol_defs.h"
+#include "src/common/timers.h"
 #include "src/common/xstring.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/preempt.h"
@@ -94,6 +95,7 @@ struct gs_job {
 	struct job_record *job_ptr;
 	uint16_t sig_state;
 	uint16_t row_state;
+	struct gs_job *job_next;	/* next job in the partition's hash */
 };
 
 struct gs_part {
@@ -102,11 +104,14 @@ struct gs_part {
 	uint32_t num_jobs;
 	struct gs_job **job_list;
 	uint32_t job_list_size;
+	struct gs_job **job_hash;	/* job_list indexed by job_id */
 	uint32_t num_shadows;
 	struct gs_job **shadow;  /* see '"Shadow" Design' below */
 	uint32_t shadow_size;
 	uint32_t jobs_active;
 	bitstr_t *active_resmap;
+	bitstr_t *active_nodes;	/* nodes used by the active row, for
+				 * GS_CORE, GS_CPU2 and GS_SOCKET */
 	uint16_t *active_cpus;
 	uint16_t array_size;
 	struct gs_part *next;
@@ -154,6 +159,7 @@ static uint16_t gr_type = GS_NODE;
 static uint16_t gs_fast_schedule = 0;
 static List gs_part_list = NULL;
 static uint32_t default_job_list_size = 64;
+#define GS_JOB_HASH_INX(_p_ptr, _job_id) ((_job_id) % (_p_ptr)->job_list_size)
 static pthread_mutex_t data_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static uint16_t *gs_bits_per_node = NULL;
@@ -312,8 +318,10 @@ static void _destroy_parts(void *x)
 		xfree(gs_part_ptr->job_list[i]);
 	xfree(gs_part_ptr->shadow);
 	FREE_NULL_BITMAP(gs_part_ptr->active_resmap);
+	FREE_NULL_BITMAP(gs_part_ptr->active_nodes);
 	xfree(gs_part_ptr->active_cpus);
 	xfree(gs_part_ptr->job_list);
+	xfree(gs_part_ptr->job_hash);
 	xfree(gs_part_ptr);
 }
 
@@ -361,15 +369,57 @@ static int _find_gs_part(void *x, void *key)
 	return 0;
 }
 
-/* Find the job_list index of the given job_id in the given partition */
-static int _find_job_index(struct gs_part *p_ptr, uint32_t job_id)
+/* Find the gs_job record of the given job_id in the given partition */
+static struct gs_job *_find_job(struct gs_part *p_ptr, uint32_t job_id)
 {
-	int i;
-	for (i = 0; i < p_ptr->num_jobs; i++) {
-		if (p_ptr->job_list[i]->job_ptr->job_id == job_id)
-			return i;
+	struct gs_job *j_ptr;
+
+	if (!p_ptr->job_hash)
+		return NULL;
+	j_ptr = p_ptr->job_hash[GS_JOB_HASH_INX(p_ptr, job_id)];
+	while (j_ptr) {
+		if (j_ptr->job_id == job_id)
+			return j_ptr;
+		j_ptr = j_ptr->job_next;
+	}
+	return NULL;
+}
+
+/* Add the given job to its partition's job_hash */
+static void _add_job_hash(struct gs_part *p_ptr, struct gs_job *j_ptr)
+{
+	int inx = GS_JOB_HASH_INX(p_ptr, j_ptr->job_id);
+
+	j_ptr->job_next = p_ptr->job_hash[inx];
+	p_ptr->job_hash[inx] = j_ptr;
+}
+
+/* Remove the given job from its partition's job_hash */
+static void _remove_job_hash(struct gs_part *p_ptr, struct gs_job *j_ptr)
+{
+	struct gs_job **j_pptr;
+
+	j_pptr = &p_ptr->job_hash[GS_JOB_HASH_INX(p_ptr, j_ptr->job_id)];
+	while (*j_pptr) {
+		if (*j_pptr == j_ptr) {
+			*j_pptr = j_ptr->job_next;
+			break;
+		}
+		j_pptr = &(*j_pptr)->job_next;
 	}
-	return -1;
+	j_ptr->job_next = NULL;
+}
+
+/* Rebuild the job_hash after the job_list has been resized */
+static void _rebuild_job_hash(struct gs_part *p_ptr)
+{
+	int i;
+
+	xfree(p_ptr->job_hash);
+	p_ptr->job_hash = xmalloc(p_ptr->job_list_size *
+				  sizeof(struct gs_job *));
+	for (i = 0; i < p_ptr->num_jobs; i++)
+		_add_job_hash(p_ptr, p_ptr->job_list[i]);
 }
 
 /* Return 1 if job "cpu count" fits in this row, else return 0 */
@@ -406,25 +456,25 @@ static int _job_fits_in_active_row(struct job_record *job_ptr,
 {
 	job_resources_t *job_res = job_ptr->job_resrcs;
 	int count;
-	bitstr_t *job_map;
 
 	if ((p_ptr->active_resmap == NULL) || (p_ptr->jobs_active == 0))
 		return 1;
 
 	if ((gr_type == GS_CPU2) || (gr_type == GS_CORE) ||
 	    (gr_type == GS_SOCKET)) {
+		/* no need to test the cores of nodes the row does not use */
+		if (p_ptr->active_nodes &&
+		    !bit_overlap(job_res->node_bitmap, p_ptr->active_nodes))
+			return 1;
 		return job_fits_into_cores(job_res, p_ptr->active_resmap,
 					   gs_bits_per_node);
 	}
 
 	/* gr_type == GS_NODE || gr_type == GS_CPU */
-	job_map = bit_copy(job_res->node_bitmap);
-	bit_and(job_map, p_ptr->active_resmap);
-	/* any set bits indicate contention for the same resource */
-	count = bit_set_count(job_map);
+	/* any overlapping bits indicate contention for the same resource */
+	count = bit_overlap(job_res->node_bitmap, p_ptr->active_resmap);
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG)
 		info("gang: _job_fits_in_active_row: %d bits conflict", count);
-	FREE_NULL_BITMAP(job_map);
 	if (count == 0)
 		return 1;
 	if (gr_type == GS_CPU) {
@@ -494,6 +544,12 @@ static void _add_job_to_active(struct job_record *job_ptr,
 		}
 		add_job_to_cores(job_res, &(p_ptr->active_resmap),
 				 gs_bits_per_node);
+		if (!p_ptr->active_nodes)
+			p_ptr->active_nodes = bit_copy(job_res->node_bitmap);
+		else if (p_ptr->jobs_active == 0)
+			bit_copybits(p_ptr->active_nodes, job_res->node_bitmap);
+		else
+			bit_or(p_ptr->active_nodes, job_res->node_bitmap);
 		if (gr_type == GS_SOCKET)
 			_fill_sockets(job_res->node_bitmap, p_ptr);
 	} else { /* GS_NODE or GS_CPU */
@@ -886,6 +942,27 @@ static void _update_all_active_rows(void)
 	list_iterator_destroy(part_iterator);
 }
 
+/* rebuild only the active rows that a change to the given partition can
+ * affect: its own row if "self" is set, and the rows of lower priority
+ * partitions, which hold the shadows of its jobs */
+static void _update_part_active_rows(struct gs_part *chg_p_ptr, bool self)
+{
+	ListIterator part_iterator;
+	struct gs_part *p_ptr;
+
+	list_sort(gs_part_list, _sort_partitions);
+
+	part_iterator = list_iterator_create(gs_part_list);
+	while ((p_ptr = (struct gs_part *) list_next(part_iterator))) {
+		if (p_ptr == chg_p_ptr) {
+			if (self)
+				_update_active_row(p_ptr, 1);
+		} else if (p_ptr->priority < chg_p_ptr->priority)
+			_update_active_row(p_ptr, 1);
+	}
+	list_iterator_destroy(part_iterator);
+}
+
 /* remove the given job from the given partition
  * IN job_id - job to remove
  * IN p_ptr  - GS partition structure
@@ -901,19 +978,23 @@ static void _remove_job_from_part(uint32_t job_id, struct gs_part *p_ptr,
 		return;
 
 	/* find the job in the job_list */
-	i = _find_job_index(p_ptr, job_id);
-	if (i < 0)
+	j_ptr = _find_job(p_ptr, job_id);
+	if (!j_ptr)
 		/* job not found */
 		return;
+	for (i = 0; i < p_ptr->num_jobs; i++) {
+		if (p_ptr->job_list[i] == j_ptr)
+			break;
+	}
 
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG) {
 		info("gang: _remove_job_from_part: removing job %u from %s",
 		     job_id, p_ptr->part_name);
 	}
-	j_ptr = p_ptr->job_list[i];
 
 	/* remove any shadow first */
 	_clear_shadow(j_ptr);
+	_remove_job_hash(p_ptr, j_ptr);
 
 	/* remove the job from the job_list by shifting everyone else down */
 	p_ptr->num_jobs--;
@@ -943,7 +1024,6 @@ static void _remove_job_from_part(uint32_t job_id, struct gs_part *p_ptr,
 static uint16_t _add_job_to_part(struct gs_part *p_ptr,
 				 struct job_record *job_ptr)
 {
-	int i;
 	struct gs_job *j_ptr;
 
 	xassert(p_ptr);
@@ -963,11 +1043,11 @@ static uint16_t _add_job_to_part(struct gs_part *p_ptr,
 		p_ptr->job_list = xmalloc(p_ptr->job_list_size *
 					  sizeof(struct gs_job *));
 		/* job_list is initialized to be NULL filled */
+		_rebuild_job_hash(p_ptr);
 	}
 
 	/* protect against duplicates */
-	i = _find_job_index(p_ptr, job_ptr->job_id);
-	if (i >= 0) {
+	if (_find_job(p_ptr, job_ptr->job_id)) {
 		/* This job already exists, but the resource allocation
 		 * may have changed. In any case, remove the existing
 		 * job before adding this new one.
@@ -986,6 +1066,7 @@ static uint16_t _add_job_to_part(struct gs_part *p_ptr,
 		xrealloc(p_ptr->job_list, p_ptr->job_list_size *
 			 sizeof(struct gs_job *));
 		/* enlarged job_list is initialized to be NULL filled */
+		_rebuild_job_hash(p_ptr);
 	}
 	j_ptr = xmalloc(sizeof(struct gs_job));
 
@@ -997,6 +1078,7 @@ static uint16_t _add_job_to_part(struct gs_part *p_ptr,
 
 	/* append this job to the job_list */
 	p_ptr->job_list[p_ptr->num_jobs++] = j_ptr;
+	_add_job_hash(p_ptr, j_ptr);
 
 	/* determine the immediate fate of this job (run or suspend) */
 	if (_job_fits_in_active_row(job_ptr, p_ptr)) {
@@ -1041,7 +1123,6 @@ static void _scan_slurm_job_list(void)
 {
 	struct job_record *job_ptr;
 	struct gs_part *p_ptr;
-	int i;
 	ListIterator job_iterator;
 
 	if (!job_list) {	/* no jobs */
@@ -1068,9 +1149,8 @@ static void _scan_slurm_job_list(void)
 						job_ptr->partition);
 			if (!p_ptr) /* no partition */
 				continue;
-			i = _find_job_index(p_ptr, job_ptr->job_id);
-			if (i >= 0) /* we're tracking it, so continue */
-				continue;
+			if (_find_job(p_ptr, job_ptr->job_id))
+				continue;	/* we're tracking it */
 
 			/* We're not tracking this job. Resume it if it's
 			 * suspended, and then add it to the job list. */
@@ -1216,6 +1296,7 @@ extern int gs_job_start(struct job_record *job_ptr)
 {
 	struct gs_part *p_ptr;
 	uint16_t job_state;
+	bool dup_job;
 
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG)
 		info("gang: entering gs_job_start for job %u", job_ptr->job_id);
@@ -1224,10 +1305,13 @@ extern int gs_job_start(struct job_record *job_ptr)
 	p_ptr = list_find_first(gs_part_list, _find_gs_part,
 				job_ptr->partition);
 	if (p_ptr) {
+		dup_job = (_find_job(p_ptr, job_ptr->job_id) != NULL);
 		job_state = _add_job_to_part(p_ptr, job_ptr);
-		/* if this job is running then check for preemption */
+		/* if this job is running then check for preemption. The job
+		 * was already added to its own row, which only needs to be
+		 * rebuilt if a previous copy of the job was removed */
 		if (job_state == GS_RESUME)
-			_update_all_active_rows();
+			_update_part_active_rows(p_ptr, dup_job);
 	}
 	pthread_mutex_unlock(&data_mutex);
 
@@ -1287,6 +1371,8 @@ extern void gs_wake_jobs(void)
 extern int gs_job_fini(struct job_record *job_ptr)
 {
 	struct gs_part *p_ptr;
+	struct gs_job *j_ptr;
+	bool in_row;
 
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG)
 		info("gang: entering gs_job_fini for job %u", job_ptr->job_id);
@@ -1301,10 +1387,16 @@ extern int gs_job_fini(struct job_record *job_ptr)
 	}
 
 	/* remove job from the partition */
-	_remove_job_from_part(job_ptr->job_id, p_ptr, true);
-	/* this job may have preempted other jobs, so
-	 * check by updating all active rows */
-	_update_all_active_rows();
+	j_ptr = _find_job(p_ptr, job_ptr->job_id);
+	if (j_ptr) {
+		/* a job outside of the active row holds no resources */
+		in_row = (j_ptr->row_state != GS_NO_ACTIVE);
+		_remove_job_from_part(job_ptr->job_id, p_ptr, true);
+		/* this job may have preempted other jobs, so check by
+		 * updating the active rows it was part of or shadowed */
+		if (in_row)
+			_update_part_active_rows(p_ptr, true);
+	}
 	pthread_mutex_unlock(&data_mutex);
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG)
 		info("gang: leaving gs_job_fini");
@@ -1484,26 +1576,25 @@ static void _build_active_row(struct gs_part *p_ptr)
  */
 static void _cycle_job_list(struct gs_part *p_ptr)
 {
-	int i, j;
-	struct gs_job *j_ptr;
+	int i, j, k;
+	struct gs_job *j_ptr, **active_list;
 
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG)
 		info("gang: entering _cycle_job_list");
-	/* re-prioritize the job_list and set all row_states to GS_NO_ACTIVE */
-	for (i = 0; i < p_ptr->num_jobs; i++) {
-		while (p_ptr->job_list[i]->row_state == GS_ACTIVE) {
-			/* move this job to the back row and "deactivate" it */
-			j_ptr = p_ptr->job_list[i];
-			j_ptr->row_state = GS_NO_ACTIVE;
-			for (j = i; j+1 < p_ptr->num_jobs; j++) {
-				p_ptr->job_list[j] = p_ptr->job_list[j+1];
-			}
-			p_ptr->job_list[j] = j_ptr;
-		}
-		if (p_ptr->job_list[i]->row_state == GS_FILLER)
-			p_ptr->job_list[i]->row_state = GS_NO_ACTIVE;
-
+	/* re-prioritize the job_list and set all row_states to GS_NO_ACTIVE:
+	 * move the active jobs to the back of the list in one pass,
+	 * preserving their order among each other */
+	active_list = xmalloc(p_ptr->num_jobs * sizeof(struct gs_job *));
+	for (i = 0, j = 0, k = 0; i < p_ptr->num_jobs; i++) {
+		j_ptr = p_ptr->job_list[i];
+		if (j_ptr->row_state == GS_ACTIVE)
+			active_list[k++] = j_ptr;
+		else
+			p_ptr->job_list[j++] = j_ptr;
+		j_ptr->row_state = GS_NO_ACTIVE;
 	}
+	memcpy(p_ptr->job_list + j, active_list, k * sizeof(struct gs_job *));
+	xfree(active_list);
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG)
 		info("gang: _cycle_job_list reordered job list:");
 	/* Rebuild the active row. */
@@ -1550,6 +1641,16 @@ static void _cycle_job_list(struct gs_part *p_ptr)
 		info("gang: leaving _cycle_job_list");
 }
 
+static void _do_diag_stats(long delta_t)
+{
+	if (delta_t > slurmctld_diag_stats.gang_cycle_max)
+		slurmctld_diag_stats.gang_cycle_max = delta_t;
+
+	slurmctld_diag_stats.gang_cycle_sum += delta_t;
+	slurmctld_diag_stats.gang_cycle_last = delta_t;
+	slurmctld_diag_stats.gang_cycle_counter++;
+}
+
 static void _slice_sleep(void)
 {
 	struct timespec ts = {0, 0};
@@ -1569,6 +1670,7 @@ static void *_timeslicer_thread(void *arg)
 		NO_LOCK, WRITE_LOCK, READ_LOCK, NO_LOCK };
 	ListIterator part_iterator;
 	struct gs_part *p_ptr;
+	DEF_TIMERS;
 
 	if (slurmctld_conf.debug_flags & DEBUG_FLAG_GANG)
 		info("gang: starting timeslicer loop");
@@ -1578,6 +1680,7 @@ static void *_timeslicer_thread(void *arg)
 			break;
 
 		lock_slurmctld(job_write_lock);
+		START_TIMER;
 		pthread_mutex_lock(&data_mutex);
 		list_sort(gs_part_list, _sort_partitions);
 
@@ -1601,6 +1704,8 @@ static void *_timeslicer_thread(void *arg)
 
 		/* Preempt jobs that were formerly only suspended */
 		_preempt_job_dequeue();	/* MUST BE OUTSIDE data_mutex lock */
+		END_TIMER2("_timeslicer_thread");
+		_do_diag_stats(DELTA_TIMER);
 		unlock_slurmctld(job_write_lock);
 	}
 
@@ -81,6 +81,7 @@
 
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/event_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/job_submit.h"
@@ -104,6 +105,9 @@
 
 #define JOB_HASH_INX(_job_id)	(_job_id % hash_table_size)
 
+#define JOB_CHANGE_SEQ_MAX	0xfff00000	/* start a new epoch beyond */
+#define PURGED_JOB_CNT		10000	/* purged job IDs remembered */
+
 /* Change JOB_STATE_VERSION value when changing the state save format */
 #define JOB_STATE_VERSION       "VER015"
 #define JOB_14_03_STATE_VERSION "VER015"	/* SLURM version 14.03 */
@@ -129,6 +133,22 @@ static bool     wiki_sched = false;
 static bool     wiki2_sched = false;
 static bool     wiki_sched_test = false;
 
+/* Job change tracking for pack_jobs_delta(), see _scan_job_changes() */
+typedef struct purged_job {
+	uint32_t job_id;
+	uint32_t change_seq;	/* job_change_seq when purged */
+} purged_job_t;
+static pthread_mutex_t job_change_mutex = PTHREAD_MUTEX_INITIALIZER;
+static Buf      job_change_buf = NULL;	/* scratch buffer for digests */
+static time_t   job_change_epoch = 0;	/* when job_change_seq started */
+static uint32_t job_change_seq = 0;	/* last change_seq assigned */
+static time_t   job_change_time = 0;	/* time of last scan */
+static purged_job_t purged_jobs[PURGED_JOB_CNT];	/* ring buffer */
+static int      purged_job_cnt = 0;
+static int      purged_job_next = 0;
+static uint32_t purged_job_floor = 0;	/* change_seq of the newest purge
+					 * dropped from purged_jobs */
+
 /* Local functions */
 static void _add_job_hash(struct job_record *job_ptr);
 static int  _checkpoint_job_record (struct job_record *job_ptr,
@@ -154,6 +174,8 @@ static void _dump_job_state(struct job_record *dump_job_ptr, Buf buffer);
 static int  _find_batch_dir(void *x, void *key);
 static void _get_batch_job_dir_ids(List batch_dirs);
 static void _job_timed_out(struct job_record *job_ptr);
+static bool _job_visible(struct job_record *job_ptr, uint16_t show_flags,
+			 uid_t uid, time_t min_age);
 static int  _job_create(job_desc_msg_t * job_specs, int allocate, int will_run,
 			struct job_record **job_rec_ptr, uid_t submit_uid,
 			char **err_msg);
@@ -174,6 +196,7 @@ static void _pack_default_job_details(struct job_record *job_ptr,
 static void _pack_pending_job_details(struct job_details *detail_ptr,
 				      Buf buffer,
 				      uint16_t protocol_version);
+static void _note_purged_job(uint32_t job_id);
 static int  _purge_job_record(uint32_t job_id);
 static void _purge_missing_jobs(int node_inx, time_t now);
 static void _read_data_array_from_file(char *file_name, char ***data,
@@ -182,10 +205,12 @@ static void _read_data_array_from_file(char *file_name, char ***data,
 static void _read_data_from_file(char *file_name, char **data);
 static char *_read_job_ckpt_file(char *ckpt_file, int *size_ptr);
 static void _remove_defunct_batch_dirs(List batch_dirs);
+static void _reset_job_changes(void);
 static int  _reset_detail_bitmaps(struct job_record *job_ptr);
 static void _reset_step_bitmaps(struct job_record *job_ptr);
 static int  _resume_job_nodes(struct job_record *job_ptr, bool indf_susp);
 static void _send_job_kill(struct job_record *job_ptr);
+static void _scan_job_changes(void);
 static int  _set_job_id(struct job_record *job_ptr);
 static void _signal_batch_job(struct job_record *job_ptr, uint16_t signal);
 static void _signal_job(struct job_record *job_ptr, int signal);
@@ -2644,6 +2669,7 @@ extern void excise_node_from_job(struct job_record *job_ptr,
 
 	orig_bitmap = bit_copy(job_ptr->node_bitmap);
 	make_node_idle(node_ptr, job_ptr); /* updates bitmap */
+	node_alloc_gen++;
 	xfree(job_ptr->nodes);
 	job_ptr->nodes = bitmap2node_name(job_ptr->node_bitmap);
 	for (i=bit_ffs(orig_bitmap); i<node_record_count; i++) {
@@ -2936,6 +2962,8 @@ struct job_record *_job_rec_copy(struct job_record *job_ptr)
 	job_ptr_new->details  = save_details;
 	job_ptr_new->prio_factors = save_prio_factors;
 	job_ptr_new->step_list = save_step_list;
+	job_ptr_new->change_seq = 0;
+	job_ptr_new->pack_digest = 0;
 
 	job_ptr_new->account = xstrdup(job_ptr->account);
 	job_ptr_new->alias_list = xstrdup(job_ptr->alias_list);
@@ -3181,6 +3209,8 @@ extern int job_allocate(job_desc_msg_t * job_specs, int immediate,
 		return error_code;
 	}
 	xassert(job_ptr);
+	if (!will_run)
+		event_job_submit(job_ptr);
 	if (job_specs->array_bitmap)
 		independent = false;
 	else
@@ -5932,6 +5962,10 @@ static void _list_delete_job(void *job_entry)
 	xassert (job_ptr->magic == JOB_MAGIC);
 	job_ptr->magic = 0;	/* make sure we don't delete record twice */
 
+	/* A delta client may hold a copy of the job */
+	if (job_ptr->change_seq)
+		_note_purged_job(job_ptr->job_id);
+
 	/* Remove the record from the hash table */
 	job_pptr = &job_hash[JOB_HASH_INX(job_ptr->job_id)];
 	while ((job_pptr != NULL) &&
@@ -6070,6 +6104,27 @@ static bool _hide_job(struct job_record *job_ptr, uid_t uid)
 	return false;
 }
 
+/* Determine if a job should be dumped for a specific user, see _hide_job().
+ * Part_filter_set() must have been called for the user.
+ * min_age - end time before which finished jobs are left for purging */
+static bool _job_visible(struct job_record *job_ptr, uint16_t show_flags,
+			 uid_t uid, time_t min_age)
+{
+	if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
+	    (job_ptr->part_ptr) &&
+	    (job_ptr->part_ptr->flags & PART_FLAG_HIDDEN))
+		return false;
+
+	if (_hide_job(job_ptr, uid))
+		return false;
+
+	if ((min_age > 0) && (job_ptr->end_time < min_age) &&
+	    (! IS_JOB_COMPLETING(job_ptr)) && IS_JOB_FINISHED(job_ptr))
+		return false;	/* job ready for purging, don't dump */
+
+	return true;
+}
+
 /*
  * pack_all_jobs - dump all job information for all jobs in
  *	machine independent form (for network transmission)
@@ -6092,11 +6147,17 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	uint32_t jobs_packed = 0, tmp_offset;
 	Buf buffer;
 	time_t min_age = 0, now = time(NULL);
+	static uint32_t job_pack_size = 0;	/* average size of a packed job */
+	uint64_t size_hint;
 
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	buffer = init_buf(BUF_SIZE);
+	/* Size the buffer for all jobs at the size they averaged in the
+	 * previous dump, so that it need not grow as they are packed */
+	size_hint = (uint64_t) list_count(job_list) * job_pack_size;
+	size_hint = MIN(size_hint, MAX_BUF_SIZE / 2);
+	buffer = init_buf(MAX(BUF_SIZE, (int) size_hint));
 
 	/* write message body header : size and time */
 	/* put in a place holder job record count of 0 for now */
@@ -6112,27 +6173,214 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
 		xassert (job_ptr->magic == JOB_MAGIC);
 
-		if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
-		    (job_ptr->part_ptr) &&
-		    (job_ptr->part_ptr->flags & PART_FLAG_HIDDEN))
+		if (!_job_visible(job_ptr, show_flags, uid, min_age))
 			continue;
 
-		if (_hide_job(job_ptr, uid))
+		if ((filter_uid != NO_VAL) && (filter_uid != job_ptr->user_id))
 			continue;
 
-		if ((min_age > 0) && (job_ptr->end_time < min_age) &&
-		    (! IS_JOB_COMPLETING(job_ptr)) && IS_JOB_FINISHED(job_ptr))
-			continue;	/* job ready for purging, don't dump */
+		pack_job(job_ptr, show_flags, buffer, protocol_version, uid);
+		jobs_packed++;
+	}
+	part_filter_clear();
+	list_iterator_destroy(job_iterator);
 
-		if ((filter_uid != NO_VAL) && (filter_uid != job_ptr->user_id))
+	/* put the real record count in the message body header */
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack32(jobs_packed, buffer);
+	set_buf_offset(buffer, tmp_offset);
+	if (jobs_packed)
+		job_pack_size = tmp_offset / jobs_packed + 1;
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
+/* Remember the ID of a purged job for delta clients, dropping the oldest
+ * once PURGED_JOB_CNT are held. Clients older than that get every job.
+ * NOTE: Caller must hold a job write lock */
+static void _note_purged_job(uint32_t job_id)
+{
+	purged_job_t *purged = &purged_jobs[purged_job_next];
+
+	if (purged_job_cnt == PURGED_JOB_CNT)
+		purged_job_floor = purged->change_seq;
+	else
+		purged_job_cnt++;
+	purged->job_id = job_id;
+	purged->change_seq = ++job_change_seq;
+	purged_job_next = (purged_job_next + 1) % PURGED_JOB_CNT;
+}
+
+/* Start a new job change epoch, forcing every delta client to reload all
+ * jobs. Done at startup and before job_change_seq can wrap.
+ * NOTE: Caller must hold job_change_mutex and a job read lock */
+static void _reset_job_changes(void)
+{
+	ListIterator job_iterator;
+	struct job_record *job_ptr;
+
+	job_change_epoch = MAX(time(NULL), job_change_epoch + 1);
+	job_change_seq = 0;
+	purged_job_cnt = 0;
+	purged_job_next = 0;
+	purged_job_floor = 0;
+
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = (struct job_record *) list_next(job_iterator)))
+		job_ptr->change_seq = 0;
+	list_iterator_destroy(job_iterator);
+}
+
+/* Give a new change_seq to every job which packs differently than when last
+ * scanned. Digesting the packed record catches every change a client could
+ * see, wherever in slurmctld the job was modified. Jobs are only rescanned
+ * after last_job_update moves, so the cost is shared by all delta clients.
+ * NOTE: Caller must hold job_change_mutex and a job read lock */
+static void _scan_job_changes(void)
+{
+	ListIterator job_iterator;
+	struct job_record *job_ptr;
+	uint64_t digest;
+
+	/* Allow for updates time stamped just before the last scan */
+	if (job_change_epoch && (last_job_update < job_change_time - 1))
+		return;
+	job_change_time = time(NULL);
+
+	if ((job_change_epoch == 0) || (job_change_seq > JOB_CHANGE_SEQ_MAX))
+		_reset_job_changes();
+	if (job_change_buf == NULL)
+		job_change_buf = init_buf(BUF_SIZE);
+
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+		set_buf_offset(job_change_buf, 0);
+		pack_job(job_ptr, SHOW_ALL | SHOW_DETAIL, job_change_buf,
+			 SLURM_PROTOCOL_VERSION, 0);
+		digest = get_buf_digest(job_change_buf, 0);
+		if (job_ptr->change_seq && (job_ptr->pack_digest == digest))
 			continue;
+		job_ptr->pack_digest = digest;
+		job_ptr->change_seq = ++job_change_seq;
+	}
+	list_iterator_destroy(job_iterator);
+}
 
-		pack_job(job_ptr, show_flags, buffer, protocol_version, uid);
+/*
+ * pack_jobs_delta - dump the jobs which changed since a client loaded its
+ *	copy of the job table, or every job if that cannot be determined
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN req - the client's request, describing its copy of the job table
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * RET SLURM_SUCCESS, SLURM_PROTOCOL_VERSION_ERROR or SLURM_NO_CHANGE_IN_DATA
+ *	if no job the client can see has changed; no buffer is returned
+ *	unless SLURM_SUCCESS
+ * global: job_list - global list of job records
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ * NOTE: change _unpack_job_info_delta_msg() in common/slurm_protocol_pack.c
+ *	whenever the data format changes
+ */
+extern int pack_jobs_delta(char **buffer_ptr, int *buffer_size,
+			   delta_info_request_msg_t *req, uid_t uid,
+			   uint16_t protocol_version)
+{
+	ListIterator job_iterator;
+	struct job_record *job_ptr;
+	uint32_t jobs_packed = 0, removed_cnt = 0, tmp_offset;
+	uint32_t *removed_ids = NULL;
+	int i, removed_size = 0;
+	bool full, changed;
+	Buf buffer;
+	time_t min_age = 0, old_min_age = 0, now = time(NULL);
+
+	buffer_ptr[0] = NULL;
+	*buffer_size = 0;
+
+	if (protocol_version < SLURM_14_11_PROTOCOL_VERSION) {
+		error("pack_jobs_delta: protocol_version "
+		      "%hu not supported", protocol_version);
+		return SLURM_PROTOCOL_VERSION_ERROR;
+	}
+
+	if (slurmctld_conf.min_job_age > 0) {
+		min_age = now - slurmctld_conf.min_job_age;
+		old_min_age = req->last_update - slurmctld_conf.min_job_age;
+	}
+
+	slurm_mutex_lock(&job_change_mutex);
+	_scan_job_changes();
+
+	/* Partition changes can hide or reveal any job */
+	full = ((req->change_seq == 0) ||
+		(req->change_epoch != job_change_epoch) ||
+		(req->change_seq < purged_job_floor) ||
+		(req->change_seq > job_change_seq) ||
+		(last_part_update >= req->last_update));
+
+	buffer = init_buf(BUF_SIZE);
+	pack32(jobs_packed, buffer);
+	pack_time(now, buffer);
+	pack_time(job_change_epoch, buffer);
+	pack32(job_change_seq, buffer);
+	pack16((uint16_t) full, buffer);
+
+	part_filter_set(uid);
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+		xassert (job_ptr->magic == JOB_MAGIC);
+
+		changed = full || (job_ptr->change_seq > req->change_seq);
+		if (!_job_visible(job_ptr, req->show_flags, uid, min_age)) {
+			/* Drop it from the client's copy if it has changed
+			 * or has become ready for purging since then */
+			if (full ||
+			    (!changed &&
+			     ((min_age == 0) || !IS_JOB_FINISHED(job_ptr) ||
+			      (job_ptr->end_time < old_min_age))))
+				continue;
+			if (removed_cnt >= removed_size) {
+				removed_size = MAX(removed_size * 2, 64);
+				xrealloc(removed_ids,
+					 sizeof(uint32_t) * removed_size);
+			}
+			removed_ids[removed_cnt++] = job_ptr->job_id;
+			continue;
+		}
+		if (!changed)
+			continue;
+
+		pack_job(job_ptr, req->show_flags, buffer, protocol_version,
+			 uid);
 		jobs_packed++;
 	}
 	part_filter_clear();
 	list_iterator_destroy(job_iterator);
 
+	if (!full) {
+		for (i = 0; i < purged_job_cnt; i++) {
+			if (purged_jobs[i].change_seq <= req->change_seq)
+				continue;
+			if (removed_cnt >= removed_size) {
+				removed_size = MAX(removed_size * 2, 64);
+				xrealloc(removed_ids,
+					 sizeof(uint32_t) * removed_size);
+			}
+			removed_ids[removed_cnt++] = purged_jobs[i].job_id;
+		}
+	}
+	slurm_mutex_unlock(&job_change_mutex);
+
+	if (!full && (jobs_packed == 0) && (removed_cnt == 0)) {
+		free_buf(buffer);
+		return SLURM_NO_CHANGE_IN_DATA;
+	}
+	pack32_array(removed_ids, removed_cnt, buffer);
+	xfree(removed_ids);
+
 	/* put the real record count in the message body header */
 	tmp_offset = get_buf_offset(buffer);
 	set_buf_offset(buffer, 0);
@@ -6141,6 +6389,7 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 
 	*buffer_size = get_buf_offset(buffer);
 	buffer_ptr[0] = xfer_buf_data(buffer);
+	return SLURM_SUCCESS;
 }
 
 /*
@@ -6975,6 +7224,7 @@ void reset_job_bitmaps(void)
 	static uint32_t cr_flag = NO_VAL;
 
 	xassert(job_list);
+	node_alloc_gen++;
 
 	if (cr_flag == NO_VAL) {
 		cr_flag = 0;  /* call is no-op for select/linear and bluegene */
@@ -8608,6 +8858,7 @@ int update_job(job_desc_msg_t * job_specs, uid_t uid)
 			error_code = select_g_job_expand(job_ptr,
 							 expand_job_ptr);
 			if (error_code == SLURM_SUCCESS) {
+				node_alloc_gen++;
 				_merge_job_licenses(job_ptr, expand_job_ptr);
 				rebuild_step_bitmaps(expand_job_ptr,
 						     orig_job_node_bitmap);
@@ -9819,6 +10070,10 @@ void job_fini (void)
 		job_list = NULL;
 	}
 	xfree(job_hash);
+	if (job_change_buf) {
+		free_buf(job_change_buf);
+		job_change_buf = NULL;
+	}
 }
 
 /* log the completion of the specified job */
@@ -9844,6 +10099,7 @@ extern void job_completion_logger(struct job_record  *job_ptr, bool requeue)
 
 		/* make sure all parts of the job are notified */
 		srun_job_complete(job_ptr);
+		event_job_fini(job_ptr);
 
 		/* mail out notifications of completion */
 		base_state = job_ptr->job_state & JOB_STATE_BASE;
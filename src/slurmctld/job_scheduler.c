@@ -247,6 +247,11 @@ extern List build_job_queue(bool clear_start, bool backfill)
 		if (!_job_runnable_test1(job_ptr, clear_start))
 			continue;
 
+		/* Leave out jobs whose association or QOS is at its
+		 * limits, the room left is cached per association/QOS */
+		if (!acct_policy_job_runnable_cached(job_ptr))
+			continue;
+
 		if (job_ptr->part_ptr_list) {
 			int inx = -1;
 			part_iterator = list_iterator_create(
@@ -692,7 +697,7 @@ extern int schedule(uint32_t job_limit)
 	ListIterator job_iterator = NULL, part_iterator = NULL;
 	List job_queue = NULL;
 	int error_code, failed_part_cnt = 0, job_cnt = 0, i;
-	uint32_t job_depth = 0;
+	uint32_t job_depth = 0, limit_eval_start;
 	job_queue_rec_t *job_queue_rec;
 	struct job_record *job_ptr = NULL;
 	struct part_record *part_ptr, **failed_parts = NULL;
@@ -802,6 +807,7 @@ extern int schedule(uint32_t job_limit)
 	}
 #endif
 
+	limit_eval_start = slurmctld_diag_stats.acct_limit_eval_cnt;
 	failed_parts = xmalloc(sizeof(struct part_record *) *
 			       list_count(part_list));
 	save_avail_node_bitmap = bit_copy(avail_node_bitmap);
@@ -935,8 +941,9 @@ next_part:			part_ptr = (struct part_record *)
 			}
 		}
 
-		if (!acct_policy_job_runnable_state(job_ptr) &&
-		    !acct_policy_job_runnable(job_ptr))
+		if (!acct_policy_job_runnable_cached(job_ptr) ||
+		    (!acct_policy_job_runnable_state(job_ptr) &&
+		     !acct_policy_job_runnable(job_ptr)))
 			continue;
 
 		if ((job_ptr->state_reason == WAIT_NODE_NOT_AVAIL) &&
@@ -1110,6 +1117,12 @@ next_part:			part_ptr = (struct part_record *)
 	} else {
 		FREE_NULL_LIST(job_queue);
 	}
+	/* Stats may have been reset by "sdiag -r" during the cycle */
+	if (slurmctld_diag_stats.acct_limit_eval_cnt >= limit_eval_start) {
+		slurmctld_diag_stats.acct_limit_eval_last =
+			slurmctld_diag_stats.acct_limit_eval_cnt -
+			limit_eval_start;
+	}
 	unlock_slurmctld(job_write_lock);
 	END_TIMER2("schedule");
 
@@ -2625,20 +2638,9 @@ static int _valid_feature_list(uint32_t job_id, List feature_list)
 static int _valid_node_feature(char *feature)
 {
 	int rc = ESLURM_INVALID_FEATURE;
-	struct features_record *feature_ptr;
-	ListIterator feature_iter;
-
-	/* Clear these nodes from the feature_list record,
-	 * then restore as needed */
-	feature_iter = list_iterator_create(feature_list);
-	while ((feature_ptr = (struct features_record *)
-			list_next(feature_iter))) {
-		if (strcmp(feature_ptr->name, feature))
-			continue;
+
+	if (find_feature_record(feature))
 		rc = SLURM_SUCCESS;
-		break;
-	}
-	list_iterator_destroy(feature_iter);
 
 	return rc;
 }
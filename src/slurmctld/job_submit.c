@@ -243,8 +243,14 @@ extern int job_submit_plugin_submit(struct job_descriptor *job_desc,
 	slurm_mutex_lock(&g_context_lock);
 	for (i=0; ((i < g_context_cnt) && (rc == SLURM_SUCCESS)); i++)
 		rc = (*(ops[i].submit))(job_desc, submit_uid, err_msg);
-	slurm_mutex_unlock(&g_context_lock);
 	END_TIMER;
+	if (g_context_cnt > 0) {
+		slurmctld_diag_stats.job_submit_cnt++;
+		slurmctld_diag_stats.job_submit_time_sum += DELTA_TIMER;
+		if (slurmctld_diag_stats.job_submit_time_max < DELTA_TIMER)
+			slurmctld_diag_stats.job_submit_time_max = DELTA_TIMER;
+	}
+	slurm_mutex_unlock(&g_context_lock);
 	debug("job_submit_plugin_submit: %s", TIME_STR);
 
 	return rc;
@@ -267,8 +273,14 @@ extern int job_submit_plugin_modify(struct job_descriptor *job_desc,
 	slurm_mutex_lock(&g_context_lock);
 	for (i=0; ((i < g_context_cnt) && (rc == SLURM_SUCCESS)); i++)
 		rc = (*(ops[i].modify))(job_desc, job_ptr, submit_uid);
-	slurm_mutex_unlock(&g_context_lock);
 	END_TIMER;
+	if (g_context_cnt > 0) {
+		slurmctld_diag_stats.job_modify_cnt++;
+		slurmctld_diag_stats.job_modify_time_sum += DELTA_TIMER;
+		if (slurmctld_diag_stats.job_modify_time_max < DELTA_TIMER)
+			slurmctld_diag_stats.job_modify_time_max = DELTA_TIMER;
+	}
+	slurm_mutex_unlock(&g_context_lock);
 	debug("job_submit_plugin_modify: %s", TIME_STR);
 
 	return rc;
@@ -68,6 +68,7 @@
 #include "src/common/slurm_acct_gather_energy.h"
 #include "src/common/slurm_ext_sensors.h"
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/event_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/ping_nodes.h"
@@ -85,6 +86,8 @@
 #define MAX_RETRIES	10
 
 /* Change NODE_STATE_VERSION value when changing the state save format */
+#define NODE_CHANGE_SEQ_MAX	0xfff00000	/* start a new epoch beyond */
+
 #define NODE_STATE_VERSION        "VER006"
 #define NODE_14_03_STATE_VERSION  "VER006"	/* SLURM version 14.03 */
 #define NODE_2_6_STATE_VERSION    "VER006"	/* SLURM version 2.6 */
@@ -104,10 +107,16 @@ static front_end_record_t * _front_end_reg(
 				slurm_node_registration_status_msg_t *reg_msg);
 static void 	_make_node_down(struct node_record *node_ptr,
 				time_t event_time);
+static bool	_hide_node(struct node_record *node_ptr, uint16_t show_flags,
+			   uid_t uid);
 static bool	_node_is_hidden(struct node_record *node_ptr);
 static int	_open_node_state_file(char **state_file);
 static void 	_pack_node (struct node_record *dump_node_ptr, Buf buffer,
 			    uint16_t protocol_version);
+static void	_pack_node_for(struct node_record *node_ptr, Buf buffer,
+			       uint16_t show_flags, uid_t uid,
+			       uint16_t protocol_version);
+static void	_scan_node_changes(void);
 static void	_sync_bitmaps(struct node_record *node_ptr, int job_count);
 static void	_update_config_ptr(bitstr_t *bitmap,
 				struct config_record *config_ptr);
@@ -613,6 +622,42 @@ static bool _node_is_hidden(struct node_record *node_ptr)
 	return true;
 }
 
+/* Determine if a node's name should be withheld from a specific user.
+ * Part_filter_set() must have been called for the user. */
+static bool _hide_node(struct node_record *node_ptr, uint16_t show_flags,
+		       uid_t uid)
+{
+	if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
+	    (_node_is_hidden(node_ptr)))
+		return true;
+	if (IS_NODE_FUTURE(node_ptr) &&
+	    !IS_NODE_MAINT(node_ptr)) /* reboot req sent */
+		return true;
+	if (IS_NODE_CLOUD(node_ptr) && IS_NODE_POWER_SAVE(node_ptr))
+		return true;
+	if ((node_ptr->name == NULL) || (node_ptr->name[0] == '\0'))
+		return true;
+	return false;
+}
+
+/* We can't avoid packing node records without breaking the node index
+ * pointers. So pack a hidden node with a name of NULL and let the caller
+ * deal with it. */
+static void _pack_node_for(struct node_record *node_ptr, Buf buffer,
+			   uint16_t show_flags, uid_t uid,
+			   uint16_t protocol_version)
+{
+	char *orig_name;
+
+	if (_hide_node(node_ptr, show_flags, uid)) {
+		orig_name = node_ptr->name;
+		node_ptr->name = NULL;
+		_pack_node(node_ptr, buffer, protocol_version);
+		node_ptr->name = orig_name;
+	} else
+		_pack_node(node_ptr, buffer, protocol_version);
+}
+
 /*
  * pack_all_node - dump all configuration and node information for all nodes
  *	in machine independent form (for network transmission)
@@ -635,12 +680,14 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	Buf buffer;
 	time_t now = time(NULL);
 	struct node_record *node_ptr = node_record_table_ptr;
-	bool hidden;
+	static int last_pack_size = BUF_SIZE*16;
 
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	buffer = init_buf (BUF_SIZE*16);
+	/* Size the buffer from the previous dump, which should be close,
+	 * so that it need not grow as the records are packed */
+	buffer = init_buf (last_pack_size);
 	nodes_packed = 0;
 
 	if (protocol_version >= SLURM_2_5_PROTOCOL_VERSION) {
@@ -659,31 +706,8 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			xassert (node_ptr->config_ptr->magic ==
 				 CONFIG_MAGIC);
 
-			/* We can't avoid packing node records without breaking
-			 * the node index pointers. So pack a node
-			 * with a name of NULL and let the caller deal
-			 * with it. */
-			hidden = false;
-			if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
-			    (_node_is_hidden(node_ptr)))
-				hidden = true;
-			else if (IS_NODE_FUTURE(node_ptr) &&
-				 !IS_NODE_MAINT(node_ptr)) /* reboot req sent */
-				hidden = true;
-			else if (IS_NODE_CLOUD(node_ptr) &&
-				 IS_NODE_POWER_SAVE(node_ptr))
-				hidden = true;
-			else if ((node_ptr->name == NULL) ||
-				 (node_ptr->name[0] == '\0'))
-				hidden = true;
-
-			if (hidden) {
-				char *orig_name = node_ptr->name;
-				node_ptr->name = NULL;
-				_pack_node(node_ptr, buffer, protocol_version);
-				node_ptr->name = orig_name;
-			} else
-				_pack_node(node_ptr, buffer, protocol_version);
+			_pack_node_for(node_ptr, buffer, show_flags, uid,
+				       protocol_version);
 			nodes_packed++;
 		}
 		part_filter_clear();
@@ -698,6 +722,7 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	set_buf_offset (buffer, tmp_offset);
 
 	*buffer_size = get_buf_offset (buffer);
+	last_pack_size = MAX(*buffer_size + BUF_SIZE, BUF_SIZE*16);
 	buffer_ptr[0] = xfer_buf_data (buffer);
 }
 
@@ -724,7 +749,6 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
 	Buf buffer;
 	time_t now = time(NULL);
 	struct node_record *node_ptr;
-	bool hidden;
 
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
@@ -747,25 +771,9 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
 			node_ptr = find_node_record(node_name);
 		else
 			node_ptr = node_record_table_ptr;
-		if (node_ptr) {
-			hidden = false;
-			if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
-			    (_node_is_hidden(node_ptr)))
-				hidden = true;
-			else if (IS_NODE_FUTURE(node_ptr) &&
-				 !IS_NODE_MAINT(node_ptr)) /* reboot req sent */
-				hidden = true;
-			else if (IS_NODE_CLOUD(node_ptr) &&
-				 IS_NODE_POWER_SAVE(node_ptr))
-				hidden = true;
-			else if ((node_ptr->name == NULL) ||
-				 (node_ptr->name[0] == '\0'))
-				hidden = true;
-
-			if (!hidden) {
-				_pack_node(node_ptr, buffer, protocol_version);
-				nodes_packed++;
-			}
+		if (node_ptr && !_hide_node(node_ptr, show_flags, uid)) {
+			_pack_node(node_ptr, buffer, protocol_version);
+			nodes_packed++;
 		}
 		part_filter_clear();
 	} else {
@@ -782,6 +790,430 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = xfer_buf_data (buffer);
 }
 
+/* Node change tracking for pack_node_delta(), see _scan_node_changes() */
+static Buf      node_change_buf = NULL;	/* scratch buffer for digests */
+static time_t   node_change_epoch = 0;	/* when node_change_seq started */
+static uint32_t node_change_seq = 0;	/* last change_seq assigned */
+static time_t   node_change_time = 0;	/* time of last scan */
+
+/* Give a new change_seq to every node which packs differently than when last
+ * scanned, as _scan_job_changes() does for jobs. A rebuilt node table starts
+ * with change_seq of zero, so every node is treated as changed.
+ * NOTE: WRITE lock_slurmctld node before entry */
+static void _scan_node_changes(void)
+{
+	struct node_record *node_ptr;
+	uint64_t digest;
+	int inx;
+
+	/* Allow for updates time stamped just before the last scan */
+	if (node_change_epoch && (last_node_update < node_change_time - 1))
+		return;
+	node_change_time = time(NULL);
+
+	if ((node_change_epoch == 0) ||
+	    (node_change_seq > NODE_CHANGE_SEQ_MAX)) {
+		/* Every delta client must reload all nodes */
+		node_change_epoch = MAX(node_change_time,
+					node_change_epoch + 1);
+		node_change_seq = 0;
+		node_ptr = node_record_table_ptr;
+		for (inx = 0; inx < node_record_count; inx++, node_ptr++)
+			node_ptr->change_seq = 0;
+	}
+	if (node_change_buf == NULL)
+		node_change_buf = init_buf(BUF_SIZE);
+
+	node_ptr = node_record_table_ptr;
+	for (inx = 0; inx < node_record_count; inx++, node_ptr++) {
+		set_buf_offset(node_change_buf, 0);
+		_pack_node(node_ptr, node_change_buf, SLURM_PROTOCOL_VERSION);
+		digest = get_buf_digest(node_change_buf, 0);
+		if (node_ptr->change_seq && (node_ptr->pack_digest == digest))
+			continue;
+		node_ptr->pack_digest = digest;
+		node_ptr->change_seq = ++node_change_seq;
+	}
+}
+
+/*
+ * pack_node_delta - dump the nodes which changed since a client loaded its
+ *	copy of the node table, or every node if that cannot be determined
+ * OUT buffer_ptr - pointer to the stored data
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN req - the client's request, describing its copy of the node table
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * RET SLURM_SUCCESS, SLURM_PROTOCOL_VERSION_ERROR or SLURM_NO_CHANGE_IN_DATA
+ *	if no node has changed; no buffer is returned unless SLURM_SUCCESS
+ * global: node_record_table_ptr - pointer to global node table
+ * NOTE: the caller must xfree the buffer at *buffer_ptr
+ * NOTE: change _unpack_node_info_delta_msg() in common/slurm_protocol_pack.c
+ *	whenever the data format changes
+ * NOTE: READ lock_slurmctld config and WRITE lock node before entry
+ */
+extern int pack_node_delta(char **buffer_ptr, int *buffer_size,
+			   delta_info_request_msg_t *req, uid_t uid,
+			   uint16_t protocol_version)
+{
+	int inx;
+	uint32_t nodes_packed = 0, tmp_offset, node_scaling;
+	Buf buffer;
+	time_t now = time(NULL);
+	struct node_record *node_ptr;
+	bool full;
+
+	buffer_ptr[0] = NULL;
+	*buffer_size = 0;
+
+	if (protocol_version < SLURM_14_11_PROTOCOL_VERSION) {
+		error("pack_node_delta: protocol_version "
+		      "%hu not supported", protocol_version);
+		return SLURM_PROTOCOL_VERSION_ERROR;
+	}
+
+	_scan_node_changes();
+
+	/* Partition changes can hide or reveal any node */
+	full = ((req->change_seq == 0) ||
+		(req->change_epoch != node_change_epoch) ||
+		(req->change_seq > node_change_seq) ||
+		(req->record_count != node_record_count) ||
+		(last_part_update >= req->last_update));
+	if (!full) {
+		node_ptr = node_record_table_ptr;
+		for (inx = 0; inx < node_record_count; inx++, node_ptr++) {
+			if (node_ptr->change_seq > req->change_seq)
+				break;
+		}
+		if (inx >= node_record_count)
+			return SLURM_NO_CHANGE_IN_DATA;
+	}
+
+	buffer = init_buf(full ? BUF_SIZE * 16 : BUF_SIZE);
+	pack32(nodes_packed, buffer);
+	select_g_alter_node_cnt(SELECT_GET_NODE_SCALING, &node_scaling);
+	pack32(node_scaling, buffer);
+	pack_time(now, buffer);
+	pack_time(node_change_epoch, buffer);
+	pack32(node_change_seq, buffer);
+	pack16((uint16_t) full, buffer);
+	pack32((uint32_t) node_record_count, buffer);
+
+	part_filter_set(uid);
+	node_ptr = node_record_table_ptr;
+	for (inx = 0; inx < node_record_count; inx++, node_ptr++) {
+		if (!full && (node_ptr->change_seq <= req->change_seq))
+			continue;
+		pack32((uint32_t) inx, buffer);
+		_pack_node_for(node_ptr, buffer, req->show_flags, uid,
+			       protocol_version);
+		nodes_packed++;
+	}
+	part_filter_clear();
+
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack32(nodes_packed, buffer);
+	set_buf_offset(buffer, tmp_offset);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+	return SLURM_SUCCESS;
+}
+
+/* A group of nodes reported by pack_node_summary() */
+typedef struct node_summary_rec {
+	node_summary_t summary;		/* data sent to the client */
+	struct part_record *part_ptr;	/* partition containing the nodes */
+	bitstr_t *node_bitmap;		/* nodes in the group */
+	bool alloc;			/* nodes have allocated CPUs */
+	bool err;			/* nodes have CPUs in an error state */
+	struct node_summary_rec *next;	/* next record in the hash chain */
+} node_summary_rec_t;
+
+static List   summary_list = NULL;	/* node_summary_rec_t records */
+static time_t summary_time = (time_t) 0;	/* when summary_list built */
+
+static void _summary_rec_del(void *x)
+{
+	node_summary_rec_t *rec = (node_summary_rec_t *) x;
+
+	if (rec) {
+		xfree(rec->summary.features);
+		xfree(rec->summary.nodes);
+		xfree(rec->summary.partition);
+		FREE_NULL_BITMAP(rec->node_bitmap);
+		xfree(rec);
+	}
+}
+
+/* like strcmp() == 0, but works with NULL pointers */
+static bool _same_features(char *features1, char *features2)
+{
+	if ((features1 == NULL) || (features2 == NULL))
+		return (features1 == features2);
+	return (strcmp(features1, features2) == 0);
+}
+
+static uint32_t _summary_hash(struct part_record *part_ptr,
+			      uint16_t node_state, char *features,
+			      bool alloc, bool err)
+{
+	uint32_t hash = (uint32_t) ((unsigned long) part_ptr >> 4);
+
+	hash = (hash * 31) + node_state;
+	hash = (hash * 31) + (alloc ? 2 : 0) + (err ? 1 : 0);
+	if (features) {
+		while (*features)
+			hash = (hash * 31) + *features++;
+	}
+	return hash;
+}
+
+/*
+ * _build_node_summary - rebuild summary_list, grouping the nodes of each
+ *	partition by state, features and whether any of their CPUs are
+ *	allocated or in an error state
+ * NOTE: READ lock_slurmctld config, node and partition before entry
+ */
+static void _build_node_summary(void)
+{
+	node_summary_rec_t **hash_table, *rec;
+	struct node_record *node_ptr = node_record_table_ptr;
+	struct part_record *part_ptr;
+	ListIterator iter;
+	uint16_t cpus, sockets, cores, threads;
+	uint16_t alloc_cpus, err_cpus;
+	uint32_t real_memory, tmp_disk, weight, hash;
+	int hash_size = node_record_count + 1;
+	int inx, i;
+
+	if (summary_list)
+		list_flush(summary_list);
+	else
+		summary_list = list_create(_summary_rec_del);
+	hash_table = xmalloc(sizeof(node_summary_rec_t *) * hash_size);
+
+	for (inx = 0; inx < node_record_count; inx++, node_ptr++) {
+		/* Same nodes hidden from everyone by pack_all_node() */
+		if ((IS_NODE_FUTURE(node_ptr) && !IS_NODE_MAINT(node_ptr)) ||
+		    (IS_NODE_CLOUD(node_ptr) && IS_NODE_POWER_SAVE(node_ptr)) ||
+		    (node_ptr->name == NULL) || (node_ptr->name[0] == '\0'))
+			continue;
+
+#ifndef HAVE_BG
+		if (slurmctld_conf.fast_schedule) {
+			cpus        = node_ptr->config_ptr->cpus;
+			sockets     = node_ptr->config_ptr->sockets;
+			cores       = node_ptr->config_ptr->cores;
+			threads     = node_ptr->config_ptr->threads;
+			real_memory = node_ptr->config_ptr->real_memory;
+			tmp_disk    = node_ptr->config_ptr->tmp_disk;
+		} else {
+#endif
+			cpus        = node_ptr->cpus;
+			sockets     = node_ptr->sockets;
+			cores       = node_ptr->cores;
+			threads     = node_ptr->threads;
+			real_memory = node_ptr->real_memory;
+			tmp_disk    = node_ptr->tmp_disk;
+#ifndef HAVE_BG
+		}
+#endif
+		weight = node_ptr->config_ptr->weight;
+
+		alloc_cpus = 0;
+		err_cpus = 0;
+		select_g_select_nodeinfo_get(node_ptr->select_nodeinfo,
+					     SELECT_NODEDATA_SUBCNT,
+					     NODE_STATE_ALLOCATED,
+					     &alloc_cpus);
+		select_g_select_nodeinfo_get(node_ptr->select_nodeinfo,
+					     SELECT_NODEDATA_SUBCNT,
+					     NODE_STATE_ERROR,
+					     &err_cpus);
+
+		for (i = 0; i < node_ptr->part_cnt; i++) {
+			part_ptr = node_ptr->part_pptr[i];
+			hash = _summary_hash(part_ptr, node_ptr->node_state,
+					     node_ptr->features,
+					     (alloc_cpus != 0),
+					     (err_cpus != 0)) % hash_size;
+			for (rec = hash_table[hash]; rec; rec = rec->next) {
+				if ((rec->part_ptr == part_ptr) &&
+				    (rec->summary.node_state ==
+				     node_ptr->node_state) &&
+				    (rec->alloc == (alloc_cpus != 0)) &&
+				    (rec->err == (err_cpus != 0)) &&
+				    _same_features(rec->summary.features,
+						   node_ptr->features))
+					break;
+			}
+			if (rec == NULL) {
+				rec = xmalloc(sizeof(node_summary_rec_t));
+				rec->part_ptr = part_ptr;
+				rec->node_bitmap = bit_alloc(node_record_count);
+				rec->alloc = (alloc_cpus != 0);
+				rec->err = (err_cpus != 0);
+				rec->summary.partition = xstrdup(part_ptr->name);
+				rec->summary.features =
+					xstrdup(node_ptr->features);
+				rec->summary.node_state = node_ptr->node_state;
+				rec->summary.min_cpus    = cpus;
+				rec->summary.max_cpus    = cpus;
+				rec->summary.min_sockets = sockets;
+				rec->summary.max_sockets = sockets;
+				rec->summary.min_cores   = cores;
+				rec->summary.max_cores   = cores;
+				rec->summary.min_threads = threads;
+				rec->summary.max_threads = threads;
+				rec->summary.min_mem     = real_memory;
+				rec->summary.max_mem     = real_memory;
+				rec->summary.min_disk    = tmp_disk;
+				rec->summary.max_disk    = tmp_disk;
+				rec->summary.min_weight  = weight;
+				rec->summary.max_weight  = weight;
+				rec->next = hash_table[hash];
+				hash_table[hash] = rec;
+				list_append(summary_list, rec);
+			} else {
+				rec->summary.min_cpus =
+					MIN(rec->summary.min_cpus, cpus);
+				rec->summary.max_cpus =
+					MAX(rec->summary.max_cpus, cpus);
+				rec->summary.min_sockets =
+					MIN(rec->summary.min_sockets, sockets);
+				rec->summary.max_sockets =
+					MAX(rec->summary.max_sockets, sockets);
+				rec->summary.min_cores =
+					MIN(rec->summary.min_cores, cores);
+				rec->summary.max_cores =
+					MAX(rec->summary.max_cores, cores);
+				rec->summary.min_threads =
+					MIN(rec->summary.min_threads, threads);
+				rec->summary.max_threads =
+					MAX(rec->summary.max_threads, threads);
+				rec->summary.min_mem =
+					MIN(rec->summary.min_mem, real_memory);
+				rec->summary.max_mem =
+					MAX(rec->summary.max_mem, real_memory);
+				rec->summary.min_disk =
+					MIN(rec->summary.min_disk, tmp_disk);
+				rec->summary.max_disk =
+					MAX(rec->summary.max_disk, tmp_disk);
+				rec->summary.min_weight =
+					MIN(rec->summary.min_weight, weight);
+				rec->summary.max_weight =
+					MAX(rec->summary.max_weight, weight);
+			}
+			bit_set(rec->node_bitmap, inx);
+			rec->summary.node_cnt++;
+			rec->summary.cpus_total += cpus;
+			rec->summary.cpus_alloc += alloc_cpus;
+			rec->summary.cpus_err   += err_cpus;
+		}
+	}
+	xfree(hash_table);
+
+	/* The node names are only needed in their compact form */
+	iter = list_iterator_create(summary_list);
+	while ((rec = (node_summary_rec_t *) list_next(iter))) {
+		rec->summary.nodes = bitmap2node_name(rec->node_bitmap);
+		FREE_NULL_BITMAP(rec->node_bitmap);
+		rec->next = NULL;
+	}
+	list_iterator_destroy(iter);
+
+	summary_time = time(NULL);
+}
+
+/*
+ * pack_node_summary - dump the nodes of every partition, grouped by state
+ *	and features, in machine independent form (for network transmission)
+ * OUT buffer_ptr - pointer to the stored data
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN show_flags - partition filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * NOTE: the caller must xfree the buffer at *buffer_ptr
+ * NOTE: change _unpack_node_summary_msg() in common/slurm_protocol_pack.c
+ *	when data format changes
+ * NOTE: READ lock_slurmctld config, node and partition before entry
+ */
+extern void pack_node_summary(char **buffer_ptr, int *buffer_size,
+			      uint16_t show_flags, uid_t uid,
+			      uint16_t protocol_version)
+{
+	uint32_t recs_packed = 0, tmp_offset;
+	Buf buffer;
+	ListIterator iter;
+	node_summary_rec_t *rec;
+	node_summary_t *summary;
+	time_t now = time(NULL);
+
+	buffer_ptr[0] = NULL;
+	*buffer_size = 0;
+
+	/* The groups only change with the node or partition tables, so
+	 * reuse them until either is updated.  Time stamps have a
+	 * resolution of one second, so rebuild if either was updated
+	 * during the second in which the groups were built. */
+	if ((summary_list == NULL) || (last_node_update >= summary_time) ||
+	    (last_part_update >= summary_time))
+		_build_node_summary();
+
+	buffer = init_buf(BUF_SIZE);
+	if (protocol_version >= SLURM_14_11_PROTOCOL_VERSION) {
+		pack32(recs_packed, buffer);
+		pack_time(now, buffer);
+
+		iter = list_iterator_create(summary_list);
+		while ((rec = (node_summary_rec_t *) list_next(iter))) {
+			if (((show_flags & SHOW_ALL) == 0) && (uid != 0) &&
+			    ((rec->part_ptr->flags & PART_FLAG_HIDDEN) ||
+			     (validate_group(rec->part_ptr, uid) == 0)))
+				continue;
+			summary = &rec->summary;
+			packstr(summary->partition, buffer);
+			packstr(summary->nodes, buffer);
+			packstr(summary->features, buffer);
+			pack16(summary->node_state, buffer);
+			pack32(summary->node_cnt, buffer);
+			pack32(summary->cpus_alloc, buffer);
+			pack32(summary->cpus_err, buffer);
+			pack32(summary->cpus_total, buffer);
+			pack16(summary->min_cpus, buffer);
+			pack16(summary->max_cpus, buffer);
+			pack16(summary->min_sockets, buffer);
+			pack16(summary->max_sockets, buffer);
+			pack16(summary->min_cores, buffer);
+			pack16(summary->max_cores, buffer);
+			pack16(summary->min_threads, buffer);
+			pack16(summary->max_threads, buffer);
+			pack32(summary->min_disk, buffer);
+			pack32(summary->max_disk, buffer);
+			pack32(summary->min_mem, buffer);
+			pack32(summary->max_mem, buffer);
+			pack32(summary->min_weight, buffer);
+			pack32(summary->max_weight, buffer);
+			recs_packed++;
+		}
+		list_iterator_destroy(iter);
+	} else {
+		error("pack_node_summary: protocol_version "
+		      "%hu not supported", protocol_version);
+	}
+
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack32(recs_packed, buffer);
+	set_buf_offset(buffer, tmp_offset);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
 /*
  * _pack_node - dump all configuration information about a specific node in
  *	machine independent form (for network transmission)
@@ -1154,6 +1586,7 @@ int update_node ( update_node_msg_t * update_node_msg )
 				 * FAIL flags too */
 				if (IS_NODE_DOWN(node_ptr)) {
 					trigger_node_up(node_ptr);
+					event_node_up(node_ptr);
 					clusteracct_storage_g_node_up(
 						acct_db_conn,
 						node_ptr,
@@ -1188,6 +1621,7 @@ int update_node ( update_node_msg_t * update_node_msg )
 				if ((node_ptr->run_job_cnt  == 0) &&
 				    (node_ptr->comp_job_cnt == 0)) {
 					trigger_node_drained(node_ptr);
+					event_node_drained(node_ptr);
 					clusteracct_storage_g_node_down(
 						acct_db_conn,
 						node_ptr, now, NULL,
@@ -1658,6 +2092,7 @@ extern int drain_nodes ( char *nodes, char *reason, uint32_t reason_uid )
 		    (node_ptr->comp_job_cnt == 0)) {
 			/* no jobs, node is drained */
 			trigger_node_drained(node_ptr);
+			event_node_drained(node_ptr);
 			clusteracct_storage_g_node_down(acct_db_conn,
 							node_ptr, now, NULL,
 							reason_uid);
@@ -1966,6 +2401,7 @@ extern int validate_node_specs(slurm_node_registration_status_msg_t *reg_msg)
 			info("node %s returned to service",
 			     reg_msg->node_name);
 			trigger_node_up(node_ptr);
+			event_node_up(node_ptr);
 			last_node_update = now;
 			if (!IS_NODE_DRAIN(node_ptr)
 			    && !IS_NODE_FAIL(node_ptr)) {
@@ -2309,6 +2745,7 @@ extern int validate_nodes_via_front_end(
 					node_ptr->last_idle = now;
 				}
 				trigger_node_up(node_ptr);
+				event_node_up(node_ptr);
 				if (!IS_NODE_DRAIN(node_ptr) &&
 				    !IS_NODE_FAIL(node_ptr)) {
 					/* reason information is handled in
@@ -2366,6 +2803,44 @@ extern int validate_nodes_via_front_end(
 	return error_code;
 }
 
+/*
+ * validate_node_reg_msgs - validate a batch of node registration messages,
+ *	as collected from a forwarding tree or from concurrent registration
+ *	RPCs, so that the locks are only acquired once for all of them
+ * IN reg_cnt - count of messages in reg_msgs
+ * IN reg_msgs - node registration messages
+ * OUT rc - error code for each message, as from validate_node_specs()
+ * NOTE: READ lock_slurmctld config, WRITE job and node before entry
+ */
+extern void validate_node_reg_msgs(int reg_cnt,
+		slurm_node_registration_status_msg_t **reg_msgs, int *rc)
+{
+	slurm_node_registration_status_msg_t *reg_msg;
+	uint32_t hash_val = slurm_get_hash_val();
+	int i;
+
+	for (i = 0; i < reg_cnt; i++) {
+		reg_msg = reg_msgs[i];
+		if (!(slurmctld_conf.debug_flags & DEBUG_FLAG_NO_CONF_HASH) &&
+		    (reg_msg->hash_val != NO_VAL) &&
+		    (reg_msg->hash_val != hash_val)) {
+			error("Node %s appears to have a different slurm.conf "
+			      "than the slurmctld.  This could cause issues "
+			      "with communication and functionality.  "
+			      "Please review both files and make sure they "
+			      "are the same.  If this is expected ignore, and "
+			      "set DebugFlags=NO_CONF_HASH in your slurm.conf.",
+			      reg_msg->node_name);
+		}
+#ifdef HAVE_FRONT_END		/* Operates only on front-end */
+		rc[i] = validate_nodes_via_front_end(reg_msg);
+#else
+		validate_jobs_on_node(reg_msg);
+		rc[i] = validate_node_specs(reg_msg);
+#endif
+	}
+}
+
 /* Sync idle, share, and avail_node_bitmaps for a given node */
 static void _sync_bitmaps(struct node_record *node_ptr, int job_count)
 {
@@ -2466,6 +2941,7 @@ static void _node_did_resp(struct node_record *node_ptr)
 		info("node_did_resp: node %s returned to service",
 		     node_ptr->name);
 		trigger_node_up(node_ptr);
+		event_node_up(node_ptr);
 		last_node_update = now;
 		if (!IS_NODE_DRAIN(node_ptr) && !IS_NODE_FAIL(node_ptr)) {
 			/* reason information is handled in
@@ -2824,6 +3300,7 @@ extern void make_node_comp(struct node_record *node_ptr,
 		bit_set(idle_node_bitmap, inx);
 		if (IS_NODE_DRAIN(node_ptr) || IS_NODE_FAIL(node_ptr)) {
 			trigger_node_drained(node_ptr);
+			event_node_drained(node_ptr);
 			clusteracct_storage_g_node_down(
 				acct_db_conn,
 				node_ptr, now, NULL,
@@ -2860,6 +3337,7 @@ static void _make_node_down(struct node_record *node_ptr, time_t event_time)
 	bit_clear (up_node_bitmap,    inx);
 	select_g_update_node_state(node_ptr);
 	trigger_node_down(node_ptr);
+	event_node_down(node_ptr);
 	last_node_update = time (NULL);
 	clusteracct_storage_g_node_down(acct_db_conn,
 					node_ptr, event_time, NULL,
@@ -2965,6 +3443,7 @@ void make_node_idle(struct node_record *node_ptr,
 		       node_ptr->name);
 		node_ptr->last_idle = now;
 		trigger_node_drained(node_ptr);
+		event_node_drained(node_ptr);
 		clusteracct_storage_g_node_down(acct_db_conn,
 						node_ptr, now, NULL,
 						slurm_get_slurm_user_id());
@@ -3071,6 +3550,11 @@ extern void node_fini (void)
 	FREE_NULL_BITMAP(power_node_bitmap);
 	FREE_NULL_BITMAP(share_node_bitmap);
 	FREE_NULL_BITMAP(up_node_bitmap);
+	FREE_NULL_LIST(summary_list);
+	if (node_change_buf) {
+		free_buf(node_change_buf);
+		node_change_buf = NULL;
+	}
 	node_fini2();
 }
 
@@ -77,6 +77,7 @@
 
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/event_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/licenses.h"
@@ -105,12 +106,16 @@ struct node_set {		/* set of nodes with same configuration */
 	bitstr_t *my_bitmap;		/* node bitmap */
 };
 
+/* Incremented whenever nodes are allocated to or released from a job */
+uint32_t node_alloc_gen = 0;
+
 static int  _build_node_list(struct job_record *job_ptr,
 			     struct node_set **node_set_pptr,
 			     int *node_set_size);
 static void _filter_nodes_in_set(struct node_set *node_set_ptr,
 				 struct job_details *detail_ptr);
-static int _match_feature(char *seek, struct node_set *node_set_ptr);
+static int _match_feature(struct features_record *feat_ptr,
+			  struct node_set *node_set_ptr);
 static int _nodes_in_sets(bitstr_t *req_bitmap,
 			  struct node_set * node_set_ptr,
 			  int node_set_size);
@@ -125,8 +130,11 @@ static int _pick_best_nodes(struct node_set *node_set_ptr,
 			    bitstr_t *exc_node_bitmap);
 static bool _valid_feature_counts(struct job_details *detail_ptr,
 				  bitstr_t *node_bitmap, bool *has_xor);
-static bitstr_t *_valid_features(struct job_details *detail_ptr,
+static bitstr_t *_valid_features(struct features_record **xor_feat,
+				 int xor_cnt,
 				 struct config_record *config_ptr);
+static struct features_record **_xor_features(struct job_details *detail_ptr,
+					      int *xor_cnt);
 
 static int _fill_in_gres_fields(struct job_record *job_ptr);
 
@@ -397,6 +405,7 @@ extern void allocate_nodes(struct job_record *job_ptr)
 	}
 
 	last_node_update = time(NULL);
+	node_alloc_gen++;
 	license_job_get(job_ptr);
 
 	if (has_cloud) {
@@ -492,6 +501,7 @@ extern void deallocate_nodes(struct job_record *job_ptr, bool timeout,
 	agent_args->hostlist = hostlist_create("");
 	kill_job = xmalloc(sizeof(kill_job_msg_t));
 	last_node_update    = time(NULL);
+	node_alloc_gen++;
 	kill_job->job_id    = job_ptr->job_id;
 	kill_job->step_id   = NO_VAL;
 	kill_job->job_state = job_ptr->job_state;
@@ -613,19 +623,13 @@ extern void deallocate_nodes(struct job_record *job_ptr, bool timeout,
 
 /*
  * _match_feature - determine if the desired feature is one of those available
- * IN seek - desired feature
+ * IN feat_ptr - desired feature, from find_feature_record()
  * IN node_set_ptr - Pointer to node_set being searched
  * RET 1 if found, 0 otherwise
  */
-static int _match_feature(char *seek, struct node_set *node_set_ptr)
+static int _match_feature(struct features_record *feat_ptr,
+			  struct node_set *node_set_ptr)
 {
-	struct features_record *feat_ptr;
-
-	if (seek == NULL)
-		return 1;	/* nothing to look for */
-
-	feat_ptr = list_find_first(feature_list, list_find_feature,
-				   (void *) seek);
 	if (feat_ptr == NULL)
 		return 0;	/* no such feature */
 
@@ -794,18 +798,20 @@ _get_req_features(struct node_set *node_set_ptr, int node_set_size,
 	    (job_ptr->details->req_node_layout == NULL)) {
 		ListIterator feat_iter;
 		struct feature_record *feat_ptr;
+		struct features_record *node_feat_ptr;
 		feat_iter = list_iterator_create(
 				job_ptr->details->feature_list);
 		while ((feat_ptr = (struct feature_record *)
 				list_next(feat_iter))) {
 			if (feat_ptr->count == 0)
 				continue;
+			node_feat_ptr = find_feature_record(feat_ptr->name);
 			tmp_node_set_size = 0;
 			/* _pick_best_nodes() is destructive of the node_set
 			 * data structure, so we need to make a copy and then
 			 * purge it */
 			for (i=0; i<node_set_size; i++) {
-				if (!_match_feature(feat_ptr->name,
+				if (!_match_feature(node_feat_ptr,
 						    node_set_ptr+i))
 					continue;
 				tmp_node_set_ptr[tmp_node_set_size].
@@ -1742,6 +1748,7 @@ extern int select_nodes(struct job_record *job_ptr, bool test_only,
 
 	slurmctld_diag_stats.jobs_started++;
 	acct_policy_job_begin(job_ptr);
+	event_job_start(job_ptr);
 
 	/* Update the job_record's gres and gres_alloc fields with
 	 * strings representing the amount of each GRES type requested
@@ -1976,8 +1983,7 @@ static bool _valid_feature_counts(struct job_details *detail_ptr,
 	job_feat_iter = list_iterator_create(detail_ptr->feature_list);
 	while ((job_feat_ptr = (struct feature_record *)
 			list_next(job_feat_iter))) {
-		feat_ptr = list_find_first(feature_list, list_find_feature,
-					   (void *) job_feat_ptr->name);
+		feat_ptr = find_feature_record(job_feat_ptr->name);
 		if (feat_ptr) {
 			if (last_op == FEATURE_OP_AND)
 				bit_and(feature_bitmap, feat_ptr->node_bitmap);
@@ -2006,9 +2012,7 @@ static bool _valid_feature_counts(struct job_details *detail_ptr,
 				list_next(job_feat_iter))) {
 			if (job_feat_ptr->count == 0)
 				continue;
-			feat_ptr = list_find_first(feature_list,
-						   list_find_feature,
-						   (void *)job_feat_ptr->name);
+			feat_ptr = find_feature_record(job_feat_ptr->name);
 			if (!feat_ptr) {
 				rc = false;
 				break;
@@ -2144,6 +2148,8 @@ static int _build_node_list(struct job_record *job_ptr,
 	bitstr_t *tmp_feature;
 	uint32_t max_weight = 0;
 	bool has_xor = false;
+	struct features_record **xor_feat = NULL;
+	int xor_cnt = 0;
 
 	if (job_ptr->resv_name) {
 		/* Limit node selection to those in selected reservation */
@@ -2204,6 +2210,8 @@ static int _build_node_list(struct job_record *job_ptr,
 		FREE_NULL_BITMAP(usable_node_mask);
 		return ESLURM_REQUESTED_NODE_CONFIG_UNAVAILABLE;
 	}
+	if (has_xor)
+		xor_feat = _xor_features(detail_ptr, &xor_cnt);
 
 	config_iterator = list_iterator_create(config_list);
 
@@ -2260,7 +2268,7 @@ static int _build_node_list(struct job_record *job_ptr,
 		}
 
 		if (has_xor) {
-			tmp_feature = _valid_features(job_ptr->details,
+			tmp_feature = _valid_features(xor_feat, xor_cnt,
 						      config_ptr);
 			if (tmp_feature == NULL) {
 				FREE_NULL_BITMAP(node_set_ptr[node_set_inx].
@@ -2298,6 +2306,7 @@ static int _build_node_list(struct job_record *job_ptr,
 	FREE_NULL_BITMAP(node_set_ptr[node_set_inx].my_bitmap);
 	FREE_NULL_BITMAP(node_set_ptr[node_set_inx].feature_bits);
 	FREE_NULL_BITMAP(usable_node_mask);
+	xfree(xor_feat);
 
 	if (node_set_inx == 0) {
 		info("No nodes satisfy job %u requirements in partition %s",
@@ -2526,10 +2535,50 @@ extern void build_node_details(struct job_record *job_ptr, bool new_alloc)
 	}
 }
 
+/*
+ * _xor_features - Find the records of a job's mutually exclusive features
+ *	once, rather than for each configuration record tested
+ * IN details_ptr - job requirement details, includes requested features
+ * OUT xor_cnt - number of entries in the returned array
+ * RET array of feature records in the order of the exclusive OR list,
+ *	NULL entries for features no node has, free with xfree()
+ */
+static struct features_record **_xor_features(struct job_details *details_ptr,
+					      int *xor_cnt)
+{
+	struct features_record **xor_feat;
+	ListIterator feat_iter;
+	struct feature_record *job_feat_ptr;
+	int last_op = FEATURE_OP_AND;
+
+	*xor_cnt = 0;
+	if (details_ptr->feature_list == NULL)	/* no constraints */
+		return NULL;
+
+	xor_feat = xmalloc(sizeof(struct features_record *) *
+			   list_count(details_ptr->feature_list));
+	feat_iter = list_iterator_create(details_ptr->feature_list);
+	while ((job_feat_ptr = (struct feature_record *)
+			list_next(feat_iter))) {
+		if ((job_feat_ptr->op_code == FEATURE_OP_XAND) ||
+		    (job_feat_ptr->op_code == FEATURE_OP_XOR)  ||
+		    (last_op == FEATURE_OP_XAND) ||
+		    (last_op == FEATURE_OP_XOR)) {
+			xor_feat[(*xor_cnt)++] =
+				find_feature_record(job_feat_ptr->name);
+		}
+		last_op = job_feat_ptr->op_code;
+	}
+	list_iterator_destroy(feat_iter);
+
+	return xor_feat;
+}
+
 /*
  * _valid_features - Determine if the requested features are satisfied by
  *	the available nodes. This is only used for XOR operators.
- * IN details_ptr - job requirement details, includes requested features
+ * IN xor_feat - job's mutually exclusive features, from _xor_features()
+ * IN xor_cnt - number of entries in xor_feat
  * IN config_ptr - node's configuration record
  * RET NULL if request is not satisfied, otherwise a bitmap indicating
  *	which mutually exclusive features are satisfied. For example
@@ -2540,41 +2589,26 @@ extern void build_node_details(struct job_record *job_ptr, bool new_alloc)
  *	with the first bit set if requirements are satisfied without a
  *	mutually exclusive feature list.
  */
-static bitstr_t *_valid_features(struct job_details *details_ptr,
+static bitstr_t *_valid_features(struct features_record **xor_feat,
+				 int xor_cnt,
 				 struct config_record *config_ptr)
 {
 	bitstr_t *result_bits = (bitstr_t *) NULL;
-	ListIterator feat_iter;
-	struct feature_record *job_feat_ptr;
-	struct features_record *feat_ptr;
-	int last_op = FEATURE_OP_AND, position = 0;
+	int position;
 
 	result_bits = bit_alloc(MAX_FEATURES);
-	if (details_ptr->feature_list == NULL) {	/* no constraints */
+	if (xor_feat == NULL) {	/* no constraints */
 		bit_set(result_bits, 0);
 		return result_bits;
 	}
 
-	feat_iter = list_iterator_create(details_ptr->feature_list);
-	while ((job_feat_ptr = (struct feature_record *)
-			list_next(feat_iter))) {
-		if ((job_feat_ptr->op_code == FEATURE_OP_XAND) ||
-		    (job_feat_ptr->op_code == FEATURE_OP_XOR)  ||
-		    (last_op == FEATURE_OP_XAND) ||
-		    (last_op == FEATURE_OP_XOR)) {
-			feat_ptr = list_find_first(feature_list,
-						   list_find_feature,
-						   (void *)job_feat_ptr->name);
-			if (feat_ptr &&
-			    bit_super_set(config_ptr->node_bitmap,
-					  feat_ptr->node_bitmap)) {
-				bit_set(result_bits, position);
-			}
-			position++;
+	for (position = 0; position < xor_cnt; position++) {
+		if (xor_feat[position] &&
+		    bit_super_set(config_ptr->node_bitmap,
+				  xor_feat[position]->node_bitmap)) {
+			bit_set(result_bits, position);
 		}
-		last_op = job_feat_ptr->op_code;
 	}
-	list_iterator_destroy(feat_iter);
 
 	return result_bits;
 }
@@ -38,7 +38,10 @@
 \*****************************************************************************/
 
 #include <pthread.h>
+#include <stdlib.h>
 
+#include "src/common/assoc_mgr.h"
+#include "src/common/bitstring.h"
 #include "src/common/log.h"
 #include "src/common/plugrack.h"
 #include "src/common/slurm_protocol_api.h"
@@ -46,6 +49,7 @@
 #include "src/common/xstring.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/job_scheduler.h"
+#include "src/slurmctld/preempt.h"
 
 
 /* ************************************************************************ */
@@ -74,6 +78,23 @@ static plugin_context_t *g_context = NULL;
 static pthread_mutex_t	    g_context_lock = PTHREAD_MUTEX_INITIALIZER;
 static bool init_run = false;
 
+/* Index of running and suspended jobs in preemption order, with the jobs
+ * allocated each node. Job IDs are kept so that entries for jobs which have
+ * since been purged can be detected without using the stale pointer. The
+ * index is rebuilt when nodes are allocated or released, or when partitions
+ * or QOS (whose priority may be the sort key) change. */
+static pthread_mutex_t	cand_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct job_record **cand_job_ptr = NULL;
+static uint32_t *cand_job_id = NULL;
+static int cand_job_cnt = 0;
+static int *cand_node_off = NULL;	/* node_record_count + 1 entries */
+static int *cand_node_job = NULL;	/* index into cand_job_ptr */
+static int cand_node_cnt = -1;
+static ListCmpF cand_sort = NULL;
+static uint32_t cand_alloc_gen = 0;
+static uint32_t cand_qos_cnt = 0;
+static time_t cand_part_time = (time_t) 0;
+
 /* *********************************************************************** */
 /*  TAG(                    _preempt_signal                             )  */
 /* *********************************************************************** */
@@ -168,6 +189,158 @@ done:
 	return retval;
 }
 
+static void _cand_free(void)
+{
+	xfree(cand_job_ptr);
+	xfree(cand_job_id);
+	xfree(cand_node_off);
+	xfree(cand_node_job);
+	cand_job_cnt = 0;
+	cand_node_cnt = -1;
+	cand_sort = NULL;
+	cand_part_time = (time_t) 0;
+}
+
+/* Rebuild the index of running and suspended jobs */
+static void _cand_build(ListCmpF sort_func)
+{
+	ListIterator job_iterator;
+	struct job_record *job_ptr;
+	int i, j, first, last, node_job_cnt = 0;
+
+	_cand_free();
+	cand_alloc_gen = node_alloc_gen;
+	cand_qos_cnt = assoc_mgr_qos_update_cnt;
+	cand_part_time = time(NULL);
+	cand_sort = sort_func;
+	cand_node_cnt = node_record_count;
+
+	cand_job_ptr = xmalloc(sizeof(struct job_record *) *
+			       (list_count(job_list) + 1));
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = (struct job_record *) list_next(job_iterator))) {
+		if (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr))
+			continue;
+		if (job_ptr->node_bitmap == NULL)
+			continue;
+		cand_job_ptr[cand_job_cnt++] = job_ptr;
+	}
+	list_iterator_destroy(job_iterator);
+	if (sort_func && (cand_job_cnt > 1)) {
+		qsort(cand_job_ptr, cand_job_cnt, sizeof(struct job_record *),
+		      (__compar_fn_t) sort_func);
+	}
+
+	/* Count the jobs on each node, then list them in preemption order */
+	cand_job_id = xmalloc(sizeof(uint32_t) * (cand_job_cnt + 1));
+	cand_node_off = xmalloc(sizeof(int) * (cand_node_cnt + 1));
+	for (i = 0; i < cand_job_cnt; i++) {
+		job_ptr = cand_job_ptr[i];
+		cand_job_id[i] = job_ptr->job_id;
+		first = bit_ffs(job_ptr->node_bitmap);
+		if (first == -1)
+			continue;
+		last = MIN(bit_fls(job_ptr->node_bitmap), cand_node_cnt - 1);
+		for (j = first; j <= last; j++) {
+			if (bit_test(job_ptr->node_bitmap, j)) {
+				cand_node_off[j + 1]++;
+				node_job_cnt++;
+			}
+		}
+	}
+	for (j = 0; j < cand_node_cnt; j++)
+		cand_node_off[j + 1] += cand_node_off[j];
+	cand_node_job = xmalloc(sizeof(int) * (node_job_cnt + 1));
+	for (i = 0; i < cand_job_cnt; i++) {
+		job_ptr = cand_job_ptr[i];
+		first = bit_ffs(job_ptr->node_bitmap);
+		if (first == -1)
+			continue;
+		last = MIN(bit_fls(job_ptr->node_bitmap), cand_node_cnt - 1);
+		for (j = first; j <= last; j++) {
+			if (bit_test(job_ptr->node_bitmap, j))
+				cand_node_job[cand_node_off[j]++] = i;
+		}
+	}
+	/* Each offset now marks the end of its node's jobs, shift them back */
+	for (j = cand_node_cnt; j > 0; j--)
+		cand_node_off[j] = cand_node_off[j - 1];
+	cand_node_off[0] = 0;
+}
+
+/* Return the indexed job if it is still running or suspended on any of the
+ * nodes in node_bitmap, otherwise NULL */
+static struct job_record *_cand_job(int inx, bitstr_t *node_bitmap)
+{
+	struct job_record *job_ptr;
+
+	job_ptr = find_job_record(cand_job_id[inx]);
+	if ((job_ptr == NULL) || (job_ptr != cand_job_ptr[inx]))
+		return NULL;	/* purged since the index was built */
+	if (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr))
+		return NULL;
+	if ((job_ptr->node_bitmap == NULL) ||
+	    (bit_overlap(job_ptr->node_bitmap, node_bitmap) == 0))
+		return NULL;
+	return job_ptr;
+}
+
+/*
+ * preempt_find_running_jobs - return a list of the running and suspended
+ *	jobs allocated any of the nodes in node_bitmap, sorted by sort_func
+ * NOTE: Only the jobs on the given nodes are examined, using an index of
+ *	jobs by node which is rebuilt as nodes are allocated and released
+ * NOTE: Returns NULL if no jobs are found
+ * NOTE: Caller must list_destroy() any list returned
+ */
+extern List preempt_find_running_jobs(bitstr_t *node_bitmap,
+				      ListCmpF sort_func)
+{
+	List job_cand_list = NULL;
+	struct job_record *job_ptr;
+	bitstr_t *cand_bitmap = NULL;
+	int i, j, k, node_cnt;
+
+	if (node_bitmap == NULL)
+		return NULL;
+
+	slurm_mutex_lock(&cand_lock);
+	if ((cand_node_cnt != node_record_count) || (cand_sort != sort_func) ||
+	    (cand_alloc_gen != node_alloc_gen) ||
+	    (cand_qos_cnt != assoc_mgr_qos_update_cnt) ||
+	    (last_part_update >= cand_part_time))
+		_cand_build(sort_func);
+	if (cand_job_cnt == 0)
+		goto fini;
+
+	node_cnt = bit_set_count(node_bitmap);
+	if (node_cnt < cand_node_cnt) {
+		/* Mark the jobs on these nodes, then take them in order */
+		cand_bitmap = bit_alloc(cand_job_cnt);
+		i = bit_ffs(node_bitmap);
+		j = MIN(bit_fls(node_bitmap), cand_node_cnt - 1);
+		for ( ; (i >= 0) && (i <= j); i++) {
+			if (!bit_test(node_bitmap, i))
+				continue;
+			for (k = cand_node_off[i]; k < cand_node_off[i+1]; k++)
+				bit_set(cand_bitmap, cand_node_job[k]);
+		}
+	}
+	for (i = 0; i < cand_job_cnt; i++) {
+		if (cand_bitmap && !bit_test(cand_bitmap, i))
+			continue;
+		if ((job_ptr = _cand_job(i, node_bitmap)) == NULL)
+			continue;
+		if (job_cand_list == NULL)
+			job_cand_list = list_create(NULL);
+		list_append(job_cand_list, job_ptr);
+	}
+	FREE_NULL_BITMAP(cand_bitmap);
+
+fini:	slurm_mutex_unlock(&cand_lock);
+	return job_cand_list;
+}
+
 /* *********************************************************************** */
 /*  TAG(                    slurm_preempt_fini                        )  */
 /* *********************************************************************** */
@@ -175,6 +348,10 @@ extern int slurm_preempt_fini(void)
 {
 	int rc;
 
+	slurm_mutex_lock(&cand_lock);
+	_cand_free();
+	slurm_mutex_unlock(&cand_lock);
+
 	if (!g_context)
 		return SLURM_SUCCESS;
 
@@ -58,6 +58,18 @@ int slurm_preempt_init(void);
  */
 extern int slurm_preempt_fini(void);
 
+/*
+ * preempt_find_running_jobs - return a list of the running and suspended
+ *	jobs allocated any of the nodes in node_bitmap, sorted by sort_func.
+ *	For use by the preempt plugins, which filter the list.
+ * NOTE: Only the jobs on the given nodes are examined, using an index of
+ *	jobs by node which is rebuilt as nodes are allocated and released
+ * NOTE: Returns NULL if no jobs are found
+ * NOTE: Caller must list_destroy() any list returned
+ */
+extern List preempt_find_running_jobs(bitstr_t *node_bitmap,
+				      ListCmpF sort_func);
+
 /*
  **************************************************************************
  *                          P L U G I N   C A L L S                       *
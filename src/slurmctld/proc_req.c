@@ -76,6 +76,7 @@
 #include "src/common/slurm_acct_gather.h"
 
 #include "src/slurmctld/agent.h"
+#include "src/slurmctld/event_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
 #include "src/slurmctld/job_scheduler.h"
@@ -95,8 +96,23 @@
 static pthread_mutex_t throttle_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t throttle_cond = PTHREAD_COND_INITIALIZER;
 
+/* Node registrations waiting to be validated. Concurrent registration RPCs
+ * are validated together by whichever of their threads takes the locks
+ * next, rather than each acquiring the node write lock in turn */
+typedef struct node_reg_req {
+	slurm_node_registration_status_msg_t *reg_msg;
+	int rc;
+	bool done;
+} node_reg_req_t;
+static pthread_mutex_t node_reg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  node_reg_cond = PTHREAD_COND_INITIALIZER;
+static List node_reg_queue = NULL;
+static bool node_reg_active = false;
+
 static void         _fill_ctld_conf(slurm_ctl_conf_t * build_ptr);
 static void         _kill_job_on_msg_fail(uint32_t job_id);
+static int          _node_registration(
+				slurm_node_registration_status_msg_t *reg_msg);
 static int          _is_prolog_finished(uint32_t job_id);
 static int 	    _launch_batch_step(job_desc_msg_t *job_desc_msg,
 				       uid_t uid, uint32_t *step_id);
@@ -119,10 +135,13 @@ inline static void  _slurm_rpc_complete_prolog(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_conf(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_front_end(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_jobs(slurm_msg_t * msg);
+inline static void  _slurm_rpc_dump_jobs_delta(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_jobs_user(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_job_single(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_nodes(slurm_msg_t * msg);
+inline static void  _slurm_rpc_dump_nodes_delta(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_node_single(slurm_msg_t * msg);
+inline static void  _slurm_rpc_dump_node_summary(slurm_msg_t * msg);
 inline static void  _slurm_rpc_dump_partitions(slurm_msg_t * msg);
 inline static void  _slurm_rpc_end_time(slurm_msg_t * msg);
 inline static void  _slurm_rpc_epilog_complete(slurm_msg_t * msg);
@@ -160,6 +179,8 @@ inline static void  _slurm_rpc_step_layout(slurm_msg_t * msg);
 inline static void  _slurm_rpc_step_update(slurm_msg_t * msg);
 inline static void  _slurm_rpc_submit_batch_job(slurm_msg_t * msg);
 inline static void  _slurm_rpc_suspend(slurm_msg_t * msg);
+inline static void  _slurm_rpc_event_subscribe(slurm_msg_t * msg);
+inline static void  _slurm_rpc_event_unsubscribe(slurm_msg_t * msg);
 inline static void  _slurm_rpc_trigger_clear(slurm_msg_t * msg);
 inline static void  _slurm_rpc_trigger_get(slurm_msg_t * msg);
 inline static void  _slurm_rpc_trigger_set(slurm_msg_t * msg);
@@ -239,6 +260,18 @@ void slurmctld_req (slurm_msg_t * msg)
 		_slurm_rpc_dump_node_single(msg);
 		slurm_free_node_info_single_msg(msg->data);
 		break;
+	case REQUEST_NODE_INFO_SUMMARY:
+		_slurm_rpc_dump_node_summary(msg);
+		slurm_free_node_info_request_msg(msg->data);
+		break;
+	case REQUEST_JOB_INFO_DELTA:
+		_slurm_rpc_dump_jobs_delta(msg);
+		slurm_free_delta_info_request_msg(msg->data);
+		break;
+	case REQUEST_NODE_INFO_DELTA:
+		_slurm_rpc_dump_nodes_delta(msg);
+		slurm_free_delta_info_request_msg(msg->data);
+		break;
 	case REQUEST_PARTITION_INFO:
 		_slurm_rpc_dump_partitions(msg);
 		slurm_free_part_info_request_msg(msg->data);
@@ -410,6 +443,14 @@ void slurmctld_req (slurm_msg_t * msg)
 		_slurm_rpc_trigger_set(msg);
 		slurm_free_trigger_msg(msg->data);
 		break;
+	case REQUEST_EVENT_SUBSCRIBE:
+		_slurm_rpc_event_subscribe(msg);
+		slurm_free_event_subscribe_msg(msg->data);
+		break;
+	case REQUEST_EVENT_UNSUBSCRIBE:
+		_slurm_rpc_event_unsubscribe(msg);
+		slurm_free_event_subscribe_msg(msg->data);
+		break;
 	case REQUEST_TRIGGER_GET:
 		_slurm_rpc_trigger_get(msg);
 		slurm_free_trigger_msg(msg->data);
@@ -697,6 +738,7 @@ void _fill_ctld_conf(slurm_ctl_conf_t * conf_ptr)
 	conf_ptr->slurmctld_timeout   = conf->slurmctld_timeout;
 	conf_ptr->slurmd_debug        = conf->slurmd_debug;
 	conf_ptr->slurmd_logfile      = xstrdup(conf->slurmd_logfile);
+	conf_ptr->slurmd_params       = xstrdup(conf->slurmd_params);
 	conf_ptr->slurmd_pidfile      = xstrdup(conf->slurmd_pidfile);
 	conf_ptr->slurmd_plugstack    = xstrdup(conf->slurmd_plugstack);
 	conf_ptr->slurmd_port         = conf->slurmd_port;
@@ -1090,6 +1132,53 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 	}
 }
 
+/* _slurm_rpc_dump_jobs_delta - process RPC for the job state information
+ *	changed since the client's copy was loaded */
+static void _slurm_rpc_dump_jobs_delta(slurm_msg_t * msg)
+{
+	DEF_TIMERS;
+	char *dump;
+	int dump_size, rc = SLURM_NO_CHANGE_IN_DATA;
+	slurm_msg_t response_msg;
+	delta_info_request_msg_t *delta_req_msg =
+		(delta_info_request_msg_t *) msg->data;
+	/* Locks: Read config job, write partition (for hiding) */
+	slurmctld_lock_t job_read_lock = {
+		READ_LOCK, READ_LOCK, NO_LOCK, WRITE_LOCK };
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+
+	START_TIMER;
+	debug3("Processing RPC: REQUEST_JOB_INFO_DELTA from uid=%d", uid);
+	lock_slurmctld(job_read_lock);
+
+	if (((delta_req_msg->last_update - 1) < last_job_update) ||
+	    ((delta_req_msg->last_update - 1) < last_part_update)) {
+		rc = pack_jobs_delta(&dump, &dump_size, delta_req_msg, uid,
+				     msg->protocol_version);
+	}
+	unlock_slurmctld(job_read_lock);
+
+	if (rc != SLURM_SUCCESS) {
+		debug3("_slurm_rpc_dump_jobs_delta: %s", slurm_strerror(rc));
+		slurm_send_rc_msg(msg, rc);
+	} else {
+		END_TIMER2("_slurm_rpc_dump_jobs_delta");
+
+		/* init response_msg structure */
+		slurm_msg_t_init(&response_msg);
+		response_msg.flags = msg->flags;
+		response_msg.protocol_version = msg->protocol_version;
+		response_msg.address = msg->address;
+		response_msg.msg_type = RESPONSE_JOB_INFO_DELTA;
+		response_msg.data = dump;
+		response_msg.data_size = dump_size;
+
+		/* send message */
+		slurm_send_node_msg(msg->conn_fd, &response_msg);
+		xfree(dump);
+	}
+}
+
 /* _slurm_rpc_dump_jobs - process RPC for job state information */
 static void _slurm_rpc_dump_jobs_user(slurm_msg_t * msg)
 {
@@ -1368,6 +1457,65 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 	}
 }
 
+/* _slurm_rpc_dump_nodes_delta - dump RPC for the node state information
+ *	changed since the client's copy was loaded */
+static void _slurm_rpc_dump_nodes_delta(slurm_msg_t * msg)
+{
+	DEF_TIMERS;
+	char *dump;
+	int dump_size, rc = SLURM_NO_CHANGE_IN_DATA;
+	slurm_msg_t response_msg;
+	delta_info_request_msg_t *delta_req_msg =
+		(delta_info_request_msg_t *) msg->data;
+	/* Locks: Read config, write node (reset allocated CPU count in some
+	 * select plugins), read partition */
+	slurmctld_lock_t node_write_lock = {
+		READ_LOCK, NO_LOCK, WRITE_LOCK, READ_LOCK };
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+
+	START_TIMER;
+	debug3("Processing RPC: REQUEST_NODE_INFO_DELTA from uid=%d", uid);
+	lock_slurmctld(node_write_lock);
+
+	if ((slurmctld_conf.private_data & PRIVATE_DATA_NODES) &&
+	    (!validate_operator(uid))) {
+		unlock_slurmctld(node_write_lock);
+		error("Security violation, REQUEST_NODE_INFO_DELTA RPC from "
+		      "uid=%d", uid);
+		slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
+		return;
+	}
+
+	select_g_select_nodeinfo_set_all();
+
+	if (((delta_req_msg->last_update - 1) < last_node_update) ||
+	    ((delta_req_msg->last_update - 1) < last_part_update)) {
+		rc = pack_node_delta(&dump, &dump_size, delta_req_msg, uid,
+				     msg->protocol_version);
+	}
+	unlock_slurmctld(node_write_lock);
+
+	if (rc != SLURM_SUCCESS) {
+		debug3("_slurm_rpc_dump_nodes_delta: %s", slurm_strerror(rc));
+		slurm_send_rc_msg(msg, rc);
+	} else {
+		END_TIMER2("_slurm_rpc_dump_nodes_delta");
+
+		/* init response_msg structure */
+		slurm_msg_t_init(&response_msg);
+		response_msg.flags = msg->flags;
+		response_msg.protocol_version = msg->protocol_version;
+		response_msg.address = msg->address;
+		response_msg.msg_type = RESPONSE_NODE_INFO_DELTA;
+		response_msg.data = dump;
+		response_msg.data_size = dump_size;
+
+		/* send message */
+		slurm_send_node_msg(msg->conn_fd, &response_msg);
+		xfree(dump);
+	}
+}
+
 /* _slurm_rpc_dump_node_single - done RPC state information for one node */
 static void _slurm_rpc_dump_node_single(slurm_msg_t * msg)
 {
@@ -1423,6 +1571,63 @@ static void _slurm_rpc_dump_node_single(slurm_msg_t * msg)
 	xfree(dump);
 }
 
+/* _slurm_rpc_dump_node_summary - dump RPC for nodes grouped by partition,
+ *	state and features */
+static void _slurm_rpc_dump_node_summary(slurm_msg_t * msg)
+{
+	DEF_TIMERS;
+	char *dump;
+	int dump_size;
+	slurm_msg_t response_msg;
+	node_info_request_msg_t *node_req_msg =
+		(node_info_request_msg_t *) msg->data;
+	/* Locks: Read config, write node (reset allocated CPU count in some
+	 * select plugins), read partition */
+	slurmctld_lock_t node_write_lock = {
+		READ_LOCK, NO_LOCK, WRITE_LOCK, READ_LOCK };
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+
+	START_TIMER;
+	debug3("Processing RPC: REQUEST_NODE_INFO_SUMMARY from uid=%d", uid);
+	lock_slurmctld(node_write_lock);
+
+	if ((slurmctld_conf.private_data & PRIVATE_DATA_NODES) &&
+	    (!validate_operator(uid))) {
+		unlock_slurmctld(node_write_lock);
+		error("Security violation, REQUEST_NODE_INFO_SUMMARY RPC from "
+		      "uid=%d", uid);
+		slurm_send_rc_msg(msg, ESLURM_ACCESS_DENIED);
+		return;
+	}
+
+	select_g_select_nodeinfo_set_all();
+
+	if (((node_req_msg->last_update - 1) >= last_node_update) &&
+	    ((node_req_msg->last_update - 1) >= last_part_update)) {
+		unlock_slurmctld(node_write_lock);
+		debug3("_slurm_rpc_dump_node_summary, no change");
+		slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
+	} else {
+		pack_node_summary(&dump, &dump_size, node_req_msg->show_flags,
+				  uid, msg->protocol_version);
+		unlock_slurmctld(node_write_lock);
+		END_TIMER2("_slurm_rpc_dump_node_summary");
+
+		/* init response_msg structure */
+		slurm_msg_t_init(&response_msg);
+		response_msg.flags = msg->flags;
+		response_msg.protocol_version = msg->protocol_version;
+		response_msg.address = msg->address;
+		response_msg.msg_type = RESPONSE_NODE_INFO_SUMMARY;
+		response_msg.data = dump;
+		response_msg.data_size = dump_size;
+
+		/* send message */
+		slurm_send_node_msg(msg->conn_fd, &response_msg);
+		xfree(dump);
+	}
+}
+
 /* _slurm_rpc_dump_partitions - process RPC for partition state information */
 static void _slurm_rpc_dump_partitions(slurm_msg_t * msg)
 {
@@ -2191,6 +2396,74 @@ static void _slurm_rpc_job_will_run(slurm_msg_t * msg)
 	xfree(err_msg);
 }
 
+/* Validate a node's registration, together with any other registrations
+ * which arrived while the locks were held for an earlier batch */
+static int _node_registration(slurm_node_registration_status_msg_t *reg_msg)
+{
+	node_reg_req_t req, **reqs;
+	slurm_node_registration_status_msg_t **reg_msgs;
+	int *rc, i, reg_cnt;
+	List batch;
+	ListIterator iter;
+	/* Locks: Read config, write job, write node */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK };
+
+	req.reg_msg = reg_msg;
+	req.rc = SLURM_SUCCESS;
+	req.done = false;
+
+	slurm_mutex_lock(&node_reg_mutex);
+	if (!node_reg_queue)
+		node_reg_queue = list_create(NULL);
+	list_append(node_reg_queue, &req);
+	while (!req.done && node_reg_active)
+		pthread_cond_wait(&node_reg_cond, &node_reg_mutex);
+	if (req.done) {
+		slurm_mutex_unlock(&node_reg_mutex);
+		return req.rc;
+	}
+
+	/* Validate every registration queued so far, including our own */
+	node_reg_active = true;
+	batch = node_reg_queue;
+	node_reg_queue = list_create(NULL);
+	slurm_mutex_unlock(&node_reg_mutex);
+
+	reg_cnt  = list_count(batch);
+	reqs     = xmalloc(sizeof(node_reg_req_t *) * reg_cnt);
+	reg_msgs = xmalloc(sizeof(slurm_node_registration_status_msg_t *) *
+			   reg_cnt);
+	rc       = xmalloc(sizeof(int) * reg_cnt);
+	iter = list_iterator_create(batch);
+	for (i = 0; i < reg_cnt; i++) {
+		reqs[i] = (node_reg_req_t *) list_next(iter);
+		reg_msgs[i] = reqs[i]->reg_msg;
+	}
+	list_iterator_destroy(iter);
+	list_destroy(batch);
+
+	lock_slurmctld(job_write_lock);
+	validate_node_reg_msgs(reg_cnt, reg_msgs, rc);
+	unlock_slurmctld(job_write_lock);
+	if (reg_cnt > 1)
+		debug2("validated %d node registrations together", reg_cnt);
+
+	slurm_mutex_lock(&node_reg_mutex);
+	for (i = 0; i < reg_cnt; i++) {
+		reqs[i]->rc = rc[i];
+		reqs[i]->done = true;
+	}
+	node_reg_active = false;
+	pthread_cond_broadcast(&node_reg_cond);
+	slurm_mutex_unlock(&node_reg_mutex);
+
+	xfree(reqs);
+	xfree(reg_msgs);
+	xfree(rc);
+	return req.rc;
+}
+
 /* _slurm_rpc_node_registration - process RPC to determine if a node's
  *	actual configuration satisfies the configured specification */
 static void _slurm_rpc_node_registration(slurm_msg_t * msg)
@@ -2200,9 +2473,6 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg)
 	int error_code = SLURM_SUCCESS;
 	slurm_node_registration_status_msg_t *node_reg_stat_msg =
 		(slurm_node_registration_status_msg_t *) msg->data;
-	/* Locks: Read config, write job, write node */
-	slurmctld_lock_t job_write_lock = {
-		READ_LOCK, WRITE_LOCK, WRITE_LOCK, NO_LOCK };
 	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
 
 	START_TIMER;
@@ -2214,25 +2484,7 @@ static void _slurm_rpc_node_registration(slurm_msg_t * msg)
 	}
 	if (error_code == SLURM_SUCCESS) {
 		/* do RPC call */
-		if (!(slurmctld_conf.debug_flags & DEBUG_FLAG_NO_CONF_HASH) &&
-		    (node_reg_stat_msg->hash_val != NO_VAL) &&
-		    (node_reg_stat_msg->hash_val != slurm_get_hash_val())) {
-			error("Node %s appears to have a different slurm.conf "
-			      "than the slurmctld.  This could cause issues "
-			      "with communication and functionality.  "
-			      "Please review both files and make sure they "
-			      "are the same.  If this is expected ignore, and "
-			      "set DebugFlags=NO_CONF_HASH in your slurm.conf.",
-			      node_reg_stat_msg->node_name);
-		}
-		lock_slurmctld(job_write_lock);
-#ifdef HAVE_FRONT_END		/* Operates only on front-end */
-		error_code = validate_nodes_via_front_end(node_reg_stat_msg);
-#else
-		validate_jobs_on_node(node_reg_stat_msg);
-		error_code = validate_node_specs(node_reg_stat_msg);
-#endif
-		unlock_slurmctld(job_write_lock);
+		error_code = _node_registration(node_reg_stat_msg);
 		END_TIMER2("_slurm_rpc_node_registration");
 	}
 
@@ -4191,6 +4443,54 @@ int _launch_batch_step(job_desc_msg_t *job_desc_msg, uid_t uid,
 	return SLURM_SUCCESS;
 }
 
+inline static void  _slurm_rpc_event_subscribe(slurm_msg_t * msg)
+{
+	int rc;
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	event_subscribe_msg_t *sub_ptr = (event_subscribe_msg_t *) msg->data;
+	slurm_addr_t resp_addr;
+	slurm_msg_t response_msg;
+	DEF_TIMERS;
+
+	START_TIMER;
+	debug("Processing RPC: REQUEST_EVENT_SUBSCRIBE from uid=%d", uid);
+
+	/* Events go back to the host the request came from */
+	if (slurm_get_peer_addr(msg->conn_fd, &resp_addr))
+		rc = errno;
+	else
+		rc = event_subscribe(uid, &resp_addr, sub_ptr);
+	END_TIMER2("_slurm_rpc_event_subscribe");
+
+	if (rc) {
+		slurm_send_rc_msg(msg, rc);
+		return;
+	}
+	slurm_msg_t_init(&response_msg);
+	response_msg.flags = msg->flags;
+	response_msg.protocol_version = msg->protocol_version;
+	response_msg.address  = msg->address;
+	response_msg.msg_type = RESPONSE_EVENT_SUBSCRIBE;
+	response_msg.data     = sub_ptr;
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+}
+
+inline static void  _slurm_rpc_event_unsubscribe(slurm_msg_t * msg)
+{
+	int rc;
+	uid_t uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	event_subscribe_msg_t *sub_ptr = (event_subscribe_msg_t *) msg->data;
+	DEF_TIMERS;
+
+	START_TIMER;
+	debug("Processing RPC: REQUEST_EVENT_UNSUBSCRIBE from uid=%d", uid);
+
+	rc = event_unsubscribe(uid, sub_ptr);
+	END_TIMER2("_slurm_rpc_event_unsubscribe");
+
+	slurm_send_rc_msg(msg, rc);
+}
+
 inline static void  _slurm_rpc_trigger_clear(slurm_msg_t * msg)
 {
 	int rc;
@@ -59,6 +59,7 @@
 #include <unistd.h>
 
 #include "src/common/assoc_mgr.h"
+#include "src/common/conn_cache.h"
 #include "src/common/gres.h"
 #include "src/common/hostlist.h"
 #include "src/common/list.h"
@@ -948,6 +949,7 @@ int read_slurm_conf(int recover, bool reconfig)
 	rehash_node();
 	rehash_jobs();
 	set_slurmd_addr();
+	conn_cache_init();	/* SlurmdParameters may have changed */
 
 	_stat_slurm_dirs();
 	if (reconfig) {		/* Preserve state from memory */
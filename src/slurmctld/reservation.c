@@ -109,6 +109,17 @@ uint32_t  top_suffix = 0;
 uint32_t  cnodes_per_bp = 0;
 #endif
 
+/* Reservations sorted by start time and by name. Rebuilt when first used
+ * after resv_index_valid is cleared, which must be done whenever a
+ * reservation is added, removed or has its start or end time changed. */
+static slurmctld_resv_t **resv_by_name = NULL;
+static slurmctld_resv_t **resv_by_start = NULL;
+static int    resv_index_cnt = 0;
+static int    resv_index_size = 0;
+static bool   resv_index_valid = false;
+static time_t resv_index_next_advance = (time_t) 0;
+
+static void _advance_resv_index(time_t now);
 static void _advance_resv_time(slurmctld_resv_t *resv_ptr);
 static void _advance_time(time_t *res_time, int day_cnt);
 static int  _build_account_list(char *accounts, int *account_cnt,
@@ -121,6 +132,7 @@ static void _del_resv_rec(void *x);
 static void _dump_resv_req(resv_desc_msg_t *resv_ptr, char *mode);
 static int  _find_resv_id(void *x, void *key);
 static int  _find_resv_name(void *x, void *key);
+static slurmctld_resv_t *_find_resv_ptr(char *resv_name);
 static void *_fork_script(void *x);
 static void _free_script_arg(resv_thread_args_t *args);
 static void _generate_resv_id(void);
@@ -148,9 +160,13 @@ static int  _post_resv_update(slurmctld_resv_t *resv_ptr,
 static int  _resize_resv(slurmctld_resv_t *resv_ptr, uint32_t node_cnt);
 static void _restore_resv(slurmctld_resv_t *dest_resv,
 			  slurmctld_resv_t *src_resv);
+static void _resv_index_build(void);
+static int  _resv_index_start(time_t start_time);
+static int  _resv_name_cmp(const void *x, const void *y);
 static bool _resv_overlap(time_t start_time, time_t end_time,
 			  uint16_t flags, bitstr_t *node_bitmap,
 			  slurmctld_resv_t *this_resv_ptr);
+static int  _resv_start_cmp(const void *x, const void *y);
 static void _run_script(char *script, slurmctld_resv_t *resv_ptr);
 static int  _select_nodes(resv_desc_msg_t *resv_desc_ptr,
 			  struct part_record **part_ptr,
@@ -404,6 +420,120 @@ static int _find_resv_name(void *x, void *key)
 		return 1;	/* match */
 }
 
+static int _resv_name_cmp(const void *x, const void *y)
+{
+	slurmctld_resv_t *resv1_ptr = *(slurmctld_resv_t **) x;
+	slurmctld_resv_t *resv2_ptr = *(slurmctld_resv_t **) y;
+
+	return strcmp(resv1_ptr->name, resv2_ptr->name);
+}
+
+static int _resv_start_cmp(const void *x, const void *y)
+{
+	slurmctld_resv_t *resv1_ptr = *(slurmctld_resv_t **) x;
+	slurmctld_resv_t *resv2_ptr = *(slurmctld_resv_t **) y;
+
+	if (resv1_ptr->start_time < resv2_ptr->start_time)
+		return -1;
+	if (resv1_ptr->start_time > resv2_ptr->start_time)
+		return 1;
+	return 0;
+}
+
+/* Rebuild the reservation indexes if they are out of date. Also note when
+ * the first daily or weekly reservation ends, so that it can be advanced */
+static void _resv_index_build(void)
+{
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+
+	if (resv_index_valid)
+		return;
+
+	resv_index_cnt = 0;
+	resv_index_next_advance = (time_t) 0;
+	if (resv_list) {
+		if (resv_index_size < list_count(resv_list)) {
+			resv_index_size = list_count(resv_list) + 16;
+			xrealloc(resv_by_name, sizeof(slurmctld_resv_t *) *
+					       resv_index_size);
+			xrealloc(resv_by_start, sizeof(slurmctld_resv_t *) *
+						resv_index_size);
+		}
+		iter = list_iterator_create(resv_list);
+		while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
+			resv_by_name[resv_index_cnt]  = resv_ptr;
+			resv_by_start[resv_index_cnt] = resv_ptr;
+			resv_index_cnt++;
+			if (!(resv_ptr->flags & (RESERVE_FLAG_DAILY |
+						 RESERVE_FLAG_WEEKLY)))
+				continue;
+			if ((resv_index_next_advance == 0) ||
+			    (resv_index_next_advance > resv_ptr->end_time))
+				resv_index_next_advance = resv_ptr->end_time;
+		}
+		list_iterator_destroy(iter);
+	}
+	qsort(resv_by_name, resv_index_cnt, sizeof(slurmctld_resv_t *),
+	      _resv_name_cmp);
+	qsort(resv_by_start, resv_index_cnt, sizeof(slurmctld_resv_t *),
+	      _resv_start_cmp);
+	resv_index_valid = true;
+}
+
+/* Advance any daily or weekly reservation which has ended, then bring the
+ * reservation indexes up to date */
+static void _advance_resv_index(time_t now)
+{
+	int i;
+
+	_resv_index_build();
+	if ((resv_index_next_advance == 0) || (resv_index_next_advance > now))
+		return;
+	for (i = 0; i < resv_index_cnt; i++) {
+		if (resv_by_start[i]->end_time <= now)
+			_advance_resv_time(resv_by_start[i]);
+	}
+	resv_index_valid = false;
+	_resv_index_build();
+}
+
+/* Return the index of the first reservation in resv_by_start which starts
+ * after start_time, call _resv_index_build() first */
+static int _resv_index_start(time_t start_time)
+{
+	int lo = 0, hi = resv_index_cnt, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (resv_by_start[mid]->start_time <= start_time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* Return pointer to the named reservation or NULL if not found */
+static slurmctld_resv_t *_find_resv_ptr(char *resv_name)
+{
+	int lo = 0, hi, mid, rc;
+
+	_resv_index_build();
+	hi = resv_index_cnt;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		rc = strcmp(resv_by_name[mid]->name, resv_name);
+		if (rc == 0)
+			return resv_by_name[mid];
+		if (rc < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return NULL;
+}
+
 static void _dump_resv_req(resv_desc_msg_t *resv_ptr, char *mode)
 {
 
@@ -1898,6 +2028,7 @@ extern int create_resv(resv_desc_msg_t *resv_desc_ptr)
 	     resv_ptr->name, name1, val1, name2, val2,
 	     resv_ptr->node_list, start_time, end_time);
 	list_append(resv_list, resv_ptr);
+	resv_index_valid = false;
 	last_resv_update = now;
 	schedule_resv_save();
 
@@ -1922,6 +2053,11 @@ extern void resv_fini(void)
 		list_destroy(resv_list);
 		resv_list = (List) NULL;
 	}
+	xfree(resv_by_name);
+	xfree(resv_by_start);
+	resv_index_cnt = 0;
+	resv_index_size = 0;
+	resv_index_valid = false;
 }
 
 /* Update an exiting resource reservation */
@@ -1953,6 +2089,7 @@ extern int update_resv(resv_desc_msg_t *resv_desc_ptr)
 
 	/* Make backup to restore state in case of failure */
 	resv_backup = _copy_resv(resv_ptr);
+	resv_index_valid = false;
 
 	/* Process the request */
 	if (resv_desc_ptr->flags != (uint16_t) NO_VAL) {
@@ -2318,6 +2455,7 @@ extern int delete_resv(reservation_name_msg_t *resv_desc_ptr)
 		rc = _post_resv_delete(resv_ptr);
 		_clear_job_resv(resv_ptr);
 		list_delete_item(iter);
+		resv_index_valid = false;
 		break;
 	}
 	list_iterator_destroy(iter);
@@ -2336,10 +2474,7 @@ extern int delete_resv(reservation_name_msg_t *resv_desc_ptr)
 /* Return pointer to the named reservation or NULL if not found */
 extern slurmctld_resv_t *find_resv_name(char *resv_name)
 {
-	slurmctld_resv_t *resv_ptr;
-	resv_ptr = (slurmctld_resv_t *) list_find_first (resv_list,
-			_find_resv_name, resv_name);
-	return resv_ptr;
+	return _find_resv_ptr(resv_name);
 }
 
 /* Dump the reservation records to a buffer */
@@ -2595,6 +2730,7 @@ static void _validate_all_reservations(void)
 			_post_resv_delete(resv_ptr);
 			_clear_job_resv(resv_ptr);
 			list_delete_item(iter);
+			resv_index_valid = false;
 		} else {
 			_set_assoc_list(resv_ptr);
 			tmp = strrchr(resv_ptr->name, '_');
@@ -2614,10 +2750,8 @@ static void _validate_all_reservations(void)
 
 		if ((job_ptr->resv_ptr == NULL) ||
 		    (job_ptr->resv_ptr->magic != RESV_MAGIC)) {
-			job_ptr->resv_ptr = (slurmctld_resv_t *)
-					list_find_first(resv_list,
-							_find_resv_name,
-							job_ptr->resv_name);
+			job_ptr->resv_ptr = _find_resv_ptr(job_ptr->
+							   resv_name);
 		}
 		if (!job_ptr->resv_ptr) {
 			error("JobId %u linked to defunct reservation %s",
@@ -2734,6 +2868,7 @@ extern int load_all_resv_state(int recover)
 	uint16_t protocol_version = (uint16_t) NO_VAL;
 
 	last_resv_update = time(NULL);
+	resv_index_valid = false;
 	if ((recover == 0) && resv_list) {
 		_validate_all_reservations();
 		return SLURM_SUCCESS;
@@ -2852,8 +2987,7 @@ extern int validate_job_resv(struct job_record *job_ptr)
 		return ESLURM_RESERVATION_INVALID;
 
 	/* Find the named reservation */
-	resv_ptr = (slurmctld_resv_t *) list_find_first (resv_list,
-			_find_resv_name, job_ptr->resv_name);
+	resv_ptr = _find_resv_ptr(job_ptr->resv_name);
 	if (!resv_ptr) {
 		info("Reservation name not found (%s)", job_ptr->resv_name);
 		return ESLURM_RESERVATION_INVALID;
@@ -3012,8 +3146,6 @@ static int  _select_nodes(resv_desc_msg_t *resv_desc_ptr,
 		char *sep_ptr, *token = features;
 		bitstr_t *feature_bitmap = bit_copy(node_bitmap);
 		struct features_record *feature_ptr;
-		ListIterator feature_iter;
-		bool match;
 
 		while (1) {
 			for (i=0; ; i++) {
@@ -3034,12 +3166,8 @@ static int  _select_nodes(resv_desc_msg_t *resv_desc_ptr,
 				}
 			}
 
-			match = false;
-			feature_iter = list_iterator_create(feature_list);
-			while ((feature_ptr = (struct features_record *)
-					list_next(feature_iter))) {
-				if (strcmp(token, feature_ptr->name))
-					continue;
+			feature_ptr = find_feature_record(token);
+			if (feature_ptr) {
 				if (last_op_code == FEATURE_OP_OR) {
 					bit_or(feature_bitmap,
 					       feature_ptr->node_bitmap);
@@ -3047,11 +3175,7 @@ static int  _select_nodes(resv_desc_msg_t *resv_desc_ptr,
 					bit_and(feature_bitmap,
 						feature_ptr->node_bitmap);
 				}
-				match = true;
-				break;
-			}
-			list_iterator_destroy(feature_iter);
-			if (!match) {
+			} else {
 				info("reservation feature invalid: %s", token);
 				rc = ESLURM_INVALID_FEATURE;
 				bit_nclear(feature_bitmap, 0,
@@ -3485,8 +3609,7 @@ extern int job_test_resv_now(struct job_record *job_ptr)
 	if (job_ptr->resv_name == NULL)
 		return SLURM_SUCCESS;
 
-	resv_ptr = (slurmctld_resv_t *) list_find_first (resv_list,
-			_find_resv_name, job_ptr->resv_name);
+	resv_ptr = _find_resv_ptr(job_ptr->resv_name);
 	job_ptr->resv_ptr = resv_ptr;
 	if (!resv_ptr)
 		return ESLURM_RESERVATION_INVALID;
@@ -3515,21 +3638,19 @@ extern int job_test_resv_now(struct job_record *job_ptr)
  *	reserved resources. Don't go below job's time_min value. */
 extern void job_time_adj_resv(struct job_record *job_ptr)
 {
-	ListIterator iter;
 	slurmctld_resv_t * resv_ptr;
 	time_t now = time(NULL);
 	int32_t resv_begin_time;
+	int i;
 
-	iter = list_iterator_create(resv_list);
-	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
-		if (resv_ptr->end_time <= now)
-			_advance_resv_time(resv_ptr);
+	/* Reservations which started already have been validated */
+	_advance_resv_index(now);
+	for (i = _resv_index_start(now); i < resv_index_cnt; i++) {
+		resv_ptr = resv_by_start[i];
+		if (resv_ptr->start_time >= job_ptr->end_time)
+			break;		/* reservation starts after job ends */
 		if (job_ptr->resv_ptr == resv_ptr)
 			continue;	/* authorized user of reservation */
-		if (resv_ptr->start_time <= now)
-			continue;	/* already validated */
-		if (resv_ptr->start_time >= job_ptr->end_time)
-			continue;	/* reservation starts after job ends */
 		if (!license_list_overlap(job_ptr->license_list,
 					  resv_ptr->license_list) &&
 		    ((resv_ptr->node_bitmap == NULL) ||
@@ -3539,7 +3660,6 @@ extern void job_time_adj_resv(struct job_record *job_ptr)
 		resv_begin_time = difftime(resv_ptr->start_time, now) / 60;
 		job_ptr->time_limit = MIN(job_ptr->time_limit,resv_begin_time);
 	}
-	list_iterator_destroy(iter);
 	job_ptr->time_limit = MAX(job_ptr->time_limit, job_ptr->time_min);
 	job_ptr->end_time = job_ptr->start_time + (job_ptr->time_limit * 60);
 }
@@ -3606,17 +3726,16 @@ extern int job_test_lic_resv(struct job_record *job_ptr, char *lic_name,
 {
 	slurmctld_resv_t * resv_ptr;
 	time_t job_start_time, job_end_time, now = time(NULL);
-	ListIterator iter;
-	int resv_cnt = 0;
+	int i, resv_cnt = 0;
 
 	job_start_time = when;
 	job_end_time   = when + _get_job_duration(job_ptr);
-	iter = list_iterator_create(resv_list);
-	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
-		if (resv_ptr->end_time <= now)
-			_advance_resv_time(resv_ptr);
-		if ((resv_ptr->start_time >= job_end_time) ||
-		    (resv_ptr->end_time   <= job_start_time))
+	_advance_resv_index(now);
+	for (i = 0; i < resv_index_cnt; i++) {
+		resv_ptr = resv_by_start[i];
+		if (resv_ptr->start_time >= job_end_time)
+			break;		/* this and later reservations */
+		if (resv_ptr->end_time <= job_start_time)
 			continue;	/* reservation at different time */
 
 		if (job_ptr->resv_name &&
@@ -3625,7 +3744,6 @@ extern int job_test_lic_resv(struct job_record *job_ptr, char *lic_name,
 
 		resv_cnt += _license_cnt(resv_ptr->license_list, lic_name);
 	}
-	list_iterator_destroy(iter);
 
 	/* info("job %u blocked from %d licenses of type %s",
 	     job_ptr->job_id, resv_cnt, lic_name); */
@@ -3656,23 +3774,20 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 	slurmctld_resv_t * resv_ptr, *res2_ptr;
 	time_t job_start_time, job_end_time, lic_resv_time;
 	time_t now = time(NULL);
-	ListIterator iter;
-	int i, rc = SLURM_SUCCESS;
+	int i, j, rc = SLURM_SUCCESS;
 
 	job_start_time = *when;
 	job_end_time   = *when + _get_job_duration(job_ptr);
 	*node_bitmap = (bitstr_t *) NULL;
 
+	_advance_resv_index(now);
 	if (job_ptr->resv_name) {
-		resv_ptr = (slurmctld_resv_t *) list_find_first (resv_list,
-				_find_resv_name, job_ptr->resv_name);
+		resv_ptr = _find_resv_ptr(job_ptr->resv_name);
 		job_ptr->resv_ptr = resv_ptr;
 		if (!resv_ptr)
 			return ESLURM_RESERVATION_INVALID;
 		if (_valid_job_access_resv(job_ptr, resv_ptr) != SLURM_SUCCESS)
 			return ESLURM_RESERVATION_ACCESS;
-		if (resv_ptr->end_time <= now)
-			_advance_resv_time(resv_ptr);
 		if (*when < resv_ptr->start_time) {
 			/* reservation starts later */
 			*when = resv_ptr->start_time;
@@ -3708,21 +3823,19 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 
 		/* if there are any overlapping reservations, we need to
 		 * prevent the job from using those nodes (e.g. MAINT nodes) */
-		iter = list_iterator_create(resv_list);
-		while ((res2_ptr = (slurmctld_resv_t *) list_next(iter))) {
+		for (j = 0; j < resv_index_cnt; j++) {
+			res2_ptr = resv_by_start[j];
 			if ((resv_ptr->flags & RESERVE_FLAG_MAINT) ||
 			    (resv_ptr->flags & RESERVE_FLAG_OVERLAP) ||
-			    (res2_ptr == resv_ptr) ||
+			    (res2_ptr->start_time >= job_end_time))
+				break;
+			if ((res2_ptr == resv_ptr) ||
 			    (res2_ptr->node_bitmap == NULL) ||
-			    (res2_ptr->start_time >= job_end_time) ||
 			    (res2_ptr->end_time   <= job_start_time) ||
 			    (!res2_ptr->full_nodes))
 				continue;
-			bit_not(res2_ptr->node_bitmap);
-			bit_and(*node_bitmap, res2_ptr->node_bitmap);
-			bit_not(res2_ptr->node_bitmap);
+			bit_and_not(*node_bitmap, res2_ptr->node_bitmap);
 		}
-		list_iterator_destroy(iter);
 
 		if (slurmctld_conf.debug_flags & DEBUG_FLAG_RESERVATION) {
 			char *nodes = bitmap2node_name(*node_bitmap);
@@ -3744,7 +3857,7 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 	job_ptr->resv_ptr = NULL;	/* should be redundant */
 	*node_bitmap = bit_alloc(node_record_count);
 	bit_nset(*node_bitmap, 0, (node_record_count - 1));
-	if (list_count(resv_list) == 0)
+	if (resv_index_cnt == 0)
 		return SLURM_SUCCESS;
 
 	/* Job has no reservation, try to find time when this can
@@ -3752,12 +3865,11 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 	for (i=0; ; i++) {
 		lic_resv_time = (time_t) 0;
 
-		iter = list_iterator_create(resv_list);
-		while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
-			if (resv_ptr->end_time <= now)
-				_advance_resv_time(resv_ptr);
+		for (j = 0; j < resv_index_cnt; j++) {
+			resv_ptr = resv_by_start[j];
+			if (resv_ptr->start_time >= job_end_time)
+				break;	/* this and later reservations */
 			if ((resv_ptr->node_bitmap == NULL) ||
-			    (resv_ptr->start_time >= job_end_time) ||
 			    (resv_ptr->end_time   <= job_start_time))
 				continue;
 			if (job_ptr->details->req_node_bitmap &&
@@ -3785,9 +3897,8 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 				info("reservation uses full nodes or job will "
 				     "not share nodes");
 #endif
-				bit_not(resv_ptr->node_bitmap);
-				bit_and(*node_bitmap, resv_ptr->node_bitmap);
-				bit_not(resv_ptr->node_bitmap);
+				bit_and_not(*node_bitmap,
+					    resv_ptr->node_bitmap);
 			} else {
 #if _DEBUG
 				info("job_test_resv: %s reservation uses "
@@ -3802,7 +3913,6 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
 				}
 			}
 		}
-		list_iterator_destroy(iter);
 
 		if ((rc == SLURM_SUCCESS) && move_time) {
 			if (license_job_test(job_ptr, job_start_time)
@@ -3837,22 +3947,22 @@ extern int job_test_resv(struct job_record *job_ptr, time_t *when,
  */
 extern time_t find_resv_end(time_t start_time)
 {
-	ListIterator iter;
 	slurmctld_resv_t *resv_ptr;
 	time_t end_time = 0;
+	int i, last;
 
 	if (!resv_list)
 		return end_time;
 
-	iter = list_iterator_create(resv_list);
-	while ((resv_ptr = (slurmctld_resv_t *) list_next(iter))) {
-		if ((start_time < resv_ptr->start_time) ||
-		    (start_time > resv_ptr->end_time))
+	_resv_index_build();
+	last = _resv_index_start(start_time);
+	for (i = 0; i < last; i++) {
+		resv_ptr = resv_by_start[i];
+		if (start_time > resv_ptr->end_time)
 			continue;
 		if ((end_time == 0) || (resv_ptr->end_time < end_time))
 			end_time = resv_ptr->end_time;
 	}
-	list_iterator_destroy(iter);
 	return end_time;
 }
 
@@ -3936,6 +4046,7 @@ static void _advance_resv_time(slurmctld_resv_t *resv_ptr)
 		resv_ptr->start_time_first = resv_ptr->start_time;
 		_advance_time(&resv_ptr->end_time, day_cnt);
 		_post_resv_create(resv_ptr);
+		resv_index_valid = false;
 		last_resv_update = time(NULL);
 		schedule_resv_save();
 	}
@@ -4064,6 +4175,7 @@ extern void fini_job_resv_check(void)
 			}
 			_clear_job_resv(resv_ptr);
 			list_delete_item(iter);
+			resv_index_valid = false;
 			last_resv_update = now;
 			schedule_resv_save();
 		}
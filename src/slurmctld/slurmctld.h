@@ -206,6 +206,22 @@ typedef struct diag_stats {
 	uint32_t bf_queue_len_sum;
 	time_t   bf_when_last_cycle;
 	uint32_t bf_active;
+
+	uint32_t job_submit_cnt;	/* job_submit plugin calls */
+	uint32_t job_submit_time_max;	/* microseconds */
+	uint32_t job_submit_time_sum;	/* microseconds */
+	uint32_t job_modify_cnt;
+	uint32_t job_modify_time_max;
+	uint32_t job_modify_time_sum;
+
+	uint32_t acct_limit_eval_cnt;	/* full accounting limit tests */
+	uint32_t acct_limit_eval_last;	/* in last main scheduling cycle */
+	uint32_t acct_limit_cached_cnt;	/* jobs held on cached limits */
+
+	uint32_t gang_cycle_counter;	/* gang timeslicer cycles */
+	uint32_t gang_cycle_last;	/* microseconds */
+	uint32_t gang_cycle_max;	/* microseconds */
+	uint32_t gang_cycle_sum;	/* microseconds */
 } diag_stats_t;
 
 extern diag_stats_t slurmctld_diag_stats;
@@ -247,6 +263,7 @@ extern bitstr_t *idle_node_bitmap;	/* bitmap of idle nodes */
 extern bitstr_t *power_node_bitmap;	/* Powered down nodes */
 extern bitstr_t *share_node_bitmap;	/* bitmap of sharable nodes */
 extern bitstr_t *up_node_bitmap;	/* bitmap of up nodes, not DOWN */
+extern uint32_t node_alloc_gen;		/* bumped as jobs' nodes change */
 
 /*****************************************************************************\
  *  FRONT_END parameters and data structures
@@ -512,6 +529,10 @@ struct job_record {
 	uint16_t ckpt_interval;		/* checkpoint interval in minutes */
 	time_t ckpt_time;		/* last time job was periodically
 					 * checkpointed */
+	uint32_t change_seq;		/* job change sequence number when
+					 * the packed record last changed,
+					 * see pack_jobs_delta(), no need to
+					 * save/restore */
 	char *comment;			/* arbitrary comment */
 	uint32_t cpu_cnt;		/* current count of CPUs held
 					 * by the job, decremented while job is
@@ -586,6 +607,9 @@ struct job_record {
 					 * for this job, used to insure
 					 * epilog is not re-run for job */
 	uint16_t other_port;		/* port for client communications */
+	uint64_t pack_digest;		/* hash of the packed record as of
+					 * change_seq, no need to
+					 * save/restore */
 	char *partition;		/* name of job partition(s) */
 	List part_ptr_list;		/* list of pointers to partition recs */
 	bool part_nodes_missing;	/* set if job's nodes removed from this
@@ -1483,6 +1507,25 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
 			  uint16_t protocol_version);
 
+/*
+ * pack_jobs_delta - dump the jobs which changed since a client loaded its
+ *	copy of the job table, or every job if that cannot be determined
+ * OUT buffer_ptr - the pointer is set to the allocated buffer.
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN req - the client's request, describing its copy of the job table
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * RET SLURM_SUCCESS, SLURM_PROTOCOL_VERSION_ERROR or SLURM_NO_CHANGE_IN_DATA
+ *	if no job the client can see has changed; no buffer is returned
+ *	unless SLURM_SUCCESS
+ * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
+ * NOTE: change _unpack_job_info_delta_msg() in common/slurm_protocol_pack.c
+ *	whenever the data format changes
+ */
+extern int pack_jobs_delta(char **buffer_ptr, int *buffer_size,
+			   delta_info_request_msg_t *req, uid_t uid,
+			   uint16_t protocol_version);
+
 /*
  * pack_all_node - dump all configuration and node information for all nodes
  *	in machine independent form (for network transmission)
@@ -1500,6 +1543,43 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 			   uint16_t show_flags, uid_t uid,
 			   uint16_t protocol_version);
 
+/*
+ * pack_node_delta - dump the nodes which changed since a client loaded its
+ *	copy of the node table, or every node if that cannot be determined
+ * OUT buffer_ptr - pointer to the stored data
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN req - the client's request, describing its copy of the node table
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * RET SLURM_SUCCESS, SLURM_PROTOCOL_VERSION_ERROR or SLURM_NO_CHANGE_IN_DATA
+ *	if no node has changed; no buffer is returned unless SLURM_SUCCESS
+ * NOTE: the caller must xfree the buffer at *buffer_ptr
+ * NOTE: change _unpack_node_info_delta_msg() in common/slurm_protocol_pack.c
+ *	whenever the data format changes
+ * NOTE: READ lock_slurmctld config and WRITE lock node before entry
+ */
+extern int pack_node_delta(char **buffer_ptr, int *buffer_size,
+			   delta_info_request_msg_t *req, uid_t uid,
+			   uint16_t protocol_version);
+
+/*
+ * pack_node_summary - dump the nodes of every partition, grouped by state
+ *	and features, in machine independent form (for network transmission)
+ * OUT buffer_ptr - pointer to the stored data
+ * OUT buffer_size - set to size of the buffer in bytes
+ * IN show_flags - partition filtering options
+ * IN uid - uid of user making request (for partition filtering)
+ * IN protocol_version - slurm protocol version of client
+ * global: node_record_table_ptr - pointer to global node table
+ * NOTE: the caller must xfree the buffer at *buffer_ptr
+ * NOTE: change slurm_load_node_summary() in api/node_info.c when data
+ *	format changes
+ * NOTE: READ lock_slurmctld config, node and partition before entry
+ */
+extern void pack_node_summary(char **buffer_ptr, int *buffer_size,
+			      uint16_t show_flags, uid_t uid,
+			      uint16_t protocol_version);
+
 /* Pack all scheduling statistics */
 extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			  uint16_t protocol_version);
@@ -1974,6 +2054,18 @@ extern void validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
  */
 extern int validate_node_specs(slurm_node_registration_status_msg_t *reg_msg);
 
+/*
+ * validate_node_reg_msgs - validate a batch of node registration messages,
+ *	as collected from a forwarding tree or from concurrent registration
+ *	RPCs, so that the locks are only acquired once for all of them
+ * IN reg_cnt - count of messages in reg_msgs
+ * IN reg_msgs - node registration messages
+ * OUT rc - error code for each message, as from validate_node_specs()
+ * NOTE: READ lock_slurmctld config, WRITE job and node before entry
+ */
+extern void validate_node_reg_msgs(int reg_cnt,
+		slurm_node_registration_status_msg_t **reg_msgs, int *rc);
+
 /*
  * validate_nodes_via_front_end - validate all nodes on a cluster as having
  *	a valid configuration as soon as the front-end registers. Individual
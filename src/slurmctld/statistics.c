@@ -118,6 +118,37 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			pack32(slurmctld_diag_stats.bf_depth_try_sum, buffer);
 			pack32(slurmctld_diag_stats.bf_queue_len_sum, buffer);
 			pack32(slurmctld_diag_stats.bf_active,	 buffer);
+
+			if (protocol_version >= SLURM_14_11_PROTOCOL_VERSION) {
+				pack32(slurmctld_diag_stats.job_submit_cnt,
+				       buffer);
+				pack32(slurmctld_diag_stats.
+				       job_submit_time_max, buffer);
+				pack32(slurmctld_diag_stats.
+				       job_submit_time_sum, buffer);
+				pack32(slurmctld_diag_stats.job_modify_cnt,
+				       buffer);
+				pack32(slurmctld_diag_stats.
+				       job_modify_time_max, buffer);
+				pack32(slurmctld_diag_stats.
+				       job_modify_time_sum, buffer);
+
+				pack32(slurmctld_diag_stats.
+				       acct_limit_eval_cnt, buffer);
+				pack32(slurmctld_diag_stats.
+				       acct_limit_eval_last, buffer);
+				pack32(slurmctld_diag_stats.
+				       acct_limit_cached_cnt, buffer);
+
+				pack32(slurmctld_diag_stats.
+				       gang_cycle_counter, buffer);
+				pack32(slurmctld_diag_stats.
+				       gang_cycle_last, buffer);
+				pack32(slurmctld_diag_stats.
+				       gang_cycle_max, buffer);
+				pack32(slurmctld_diag_stats.
+				       gang_cycle_sum, buffer);
+			}
 		}
 	}
 
@@ -157,4 +188,20 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_last_depth = 0;
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 	slurmctld_diag_stats.bf_active = 0;
+
+	slurmctld_diag_stats.job_submit_cnt = 0;
+	slurmctld_diag_stats.job_submit_time_max = 0;
+	slurmctld_diag_stats.job_submit_time_sum = 0;
+	slurmctld_diag_stats.job_modify_cnt = 0;
+	slurmctld_diag_stats.job_modify_time_max = 0;
+	slurmctld_diag_stats.job_modify_time_sum = 0;
+
+	slurmctld_diag_stats.acct_limit_eval_cnt = 0;
+	slurmctld_diag_stats.acct_limit_eval_last = 0;
+	slurmctld_diag_stats.acct_limit_cached_cnt = 0;
+
+	slurmctld_diag_stats.gang_cycle_counter = 0;
+	slurmctld_diag_stats.gang_cycle_last = 0;
+	slurmctld_diag_stats.gang_cycle_max = 0;
+	slurmctld_diag_stats.gang_cycle_sum = 0;
 }
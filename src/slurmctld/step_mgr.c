@@ -839,8 +839,7 @@ _pick_step_nodes (struct job_record  *job_ptr,
 		/* We only select for a single feature name here.
 		 * Add support for AND, OR, etc. here if desired */
 		struct features_record *feat_ptr;
-		feat_ptr = list_find_first(feature_list, list_find_feature,
-					   (void *) step_spec->features);
+		feat_ptr = find_feature_record(step_spec->features);
 		if (feat_ptr && feat_ptr->node_bitmap)
 			bit_and(nodes_avail, feat_ptr->node_bitmap);
 		else
@@ -86,6 +86,7 @@
 #include "src/slurmd/slurmd/get_mach_stat.h"
 #include "src/slurmd/slurmd/slurmd.h"
 #include "src/slurmd/slurmd/reverse_tree_math.h"
+#include "src/slurmd/slurmd/stepd_pool.h"
 #include "src/slurmd/slurmd/xcpu.h"
 
 #include "src/slurmd/common/job_container_plugin.h"
@@ -174,10 +175,12 @@ static void _rpc_reboot(slurm_msg_t *msg);
 static void _rpc_pid2jid(slurm_msg_t *msg);
 static int  _rpc_file_bcast(slurm_msg_t *msg);
 static int  _rpc_ping(slurm_msg_t *);
+static void _rpc_node_registration(slurm_msg_t *);
 static int  _rpc_health_check(slurm_msg_t *);
 static int  _rpc_acct_gather_update(slurm_msg_t *);
 static int  _rpc_acct_gather_energy(slurm_msg_t *);
 static int  _rpc_step_complete(slurm_msg_t *msg);
+static int  _rpc_step_io_connect(slurm_msg_t *msg);
 static int  _rpc_stat_jobacct(slurm_msg_t *msg);
 static int  _rpc_list_pids(slurm_msg_t *msg);
 static int  _rpc_daemon_status(slurm_msg_t *msg);
@@ -368,6 +371,13 @@ slurmd_req(slurm_msg_t *msg)
 		break;
 	case REQUEST_NODE_REGISTRATION_STATUS:
 		debug2("Processing RPC: REQUEST_NODE_REGISTRATION_STATUS");
+		if (msg->protocol_version >= SLURM_14_11_PROTOCOL_VERSION) {
+			/* Reply with the registration itself */
+			_rpc_node_registration(msg);
+			last_slurmctld_msg = time(NULL);
+			/* No body to free */
+			break;
+		}
 		/* Treat as ping (for slurmctld agent, just return SUCCESS) */
 		rc = _rpc_ping(msg);
 		last_slurmctld_msg = time(NULL);
@@ -419,6 +429,11 @@ slurmd_req(slurm_msg_t *msg)
 		rc = _rpc_list_pids(msg);
 		slurm_free_job_step_id_msg(msg->data);
 		break;
+	case REQUEST_STEP_IO_CONNECT:
+		debug2("Processing RPC: REQUEST_STEP_IO_CONNECT");
+		rc = _rpc_step_io_connect(msg);
+		slurm_free_job_step_id_msg(msg->data);
+		break;
 	case REQUEST_DAEMON_STATUS:
 		_rpc_daemon_status(msg);
 		/* No body to free */
@@ -440,24 +455,15 @@ slurmd_req(slurm_msg_t *msg)
 	}
 	return;
 }
-static int _send_slurmd_conf_lite (int fd, slurmd_conf_t *cf)
-{
-	int len;
-	Buf buffer = init_buf(0);
-	pack_slurmd_conf_lite(cf, buffer);
-	len = get_buf_offset(buffer);
-	safe_write(fd, &len, sizeof(int));
-	safe_write(fd, get_buf_data(buffer), len);
-	free_buf(buffer);
-	return (0);
- rwfail:
-	return (-1);
-}
-
+/*
+ * Send a slurmstepd its initialization data.  A pooled slurmstepd was sent
+ * the configuration by the pool when it was started, so send_conf is only
+ * set for a slurmstepd started for this launch.
+ */
 static int
 _send_slurmstepd_init(int fd, slurmd_step_type_t type, void *req,
 		      slurm_addr_t *cli, slurm_addr_t *self,
-		      hostset_t step_hset)
+		      hostset_t step_hset, bool send_conf)
 {
 	int len = 0;
 	Buf buffer = NULL;
@@ -553,7 +559,7 @@ _send_slurmstepd_init(int fd, slurmd_step_type_t type, void *req,
 	safe_write(fd, &parent_addr, sizeof(slurm_addr_t));
 
 	/* send conf over to slurmstepd */
-	if (_send_slurmd_conf_lite(fd, conf) < 0)
+	if (send_conf && (stepd_send_conf(fd) < 0))
 		goto rwfail;
 
 	/* send cli address over to slurmstepd */
@@ -676,155 +682,72 @@ rwfail:
 
 
 /*
- * Fork and exec the slurmstepd, then send the slurmstepd its
- * initialization data.  Then wait for slurmstepd to send an "ok"
- * message before returning.  When the "ok" message is received,
- * the slurmstepd has created and begun listening on its unix
- * domain socket.
- *
- * Note that this code forks twice and it is the grandchild that
- * becomes the slurmstepd process, so the slurmstepd's parent process
- * will be init, not slurmd.
+ * Take a slurmstepd from the pool (or fork and exec a new one if the pool
+ * is empty or disabled), then send the slurmstepd its initialization data.
+ * Then wait for slurmstepd to send an "ok" message before returning.  When
+ * the "ok" message is received, the slurmstepd has created and begun
+ * listening on its unix domain socket.
  */
 static int
 _forkexec_slurmstepd(slurmd_step_type_t type, void *req,
 		     slurm_addr_t *cli, slurm_addr_t *self,
 		     const hostset_t step_hset)
 {
-	pid_t pid;
-	int to_stepd[2] = {-1, -1};
-	int to_slurmd[2] = {-1, -1};
-
-	if (pipe(to_stepd) < 0 || pipe(to_slurmd) < 0) {
-		error("_forkexec_slurmstepd pipe failed: %m");
-		return SLURM_FAILURE;
-	}
+	int to_stepd = -1, to_slurmd = -1;
+	int rc = 0;
+	bool pooled;
+#ifndef SLURMSTEPD_MEMCHECK
+	time_t start_time = time(NULL);
+#endif
 
 	if (_add_starting_step(type, req)) {
 		error("_forkexec_slurmstepd failed in _add_starting_step: %m");
 		return SLURM_FAILURE;
 	}
 
-	if ((pid = fork()) < 0) {
-		error("_forkexec_slurmstepd: fork: %m");
-		close(to_stepd[0]);
-		close(to_stepd[1]);
-		close(to_slurmd[0]);
-		close(to_slurmd[1]);
+	pooled = (stepd_pool_get(&to_stepd, &to_slurmd) == SLURM_SUCCESS);
+	if (!pooled &&
+	    (stepd_exec(&to_stepd, &to_slurmd, false) != SLURM_SUCCESS)) {
 		_remove_starting_step(type, req);
 		return SLURM_FAILURE;
-	} else if (pid > 0) {
-		int rc = 0;
-#ifndef SLURMSTEPD_MEMCHECK
-		time_t start_time = time(NULL);
-#endif
-		/*
-		 * Parent sends initialization data to the slurmstepd
-		 * over the to_stepd pipe, and waits for the return code
-		 * reply on the to_slurmd pipe.
-		 */
-		if (close(to_stepd[0]) < 0)
-			error("Unable to close read to_stepd in parent: %m");
-		if (close(to_slurmd[1]) < 0)
-			error("Unable to close write to_slurmd in parent: %m");
-
-		if ((rc = _send_slurmstepd_init(to_stepd[1], type,
-						req, cli, self,
-						step_hset)) != 0) {
-			error("Unable to init slurmstepd");
-			goto done;
-		}
+	}
 
-		/* If running under memcheck stdout doesn't work correctly so
-		 * just skip it.
-		 */
+	/*
+	 * Send initialization data to the slurmstepd over the to_stepd
+	 * pipe, and wait for the return code reply on the to_slurmd pipe.
+	 */
+	if ((rc = _send_slurmstepd_init(to_stepd, type, req, cli, self,
+					step_hset, !pooled)) != 0) {
+		error("Unable to init slurmstepd");
+		goto done;
+	}
+
+	/* If running under memcheck stdout doesn't work correctly so
+	 * just skip it.
+	 */
 #ifndef SLURMSTEPD_MEMCHECK
-		if (read(to_slurmd[0], &rc, sizeof(int)) != sizeof(int)) {
-			error("Error reading return code message "
-			      "from slurmstepd: %m");
-			rc = SLURM_FAILURE;
-		} else {
-			int delta_time = time(NULL) - start_time;
-			if (delta_time > 5) {
-				info("Warning: slurmstepd startup took %d sec, "
-				     "possible file system problem or full "
-				     "memory", delta_time);
-			}
-		}
-#endif
-	done:
-		if (_remove_starting_step(type, req))
-			error("Error cleaning up starting_step list");
-
-		/* Reap child */
-		if (waitpid(pid, NULL, 0) < 0)
-			error("Unable to reap slurmd child process");
-		if (close(to_stepd[1]) < 0)
-			error("close write to_stepd in parent: %m");
-		if (close(to_slurmd[0]) < 0)
-			error("close read to_slurmd in parent: %m");
-		return rc;
+	if (read(to_slurmd, &rc, sizeof(int)) != sizeof(int)) {
+		error("Error reading return code message "
+		      "from slurmstepd: %m");
+		rc = SLURM_FAILURE;
 	} else {
-#ifndef SLURMSTEPD_MEMCHECK
-		char *const argv[2] = { (char *)conf->stepd_loc, NULL};
-#else
-		char *const argv[3] = {"memcheck",
-				       (char *)conf->stepd_loc, NULL};
-#endif
-		int failed = 0;
-		/* inform slurmstepd about our config */
-		setenv("SLURM_CONF", conf->conffile, 1);
-
-		/*
-		 * Child forks and exits
-		 */
-		if (setsid() < 0) {
-			error("_forkexec_slurmstepd: setsid: %m");
-			failed = 1;
-		}
-		if ((pid = fork()) < 0) {
-			error("_forkexec_slurmstepd: "
-			      "Unable to fork grandchild: %m");
-			failed = 2;
-		} else if (pid > 0) { /* child */
-			exit(0);
-		}
-
-		/*
-		 * Grandchild exec's the slurmstepd
-		 */
-		slurm_shutdown_msg_engine(conf->lfd);
-
-		if (close(to_stepd[1]) < 0)
-			error("close write to_stepd in grandchild: %m");
-		if (close(to_slurmd[0]) < 0)
-			error("close read to_slurmd in parent: %m");
-
-		(void) close(STDIN_FILENO); /* ignore return */
-		if (dup2(to_stepd[0], STDIN_FILENO) == -1) {
-			error("dup2 over STDIN_FILENO: %m");
-			exit(1);
+		int delta_time = time(NULL) - start_time;
+		if (delta_time > 5) {
+			info("Warning: slurmstepd startup took %d sec, "
+			     "possible file system problem or full "
+			     "memory", delta_time);
 		}
-		fd_set_close_on_exec(to_stepd[0]);
-		(void) close(STDOUT_FILENO); /* ignore return */
-		if (dup2(to_slurmd[1], STDOUT_FILENO) == -1) {
-			error("dup2 over STDOUT_FILENO: %m");
-			exit(1);
-		}
-		fd_set_close_on_exec(to_slurmd[1]);
-		(void) close(STDERR_FILENO); /* ignore return */
-		if (dup2(devnull, STDERR_FILENO) == -1) {
-			error("dup2 /dev/null to STDERR_FILENO: %m");
-			exit(1);
-		}
-		fd_set_noclose_on_exec(STDERR_FILENO);
-		log_fini();
-		if (!failed) {
-			execvp(argv[0], argv);
-			error("exec of slurmstepd failed: %m");
-		}
-		exit(2);
 	}
+#endif
+done:
+	if (_remove_starting_step(type, req))
+		error("Error cleaning up starting_step list");
+
+	if (close(to_stepd) < 0)
+		error("close write to_stepd in parent: %m");
+	if (close(to_slurmd) < 0)
+		error("close read to_slurmd in parent: %m");
+	return rc;
 }
 
 
@@ -2110,6 +2033,30 @@ _rpc_ping(slurm_msg_t *msg)
 	return rc;
 }
 
+/* Answer slurmctld's registration request with the node registration,
+ * so that intermediate slurmds in the forwarding tree return the
+ * registrations of all their children to slurmctld in one message */
+static void
+_rpc_node_registration(slurm_msg_t *msg)
+{
+	uid_t req_uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+
+	if (!_slurm_authorized_user(req_uid)) {
+		error("Security violation, node registration RPC from uid %d",
+		      req_uid);
+		slurm_send_rc_msg(msg, ESLURM_USER_ID_MISSING);
+		return;
+	}
+
+	/* If the reply can't be sent, register separately in hopes of
+	 * avoiding having the node set DOWN, as for a ping */
+	if (reply_registration_msg(msg, true) != SLURM_SUCCESS)
+		send_registration_msg(SLURM_SUCCESS, true);
+
+	/* Take this opportunity to enforce any job memory limits */
+	_enforce_job_mem_limit();
+}
+
 static int
 _rpc_health_check(slurm_msg_t *msg)
 {
@@ -2455,6 +2402,61 @@ done:
 	return rc;
 }
 
+/*
+ * A slurmstepd below this node in a step's stdio tree wants to send its
+ * output through the local slurmstepd.  Hand the connection itself to the
+ * slurmstepd, which answers the request and then uses the socket as an
+ * IO stream.  Only failures are answered here.
+ */
+static int
+_rpc_step_io_connect(slurm_msg_t *msg)
+{
+	job_step_id_msg_t *req = (job_step_id_msg_t *)msg->data;
+	int               rc = SLURM_SUCCESS;
+	int               fd;
+	uid_t             req_uid;
+	slurmstepd_info_t *step;
+
+	debug3("Entering _rpc_step_io_connect");
+	fd = stepd_connect(conf->spooldir, conf->node_name,
+			   req->job_id, req->step_id);
+	if (fd == -1) {
+		debug("stepd_connect to %u.%u failed: %m",
+		      req->job_id, req->step_id);
+		rc = ESLURM_INVALID_JOB_ID;
+		goto done;
+	}
+	if ((step = stepd_get_info(fd)) == NULL) {
+		close(fd);
+		rc = ESLURM_INVALID_JOB_ID;
+		goto done;
+	}
+
+	/* The slurmstepd below connects with the user's privileges */
+	req_uid = g_slurm_auth_get_uid(msg->auth_cred, NULL);
+	if ((req_uid != step->uid) && !_slurm_authorized_user(req_uid)) {
+		debug("step IO connection from uid %ld for job %u.%u "
+		      "owned by uid %ld", (long) req_uid, req->job_id,
+		      req->step_id, (long) step->uid);
+		xfree(step);
+		close(fd);
+		rc = ESLURM_USER_ID_MISSING;
+		goto done;
+	}
+	xfree(step);
+
+	rc = stepd_io_connect(fd, msg->conn_fd);
+	close(fd);
+	if (rc == SLURM_SUCCESS)
+		return rc;
+	if (rc == -1)
+		rc = ESLURMD_JOB_NOTRUNNING;
+
+done:
+	slurm_send_rc_msg(msg, rc);
+	return rc;
+}
+
 /* Get list of active jobs and steps, xfree returned value */
 static char *
 _get_step_list(void)
@@ -2520,6 +2522,11 @@ _rpc_daemon_status(slurm_msg_t *msg)
 	resp->step_list          = _get_step_list();
 	resp->last_slurmctld_msg = last_slurmctld_msg;
 	resp->pid                = conf->pid;
+	stepd_pool_stats(&resp->stepd_pool_size, &resp->stepd_pool_idle,
+			 &resp->stepd_pool_hits, &resp->stepd_pool_misses);
+	get_rpc_stats(&resp->rpc_type_size, &resp->rpc_type_id,
+		      &resp->rpc_type_cnt, &resp->rpc_type_ave_time,
+		      &resp->rpc_type_max_time);
 	resp->slurmd_debug       = conf->debug_level;
 	resp->slurmd_logfile     = xstrdup(conf->logfile);
 	resp->version            = xstrdup(SLURM_VERSION_STRING);
@@ -4089,10 +4096,14 @@ _rpc_terminate_job(slurm_msg_t *msg)
 
 #ifndef HAVE_AIX
 	if ((nsteps == 0) && !conf->epilog && !have_spank) {
+		bool replied = false;
+
 		debug4("sent ALREADY_COMPLETE");
-		if (msg->conn_fd >= 0)
+		if (msg->conn_fd >= 0) {
 			slurm_send_rc_msg(msg,
 					  ESLURMD_KILL_JOB_ALREADY_COMPLETE);
+			replied = true;
+		}
 		slurm_cred_begin_expiration(conf->vctx, req->job_id);
 		save_cred_state(conf->vctx);
 		_waiter_complete(req->job_id);
@@ -4104,7 +4115,7 @@ _rpc_terminate_job(slurm_msg_t *msg)
 		 * to terminate is resent.
 		 */
 		_sync_messages_kill(req);
-		if (msg->conn_fd < 0) {
+		if (!replied) {
 			/* The epilog complete message processing on
 			 * slurmctld is equivalent to that of a
 			 * ESLURMD_KILL_JOB_ALREADY_COMPLETE reply above */
@@ -4513,7 +4524,7 @@ _run_spank_job_script (const char *mode, char **env, uint32_t job_id, uid_t uid)
 
 	close (pfds[0]);
 
-	if (_send_slurmd_conf_lite (pfds[1], conf) < 0)
+	if (stepd_send_conf(pfds[1]) < 0)
 		error ("Failed to send slurmd conf to slurmstepd\n");
 	close (pfds[1]);
 
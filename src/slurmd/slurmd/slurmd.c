@@ -52,6 +52,7 @@
 #include <dlfcn.h>
 #include <fcntl.h>
 #include <grp.h>
+#include <poll.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
@@ -66,6 +67,7 @@
 #include <unistd.h>
 
 #include "src/common/bitstring.h"
+#include "src/common/conn_cache.h"
 #include "src/common/cpu_frequency.h"
 #include "src/common/daemonize.h"
 #include "src/common/fd.h"
@@ -103,6 +105,7 @@
 #include "src/slurmd/slurmd/req.h"
 #include "src/slurmd/slurmd/get_mach_stat.h"
 #include "src/slurmd/slurmd/slurmd_plugstack.h"
+#include "src/slurmd/slurmd/stepd_pool.h"
 #include "src/slurmd/common/job_container_plugin.h"
 #include "src/slurmd/common/proctrack.h"
 
@@ -113,15 +116,21 @@
 #endif
 
 #define MAX_THREADS		130
+#define DEFAULT_MSG_THREADS	8	/* idle RPC workers to keep */
+#define PRIO_MSG_THREADS	2	/* workers for high priority RPCs */
+#define MAX_PENDING_CONNS	256	/* connections awaiting a header */
+#define MAX_RPC_TYPES		100	/* message types in RPC statistics */
 
 /* global, copied to STDERR_FILENO in tasks before the exec */
 int devnull = -1;
 slurmd_conf_t * conf;
 
 /*
- * count of active threads
+ * count of active threads, at most MAX_THREADS of them besides the
+ * active_prio threads of the priority workers, which have their own budget
  */
 static int             active_threads = 0;
+static int             active_prio    = 0;
 static pthread_mutex_t active_mutex   = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  active_cond    = PTHREAD_COND_INITIALIZER;
 
@@ -130,8 +139,47 @@ static pthread_mutex_t fork_mutex     = PTHREAD_MUTEX_INITIALIZER;
 typedef struct connection {
 	slurm_fd_t fd;
 	slurm_addr_t *cli_addr;
+	uint16_t msg_type;		/* peeked from the message header */
+	time_t accept_time;		/* when accepted or last used */
+	struct timeval ready_time;	/* when the message was queued */
+	bool persist;			/* kept open by SLURM_PERSIST_CONN */
 } conn_t;
 
+/*
+ * Connections with a message ready to be received are queued for a pool
+ * of worker threads by _msg_engine().  High priority messages (pings and
+ * health checks) are also served by PRIO_MSG_THREADS dedicated workers so
+ * they do not wait behind a burst of job launches or terminations.
+ */
+static List            msg_queue    = NULL;
+static List            prio_queue   = NULL;
+static pthread_mutex_t queue_mutex  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  queue_cond   = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  prio_cond    = PTHREAD_COND_INITIALIZER;
+static int             msg_workers  = 0;	/* general workers */
+static int             idle_workers = 0;	/* general workers waiting */
+static int             idle_prio    = 0;	/* prio workers waiting */
+static bool            workers_fini = false;
+
+/*
+ * Connections to keep open for another message, handed back to
+ * _msg_engine() by the workers, which write to wake_pipe to interrupt
+ * its poll()
+ */
+static List            persist_queue = NULL;
+static int             wake_pipe[2]  = {-1, -1};
+
+/*
+ * RPC latency by message type, from the time a message is ready to be
+ * received until it has been processed, see get_rpc_stats()
+ */
+static pthread_mutex_t rpc_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t rpc_type_size = 0;
+static uint16_t rpc_type_id[MAX_RPC_TYPES];
+static uint32_t rpc_type_cnt[MAX_RPC_TYPES];
+static uint64_t rpc_type_time[MAX_RPC_TYPES];	/* usec */
+static uint32_t rpc_type_max[MAX_RPC_TYPES];	/* usec */
+
 
 
 /*
@@ -145,25 +193,35 @@ static time_t sent_reg_time = (time_t) 0;
 static void      _atfork_final(void);
 static void      _atfork_prepare(void);
 static void      _create_msg_socket(void);
+static void      _decrement_prio_thd_count(void);
 static void      _decrement_thd_count(void);
 static void      _destroy_conf(void);
 static int       _drain_node(char *reason);
 static void      _fill_registration_msg(slurm_node_registration_status_msg_t *);
-static void      _handle_connection(slurm_fd_t fd, slurm_addr_t *client);
+static void      _free_connection(conn_t *con);
 static void      _hup_handler(int);
+static void      _increment_prio_thd_count(void);
 static void      _increment_thd_count(void);
 static void      _init_conf(void);
 static void      _install_fork_handlers(void);
 static void 	 _kill_old_slurmd(void);
 static void      _msg_engine(void);
+static void     *_msg_worker(void *arg);
+static void      _msg_workers_fini(void);
+static void      _msg_workers_init(void);
+static void      _persist_connection(conn_t *con);
+static void      _persist_conn_hook(slurm_msg_t *msg);
 static void      _print_conf(void);
 static void      _print_config(void);
+static bool      _prio_msg_type(uint16_t msg_type);
 static void      _process_cmdline(int ac, char **av);
+static void      _queue_connection(conn_t *con);
 static void      _read_config(void);
 static void      _reconfigure(void);
 static void     *_registration_engine(void *arg);
+static void      _record_rpc(uint16_t msg_type, struct timeval *start);
 static int       _restore_cred_state(slurm_cred_ctx_t ctx);
-static void     *_service_connection(void *);
+static void      _service_connection(conn_t *con, bool prio);
 static int       _set_slurmd_spooldir(void);
 static int       _set_topo_info(void);
 static int       _slurmd_init(void);
@@ -333,6 +391,8 @@ main (int argc, char *argv[])
 		fatal("failed to initialize slurmd_plugstack");
 
 	_spawn_registration_engine();
+	stepd_pool_reconfig(conf->stepd_pool_size);
+	conn_cache_init();
 	_msg_engine();
 
 	/*
@@ -408,11 +468,19 @@ _registration_engine(void *arg)
 static void
 _msg_engine(void)
 {
+	conn_t *pending[MAX_PENDING_CONNS], *con;
+	struct pollfd ufds[MAX_PENDING_CONNS + 2];
+	int pending_cnt = 0, old_cnt, nfds, first, wake, i, rc;
+	bool listening;
 	slurm_addr_t *cli;
 	slurm_fd_t sock;
+	time_t now;
+	uint16_t msg_timeout, timeout;
+	char buf[64];
 
 	msg_pthread = pthread_self();
 	slurmd_req(NULL);	/* initialize timer */
+	_msg_workers_init();
 	while (!_shutdown) {
 		if (_reconfig) {
 			verbose("got reconfigure request");
@@ -420,9 +488,102 @@ _msg_engine(void)
 			_reconfigure();
 		}
 
+		/*
+		 * Wait for new connections, while there is room to track
+		 * them, and for the message header on accepted connections.
+		 * No thread is tied up by a connection until its message
+		 * can be received.
+		 */
+		nfds = 0;
+		listening = (pending_cnt < MAX_PENDING_CONNS);
+		if (listening) {
+			ufds[nfds].fd = conf->lfd;
+			ufds[nfds].events = POLLIN;
+			ufds[nfds].revents = 0;
+			nfds++;
+		}
+		wake = nfds;
+		ufds[nfds].fd = wake_pipe[0];
+		ufds[nfds].events = POLLIN;
+		ufds[nfds].revents = 0;
+		nfds++;
+		first = nfds;
+		for (i = 0; i < pending_cnt; i++) {
+			ufds[nfds].fd = pending[i]->fd;
+			ufds[nfds].events = POLLIN;
+			ufds[nfds].revents = 0;
+			nfds++;
+		}
+		if (poll(ufds, nfds, 1000) < 0) {
+			if (errno != EINTR)
+				error("poll: %m");
+			continue;
+		}
+
+		now = time(NULL);
+		msg_timeout = slurm_get_msg_timeout();
+		old_cnt = pending_cnt;
+		pending_cnt = 0;
+		for (i = 0; i < old_cnt; i++) {
+			con = pending[i];
+			rc = 0;
+			if (ufds[first + i].revents) {
+				rc = slurm_peek_msg_type(con->fd,
+							 &con->msg_type);
+				/* Only part of the header has arrived, let a
+				 * worker wait for the rest rather than poll()
+				 * return at once for the data already there */
+				if (rc == 0) {
+					con->msg_type = 0;
+					rc = 1;
+				}
+			}
+			/* An idle persistent connection is closed after its
+			 * sender would have stopped using it */
+			timeout = con->persist ? (2 * CONN_CACHE_IDLE) :
+				  msg_timeout;
+			if (rc > 0) {
+				_queue_connection(con);
+			} else if (rc < 0) {
+				_free_connection(con);
+			} else if (difftime(now, con->accept_time) > timeout) {
+				if (!con->persist) {
+					debug("msg_engine: timeout waiting for "
+					      "message on fd %d", con->fd);
+				}
+				_free_connection(con);
+			} else
+				pending[pending_cnt++] = con;
+		}
+
+		if (ufds[wake].revents) {
+			while (read(wake_pipe[0], buf, sizeof(buf)) > 0)
+				;
+			slurm_mutex_lock(&queue_mutex);
+			while ((con = list_dequeue(persist_queue))) {
+				con->accept_time = now;
+				if (pending_cnt < MAX_PENDING_CONNS)
+					pending[pending_cnt++] = con;
+				else
+					_free_connection(con);
+			}
+			slurm_mutex_unlock(&queue_mutex);
+		}
+
+		if (!listening || !ufds[0].revents)
+			continue;
 		cli = xmalloc (sizeof (slurm_addr_t));
 		if ((sock = slurm_accept_msg_conn(conf->lfd, cli)) >= 0) {
-			_handle_connection(sock, cli);
+			fd_set_close_on_exec(sock);
+			con = xmalloc(sizeof(conn_t));
+			con->fd = sock;
+			con->cli_addr = cli;
+			con->accept_time = now;
+			/* The message has usually arrived with the connection */
+			if (slurm_peek_msg_type(sock, &con->msg_type) > 0)
+				_queue_connection(con);
+			else
+				pending[pending_cnt++] = con;
 			continue;
 		}
 		/*
@@ -434,10 +595,202 @@ _msg_engine(void)
 		error("accept: %m");
 	}
 	verbose("got shutdown request");
+	for (i = 0; i < pending_cnt; i++)
+		_free_connection(pending[i]);
+	_msg_workers_fini();
 	slurm_shutdown_msg_engine(conf->lfd);
 	return;
 }
 
+static void
+_msg_workers_init(void)
+{
+	pthread_attr_t attr;
+	pthread_t id;
+	int i;
+
+	msg_queue  = list_create(NULL);
+	prio_queue = list_create(NULL);
+	persist_queue = list_create(NULL);
+
+	slurm_set_persist_conn_hook(_persist_conn_hook);
+	if (pipe(wake_pipe) < 0)
+		fatal("msg_engine: pipe: %m");
+	fd_set_nonblocking(wake_pipe[0]);
+	fd_set_nonblocking(wake_pipe[1]);
+	fd_set_close_on_exec(wake_pipe[0]);
+	fd_set_close_on_exec(wake_pipe[1]);
+
+	slurm_attr_init(&attr);
+	if (pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED))
+		error("Unable to set detachstate on attr: %m");
+	for (i = 0; i < PRIO_MSG_THREADS; i++) {
+		if (pthread_create(&id, &attr, &_msg_worker, (void *) 1))
+			error("msg_engine: pthread_create: %m");
+	}
+	slurm_attr_destroy(&attr);
+}
+
+/* Release idle workers and drop connections not yet being serviced,
+ * RPCs already in progress are waited for by _wait_for_all_threads() */
+static void
+_msg_workers_fini(void)
+{
+	conn_t *con;
+
+	slurm_mutex_lock(&queue_mutex);
+	workers_fini = true;
+	while ((con = list_dequeue(prio_queue)))
+		_free_connection(con);
+	while ((con = list_dequeue(msg_queue)))
+		_free_connection(con);
+	while ((con = list_dequeue(persist_queue)))
+		_free_connection(con);
+	pthread_cond_broadcast(&prio_cond);
+	pthread_cond_broadcast(&queue_cond);
+	slurm_mutex_unlock(&queue_mutex);
+}
+
+static bool
+_prio_msg_type(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_PING:
+	case REQUEST_HEALTH_CHECK:
+	case REQUEST_ACCT_GATHER_UPDATE:
+	case REQUEST_NODE_REGISTRATION_STATUS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/* Queue a connection whose message can be received for the workers,
+ * starting another worker if none is free to take it */
+static void
+_queue_connection(conn_t *con)
+{
+	pthread_attr_t attr;
+	pthread_t id;
+	int waiting;
+
+	gettimeofday(&con->ready_time, NULL);
+
+	slurm_mutex_lock(&queue_mutex);
+	if (_prio_msg_type(con->msg_type)) {
+		list_enqueue(prio_queue, con);
+		pthread_cond_signal(&prio_cond);
+		waiting = list_count(prio_queue) - idle_prio;
+	} else {
+		list_enqueue(msg_queue, con);
+		waiting = list_count(msg_queue) +
+			  MAX(list_count(prio_queue) - idle_prio, 0);
+	}
+	if ((waiting > idle_workers) && (msg_workers < MAX_THREADS)) {
+		slurm_attr_init(&attr);
+		if (pthread_attr_setdetachstate(&attr,
+						PTHREAD_CREATE_DETACHED))
+			error("Unable to set detachstate on attr: %m");
+		if (pthread_create(&id, &attr, &_msg_worker, NULL))
+			error("msg_engine: pthread_create: %m");
+		else
+			msg_workers++;
+		slurm_attr_destroy(&attr);
+	}
+	pthread_cond_signal(&queue_cond);
+	slurm_mutex_unlock(&queue_mutex);
+}
+
+/*
+ * RPC worker thread.  A general worker (arg == NULL) services both queues,
+ * high priority messages first, and exits once conf->msg_threads other
+ * workers are already idle.  A priority worker only services prio_queue.
+ */
+static void *
+_msg_worker(void *arg)
+{
+	bool prio = (arg != NULL);
+	conn_t *con;
+
+	slurm_mutex_lock(&queue_mutex);
+	while (!workers_fini) {
+		con = list_dequeue(prio_queue);
+		if (!con && !prio)
+			con = list_dequeue(msg_queue);
+		if (con) {
+			slurm_mutex_unlock(&queue_mutex);
+			_service_connection(con, prio);
+			slurm_mutex_lock(&queue_mutex);
+			continue;
+		}
+		if (prio) {
+			idle_prio++;
+			pthread_cond_wait(&prio_cond, &queue_mutex);
+			idle_prio--;
+		} else if (idle_workers >= conf->msg_threads) {
+			break;
+		} else {
+			idle_workers++;
+			pthread_cond_wait(&queue_cond, &queue_mutex);
+			idle_workers--;
+		}
+	}
+	if (!prio)
+		msg_workers--;
+	slurm_mutex_unlock(&queue_mutex);
+	return NULL;
+}
+
+/* Hand a connection back to _msg_engine() to wait for its next message */
+static void
+_persist_connection(conn_t *con)
+{
+	char c = 0;
+
+	slurm_mutex_lock(&queue_mutex);
+	if (workers_fini) {
+		slurm_mutex_unlock(&queue_mutex);
+		_free_connection(con);
+		return;
+	}
+	con->persist = true;
+	list_enqueue(persist_queue, con);
+	slurm_mutex_unlock(&queue_mutex);
+	if ((write(wake_pipe[1], &c, 1) < 0) && (errno != EAGAIN))
+		error("msg_engine: write: %m");
+}
+
+/*
+ * Called once the reply to a message received on a persistent connection
+ * has been sent.  Hand the connection back to _msg_engine() right away,
+ * rather than once the message's handler returns, so the next message from
+ * the sender is not held up by work done after the reply (e.g. a batch
+ * job's prolog).
+ */
+static void
+_persist_conn_hook(slurm_msg_t *msg)
+{
+	conn_t *con;
+
+	if (msg->conn_fd < 0)
+		return;
+	con = xmalloc(sizeof(conn_t));
+	con->fd = msg->conn_fd;
+	con->cli_addr = xmalloc(sizeof(slurm_addr_t));
+	memcpy(con->cli_addr, &msg->address, sizeof(slurm_addr_t));
+	msg->conn_fd = -1;	/* no longer the handler's to use */
+	_persist_connection(con);
+}
+
+static void
+_free_connection(conn_t *con)
+{
+	if (slurm_close_accepted_conn(con->fd) < 0)
+		error ("close(%d): %m", con->fd);
+	xfree(con->cli_addr);
+	xfree(con);
+}
+
 static void
 _decrement_thd_count(void)
 {
@@ -448,13 +801,36 @@ _decrement_thd_count(void)
 	slurm_mutex_unlock(&active_mutex);
 }
 
+static void
+_decrement_prio_thd_count(void)
+{
+	slurm_mutex_lock(&active_mutex);
+	if (active_prio > 0)
+		active_prio--;
+	if (active_threads > 0)
+		active_threads--;
+	pthread_cond_signal(&active_cond);
+	slurm_mutex_unlock(&active_mutex);
+}
+
+/* The priority workers are limited to PRIO_MSG_THREADS, so they never wait
+ * for the general workers to free up a slot */
+static void
+_increment_prio_thd_count(void)
+{
+	slurm_mutex_lock(&active_mutex);
+	active_prio++;
+	active_threads++;
+	slurm_mutex_unlock(&active_mutex);
+}
+
 static void
 _increment_thd_count(void)
 {
 	bool logged = false;
 
 	slurm_mutex_lock(&active_mutex);
-	while (active_threads >= MAX_THREADS) {
+	while ((active_threads - active_prio) >= MAX_THREADS) {
 		if (!logged) {
 			info("active_threads == MAX_THREADS(%d)",
 			     MAX_THREADS);
@@ -495,54 +871,15 @@ _wait_for_all_threads(int secs)
 }
 
 static void
-_handle_connection(slurm_fd_t fd, slurm_addr_t *cli)
+_service_connection(conn_t *con, bool prio)
 {
-	int            rc;
-	pthread_attr_t attr;
-	pthread_t      id;
-	conn_t         *arg = xmalloc(sizeof(conn_t));
-	int            retries = 0;
-
-	arg->fd       = fd;
-	arg->cli_addr = cli;
-
-	slurm_attr_init(&attr);
-	rc = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
-	if (rc != 0) {
-		errno = rc;
-		xfree(arg);
-		error("Unable to set detachstate on attr: %m");
-		slurm_attr_destroy(&attr);
-		return;
-	}
-
-	fd_set_close_on_exec(fd);
-
-	_increment_thd_count();
-	while (pthread_create(&id, &attr, &_service_connection, (void *)arg)) {
-		error("msg_engine: pthread_create: %m");
-		if (++retries > 3) {
-			error("running service_connection without starting "
-			      "a new thread slurmd will be "
-			      "unresponsive until done");
-
-			_service_connection((void *) arg);
-			info("slurmd should be responsive now");
-			break;
-		}
-		usleep(10);	/* sleep and again */
-	}
-
-	return;
-}
-
-static void *
-_service_connection(void *arg)
-{
-	conn_t *con = (conn_t *) arg;
 	slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
 	int rc = SLURM_SUCCESS;
 
+	if (prio)
+		_increment_prio_thd_count();
+	else
+		_increment_thd_count();
 	debug3("in the service_connection");
 	slurm_msg_t_init(msg);
 	if ((rc = slurm_receive_msg_and_forward(con->fd, con->cli_addr, msg, 0))
@@ -556,16 +893,85 @@ _service_connection(void *arg)
 	}
 	debug2("got this type of message %d", msg->msg_type);
 	slurmd_req(msg);
+	_record_rpc(msg->msg_type, &con->ready_time);
 
-cleanup:
-	if ((msg->conn_fd >= 0) && slurm_close_accepted_conn(msg->conn_fd) < 0)
-		error ("close(%d): %m", con->fd);
+	if ((msg->flags & SLURM_PERSIST_CONN) && (msg->conn_fd >= 0)) {
+		_persist_connection(con);
+		con = NULL;
+	}
 
-	xfree(con->cli_addr);
-	xfree(con);
+cleanup:
+	if (con) {
+		if ((msg->conn_fd >= 0) &&
+		    slurm_close_accepted_conn(msg->conn_fd) < 0)
+			error ("close(%d): %m", con->fd);
+		xfree(con->cli_addr);
+		xfree(con);
+	}
 	slurm_free_msg(msg);
-	_decrement_thd_count();
-	return NULL;
+	if (prio)
+		_decrement_prio_thd_count();
+	else
+		_decrement_thd_count();
+}
+
+static void
+_record_rpc(uint16_t msg_type, struct timeval *start)
+{
+	static bool table_full = false;
+	struct timeval now;
+	uint32_t i;
+	uint64_t delta;
+
+	gettimeofday(&now, NULL);
+	delta = (now.tv_sec - start->tv_sec) * 1000000 +
+		(now.tv_usec - start->tv_usec);
+
+	slurm_mutex_lock(&rpc_mutex);
+	for (i = 0; i < rpc_type_size; i++) {
+		if (rpc_type_id[i] == msg_type)
+			break;
+	}
+	if (i == rpc_type_size) {
+		if (rpc_type_size == MAX_RPC_TYPES) {
+			if (!table_full) {
+				error("RPC statistics limited to %d message "
+				      "types, not recording type %u",
+				      MAX_RPC_TYPES, msg_type);
+				table_full = true;
+			}
+			slurm_mutex_unlock(&rpc_mutex);
+			return;
+		}
+		rpc_type_id[i] = msg_type;
+		rpc_type_size++;
+	}
+	rpc_type_cnt[i]++;
+	rpc_type_time[i] += delta;
+	if (delta > rpc_type_max[i])
+		rpc_type_max[i] = MIN(delta, NO_VAL);
+	slurm_mutex_unlock(&rpc_mutex);
+}
+
+extern void
+get_rpc_stats(uint32_t *size, uint16_t **type_id, uint32_t **type_cnt,
+	      uint32_t **type_ave_time, uint32_t **type_max_time)
+{
+	uint32_t i;
+
+	slurm_mutex_lock(&rpc_mutex);
+	*size          = rpc_type_size;
+	*type_id       = xmalloc(sizeof(uint16_t) * rpc_type_size);
+	*type_cnt      = xmalloc(sizeof(uint32_t) * rpc_type_size);
+	*type_ave_time = xmalloc(sizeof(uint32_t) * rpc_type_size);
+	*type_max_time = xmalloc(sizeof(uint32_t) * rpc_type_size);
+	for (i = 0; i < rpc_type_size; i++) {
+		(*type_id)[i]       = rpc_type_id[i];
+		(*type_cnt)[i]      = rpc_type_cnt[i];
+		(*type_ave_time)[i] = rpc_type_time[i] / rpc_type_cnt[i];
+		(*type_max_time)[i] = rpc_type_max[i];
+	}
+	slurm_mutex_unlock(&rpc_mutex);
 }
 
 extern int
@@ -596,6 +1002,33 @@ send_registration_msg(uint32_t status, bool startup)
 	return ret_val;
 }
 
+extern int
+reply_registration_msg(slurm_msg_t *req, bool startup)
+{
+	int ret_val = SLURM_SUCCESS;
+	slurm_msg_t resp_msg;
+	slurm_node_registration_status_msg_t *msg =
+		xmalloc (sizeof (slurm_node_registration_status_msg_t));
+
+	msg->startup = (uint16_t) startup;
+	_fill_registration_msg(msg);
+	msg->status  = SLURM_SUCCESS;
+
+	slurm_msg_t_copy(&resp_msg, req);
+	resp_msg.msg_type = MESSAGE_NODE_REGISTRATION_STATUS;
+	resp_msg.data     = msg;
+
+	if (slurm_send_node_msg(req->conn_fd, &resp_msg) < 0) {
+		error("Unable to reply with registration: %m");
+		ret_val = SLURM_FAILURE;
+	} else {
+		sent_reg_time = time(NULL);
+	}
+	slurm_free_node_registration_status_msg (msg);
+
+	return ret_val;
+}
+
 static void
 _fill_registration_msg(slurm_node_registration_status_msg_t *msg)
 {
@@ -738,7 +1171,7 @@ _massage_pathname(char **path)
 static void
 _read_config(void)
 {
-	char *path_pubkey = NULL;
+	char *path_pubkey = NULL, *tmp_ptr;
 	slurm_ctl_conf_t *cf = NULL;
 	uint16_t tmp16 = 0;
 
@@ -937,6 +1370,28 @@ _read_config(void)
 	conf->use_pam = cf->use_pam;
 	conf->task_plugin_param = cf->task_plugin_param;
 
+	conf->msg_threads = DEFAULT_MSG_THREADS;
+	if (cf->slurmd_params &&
+	    (tmp_ptr = strstr(cf->slurmd_params, "msg_threads="))) {
+		int msg_threads = atoi(tmp_ptr + 12);
+		if ((msg_threads < 0) || (msg_threads > MAX_THREADS)) {
+			error("Invalid SlurmdParameters msg_threads: %d",
+			      msg_threads);
+		} else
+			conf->msg_threads = msg_threads;
+	}
+
+	conf->stepd_pool_size = 0;
+	if (cf->slurmd_params &&
+	    (tmp_ptr = strstr(cf->slurmd_params, "stepd_pool="))) {
+		int pool_size = atoi(tmp_ptr + 11);
+		if ((pool_size < 0) || (pool_size > STEPD_POOL_MAX)) {
+			error("Invalid SlurmdParameters stepd_pool: %d",
+			      pool_size);
+		} else
+			conf->stepd_pool_size = pool_size;
+	}
+
 	slurm_mutex_unlock(&conf->config_mutex);
 	slurm_conf_unlock();
 }
@@ -968,6 +1423,13 @@ _reconfigure(void)
 
 	_print_conf();
 
+	/*
+	 * Discard any idle slurmstepds, they were started with the old
+	 * configuration
+	 */
+	stepd_pool_reconfig(conf->stepd_pool_size);
+	conn_cache_init();
+
 	/*
 	 * Make best effort at changing to new public key
 	 */
@@ -1583,6 +2045,8 @@ cleanup:
 static int
 _slurmd_fini(void)
 {
+	stepd_pool_fini();
+	conn_cache_fini();
 	switch_g_node_fini();
 	jobacct_gather_fini();
 	acct_gather_profile_fini();
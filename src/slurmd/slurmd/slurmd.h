@@ -148,6 +148,8 @@ typedef struct slurmd_config {
 	uint16_t	task_plugin_param; /* TaskPluginParams, expressed
 					 * using cpu_bind_type_t flags */
 	uint16_t	propagate_prio;	/* PropagatePrioProcess flag       */
+	uint16_t	msg_threads;	/* SlurmdParameters=msg_threads=# */
+	uint16_t	stepd_pool_size; /* SlurmdParameters=stepd_pool=#  */
 
 	List		starting_steps; /* steps that are starting but cannot
 					   receive RPCs yet */
@@ -166,6 +168,14 @@ extern slurmd_conf_t * conf;
  */
 int send_registration_msg(uint32_t status, bool startup);
 
+/* Reply to a slurmctld request with a node registration message, which
+ * the forwarding tree returns to slurmctld together with those of the
+ * other nodes the request was sent to
+ * IN req - REQUEST_NODE_REGISTRATION_STATUS message being answered
+ * IN startup - non-zero if slurmd just restarted
+ */
+int reply_registration_msg(slurm_msg_t *req, bool startup);
+
 /*
  * save_cred_state - save the current credential list to a file
  * IN list - list of credentials
@@ -173,5 +183,17 @@ int send_registration_msg(uint32_t status, bool startup);
  */
 int save_cred_state(slurm_cred_ctx_t vctx);
 
+/*
+ * get_rpc_stats - report the RPCs processed by message type
+ * OUT size - number of message types reported
+ * OUT type_id, type_cnt - message type and count of RPCs processed
+ * OUT type_ave_time, type_max_time - average and maximum latency in usec,
+ *	including time spent waiting for a worker thread
+ * NOTE: the arrays must be freed with xfree()
+ */
+extern void get_rpc_stats(uint32_t *size, uint16_t **type_id,
+			  uint32_t **type_cnt, uint32_t **type_ave_time,
+			  uint32_t **type_max_time);
+
 
 #endif /* !_SLURMD_H */
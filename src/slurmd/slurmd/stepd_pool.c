@@ -0,0 +1,376 @@
+/*****************************************************************************\
+ *  stepd_pool.c - pool of pre-started slurmstepd processes
+ *****************************************************************************
+ *  Copyright (C) 2014 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * Launching a job step normally forks and execs a new slurmstepd, which
+ * then loads its plugins before it can start the tasks.  When configured
+ * with SlurmdParameters=stepd_pool=#, slurmd keeps that many slurmstepd
+ * processes started ahead of time, each blocked reading its initialization
+ * data from slurmd with its plugins already loaded.  A launch request takes
+ * one of them and the pool is refilled in the background by a thread of
+ * its own, so the launch RPC never waits for a fork or exec.
+ */
+
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "slurm/slurm_errno.h"
+
+#include "src/common/fd.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+#include "src/slurmd/common/slurmstepd_init.h"
+#include "src/slurmd/slurmd/slurmd.h"
+#include "src/slurmd/slurmd/stepd_pool.h"
+
+typedef struct pooled_stepd {
+	int to_stepd;		/* write end of slurmstepd's stdin */
+	int to_slurmd;		/* read end of slurmstepd's stdout */
+} pooled_stepd_t;
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  pool_cond = PTHREAD_COND_INITIALIZER;
+static pooled_stepd_t  pool[STEPD_POOL_MAX];
+static uint16_t pool_cnt = 0;		/* idle slurmstepds in pool */
+static uint16_t pool_size = 0;		/* configured pool size */
+static uint32_t pool_hits = 0, pool_misses = 0;
+static uint32_t pool_gen = 0;		/* bumped when the pool is emptied */
+static bool pool_shutdown = false;
+static pthread_t pool_thread = 0;
+
+static void _release_stepd(pooled_stepd_t *stepd)
+{
+	/* The slurmstepd exits when it reads EOF from its stdin */
+	(void) close(stepd->to_stepd);
+	(void) close(stepd->to_slurmd);
+}
+
+/* Return true if a pooled slurmstepd has exited since it was started */
+static bool _stepd_gone(pooled_stepd_t *stepd)
+{
+	struct pollfd pfd;
+
+	pfd.fd = stepd->to_slurmd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	if (poll(&pfd, 1, 0) < 0)
+		return true;
+	/* slurmstepd writes nothing before it is initialized, so any
+	 * event on its stdout means it is gone */
+	return (pfd.revents != 0);
+}
+
+static void *_pool_agent(void *arg)
+{
+	int to_stepd, to_slurmd;
+	uint32_t gen;
+
+	while (1) {
+		slurm_mutex_lock(&pool_mutex);
+		while (!pool_shutdown && (pool_cnt >= pool_size))
+			pthread_cond_wait(&pool_cond, &pool_mutex);
+		if (pool_shutdown) {
+			slurm_mutex_unlock(&pool_mutex);
+			break;
+		}
+		gen = pool_gen;
+		slurm_mutex_unlock(&pool_mutex);
+
+		if (stepd_exec(&to_stepd, &to_slurmd, true) != SLURM_SUCCESS) {
+			/* Avoid spinning if fork fails, e.g. out of memory */
+			sleep(1);
+			continue;
+		}
+		if (stepd_send_conf(to_stepd) < 0) {
+			error("stepd_pool: unable to send conf to slurmstepd");
+			(void) close(to_stepd);
+			(void) close(to_slurmd);
+			sleep(1);
+			continue;
+		}
+
+		/* Discard the slurmstepd if the configuration it was sent
+		 * was replaced in the meantime */
+		slurm_mutex_lock(&pool_mutex);
+		if (!pool_shutdown && (gen == pool_gen) &&
+		    (pool_cnt < pool_size)) {
+			pool[pool_cnt].to_stepd = to_stepd;
+			pool[pool_cnt].to_slurmd = to_slurmd;
+			pool_cnt++;
+			to_stepd = to_slurmd = -1;
+		}
+		slurm_mutex_unlock(&pool_mutex);
+		if (to_stepd >= 0) {
+			(void) close(to_stepd);
+			(void) close(to_slurmd);
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Fork and exec a slurmstepd whose stdin and stdout are pipes to slurmd.
+ *
+ * Note that this code forks twice and it is the grandchild that
+ * becomes the slurmstepd process, so the slurmstepd's parent process
+ * will be init, not slurmd.
+ */
+extern int stepd_exec(int *to_stepd, int *to_slurmd, bool pooled)
+{
+	pid_t pid;
+	int stdin_pipe[2] = {-1, -1};
+	int stdout_pipe[2] = {-1, -1};
+
+	if ((pipe(stdin_pipe) < 0) || (pipe(stdout_pipe) < 0)) {
+		error("stepd_exec: pipe failed: %m");
+		if (stdin_pipe[0] >= 0) {
+			close(stdin_pipe[0]);
+			close(stdin_pipe[1]);
+		}
+		return SLURM_FAILURE;
+	}
+
+	if ((pid = fork()) < 0) {
+		error("stepd_exec: fork: %m");
+		close(stdin_pipe[0]);
+		close(stdin_pipe[1]);
+		close(stdout_pipe[0]);
+		close(stdout_pipe[1]);
+		return SLURM_FAILURE;
+	} else if (pid > 0) {
+		if (close(stdin_pipe[0]) < 0)
+			error("Unable to close read to_stepd in parent: %m");
+		if (close(stdout_pipe[1]) < 0)
+			error("Unable to close write to_slurmd in parent: %m");
+
+		/* Keep other slurmstepds and scripts from inheriting
+		 * these, which would hide EOF from an idle slurmstepd */
+		fd_set_close_on_exec(stdin_pipe[1]);
+		fd_set_close_on_exec(stdout_pipe[0]);
+
+		/* Reap child */
+		if (waitpid(pid, NULL, 0) < 0)
+			error("Unable to reap slurmd child process");
+
+		*to_stepd = stdin_pipe[1];
+		*to_slurmd = stdout_pipe[0];
+		return SLURM_SUCCESS;
+	} else {
+#ifndef SLURMSTEPD_MEMCHECK
+		char *const argv[3] = { (char *)conf->stepd_loc,
+					pooled ? "pool" : NULL, NULL };
+#else
+		char *const argv[3] = {"memcheck",
+				       (char *)conf->stepd_loc, NULL};
+#endif
+		int failed = 0;
+		/* inform slurmstepd about our config */
+		setenv("SLURM_CONF", conf->conffile, 1);
+
+		/*
+		 * Child forks and exits
+		 */
+		if (setsid() < 0) {
+			error("stepd_exec: setsid: %m");
+			failed = 1;
+		}
+		if ((pid = fork()) < 0) {
+			error("stepd_exec: Unable to fork grandchild: %m");
+			failed = 2;
+		} else if (pid > 0) { /* child */
+			exit(0);
+		}
+
+		/*
+		 * Grandchild exec's the slurmstepd
+		 */
+		slurm_shutdown_msg_engine(conf->lfd);
+
+		if (close(stdin_pipe[1]) < 0)
+			error("close write to_stepd in grandchild: %m");
+		if (close(stdout_pipe[0]) < 0)
+			error("close read to_slurmd in parent: %m");
+
+		(void) close(STDIN_FILENO); /* ignore return */
+		if (dup2(stdin_pipe[0], STDIN_FILENO) == -1) {
+			error("dup2 over STDIN_FILENO: %m");
+			exit(1);
+		}
+		fd_set_close_on_exec(stdin_pipe[0]);
+		(void) close(STDOUT_FILENO); /* ignore return */
+		if (dup2(stdout_pipe[1], STDOUT_FILENO) == -1) {
+			error("dup2 over STDOUT_FILENO: %m");
+			exit(1);
+		}
+		fd_set_close_on_exec(stdout_pipe[1]);
+		(void) close(STDERR_FILENO); /* ignore return */
+		if (dup2(devnull, STDERR_FILENO) == -1) {
+			error("dup2 /dev/null to STDERR_FILENO: %m");
+			exit(1);
+		}
+		fd_set_noclose_on_exec(STDERR_FILENO);
+		log_fini();
+		if (!failed) {
+			execvp(argv[0], argv);
+			error("exec of slurmstepd failed: %m");
+		}
+		exit(2);
+	}
+}
+
+extern int stepd_send_conf(int fd)
+{
+	int len;
+	Buf buffer = init_buf(0);
+
+	pack_slurmd_conf_lite(conf, buffer);
+	len = get_buf_offset(buffer);
+	safe_write(fd, &len, sizeof(int));
+	safe_write(fd, get_buf_data(buffer), len);
+	free_buf(buffer);
+	return 0;
+
+rwfail:
+	free_buf(buffer);
+	return -1;
+}
+
+extern void stepd_pool_reconfig(uint16_t size)
+{
+	pthread_attr_t attr;
+	int i;
+
+#ifdef SLURMSTEPD_MEMCHECK
+	size = 0;	/* memcheck wrapper can not be started in advance */
+#endif
+	if (size > STEPD_POOL_MAX)
+		size = STEPD_POOL_MAX;
+
+	slurm_mutex_lock(&pool_mutex);
+	for (i = 0; i < pool_cnt; i++)
+		_release_stepd(&pool[i]);
+	pool_cnt = 0;
+	pool_gen++;
+	pool_size = size;
+	if (size && !pool_thread) {
+		pool_shutdown = false;
+		slurm_attr_init(&attr);
+		if (pthread_create(&pool_thread, &attr, _pool_agent, NULL)) {
+			error("stepd_pool: pthread_create: %m");
+			pool_thread = 0;
+		}
+		slurm_attr_destroy(&attr);
+	}
+	pthread_cond_signal(&pool_cond);
+	slurm_mutex_unlock(&pool_mutex);
+
+	if (size)
+		debug("slurmstepd pool size set to %u", size);
+}
+
+extern void stepd_pool_fini(void)
+{
+	int i;
+	pthread_t thread_id;
+
+	slurm_mutex_lock(&pool_mutex);
+	pool_shutdown = true;
+	pthread_cond_signal(&pool_cond);
+	thread_id = pool_thread;
+	pool_thread = 0;
+	slurm_mutex_unlock(&pool_mutex);
+
+	if (thread_id)
+		pthread_join(thread_id, NULL);
+
+	slurm_mutex_lock(&pool_mutex);
+	for (i = 0; i < pool_cnt; i++)
+		_release_stepd(&pool[i]);
+	pool_cnt = 0;
+	slurm_mutex_unlock(&pool_mutex);
+}
+
+extern int stepd_pool_get(int *to_stepd, int *to_slurmd)
+{
+	pooled_stepd_t stepd;
+	int rc = SLURM_ERROR;
+
+	slurm_mutex_lock(&pool_mutex);
+	if (!pool_size) {
+		slurm_mutex_unlock(&pool_mutex);
+		return SLURM_ERROR;
+	}
+	while (pool_cnt) {
+		stepd = pool[--pool_cnt];
+		if (_stepd_gone(&stepd)) {
+			error("stepd_pool: idle slurmstepd exited unexpectedly");
+			_release_stepd(&stepd);
+			continue;
+		}
+		*to_stepd = stepd.to_stepd;
+		*to_slurmd = stepd.to_slurmd;
+		rc = SLURM_SUCCESS;
+		break;
+	}
+	if (rc == SLURM_SUCCESS)
+		pool_hits++;
+	else
+		pool_misses++;
+	pthread_cond_signal(&pool_cond);
+	slurm_mutex_unlock(&pool_mutex);
+
+	return rc;
+}
+
+extern void stepd_pool_stats(uint16_t *size, uint16_t *idle,
+			     uint32_t *hits, uint32_t *misses)
+{
+	slurm_mutex_lock(&pool_mutex);
+	*size = pool_size;
+	*idle = pool_cnt;
+	*hits = pool_hits;
+	*misses = pool_misses;
+	slurm_mutex_unlock(&pool_mutex);
+}
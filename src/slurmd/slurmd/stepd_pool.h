@@ -0,0 +1,88 @@
+/*****************************************************************************\
+ *  stepd_pool.h - pool of pre-started slurmstepd processes
+ *****************************************************************************
+ *  Copyright (C) 2014 SchedMD LLC.
+ *
+ *  This file is part of SLURM, a resource management program.
+ *  For details, see <http://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  SLURM is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  SLURM is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with SLURM; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _STEPD_POOL_H
+#define _STEPD_POOL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Largest value accepted for SlurmdParameters=stepd_pool=# */
+#define STEPD_POOL_MAX 64
+
+/*
+ * Fork and exec a slurmstepd whose stdin and stdout are pipes to slurmd.
+ * The slurmstepd is reparented to init and blocks until it is sent its
+ * initialization data by _send_slurmstepd_init() in req.c.
+ *
+ * OUT to_stepd - write end of the slurmstepd's stdin
+ * OUT to_slurmd - read end of the slurmstepd's stdout
+ * IN pooled - if set, the slurmstepd first reads its configuration, sent by
+ *	stepd_send_conf(), and preloads its plugins before waiting
+ * RET SLURM_SUCCESS or SLURM_FAILURE
+ */
+extern int stepd_exec(int *to_stepd, int *to_slurmd, bool pooled);
+
+/*
+ * Send slurmd's configuration to a slurmstepd.
+ * IN fd - write end of the slurmstepd's stdin
+ * RET 0 on success, -1 on failure
+ */
+extern int stepd_send_conf(int fd);
+
+/*
+ * Set the number of idle slurmstepd processes to keep, discarding any
+ * already started (they may be using an outdated configuration) and
+ * starting the pool's refill thread if needed.  Called at startup and on
+ * reconfiguration.
+ */
+extern void stepd_pool_reconfig(uint16_t size);
+
+/* Stop the refill thread and release all idle slurmstepd processes */
+extern void stepd_pool_fini(void);
+
+/*
+ * Take an idle slurmstepd from the pool, see stepd_exec() for the
+ * meaning of the arguments.
+ * RET SLURM_SUCCESS, or SLURM_ERROR if the pool was empty
+ */
+extern int stepd_pool_get(int *to_stepd, int *to_slurmd);
+
+/* Report the pool's configured size, current number of idle processes and
+ * the number of launches which did or did not find one available */
+extern void stepd_pool_stats(uint16_t *size, uint16_t *idle,
+			     uint32_t *hits, uint32_t *misses);
+
+#endif /* !_STEPD_POOL_H */
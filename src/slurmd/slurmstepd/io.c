@@ -68,6 +68,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
@@ -75,6 +76,7 @@
 #include "src/common/cbuf.h"
 #include "src/common/eio.h"
 #include "src/common/fd.h"
+#include "src/common/hostlist.h"
 #include "src/common/io_hdr.h"
 #include "src/common/list.h"
 #include "src/common/log.h"
@@ -87,6 +89,8 @@
 #include "src/common/xstring.h"
 
 
+#include "src/slurmd/common/reverse_tree.h"
+#include "src/slurmd/slurmd/reverse_tree_math.h"
 #include "src/slurmd/slurmd/slurmd.h"
 #include "src/slurmd/slurmstepd/io.h"
 #include "src/slurmd/slurmstepd/fname.h"
@@ -134,6 +138,11 @@ struct client_io_info {
 
 	/* true if writing to a file, false if writing to a socket */
 	bool is_local_file;
+
+	/* true for the connection to srun, or to our parent in the
+	 * stdio tree, that also carries the output of nodes below us */
+	bool tree_relay;
+	bool tree_eof_sent;	/* released the hold of io_tree_hold */
 };
 
 
@@ -194,8 +203,56 @@ struct task_read_info {
 	cbuf_t           buf;
 	bool		 eof;
 	bool		 eof_msg_sent;
+	struct timeval	 stall_start;	 /* when buf filled, or zero   */
+};
+
+/**********************************************************************
+ * stdio tree declarations
+ **********************************************************************/
+static bool _tree_readable(eio_obj_t *);
+static bool _tree_writable(eio_obj_t *);
+static int  _tree_read(eio_obj_t *, List);
+static int  _tree_write(eio_obj_t *, List);
+
+struct io_operations tree_ops = {
+	.readable = &_tree_readable,
+	.writable = &_tree_writable,
+	.handle_read = &_tree_read,
+	.handle_write = &_tree_write,
+};
+
+/*
+ * A connection from a slurmstepd below this one in the stdio tree.  The
+ * frames it sends are relayed unchanged towards srun, and stdin for the
+ * tasks below it is passed down to it.
+ */
+struct tree_io_info {
+#ifndef NDEBUG
+#define TREE_IO_MAGIC  0x10106
+	int                   magic;
+#endif
+	stepd_step_rec_t    *job;		 /* pointer back to job data   */
+	bool                 got_init;	 /* read the node's io init msg */
+
+	/* incoming variables */
+	struct slurm_io_header header;
+	struct io_buf *in_msg;
+	int32_t in_remaining;
+	bool in_eof;
+
+	/* outgoing variables */
+	List msg_queue;
+	struct io_buf *out_msg;
+	int32_t out_remaining;
+	bool out_eof;
 };
 
+static void _tree_route_stdin(stepd_step_rec_t *job, io_hdr_t *header,
+			      struct io_buf *in);
+static bool _tree_release_hold(stepd_step_rec_t *job);
+static struct io_buf *_build_tree_eof_message(stepd_step_rec_t *job);
+static int  _tree_parent_connect(stepd_step_rec_t *job);
+
 /**********************************************************************
  * Pseudo terminal declarations
  **********************************************************************/
@@ -213,17 +270,28 @@ static void *_window_manager(void *arg);
  * General declarations
  **********************************************************************/
 static void *_io_thr(void *);
-static int _send_io_init_msg(int sock, srun_key_t *key, stepd_step_rec_t *job);
+static int _send_io_init_msg(int sock, srun_key_t *key, stepd_step_rec_t *job,
+			     bool tree_relay);
 static void _send_eof_msg(struct task_read_info *out);
 static struct io_buf *_task_build_message(struct task_read_info *out,
 					  stepd_step_rec_t *job, cbuf_t cbuf);
 static void *_io_thr(void *arg);
 static void _route_msg_task_to_client(eio_obj_t *obj);
+static void _task_queue_message(struct task_read_info *out,
+				struct io_buf *msg);
+static void _task_pack_header(struct task_read_info *out,
+			      struct io_buf *msg, int len);
 static void _free_outgoing_msg(struct io_buf *msg, stepd_step_rec_t *job);
 static void _free_incoming_msg(struct io_buf *msg, stepd_step_rec_t *job);
 static void _free_all_outgoing_msgs(List msg_queue, stepd_step_rec_t *job);
 static bool _incoming_buf_free(stepd_step_rec_t *job);
 static bool _outgoing_buf_free(stepd_step_rec_t *job);
+static struct io_buf *_incoming_buf_get(stepd_step_rec_t *job);
+static void _incoming_buf_put(stepd_step_rec_t *job, struct io_buf *buf);
+static struct io_buf *_outgoing_buf_get(stepd_step_rec_t *job);
+static void _outgoing_buf_put(stepd_step_rec_t *job, struct io_buf *buf);
+static struct io_buf *_outgoing_buf_alloc(stepd_step_rec_t *job);
+static inline int _outgoing_cache_max(stepd_step_rec_t *job);
 static int  _send_connection_okay_response(stepd_step_rec_t *job);
 static struct io_buf *_build_connection_okay_message(stepd_step_rec_t *job);
 
@@ -295,6 +363,18 @@ _client_writable(eio_obj_t *obj)
 		list_append(client->job->clients, (void *)obj);
 	}
 
+	/* Once the nodes below us are done, send the eof message that
+	 * stands for them, see _send_io_init_msg() */
+	if (client->tree_relay && !client->tree_eof_sent &&
+	    client->job->io_tree_hold && _tree_release_hold(client->job)) {
+		struct io_buf *msg = _build_tree_eof_message(client->job);
+		if (msg) {
+			msg->ref_count = 1;
+			list_enqueue(client->msg_queue, msg);
+			client->tree_eof_sent = true;
+		}
+	}
+
 	if (client->out_msg != NULL)
 		debug5("  client->out.msg != NULL");
 	if (!list_is_empty(client->msg_queue))
@@ -323,10 +403,9 @@ _client_read(eio_obj_t *obj, List objs)
 	 * Read the header, if a message read is not already in progress
 	 */
 	if (client->in_msg == NULL) {
-		if (_incoming_buf_free(client->job)) {
-			client->in_msg =
-				list_dequeue(client->job->free_incoming);
-		} else {
+		if (_incoming_buf_free(client->job))
+			client->in_msg = _incoming_buf_get(client->job);
+		if (client->in_msg == NULL) {
 			debug5("  _client_read free_incoming is empty");
 			return SLURM_SUCCESS;
 		}
@@ -334,7 +413,7 @@ _client_read(eio_obj_t *obj, List objs)
 		if (n <= 0) { /* got eof or fatal error */
 			debug5("  got eof or error _client_read header, n=%d", n);
 			client->in_eof = true;
-			list_enqueue(client->job->free_incoming, client->in_msg);
+			_incoming_buf_put(client->job, client->in_msg);
 			client->in_msg = NULL;
 			return SLURM_SUCCESS;
 		}
@@ -352,7 +431,7 @@ _client_read(eio_obj_t *obj, List objs)
 	if (client->header.type == SLURM_IO_CONNECTION_TEST) {
 		if (client->header.length != 0) {
 			debug5("  error in _client_read: bad connection test");
-			list_enqueue(client->job->free_incoming, client->in_msg);
+			_incoming_buf_put(client->job, client->in_msg);
 			client->in_msg = NULL;
 			return SLURM_ERROR;
 		}
@@ -366,7 +445,7 @@ _client_read(eio_obj_t *obj, List objs)
 			 */
 			return SLURM_SUCCESS;
 		}
-		list_enqueue(client->job->free_incoming, client->in_msg);
+		_incoming_buf_put(client->job, client->in_msg);
 		client->in_msg = NULL;
 		return SLURM_SUCCESS;
 	} else if (client->header.length == 0) { /* zero length is an eof message */
@@ -388,7 +467,7 @@ _client_read(eio_obj_t *obj, List objs)
 		if (n <= 0) { /* got eof (or unhandled error) */
 			debug5("  got eof on _client_read body");
 			client->in_eof = true;
-			list_enqueue(client->job->free_incoming, client->in_msg);
+			_incoming_buf_put(client->job, client->in_msg);
 			client->in_msg = NULL;
 			return SLURM_SUCCESS;
 		}
@@ -434,6 +513,13 @@ _client_read(eio_obj_t *obj, List objs)
 				break;
 			}
 		}
+		/* Pass it on to the nodes below us in the stdio tree */
+		if (client->job->io_tree_route && client->tree_relay) {
+			_tree_route_stdin(client->job, &client->header,
+					  client->in_msg);
+		}
+		if (client->in_msg->ref_count == 0)
+			_incoming_buf_put(client->job, client->in_msg);
 	}
 	client->in_msg = NULL;
 	debug4("Leaving  _client_read");
@@ -504,6 +590,343 @@ again:
 	return SLURM_SUCCESS;
 }
 
+/**********************************************************************
+ * stdio tree functions
+ **********************************************************************/
+static bool
+_tree_readable(eio_obj_t *obj)
+{
+	struct tree_io_info *tree = (struct tree_io_info *) obj->arg;
+
+	xassert(tree->magic == TREE_IO_MAGIC);
+
+	/* Connections from below are not shut down with our own clients,
+	 * io_tree_wait() has already waited for them to close */
+	if (tree->in_eof || (obj->shutdown && tree->job->io_tree_abort))
+		return false;
+
+	if (tree->in_msg != NULL || _outgoing_buf_free(tree->job))
+		return true;
+
+	return false;
+}
+
+static void
+_tree_free_msg(struct io_buf *msg)
+{
+	if (--msg->ref_count == 0)
+		free_io_buf(msg);
+}
+
+/* Called on eof or error, the node below will not reconnect */
+static void
+_tree_close(eio_obj_t *obj)
+{
+	struct tree_io_info *tree = (struct tree_io_info *) obj->arg;
+	stepd_step_rec_t *job = tree->job;
+	struct io_buf *msg;
+	uint32_t i;
+
+	if (tree->in_msg) {
+		_outgoing_buf_put(job, tree->in_msg);
+		tree->in_msg = NULL;
+	}
+	if (tree->out_msg) {
+		_tree_free_msg(tree->out_msg);
+		tree->out_msg = NULL;
+	}
+	while ((msg = list_dequeue(tree->msg_queue)))
+		_tree_free_msg(msg);
+	for (i = 0; i < job->nnodes; i++) {
+		if (job->io_tree_route[i] == obj)
+			job->io_tree_route[i] = NULL;
+	}
+	tree->in_eof = true;
+	tree->out_eof = true;
+	close(obj->fd);
+	obj->fd = -1;
+
+	pthread_mutex_lock(&job->io_tree_lock);
+	job->io_tree_conns--;
+	pthread_cond_broadcast(&job->io_tree_cond);
+	pthread_mutex_unlock(&job->io_tree_lock);
+}
+
+/*
+ * Handle the io init message of a node at or below the other end of this
+ * connection, so that stdin for its tasks can be routed to it.
+ */
+static int
+_tree_node_init(eio_obj_t *obj)
+{
+	struct tree_io_info *tree = (struct tree_io_info *) obj->arg;
+	stepd_step_rec_t *job = tree->job;
+	srun_info_t *srun = list_peek(job->sruns);
+	struct slurm_io_init_msg msg;
+	Buf packbuf;
+	int rc;
+
+	packbuf = create_buf(tree->in_msg->data + io_hdr_packed_size(),
+			     tree->header.length);
+	rc = io_init_msg_unpack(&msg, packbuf);
+	packbuf->head = NULL;
+	free_buf(packbuf);
+
+	if ((rc != SLURM_SUCCESS) || !srun ||
+	    (io_init_msg_validate(&msg, srun->key->data) != SLURM_SUCCESS))
+		return SLURM_ERROR;
+	if (msg.nodeid >= job->nnodes) {
+		error("stdio tree: invalid nodeid %u", msg.nodeid);
+		return SLURM_ERROR;
+	}
+	debug3("stdio tree: node %u connected", msg.nodeid);
+	job->io_tree_route[msg.nodeid] = obj;
+
+	if (!tree->got_init) {
+		tree->got_init = true;
+		pthread_mutex_lock(&job->io_tree_lock);
+		job->io_tree_pending--;
+		pthread_cond_broadcast(&job->io_tree_cond);
+		pthread_mutex_unlock(&job->io_tree_lock);
+	}
+	return SLURM_SUCCESS;
+}
+
+/* Queue a message from below on the connection(s) towards srun */
+static void
+_tree_relay(stepd_step_rec_t *job, struct io_buf *msg)
+{
+	struct client_io_info *client;
+	eio_obj_t *eio;
+	ListIterator clients;
+
+	msg->ref_count = 0;
+	clients = list_iterator_create(job->clients);
+	while ((eio = list_next(clients))) {
+		client = (struct client_io_info *)eio->arg;
+		xassert(client->magic == CLIENT_IO_MAGIC);
+		if (!client->tree_relay || client->out_eof)
+			continue;
+		if (list_enqueue(client->msg_queue, msg))
+			msg->ref_count++;
+	}
+	list_iterator_destroy(clients);
+
+	if (msg->ref_count == 0)
+		_outgoing_buf_put(job, msg);
+}
+
+/*
+ * Read messages from a node below us.  The first is its io init message,
+ * which has no header of its own, see _send_io_init_msg().  It is relayed
+ * to srun as a SLURM_IO_NODE_INIT message.
+ */
+static int
+_tree_read(eio_obj_t *obj, List objs)
+{
+	struct tree_io_info *tree = (struct tree_io_info *) obj->arg;
+	stepd_step_rec_t *job = tree->job;
+	Buf packbuf;
+	void *buf;
+	int n;
+
+	xassert(tree->magic == TREE_IO_MAGIC);
+
+	if (tree->in_msg == NULL) {
+		if (_outgoing_buf_free(job))
+			tree->in_msg = _outgoing_buf_get(job);
+		if (tree->in_msg == NULL)
+			return SLURM_SUCCESS;
+		if (!tree->got_init) {
+			tree->header.type = SLURM_IO_NODE_INIT;
+			tree->header.ltaskid = 0;
+			tree->header.gtaskid = 0;
+			tree->header.length = io_init_msg_packed_size();
+		} else {
+			n = io_hdr_read_fd(obj->fd, &tree->header);
+			if (n <= 0) {
+				debug3("stdio tree: eof from node below");
+				_tree_close(obj);
+				return SLURM_SUCCESS;
+			}
+			if ((tree->header.type != SLURM_IO_STDOUT &&
+			     tree->header.type != SLURM_IO_STDERR &&
+			     tree->header.type != SLURM_IO_NODE_INIT) ||
+			    (tree->header.length > job->io_msg_len)) {
+				error("stdio tree: bad message type %u "
+				      "length %u", tree->header.type,
+				      tree->header.length);
+				_tree_close(obj);
+				return SLURM_ERROR;
+			}
+		}
+		tree->in_remaining = tree->header.length;
+		tree->in_msg->length = io_hdr_packed_size() +
+				       tree->header.length;
+	}
+
+	/*
+	 * Read the body
+	 */
+	if (tree->in_remaining > 0) {
+		buf = tree->in_msg->data +
+			(tree->in_msg->length - tree->in_remaining);
+	again:
+		if ((n = read(obj->fd, buf, tree->in_remaining)) < 0) {
+			if (errno == EINTR)
+				goto again;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return SLURM_SUCCESS;
+			debug3("stdio tree: read error: %m");
+		}
+		if (n <= 0) {
+			_tree_close(obj);
+			return SLURM_SUCCESS;
+		}
+		tree->in_remaining -= n;
+		if (tree->in_remaining > 0)
+			return SLURM_SUCCESS;
+	}
+
+	if ((tree->header.type == SLURM_IO_NODE_INIT) &&
+	    (_tree_node_init(obj) != SLURM_SUCCESS)) {
+		error("stdio tree: bad io init message from node below");
+		_tree_close(obj);
+		return SLURM_ERROR;
+	}
+
+	/* Messages are relayed as sent, header and all */
+	packbuf = create_buf(tree->in_msg->data, io_hdr_packed_size());
+	io_hdr_pack(&tree->header, packbuf);
+	packbuf->head = NULL;
+	free_buf(packbuf);
+
+	_tree_relay(job, tree->in_msg);
+	tree->in_msg = NULL;
+	return SLURM_SUCCESS;
+}
+
+static bool
+_tree_writable(eio_obj_t *obj)
+{
+	struct tree_io_info *tree = (struct tree_io_info *) obj->arg;
+
+	xassert(tree->magic == TREE_IO_MAGIC);
+
+	if (tree->out_eof)
+		return false;
+	if (tree->out_msg != NULL || !list_is_empty(tree->msg_queue))
+		return true;
+	return false;
+}
+
+/* Write stdin messages to a node below us */
+static int
+_tree_write(eio_obj_t *obj, List objs)
+{
+	struct tree_io_info *tree = (struct tree_io_info *) obj->arg;
+	struct io_buf *msg;
+	void *buf;
+	int n;
+
+	xassert(tree->magic == TREE_IO_MAGIC);
+
+	if (tree->out_msg == NULL) {
+		tree->out_msg = list_dequeue(tree->msg_queue);
+		if (tree->out_msg == NULL)
+			return SLURM_SUCCESS;
+		tree->out_remaining = tree->out_msg->length;
+	}
+
+	buf = tree->out_msg->data +
+		(tree->out_msg->length - tree->out_remaining);
+again:
+	if ((n = write(obj->fd, buf, tree->out_remaining)) < 0) {
+		if (errno == EINTR)
+			goto again;
+		if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+			return SLURM_SUCCESS;
+		debug3("stdio tree: write error: %m");
+		tree->out_eof = true;
+		_tree_free_msg(tree->out_msg);
+		tree->out_msg = NULL;
+		while ((msg = list_dequeue(tree->msg_queue)))
+			_tree_free_msg(msg);
+		return SLURM_SUCCESS;
+	}
+	tree->out_remaining -= n;
+	if (tree->out_remaining > 0)
+		return SLURM_SUCCESS;
+
+	_tree_free_msg(tree->out_msg);
+	tree->out_msg = NULL;
+	return SLURM_SUCCESS;
+}
+
+static void
+_tree_queue_stdin(eio_obj_t *obj, io_hdr_t *header, struct io_buf *in,
+		  struct io_buf **msg)
+{
+	struct tree_io_info *tree = (struct tree_io_info *) obj->arg;
+	Buf packbuf;
+
+	if (tree->out_eof)
+		return;
+
+	/* Messages read from srun hold only the body, add the header */
+	if (*msg == NULL) {
+		*msg = alloc_io_buf(header->length);
+		packbuf = create_buf((*msg)->data, io_hdr_packed_size());
+		io_hdr_pack(header, packbuf);
+		packbuf->head = NULL;
+		free_buf(packbuf);
+		if (header->length) {
+			memcpy((*msg)->data + io_hdr_packed_size(), in->data,
+			       header->length);
+		}
+		(*msg)->length = io_hdr_packed_size() + header->length;
+	}
+	(*msg)->ref_count++;
+	list_enqueue(tree->msg_queue, *msg);
+}
+
+/* Pass stdin for tasks on nodes below us down the tree */
+static void
+_tree_route_stdin(stepd_step_rec_t *job, io_hdr_t *header,
+		  struct io_buf *in)
+{
+	struct io_buf *msg = NULL;
+	ListIterator children;
+	eio_obj_t *obj;
+	uint32_t nodeid;
+
+	if (header->type == SLURM_IO_ALLSTDIN) {
+		children = list_iterator_create(job->io_tree_children);
+		while ((obj = list_next(children)))
+			_tree_queue_stdin(obj, header, in, &msg);
+		list_iterator_destroy(children);
+	} else if (header->gtaskid < job->ntasks) {
+		nodeid = job->io_tree_task_node[header->gtaskid];
+		if ((nodeid != job->nodeid) && (nodeid < job->nnodes) &&
+		    (obj = job->io_tree_route[nodeid]))
+			_tree_queue_stdin(obj, header, in, &msg);
+	}
+}
+
+/* True once all the nodes below us are done with their stdio */
+static bool
+_tree_release_hold(stepd_step_rec_t *job)
+{
+	bool done;
+
+	pthread_mutex_lock(&job->io_tree_lock);
+	done = job->io_tree_closed &&
+	       ((job->io_tree_conns == 0) || job->io_tree_abort);
+	pthread_mutex_unlock(&job->io_tree_lock);
+
+	return done;
+}
+
 
 static bool
 _local_file_writable(eio_obj_t *obj)
@@ -699,6 +1122,7 @@ again:
 		}
 	}
 	in->remaining -= n;
+	in->job->stdio_in_bytes += n;
 	if (in->remaining > 0)
 		return SLURM_SUCCESS;
 
@@ -729,7 +1153,7 @@ _create_task_out_eio(int fd, uint16_t type,
 	out->gtaskid = task->gtid;
 	out->ltaskid = task->id;
 	out->job = job;
-	out->buf = cbuf_create(MAX_MSG_LEN, MAX_MSG_LEN*4);
+	out->buf = cbuf_create(MAX_MSG_LEN, job->io_msg_len*4);
 	out->eof = false;
 	out->eof_msg_sent = false;
 	if (cbuf_opt_set(out->buf, CBUF_OPT_OVERWRITE, CBUF_NO_DROP) == -1)
@@ -754,13 +1178,48 @@ _task_readable(eio_obj_t *obj)
 	}
 	if (cbuf_free(out->buf) > 0) {
 		debug5("  cbuf_free = %d", cbuf_free(out->buf));
+		if (out->stall_start.tv_sec) {
+			struct timeval now;
+			gettimeofday(&now, NULL);
+			out->job->stdio_stall_usec +=
+				(now.tv_sec - out->stall_start.tv_sec) *
+				1000000 +
+				(now.tv_usec - out->stall_start.tv_usec);
+			out->stall_start.tv_sec = 0;
+		}
 		return true;
 	}
 
+	/* The task is blocked until clients take some of its output */
+	if (!out->stall_start.tv_sec)
+		gettimeofday(&out->stall_start, NULL);
 	debug5("  false");
 	return false;
 }
 
+/*
+ * Without line buffering, and with nothing already waiting in the cbuf,
+ * read a task's output directly into the payload of a message and queue
+ * it for the clients, avoiding the copies into and out of the cbuf.
+ * Returns the read() return value.
+ */
+static int
+_task_read_message(eio_obj_t *obj, struct task_read_info *out,
+		   struct io_buf *msg)
+{
+	int n;
+
+	n = read(obj->fd, msg->data + io_hdr_packed_size(),
+		 out->job->io_msg_len);
+	if (n <= 0) {
+		_outgoing_buf_put(out->job, msg);
+		return n;
+	}
+	_task_pack_header(out, msg, n);
+	_task_queue_message(out, msg);
+	return n;
+}
+
 /*
  * Read output (stdout or stderr) from a task into a cbuf.  The cbuf
  * allows whole lines to be packed into messages if line buffering
@@ -770,6 +1229,7 @@ static int
 _task_read(eio_obj_t *obj, List objs)
 {
 	struct task_read_info *out = (struct task_read_info *)obj->arg;
+	struct io_buf *msg;
 	int len;
 	int rc = -1;
 
@@ -779,8 +1239,15 @@ _task_read(eio_obj_t *obj, List objs)
 	len = cbuf_free(out->buf);
 	if (len > 0 && !out->eof) {
 again:
-		if ((rc = cbuf_write_from_fd(out->buf, obj->fd, len, NULL))
-		    < 0) {
+		msg = NULL;
+		if (!out->job->buffered_stdio && (cbuf_used(out->buf) == 0)
+		    && _outgoing_buf_free(out->job))
+			msg = _outgoing_buf_get(out->job);
+		if (msg)
+			rc = _task_read_message(obj, out, msg);
+		else
+			rc = cbuf_write_from_fd(out->buf, obj->fd, len, NULL);
+		if (rc < 0) {
 			if (errno == EINTR)
 				goto again;
 			if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
@@ -1195,16 +1662,22 @@ void
 _shrink_msg_cache(List cache, stepd_step_rec_t *job)
 {
 	struct io_buf *msg;
-	int over = 0;
+	ListIterator iter;
+	int bytes = 0;
 	int count;
-	int i;
 
 	count = list_count(cache);
-	if (count > STDIO_MAX_MSG_CACHE)
-		over = count - STDIO_MAX_MSG_CACHE;
-
-	for (i = 0; i < over; i++) {
+	iter = list_iterator_create(cache);
+	while ((msg = list_next(iter)))
+		bytes += msg->length;
+	list_iterator_destroy(iter);
+
+	/* Keep at least the newest message, however large */
+	while ((count > _outgoing_cache_max(job)) ||
+	       ((count > 1) && (bytes > STDIO_MAX_CACHE_BYTES))) {
 		msg = list_dequeue(cache);
+		count--;
+		bytes -= msg->length;
 		/* FIXME - following call MIGHT lead to too much recursion */
 		_free_outgoing_msg(msg, job);
 	}
@@ -1252,11 +1725,8 @@ _build_connection_okay_message(stepd_step_rec_t *job)
 	Buf packbuf;
 	struct slurm_io_header header;
 
-	if (_outgoing_buf_free(job)) {
-		msg = list_dequeue(job->free_outgoing);
-	} else {
+	if (!_outgoing_buf_free(job) || !(msg = _outgoing_buf_get(job)))
 		return NULL;
-	}
 
 	header.type = SLURM_IO_CONNECTION_TEST;
 	header.ltaskid = 0;  /* Unused */
@@ -1281,14 +1751,39 @@ _build_connection_okay_message(stepd_step_rec_t *job)
 
 
 
+/* An eof message which stands for all of the nodes below us */
+static struct io_buf *
+_build_tree_eof_message(stepd_step_rec_t *job)
+{
+	struct io_buf *msg;
+	Buf packbuf;
+	struct slurm_io_header header;
+
+	if (!_outgoing_buf_free(job) || !(msg = _outgoing_buf_get(job)))
+		return NULL;
+
+	header.type = SLURM_IO_STDOUT;
+	header.ltaskid = 0;  /* Unused */
+	header.gtaskid = 0;  /* Unused */
+	header.length = 0;
+
+	packbuf = create_buf(msg->data, io_hdr_packed_size());
+	io_hdr_pack(&header, packbuf);
+	msg->length = io_hdr_packed_size();
+	msg->ref_count = 0;
+
+	/* free the Buf packbuf, but not the memory to which it points */
+	packbuf->head = NULL;
+	free_buf(packbuf);
+
+	return msg;
+}
+
 static void
 _route_msg_task_to_client(eio_obj_t *obj)
 {
 	struct task_read_info *out = (struct task_read_info *)obj->arg;
-	struct client_io_info *client;
 	struct io_buf *msg = NULL;
-	eio_obj_t *eio;
-	ListIterator clients;
 
 	/* Pack task output into messages for transfer to a client */
 	while (cbuf_used(out->buf) > 0
@@ -1297,38 +1792,47 @@ _route_msg_task_to_client(eio_obj_t *obj)
 		msg = _task_build_message(out, out->job, out->buf);
 		if (msg == NULL)
 			return;
+		_task_queue_message(out, msg);
+	}
+}
 
-		/* Add message to the msg_queue of all clients */
-		clients = list_iterator_create(out->job->clients);
-		while ((eio = list_next(clients))) {
-			client = (struct client_io_info *)eio->arg;
-			if (client->out_eof == true)
-				continue;
+/* Add a message of task output to the msg_queue of all clients */
+static void
+_task_queue_message(struct task_read_info *out, struct io_buf *msg)
+{
+	struct client_io_info *client;
+	eio_obj_t *eio;
+	ListIterator clients;
 
-			/* Some clients only take certain I/O streams */
-			if (out->type==SLURM_IO_STDOUT) {
-				if (client->ltaskid_stdout != -1 &&
-				    client->ltaskid_stdout != out->ltaskid)
-					continue;
-			}
-			if (out->type==SLURM_IO_STDERR) {
-				if (client->ltaskid_stderr != -1 &&
-				    client->ltaskid_stderr != out->ltaskid)
-					continue;
-			}
+	clients = list_iterator_create(out->job->clients);
+	while ((eio = list_next(clients))) {
+		client = (struct client_io_info *)eio->arg;
+		if (client->out_eof == true)
+			continue;
 
-			debug5("======================== Enqueued message");
-			xassert(client->magic == CLIENT_IO_MAGIC);
-			if (list_enqueue(client->msg_queue, msg))
-				msg->ref_count++;
+		/* Some clients only take certain I/O streams */
+		if (out->type==SLURM_IO_STDOUT) {
+			if (client->ltaskid_stdout != -1 &&
+			    client->ltaskid_stdout != out->ltaskid)
+				continue;
+		}
+		if (out->type==SLURM_IO_STDERR) {
+			if (client->ltaskid_stderr != -1 &&
+			    client->ltaskid_stderr != out->ltaskid)
+				continue;
 		}
-		list_iterator_destroy(clients);
 
-		/* Update the outgoing message cache */
-		if (list_enqueue(out->job->outgoing_cache, msg)) {
+		debug5("======================== Enqueued message");
+		xassert(client->magic == CLIENT_IO_MAGIC);
+		if (list_enqueue(client->msg_queue, msg))
 			msg->ref_count++;
-			_shrink_msg_cache(out->job->outgoing_cache, out->job);
-		}
+	}
+	list_iterator_destroy(clients);
+
+	/* Update the outgoing message cache */
+	if (list_enqueue(out->job->outgoing_cache, msg)) {
+		msg->ref_count++;
+		_shrink_msg_cache(out->job->outgoing_cache, out->job);
 	}
 }
 
@@ -1337,8 +1841,8 @@ _free_incoming_msg(struct io_buf *msg, stepd_step_rec_t *job)
 {
 	msg->ref_count--;
 	if (msg->ref_count == 0) {
-		/* Put the message back on the free List */
-		list_enqueue(job->free_incoming, msg);
+		/* Put the message back on the free stack */
+		_incoming_buf_put(job, msg);
 
 		/* Kick the event IO engine */
 		eio_signal_wakeup(job->eio);
@@ -1352,8 +1856,8 @@ _free_outgoing_msg(struct io_buf *msg, stepd_step_rec_t *job)
 
 	msg->ref_count--;
 	if (msg->ref_count == 0) {
-		/* Put the message back on the free List */
-		list_enqueue(job->free_outgoing, msg);
+		/* Put the message back on the free stack */
+		_outgoing_buf_put(job, msg);
 
 		/* Try packing messages from tasks' output cbufs */
 		if (job->task == NULL)
@@ -1480,6 +1984,10 @@ _io_thr(void *arg)
 	debug("IO handler started pid=%lu", (unsigned long) getpid());
 	rc = eio_handle_mainloop(job->eio);
 	debug("IO handler exited, rc=%d", rc);
+	debug("stdio: %"PRIu64" bytes out, %"PRIu64" bytes in, "
+	      "output stalled %"PRIu64" usec, %u byte messages",
+	      job->stdio_out_bytes, job->stdio_in_bytes,
+	      job->stdio_stall_usec, job->io_msg_len);
 	return (void *)1;
 }
 
@@ -1532,6 +2040,219 @@ io_create_local_client(const char *filename, int file_flags,
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Work out this node's place in the stdio tree.  srun is the root of the
+ * tree, with the nodes of the step below it in the same shape as the
+ * reverse tree used for step completion and by mpi/pmi2.
+ */
+extern void
+io_tree_init(stepd_step_rec_t *job)
+{
+	int parent = -1, children = 0, depth, max_depth;
+	uint32_t i, j, gtid;
+	hostlist_t hl;
+	char *name;
+
+	pthread_mutex_init(&job->io_tree_lock, NULL);
+	pthread_cond_init(&job->io_tree_cond, NULL);
+	job->io_tree_parent = -1;
+	job->io_tree_start = time(NULL);
+
+	if (!(job->task_flags & TASK_IO_TREE) || !job->msg ||
+	    (job->nnodes < 2))
+		return;
+#ifdef HAVE_FRONT_END
+	debug("stdio tree not supported on front end systems");
+	return;
+#endif
+	/* The parent's address may only be known to srun */
+	if (job->msg->alias_list) {
+		debug("stdio tree disabled with node address aliases");
+		return;
+	}
+
+	reverse_tree_info(job->nodeid + 1, job->nnodes + 1,
+			  REVERSE_TREE_WIDTH, &parent, &children,
+			  &depth, &max_depth);
+	parent--;	/* restore real nodeid, -1 is srun */
+
+	if (parent >= 0) {
+		hl = hostlist_create(job->msg->complete_nodelist);
+		name = hostlist_nth(hl, parent);
+		hostlist_destroy(hl);
+		if (name &&
+		    (slurm_conf_get_addr(name, &job->io_tree_parent_addr) ==
+		     SLURM_SUCCESS))
+			job->io_tree_parent = parent;
+		else
+			error("stdio tree: no address for node %s, "
+			      "connecting to srun", name);
+		if (name)
+			free(name);
+	}
+
+	if (children > 0) {
+		job->io_tree_hold = true;
+		job->io_tree_pending = children;
+		job->io_tree_route = xmalloc(sizeof(eio_obj_t *) *
+					     job->nnodes);
+		job->io_tree_task_node = xmalloc(sizeof(uint32_t) *
+						 job->ntasks);
+		for (i = 0; i < job->nnodes; i++) {
+			for (j = 0; j < job->msg->tasks_to_launch[i]; j++) {
+				gtid = job->msg->global_task_ids[i][j];
+				if (gtid < job->ntasks)
+					job->io_tree_task_node[gtid] = i;
+			}
+		}
+		job->io_tree_children = list_create(NULL);
+	}
+	debug("stdio tree: parent %d, %d children",
+	      job->io_tree_parent, children);
+}
+
+/*
+ * Take over a connection from a node below us in the stdio tree, passed
+ * on by slurmd.  Reply to the node, which then sends its io init message
+ * and stdout/stderr as if we were srun.
+ */
+extern int
+io_tree_child_connect(stepd_step_rec_t *job, int fd)
+{
+	struct tree_io_info *tree;
+	slurm_msg_t msg;
+	eio_obj_t *obj;
+
+	if (!job->io_tree_route)	/* not a parent in the tree */
+		return ESLURMD_JOB_NOTRUNNING;
+
+	pthread_mutex_lock(&job->io_tree_lock);
+	if (job->io_tree_closed) {
+		pthread_mutex_unlock(&job->io_tree_lock);
+		return ESLURMD_JOB_NOTRUNNING;
+	}
+	job->io_tree_conns++;
+	pthread_mutex_unlock(&job->io_tree_lock);
+
+	slurm_msg_t_init(&msg);
+	msg.conn_fd = fd;
+	msg.protocol_version = SLURM_PROTOCOL_VERSION;
+	if (slurm_send_rc_msg(&msg, SLURM_SUCCESS) < 0) {
+		error("stdio tree: reply to node below: %m");
+		pthread_mutex_lock(&job->io_tree_lock);
+		job->io_tree_conns--;
+		pthread_cond_broadcast(&job->io_tree_cond);
+		pthread_mutex_unlock(&job->io_tree_lock);
+		return SLURM_ERROR;
+	}
+
+	fd_set_nonblocking(fd);
+	fd_set_close_on_exec(fd);
+
+	tree = xmalloc(sizeof(struct tree_io_info));
+#ifndef NDEBUG
+	tree->magic = TREE_IO_MAGIC;
+#endif
+	tree->job = job;
+	tree->msg_queue = list_create(NULL);
+
+	obj = eio_obj_create(fd, &tree_ops, (void *)tree);
+	list_append(job->io_tree_children, obj);
+	eio_new_obj(job->eio, obj);
+
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Wait for the nodes below us to finish with their stdio before closing
+ * our own connection to srun, which carries it.
+ */
+extern void
+io_tree_wait(stepd_step_rec_t *job)
+{
+	struct timespec ts = {0, 0};
+
+	if (!job->io_tree_hold)
+		return;
+
+	pthread_mutex_lock(&job->io_tree_lock);
+	ts.tv_sec = job->io_tree_start + REVERSE_TREE_CHILDREN_TIMEOUT;
+	while ((job->io_tree_pending > 0) && !job->io_tree_abort) {
+		if (pthread_cond_timedwait(&job->io_tree_cond,
+					   &job->io_tree_lock, &ts) ==
+		    ETIMEDOUT)
+			break;
+	}
+	if (job->io_tree_pending > 0) {
+		error("stdio tree: %d node(s) below never connected",
+		      job->io_tree_pending);
+	}
+	job->io_tree_closed = true;
+	while ((job->io_tree_conns > 0) && !job->io_tree_abort)
+		pthread_cond_wait(&job->io_tree_cond, &job->io_tree_lock);
+	pthread_mutex_unlock(&job->io_tree_lock);
+
+	/* Let the client connection send the final eof message */
+	eio_signal_wakeup(job->eio);
+}
+
+/* The step is being killed, do not wait on nodes below us */
+extern void
+io_tree_abort(stepd_step_rec_t *job)
+{
+	if (!job->io_tree_hold)
+		return;
+
+	pthread_mutex_lock(&job->io_tree_lock);
+	job->io_tree_abort = true;
+	pthread_cond_broadcast(&job->io_tree_cond);
+	pthread_mutex_unlock(&job->io_tree_lock);
+}
+
+/*
+ * Connect to our parent in the stdio tree through its slurmd.
+ * Return the connected socket, or -1 if the parent could not be reached.
+ */
+static int
+_tree_parent_connect(stepd_step_rec_t *job)
+{
+	job_step_id_msg_t req;
+	slurm_msg_t msg, resp;
+	int fd, rc, retry;
+
+	for (retry = 0; retry < REVERSE_TREE_PARENT_RETRY; retry++) {
+		if (retry)
+			sleep(1);
+		if ((fd = slurm_open_msg_conn(&job->io_tree_parent_addr)) < 0)
+			continue;
+
+		req.job_id = job->jobid;
+		req.step_id = job->stepid;
+		slurm_msg_t_init(&msg);
+		msg.msg_type = REQUEST_STEP_IO_CONNECT;
+		msg.data = &req;
+		slurm_msg_t_init(&resp);
+		if ((slurm_send_node_msg(fd, &msg) < 0) ||
+		    (slurm_receive_msg(fd, &resp, 0) < 0)) {
+			slurm_shutdown_msg_conn(fd);
+			continue;
+		}
+
+		if (resp.msg_type == RESPONSE_SLURM_RC)
+			rc = ((return_code_msg_t *) resp.data)->return_code;
+		else
+			rc = SLURM_ERROR;
+		slurm_free_msg_data(resp.msg_type, resp.data);
+		if (rc == SLURM_SUCCESS)
+			return fd;
+		debug("stdio tree: node %d refused connection: %s",
+		      job->io_tree_parent, slurm_strerror(rc));
+		slurm_shutdown_msg_conn(fd);
+	}
+
+	return -1;
+}
+
 /*
  * Create the initial TCP connection back to a waiting client (e.g. srun).
  *
@@ -1563,7 +2284,15 @@ io_initial_client_connect(srun_info_t *srun, stepd_step_rec_t *job,
 		debug4("connecting IO back to %s:%d", ip, ntohs(port));
 	}
 
-	if ((sock = (int) slurm_open_stream(&srun->ioaddr)) < 0) {
+	/* Our stdio goes through our parent in the stdio tree, if any */
+	if ((job->io_tree_parent >= 0) &&
+	    ((sock = _tree_parent_connect(job)) < 0)) {
+		error("stdio tree: cannot reach node %d, connecting to srun",
+		      job->io_tree_parent);
+	}
+
+	if ((sock < 0) &&
+	    ((sock = (int) slurm_open_stream(&srun->ioaddr)) < 0)) {
 		error("connect io: %m");
 		/* XXX retry or silently fail?
 		 *     fail for now.
@@ -1573,7 +2302,7 @@ io_initial_client_connect(srun_info_t *srun, stepd_step_rec_t *job,
 
 	fd_set_blocking(sock);  /* just in case... */
 
-	_send_io_init_msg(sock, srun->key, job);
+	_send_io_init_msg(sock, srun->key, job, true);
 
 	debug5("  back from _send_io_init_msg");
 	fd_set_nonblocking(sock);
@@ -1592,6 +2321,7 @@ io_initial_client_connect(srun_info_t *srun, stepd_step_rec_t *job,
 	client->labelio = false;
 	client->label_width = 0;
 	client->is_local_file = false;
+	client->tree_relay = true;
 
 	obj = eio_obj_create(sock, &client_ops, (void *)client);
 	list_append(job->clients, (void *)obj);
@@ -1633,7 +2363,7 @@ io_client_connect(srun_info_t *srun, stepd_step_rec_t *job)
 
 	fd_set_blocking(sock);  /* just in case... */
 
-	_send_io_init_msg(sock, srun->key, job);
+	_send_io_init_msg(sock, srun->key, job, false);
 
 	debug5("  back from _send_io_init_msg");
 	fd_set_nonblocking(sock);
@@ -1664,7 +2394,8 @@ io_client_connect(srun_info_t *srun, stepd_step_rec_t *job)
 }
 
 static int
-_send_io_init_msg(int sock, srun_key_t *key, stepd_step_rec_t *job)
+_send_io_init_msg(int sock, srun_key_t *key, stepd_step_rec_t *job,
+		  bool tree_relay)
 {
 	struct slurm_io_init_msg msg;
 
@@ -1678,6 +2409,9 @@ _send_io_init_msg(int sock, srun_key_t *key, stepd_step_rec_t *job)
 		msg.stderr_objs = 0;
 	else
 		msg.stderr_objs = list_count(job->stderr_eio_objs);
+	/* Held open for the nodes below us, see _client_writable() */
+	if (tree_relay && job->io_tree_hold)
+		msg.stdout_objs++;
 
 	if (io_init_msg_write_to_fd(sock, &msg) != SLURM_SUCCESS) {
 		error("Couldn't sent slurm_io_init_msg");
@@ -1731,16 +2465,15 @@ _send_eof_msg(struct task_read_info *out)
 	debug4("Entering _send_eof_msg");
 	out->eof_msg_sent = true;
 
-	if (_outgoing_buf_free(out->job)) {
-		msg = list_dequeue(out->job->free_outgoing);
-	} else {
+	if (!_outgoing_buf_free(out->job) ||
+	    !(msg = _outgoing_buf_get(out->job))) {
 		/* eof message must be allowed to allocate new memory
 		   because _task_readable() will return "true" until
 		   the eof message is enqueued.  For instance, if
 		   a poll returns POLLHUP on the incoming task pipe,
 		   put there are no outgoing message buffers available,
 		   the slurmstepd will start spinning. */
-		msg = alloc_io_buf();
+		msg = _outgoing_buf_alloc(out->job);
 	}
 
 	header.type = out->type;
@@ -1796,25 +2529,20 @@ _task_build_message(struct task_read_info *out, stepd_step_rec_t *job, cbuf_t cb
 {
 	struct io_buf *msg;
 	char *ptr;
-	Buf packbuf;
 	bool must_truncate = false;
 	int avail;
-	struct slurm_io_header header;
 	int n;
 
 	debug4("Entering _task_build_message");
-	if (_outgoing_buf_free(job)) {
-		msg = list_dequeue(job->free_outgoing);
-	} else {
+	if (!_outgoing_buf_free(job) || !(msg = _outgoing_buf_get(job)))
 		return NULL;
-	}
 	ptr = msg->data + io_hdr_packed_size();
 
 	if (job->buffered_stdio) {
-		avail = cbuf_peek_line(cbuf, ptr, MAX_MSG_LEN, 1);
-		if (avail >= MAX_MSG_LEN)
+		avail = cbuf_peek_line(cbuf, ptr, job->io_msg_len, 1);
+		if (avail >= job->io_msg_len)
 			must_truncate = true;
-		else if (avail == 0 && cbuf_used(cbuf) >= MAX_MSG_LEN)
+		else if (avail == 0 && cbuf_used(cbuf) >= job->io_msg_len)
 			must_truncate = true;
 	}
 
@@ -1827,42 +2555,53 @@ _task_build_message(struct task_read_info *out, stepd_step_rec_t *job, cbuf_t cb
 	 * Hence the "|| out->eof".
 	 */
 	if (must_truncate || !job->buffered_stdio || out->eof) {
-		n = cbuf_read(cbuf, ptr, MAX_MSG_LEN);
+		n = cbuf_read(cbuf, ptr, job->io_msg_len);
 	} else {
-		n = cbuf_read_line(cbuf, ptr, MAX_MSG_LEN, -1);
+		n = cbuf_read_line(cbuf, ptr, job->io_msg_len, -1);
 		if (n == 0) {
 			debug5("  partial line in buffer, ignoring");
 			debug4("Leaving  _task_build_message");
-			list_enqueue(job->free_outgoing, msg);
+			_outgoing_buf_put(job, msg);
 			return NULL;
 		}
 	}
 
+	_task_pack_header(out, msg, n);
+
+	debug4("Leaving  _task_build_message");
+	return msg;
+}
+
+/* Pack the header for "len" bytes of task output already in msg */
+static void
+_task_pack_header(struct task_read_info *out, struct io_buf *msg, int len)
+{
+	Buf packbuf;
+	struct slurm_io_header header;
+
 	header.type = out->type;
 	header.ltaskid = out->ltaskid;
 	header.gtaskid = out->gtaskid;
-	header.length = n;
+	header.length = len;
 
-	debug5("  header.length = %d", n);
+	debug5("  header.length = %d", len);
 	packbuf = create_buf(msg->data, io_hdr_packed_size());
 	if (!packbuf) {
 		fatal("Failure to allocate memory for a message header");
-		return msg;	/* Fix for CLANG false positive error */
+		return;	/* Fix for CLANG false positive error */
 	}
 	io_hdr_pack(&header, packbuf);
 	msg->length = io_hdr_packed_size() + header.length;
 	msg->ref_count = 0; /* make certain it is initialized */
+	out->job->stdio_out_bytes += len;
 
 	/* free the Buf packbuf, but not the memory to which it points */
 	packbuf->head = NULL;	/* CLANG false positive bug here */
 	free_buf(packbuf);
-
-	debug4("Leaving  _task_build_message");
-	return msg;
 }
 
 struct io_buf *
-alloc_io_buf(void)
+alloc_io_buf(uint32_t len)
 {
 	struct io_buf *buf;
 
@@ -1873,7 +2612,7 @@ alloc_io_buf(void)
 	buf->length = 0;
 	/* The following "+ 1" is just temporary so I can stick a \0 at
 	   the end and do a printf of the data pointer */
-	buf->data = xmalloc(MAX_MSG_LEN + io_hdr_packed_size() + 1);
+	buf->data = xmalloc(len + io_hdr_packed_size() + 1);
 	if (!buf->data) {
 		xfree(buf);
 		return NULL;
@@ -1892,43 +2631,140 @@ free_io_buf(struct io_buf *buf)
 	}
 }
 
+/*
+ * The free message buffers are kept on plain arrays used as stacks rather
+ * than Lists, so the most recently used (cache warm) buffer is reused
+ * first.  The arrays grow with the number of buffers allocated, so a
+ * buffer can always be returned.  Besides the IO thread, the slurmstepd
+ * request thread takes buffers when a client attaches, so the stacks are
+ * protected by free_buf_lock, and a get returns NULL if another thread
+ * took the last free buffer.
+ */
+static pthread_mutex_t free_buf_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct io_buf *
+_incoming_buf_get(stepd_step_rec_t *job)
+{
+	struct io_buf *buf = NULL;
+
+	slurm_mutex_lock(&free_buf_lock);
+	if (job->free_incoming_cnt > 0)
+		buf = job->free_incoming[--job->free_incoming_cnt];
+	slurm_mutex_unlock(&free_buf_lock);
+	return buf;
+}
+
+static void
+_incoming_buf_put(stepd_step_rec_t *job, struct io_buf *buf)
+{
+	slurm_mutex_lock(&free_buf_lock);
+	xassert(job->free_incoming_cnt < job->incoming_count);
+	job->free_incoming[job->free_incoming_cnt++] = buf;
+	slurm_mutex_unlock(&free_buf_lock);
+}
+
+static struct io_buf *
+_outgoing_buf_get(stepd_step_rec_t *job)
+{
+	struct io_buf *buf = NULL;
+
+	slurm_mutex_lock(&free_buf_lock);
+	if (job->free_outgoing_cnt > 0)
+		buf = job->free_outgoing[--job->free_outgoing_cnt];
+	slurm_mutex_unlock(&free_buf_lock);
+	return buf;
+}
+
+static void
+_outgoing_buf_put(stepd_step_rec_t *job, struct io_buf *buf)
+{
+	slurm_mutex_lock(&free_buf_lock);
+	xassert(job->free_outgoing_cnt < job->outgoing_count);
+	job->free_outgoing[job->free_outgoing_cnt++] = buf;
+	slurm_mutex_unlock(&free_buf_lock);
+}
+
+/* Allocate a new outgoing buffer, making room to return it to the stack */
+static struct io_buf *
+_outgoing_buf_alloc(stepd_step_rec_t *job)
+{
+	struct io_buf *buf;
+
+	buf = alloc_io_buf(job->io_msg_len);
+	if (buf != NULL) {
+		slurm_mutex_lock(&free_buf_lock);
+		job->outgoing_count++;
+		xrealloc(job->free_outgoing,
+			 sizeof(struct io_buf *) * job->outgoing_count);
+		slurm_mutex_unlock(&free_buf_lock);
+	}
+	return buf;
+}
+
+/*
+ * Larger outgoing messages get fewer buffers, so that the memory used
+ * for stdout and stderr does not depend upon the message size.
+ */
+static inline int
+_outgoing_buf_max(stepd_step_rec_t *job)
+{
+	return STDIO_MAX_FREE_BUF * MAX_MSG_LEN / job->io_msg_len;
+}
+
+/* The cache may hold at most half of the outgoing buffers */
+static inline int
+_outgoing_cache_max(stepd_step_rec_t *job)
+{
+	return MIN(STDIO_MAX_MSG_CACHE, _outgoing_buf_max(job) / 2);
+}
+
 /* This just determines if there's space to hold more of the stdin stream */
 static bool
 _incoming_buf_free(stepd_step_rec_t *job)
 {
 	struct io_buf *buf;
+	bool rc = false;
 
-	if (list_count(job->free_incoming) > 0) {
-		return true;
+	slurm_mutex_lock(&free_buf_lock);
+	if (job->free_incoming_cnt > 0) {
+		rc = true;
 	} else if (job->incoming_count < STDIO_MAX_FREE_BUF) {
-		buf = alloc_io_buf();
+		buf = alloc_io_buf(MAX_MSG_LEN);
 		if (buf != NULL) {
-			list_enqueue(job->free_incoming, buf);
 			job->incoming_count++;
-			return true;
+			xrealloc(job->free_incoming,
+				 sizeof(struct io_buf *) * job->incoming_count);
+			job->free_incoming[job->free_incoming_cnt++] = buf;
+			rc = true;
 		}
 	}
+	slurm_mutex_unlock(&free_buf_lock);
 
-	return false;
+	return rc;
 }
 
 static bool
 _outgoing_buf_free(stepd_step_rec_t *job)
 {
 	struct io_buf *buf;
+	bool rc = false;
 
-	if (list_count(job->free_outgoing) > 0) {
-		return true;
-	} else if (job->outgoing_count < STDIO_MAX_FREE_BUF) {
-		buf = alloc_io_buf();
+	slurm_mutex_lock(&free_buf_lock);
+	if (job->free_outgoing_cnt > 0) {
+		rc = true;
+	} else if (job->outgoing_count < _outgoing_buf_max(job)) {
+		buf = alloc_io_buf(job->io_msg_len);
 		if (buf != NULL) {
-			list_enqueue(job->free_outgoing, buf);
 			job->outgoing_count++;
-			return true;
+			xrealloc(job->free_outgoing,
+				 sizeof(struct io_buf *) * job->outgoing_count);
+			job->free_outgoing[job->free_outgoing_cnt++] = buf;
+			rc = true;
 		}
 	}
+	slurm_mutex_unlock(&free_buf_lock);
 
-	return false;
+	return rc;
 }
 
 /**********************************************************************
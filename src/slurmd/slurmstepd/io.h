@@ -46,10 +46,13 @@
 
 /*
  * The message cache uses up free message buffers, so STDIO_MAX_MSG_CACHE
- * must be a number smaller than STDIO_MAX_FREE_BUF.
+ * must be a number smaller than STDIO_MAX_FREE_BUF.  Both are counts of
+ * MAX_MSG_LEN buffers; with larger messages there are fewer buffers, and
+ * the cache keeps up to STDIO_MAX_CACHE_BYTES of the most recent output.
  */
 #define STDIO_MAX_FREE_BUF 1024
 #define STDIO_MAX_MSG_CACHE 128
+#define STDIO_MAX_CACHE_BYTES (STDIO_MAX_MSG_CACHE * MAX_MSG_LEN)
 
 struct io_buf {
 	int ref_count;
@@ -74,7 +77,7 @@ typedef enum {
 } slurmd_filename_pattern_t;
 
 
-struct io_buf *alloc_io_buf(void);
+struct io_buf *alloc_io_buf(uint32_t len);
 void free_io_buf(struct io_buf *buf);
 
 /*
@@ -95,6 +98,21 @@ int io_initial_client_connect(srun_info_t *srun, stepd_step_rec_t *job,
  */
 int io_client_connect(srun_info_t *srun, stepd_step_rec_t *job);
 
+/*
+ * The stdio tree relays the stdio of nodes below this one to srun when
+ * the step is launched with TASK_IO_TREE.
+ *
+ * io_tree_init() sets up this node's place in the tree, before any node
+ * below can connect.
+ * io_tree_child_connect() takes over a connection from a node below.
+ * io_tree_wait() waits for the nodes below to finish, before io_close_all().
+ * io_tree_abort() stops io_tree_wait() waiting when the step is killed.
+ */
+void io_tree_init(stepd_step_rec_t *job);
+int  io_tree_child_connect(stepd_step_rec_t *job, int fd);
+void io_tree_wait(stepd_step_rec_t *job);
+void io_tree_abort(stepd_step_rec_t *job);
+
 
 /*
  * Open a local file and create and eio object for files written
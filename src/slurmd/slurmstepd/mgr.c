@@ -248,6 +248,10 @@ mgr_launch_tasks_setup(launch_tasks_request_msg_t *msg, slurm_addr_t *cli,
 	job->envtp->self = self;
 	job->envtp->select_jobinfo = msg->select_jobinfo;
 
+	/* Before the message thread starts, nodes below this one in
+	 * the stdio tree connect through it */
+	io_tree_init(job);
+
 	return job;
 }
 
@@ -1884,6 +1888,7 @@ static void
 _wait_for_io(stepd_step_rec_t *job)
 {
 	debug("Waiting for IO");
+	io_tree_wait(job);
 	io_close_all(job);
 
 	/*
@@ -92,6 +92,7 @@ static int _handle_stat_jobacct(int fd, stepd_step_rec_t *job, uid_t uid);
 static int _handle_task_info(int fd, stepd_step_rec_t *job);
 static int _handle_list_pids(int fd, stepd_step_rec_t *job);
 static int _handle_reconfig(int fd, stepd_step_rec_t *job, uid_t uid);
+static int _handle_io_connect(int fd, stepd_step_rec_t *job, uid_t uid);
 static bool _msg_socket_readable(eio_obj_t *obj);
 static int _msg_socket_accept(eio_obj_t *obj, List objs);
 
@@ -540,6 +541,10 @@ _handle_request(int fd, stepd_step_rec_t *job, uid_t uid, gid_t gid)
 		debug("Handling REQUEST_JOB_NOTIFY");
 		rc = _handle_notify_job(fd, job, uid);
 		break;
+	case REQUEST_STEP_IO_CONNECT:
+		debug("Handling REQUEST_STEP_IO_CONNECT");
+		rc = _handle_io_connect(fd, job, uid);
+		break;
 	default:
 		error("Unrecognized request: %d", req);
 		rc = SLURM_FAILURE;
@@ -789,6 +794,8 @@ _handle_signal_container(int fd, stepd_step_rec_t *job, uid_t uid)
 			sig, job->jobid, job->stepid);
 	}
 	pthread_mutex_unlock(&suspend_mutex);
+	if (sig == SIGKILL)
+		io_tree_abort(job);
 
 done:
 	/* Send the return code and errnum */
@@ -918,6 +925,39 @@ rwfail:
 	return SLURM_FAILURE;
 }
 
+/*
+ * slurmd passes on the connection of a slurmstepd below us in the stdio
+ * tree, the IO thread takes it over.
+ */
+static int
+_handle_io_connect(int fd, stepd_step_rec_t *job, uid_t uid)
+{
+	int rc = SLURM_SUCCESS;
+	int conn;
+
+	debug3("_handle_io_connect for job %u.%u", job->jobid, job->stepid);
+
+	if ((conn = receive_fd_over_pipe(fd)) < 0)
+		return SLURM_FAILURE;
+
+	if (!_slurm_authorized_user(uid)) {
+		debug("io connect req from uid %ld for job %u.%u",
+		      (long)uid, job->jobid, job->stepid);
+		close(conn);
+		rc = EPERM;
+		goto done;
+	}
+	if ((rc = io_tree_child_connect(job, conn)) != SLURM_SUCCESS)
+		close(conn);
+
+done:
+	/* Send the return code */
+	safe_write(fd, &rc, sizeof(int));
+	return SLURM_SUCCESS;
+rwfail:
+	return SLURM_FAILURE;
+}
+
 static int
 _handle_terminate(int fd, stepd_step_rec_t *job, uid_t uid)
 {
@@ -987,6 +1027,7 @@ _handle_terminate(int fd, stepd_step_rec_t *job, uid_t uid)
 			job->jobid, job->stepid);
 	}
 	pthread_mutex_unlock(&suspend_mutex);
+	io_tree_abort(job);
 
 done:
 	/* Send the return code and errnum */
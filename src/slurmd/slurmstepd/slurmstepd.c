@@ -46,7 +46,9 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <signal.h>
+#include <errno.h>
 
+#include "src/common/checkpoint.h"
 #include "src/common/cpu_frequency.h"
 #include "src/common/gres.h"
 #include "src/common/slurm_jobacct_gather.h"
@@ -62,6 +64,7 @@
 #include "src/slurmd/common/slurmstepd_init.h"
 #include "src/slurmd/common/setproctitle.h"
 #include "src/slurmd/common/proctrack.h"
+#include "src/slurmd/common/task_plugin.h"
 #include "src/slurmd/slurmd/slurmd.h"
 #include "src/slurmd/slurmstepd/mgr.h"
 #include "src/slurmd/slurmstepd/req.h"
@@ -81,6 +84,7 @@ static stepd_step_rec_t *_step_setup(slurm_addr_t *cli, slurm_addr_t *self,
 static void _step_cleanup(stepd_step_rec_t *job, slurm_msg_t *msg, int rc);
 #endif
 static int process_cmdline (int argc, char *argv[]);
+static void _preload_plugins(char **argv);
 
 int slurmstepd_blocked_signals[] = {
 	SIGPIPE, 0
@@ -90,6 +94,9 @@ int slurmstepd_blocked_signals[] = {
 slurmd_conf_t * conf;
 extern char  ** environ;
 
+/* Started ahead of time by slurmd's stepd_pool, see _preload_plugins() */
+static bool pooled = false;
+
 int
 main (int argc, char *argv[])
 {
@@ -111,6 +118,8 @@ main (int argc, char *argv[])
 	init_setproctitle(argc, argv);
 	if (slurm_select_init(1) != SLURM_SUCCESS )
 		fatal( "failed to initialize node selection plugin" );
+	if (pooled)
+		_preload_plugins(argv);
 
 	/* Receive job parameters from the slurmd */
 	_init_from_slurmd(STDIN_FILENO, argv, &cli, &self, &msg,
@@ -328,9 +337,43 @@ static int process_cmdline (int argc, char *argv[])
 			exit (1);
 		exit (0);
 	}
+	if ((argc == 2) && (strcmp(argv[1], "pool") == 0))
+		pooled = true;
 	return (0);
 }
 
+/*
+ *  A pooled slurmstepd may wait a long time for slurmd to hand it a job
+ *  step, so load the plugins that job_manager() would otherwise load on
+ *  the launch path.  slurmd sends a pooled slurmstepd its configuration as
+ *  soon as it is started, the plugins being initialized from it, and the
+ *  rest of its initialization data at launch.  The plugin init functions
+ *  only run once, so job_manager() still calls them unconditionally.
+ */
+static void _preload_plugins(char **argv)
+{
+	char *ckpt_type;
+	log_options_t lopts = LOG_OPTS_INITIALIZER;
+
+	log_init(argv[0], lopts, LOG_DAEMON, NULL);
+
+	/* slurmd closes our stdin to release an unused slurmstepd from its
+	 * pool, exit quietly in that case */
+	if ((conf = read_slurmd_conf_lite(STDIN_FILENO)) == NULL)
+		exit(0);
+	log_alter(conf->log_opts, 0, conf->logfile);
+
+	ckpt_type = slurm_get_checkpoint_type();
+	acct_gather_conf_init();
+	if ((switch_init() != SLURM_SUCCESS)			||
+	    (slurmd_task_init() != SLURM_SUCCESS)		||
+	    (slurm_proctrack_init() != SLURM_SUCCESS)		||
+	    (checkpoint_init(ckpt_type) != SLURM_SUCCESS)	||
+	    (jobacct_gather_init() != SLURM_SUCCESS))
+		debug("slurmstepd plugin preload failed, deferring to launch");
+	xfree(ckpt_type);
+}
+
 
 static void
 _send_ok_to_slurmd(int sock)
@@ -386,7 +429,19 @@ _init_from_slurmd(int sock, char **argv,
 	log_init(argv[0], lopts, LOG_DAEMON, NULL);
 
 	/* receive job type from slurmd */
-	safe_read(sock, &step_type, sizeof(int));
+	if (pooled) {
+		/* slurmd closes our stdin to release an unused slurmstepd
+		 * from its pool, exit quietly in that case */
+		int rc;
+		do {
+			rc = read(sock, &step_type, sizeof(int));
+		} while ((rc < 0) && (errno == EINTR));
+		if (rc == 0)
+			exit(0);
+		if (rc != sizeof(int))
+			goto rwfail;
+	} else
+		safe_read(sock, &step_type, sizeof(int));
 	debug3("step_type = %d", step_type);
 
 	/* receive reverse-tree info from slurmd */
@@ -401,8 +456,8 @@ _init_from_slurmd(int sock, char **argv,
 	step_complete.jobacct = jobacctinfo_create(NULL);
 	pthread_mutex_unlock(&step_complete.lock);
 
-	/* receive conf from slurmd */
-	if ((conf = read_slurmd_conf_lite (sock)) == NULL)
+	/* receive conf from slurmd, a pooled slurmstepd already has it */
+	if (!pooled && ((conf = read_slurmd_conf_lite (sock)) == NULL))
 		fatal("Failed to read conf from slurmd");
 	log_alter(conf->log_opts, 0, conf->logfile);
 
@@ -367,9 +367,7 @@ stepd_step_rec_create(launch_tasks_request_msg_t *msg)
 	job->clients = list_create(NULL); /* FIXME! Needs destructor */
 	job->stdout_eio_objs = list_create(NULL); /* FIXME! Needs destructor */
 	job->stderr_eio_objs = list_create(NULL); /* FIXME! Needs destructor */
-	job->free_incoming = list_create(NULL); /* FIXME! Needs destructor */
 	job->incoming_count = 0;
-	job->free_outgoing = list_create(NULL); /* FIXME! Needs destructor */
 	job->outgoing_count = 0;
 	job->outgoing_cache = list_create(NULL); /* FIXME! Needs destructor */
 
@@ -428,6 +426,10 @@ stepd_step_rec_create(launch_tasks_request_msg_t *msg)
 	job->multi_prog  = msg->multi_prog;
 	job->timelimit   = (time_t) -1;
 	job->task_flags  = msg->task_flags;
+	if (job->task_flags & TASK_LARGE_IO)
+		job->io_msg_len = IO_LARGE_MSG_LEN;
+	else
+		job->io_msg_len = MAX_MSG_LEN;
 	job->switch_job  = msg->switch_job;
 	job->pty         = msg->pty;
 	job->open_mode   = msg->open_mode;
@@ -604,6 +606,10 @@ stepd_step_rec_destroy(stepd_step_rec_t *job)
 	xfree(job->job_alloc_cores);
 	xfree(job->step_alloc_cores);
 	xfree(job->user_name);
+	xfree(job->io_tree_route);
+	xfree(job->io_tree_task_node);
+	if (job->io_tree_children)
+		list_destroy(job->io_tree_children);
 	xfree(job);
 }
 
@@ -159,14 +159,16 @@ typedef struct {
 	List           clients; /* List of struct client_io_info pointers   */
 	List stdout_eio_objs; /* List of objs that gather stdout from tasks */
 	List stderr_eio_objs; /* List of objs that gather stderr from tasks */
-	List free_incoming;   /* List of free struct io_buf * for incoming
-			       * traffic. "incoming" means traffic from srun
-			       * to the tasks.
+	struct io_buf **free_incoming; /* Stack of free struct io_buf * for
+			       * incoming traffic. "incoming" means traffic
+			       * from srun to the tasks.
 			       */
-	List free_outgoing;   /* List of free struct io_buf * for outgoing
-			       * traffic "outgoing" means traffic from the
-			       * tasks to srun.
+	struct io_buf **free_outgoing; /* Stack of free struct io_buf * for
+			       * outgoing traffic "outgoing" means traffic
+			       * from the tasks to srun.
 			       */
+	int free_incoming_cnt; /* Buffers on the free_incoming stack */
+	int free_outgoing_cnt; /* Buffers on the free_outgoing stack */
 	int incoming_count;   /* Count of total incoming message buffers
 			       * including free_incoming buffers and
 			       * buffers in use.
@@ -175,11 +177,33 @@ typedef struct {
 			       * including free_outgoing buffers and
 			       * buffers in use.
 			       */
+	uint32_t io_msg_len;  /* Largest stdout/stderr message payload */
+	uint64_t stdio_out_bytes; /* stdout/stderr bytes read from tasks */
+	uint64_t stdio_in_bytes;  /* stdin bytes written to tasks */
+	uint64_t stdio_stall_usec; /* time task output waited on a full
+				    * buffer */
 
 	List outgoing_cache;  /* cache of outgoing stdio messages
 			       * used when a new client attaches
 			       */
 
+	/* stdio tree, used when the step is launched with TASK_IO_TREE */
+	int io_tree_parent;   /* nodeid relaying our stdio, -1 for srun */
+	slurm_addr_t io_tree_parent_addr; /* slurmd of io_tree_parent */
+	bool io_tree_hold;    /* nodes below us relay through us, keep the
+			       * connection to srun open until they finish
+			       */
+	int io_tree_pending;  /* nodes below us not yet seen */
+	int io_tree_conns;    /* open connections from nodes below us */
+	bool io_tree_closed;  /* accept no more connections */
+	bool io_tree_abort;   /* step killed, stop waiting for nodes below */
+	time_t io_tree_start; /* when nodes below us could start connecting */
+	eio_obj_t **io_tree_route; /* connection leading to each nodeid */
+	uint32_t *io_tree_task_node; /* nodeid of each global task id */
+	List io_tree_children; /* eio objs of connections from below */
+	pthread_mutex_t io_tree_lock;
+	pthread_cond_t  io_tree_cond;
+
 	uint8_t	buffered_stdio; /* stdio buffering flag, 1 for line-buffering,
 				 * 0 for no buffering
 				 */
@@ -59,11 +59,16 @@
 struct squeue_parameters params;
 int max_line_size;
 
+/* Set if the controller can not report only the changed jobs */
+static bool delta_unavailable = false;
+
 /************
  * Funtions *
  ************/
 static int  _get_info(bool clear_old);
 static int  _get_window_width( void );
+static int  _load_jobs(job_info_msg_t *old_job_ptr,
+		       job_info_msg_t **new_job_ptr, uint16_t show_flags);
 static void _print_date( void );
 static int  _multi_cluster(List clusters);
 static int  _print_job ( bool clear_old );
@@ -164,6 +169,32 @@ _get_window_width( void )
 }
 
 
+/* Load all jobs. Once a copy is held, fetch only the jobs changed since then
+ * unless the controller is too old to support that.
+ * NOTE: on success the records of old_job_ptr may be moved to new_job_ptr,
+ * old_job_ptr must still be freed */
+static int
+_load_jobs(job_info_msg_t *old_job_ptr, job_info_msg_t **new_job_ptr,
+	   uint16_t show_flags)
+{
+	int error_code;
+
+	if (!delta_unavailable) {
+		error_code = slurm_load_jobs_delta(old_job_ptr, new_job_ptr,
+						   show_flags);
+		if ((error_code == SLURM_SUCCESS) ||
+		    (slurm_get_errno() == SLURM_NO_CHANGE_IN_DATA))
+			return error_code;
+		/* Likely an older slurmctld, use slurm_load_jobs() */
+		if (params.verbose)
+			slurm_perror("slurm_load_jobs_delta");
+		delta_unavailable = true;
+	}
+
+	return slurm_load_jobs(old_job_ptr ? old_job_ptr->last_update : 0,
+			       new_job_ptr, show_flags);
+}
+
 /* _print_job - print the specified job's information */
 static int
 _print_job ( bool clear_old )
@@ -191,9 +222,8 @@ _print_job ( bool clear_old )
 							 params.user_id,
 							 show_flags);
 		} else {
-			error_code = slurm_load_jobs(
-				old_job_ptr->last_update,
-				&new_job_ptr, show_flags);
+			error_code = _load_jobs(clear_old ? NULL : old_job_ptr,
+						&new_job_ptr, show_flags);
 		}
 		if (error_code ==  SLURM_SUCCESS)
 			slurm_free_job_info_msg( old_job_ptr );
@@ -208,8 +238,7 @@ _print_job ( bool clear_old )
 		error_code = slurm_load_job_user(&new_job_ptr, params.user_id,
 						 show_flags);
 	} else {
-		error_code = slurm_load_jobs((time_t) NULL, &new_job_ptr,
-					     show_flags);
+		error_code = _load_jobs(NULL, &new_job_ptr, show_flags);
 	}
 
 	if (error_code) {
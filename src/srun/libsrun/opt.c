@@ -191,6 +191,8 @@
 #define LONG_OPT_CPU_FREQ        0x155
 #define LONG_OPT_LAUNCH_CMD      0x156
 #define LONG_OPT_PROFILE         0x157
+#define LONG_OPT_IO_TREE         0x158
+#define LONG_OPT_LARGE_IO        0x159
 
 extern char **environ;
 
@@ -437,6 +439,8 @@ static void _opt_default()
 
 	opt.labelio = false;
 	opt.unbuffered = false;
+	opt.io_tree = false;
+	opt.large_io = false;
 	opt.overcommit = false;
 	opt.shared = (uint16_t)NO_VAL;
 	opt.exclusive = false;
@@ -870,8 +874,10 @@ static void _set_options(const int argc, char **argv)
 		{"help",             no_argument,       0, LONG_OPT_HELP},
 		{"hint",             required_argument, 0, LONG_OPT_HINT},
 		{"ioload-image",     required_argument, 0, LONG_OPT_RAMDISK_IMAGE},
+		{"io-tree",          no_argument,       0, LONG_OPT_IO_TREE},
 		{"jobid",            required_argument, 0, LONG_OPT_JOBID},
 		{"linux-image",      required_argument, 0, LONG_OPT_LINUX_IMAGE},
+		{"large-io",         no_argument,       0, LONG_OPT_LARGE_IO},
 		{"launch-cmd",       no_argument,       0, LONG_OPT_LAUNCH_CMD},
 		{"launcher-opts",      required_argument, 0, LONG_OPT_LAUNCHER_OPTS},
 		{"mail-type",        required_argument, 0, LONG_OPT_MAIL_TYPE},
@@ -1182,6 +1188,12 @@ static void _set_options(const int argc, char **argv)
 		case LONG_OPT_LAUNCH_CMD:
 			opt.launch_cmd = true;
 			break;
+		case LONG_OPT_IO_TREE:
+			opt.io_tree = true;
+			break;
+		case LONG_OPT_LARGE_IO:
+			opt.large_io = true;
+			break;
 		case LONG_OPT_MEM_BIND:
 			if (slurm_verify_mem_bind(optarg, &opt.mem_bind,
 						  &opt.mem_bind_type))
@@ -2317,6 +2329,8 @@ static void _opt_list(void)
 		info("immediate      : %d secs", (opt.immediate - 1));
 	info("label output   : %s", tf_(opt.labelio));
 	info("unbuffered IO  : %s", tf_(opt.unbuffered));
+	info("stdio tree     : %s", tf_(opt.io_tree));
+	info("large stdio    : %s", tf_(opt.large_io));
 	info("overcommit     : %s", tf_(opt.overcommit));
 	info("threads        : %d", opt.max_threads);
 	if (opt.time_limit == INFINITE)
@@ -2427,14 +2441,15 @@ static void _usage(void)
 "Usage: srun [-N nnodes] [-n ntasks] [-i in] [-o out] [-e err]\n"
 "            [-c ncpus] [-r n] [-p partition] [--hold] [-t minutes]\n"
 "            [-D path] [--immediate[=secs]] [--overcommit] [--no-kill]\n"
-"            [--share] [--label] [--unbuffered] [-m dist] [-J jobname]\n"
+"            [--share] [--label] [--unbuffered] [--io-tree] [-m dist]\n"
+"            [-J jobname]\n"
 "            [--jobid=id] [--verbose] [--slurmd_debug=#] [--gres=list]\n"
 "            [-T threads] [-W sec] [--checkpoint=time]\n"
 "            [--checkpoint-dir=dir]  [--licenses=names]\n"
 "            [--restart-dir=dir] [--qos=qos] [--time-min=minutes]\n"
 "            [--contiguous] [--mincpus=n] [--mem=MB] [--tmp=MB] [-C list]\n"
 "            [--mpi=type] [--account=name] [--dependency=type:jobid]\n"
-"            [--launch-cmd] [--launcher-opts=options]\n"
+"            [--launch-cmd] [--launcher-opts=options] [--large-io]\n"
 "            [--kill-on-bad-exit] [--propagate[=rlimits] [--comment=name]\n"
 "            [--cpu_bind=...] [--mem_bind=...] [--network=type]\n"
 "            [--ntasks-per-node=n] [--ntasks-per-socket=n] [reservation=name]\n"
@@ -2490,6 +2505,7 @@ static void _help(void)
 "  -H, --hold                  submit job in held state\n"
 "  -i, --input=in              location of stdin redirection\n"
 "  -I, --immediate[=secs]      exit if resources not available in \"secs\"\n"
+"      --io-tree               relay stdio through a tree of the step's nodes\n"
 "      --jobid=id              run under already allocated job\n"
 "  -J, --job-name=jobname      name of job\n"
 "  -k, --no-kill               do not kill job on node failure\n"
@@ -2497,6 +2513,7 @@ static void _help(void)
 "                              non-zero exit code\n"
 "  -l, --label                 prepend task number to lines of stdout/err\n"
 "  -L, --licenses=names        required license, comma separated\n"
+"      --large-io              move stdout/err in messages of up to 64KB\n"
 "      --launch-cmd            print external launcher command line if not SLURM\n"
 "      --launcher-opts=        options for the external launcher command if not\n"
 "                              SLURM\n"
@@ -161,6 +161,8 @@ typedef struct srun_options {
 	char *hostfile;         /* location of hostfile if there is one */
 	bool labelio;		/* --label-output, -l		*/
 	bool unbuffered;        /* --unbuffered,   -u           */
+	bool io_tree;		/* --io-tree			*/
+	bool large_io;		/* --large-io			*/
 	bool allocate;		/* --allocate, 	   -A		*/
 	bool noshell;		/* --no-shell                   */
 	bool overcommit;	/* --overcommit,   -O		*/
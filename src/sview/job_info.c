@@ -66,6 +66,7 @@ typedef struct {
 
 static List foreach_list = NULL;
 static char *stacked_job_list = NULL;
+static bool delta_unavailable = false;	/* controller can't send changes */
 
 typedef struct {
 	int job_id;
@@ -3052,6 +3053,28 @@ extern void refresh_job(GtkAction *action, gpointer user_data)
 	specific_info_job(popup_win);
 }
 
+/* Load all jobs, only those changed since old_job_ptr was loaded if the
+ * controller supports it. On success the records of old_job_ptr may be
+ * moved to new_job_ptr, but it must still be freed. */
+static int _load_jobs(job_info_msg_t *old_job_ptr,
+		      job_info_msg_t **new_job_ptr, uint16_t show_flags)
+{
+	int error_code;
+
+	if (!delta_unavailable) {
+		error_code = slurm_load_jobs_delta(old_job_ptr, new_job_ptr,
+						   show_flags);
+		if ((error_code == SLURM_SUCCESS) ||
+		    (slurm_get_errno() == SLURM_NO_CHANGE_IN_DATA))
+			return error_code;
+		/* Likely an older slurmctld, use slurm_load_jobs() */
+		delta_unavailable = true;
+	}
+
+	return slurm_load_jobs(old_job_ptr ? old_job_ptr->last_update : 0,
+			       new_job_ptr, show_flags);
+}
+
 extern int get_new_info_job(job_info_msg_t **info_ptr,
 			    int force)
 {
@@ -3077,10 +3100,10 @@ extern int get_new_info_job(job_info_msg_t **info_ptr,
 	if (working_sview_config.show_hidden)
 		show_flags |= SHOW_ALL;
 	if (g_job_info_ptr) {
-		if (show_flags != last_flags)
-			g_job_info_ptr->last_update = 0;
-		error_code = slurm_load_jobs(g_job_info_ptr->last_update,
-					     &new_job_ptr, show_flags);
+		/* Reload everything if the flags changed */
+		error_code = _load_jobs((show_flags != last_flags) ?
+					NULL : g_job_info_ptr,
+					&new_job_ptr, show_flags);
 		if (error_code == SLURM_SUCCESS) {
 			slurm_free_job_info_msg(g_job_info_ptr);
 			changed = 1;
@@ -3091,8 +3114,7 @@ extern int get_new_info_job(job_info_msg_t **info_ptr,
 		}
 	} else {
 		new_job_ptr = NULL;
-		error_code = slurm_load_jobs((time_t) NULL, &new_job_ptr,
-					     show_flags);
+		error_code = _load_jobs(NULL, &new_job_ptr, show_flags);
 		changed = 1;
 	}
 
@@ -188,6 +188,7 @@ static display_data_t options_data_node[] = {
 };
 
 static display_data_t *local_display_data = NULL;
+static bool delta_unavailable = false;	/* controller can't send changes */
 
 static void _layout_node_record(GtkTreeView *treeview,
 				sview_node_info_t *sview_node_info_ptr,
@@ -855,6 +856,28 @@ update_color:
 	return info_list;
 }
 
+/* Load all nodes, only those changed since old_node_ptr was loaded if the
+ * controller supports it. On success the records of old_node_ptr may be
+ * moved to new_node_ptr, but it must still be freed. */
+static int _load_nodes(node_info_msg_t *old_node_ptr,
+		       node_info_msg_t **new_node_ptr, uint16_t show_flags)
+{
+	int error_code;
+
+	if (!delta_unavailable) {
+		error_code = slurm_load_node_delta(old_node_ptr, new_node_ptr,
+						   show_flags);
+		if ((error_code == SLURM_SUCCESS) ||
+		    (slurm_get_errno() == SLURM_NO_CHANGE_IN_DATA))
+			return error_code;
+		/* Likely an older slurmctld, use slurm_load_node() */
+		delta_unavailable = true;
+	}
+
+	return slurm_load_node(old_node_ptr ? old_node_ptr->last_update : 0,
+			       new_node_ptr, show_flags);
+}
+
 extern int get_new_info_node(node_info_msg_t **info_ptr, int force)
 {
 	node_info_msg_t *new_node_ptr = NULL;
@@ -888,10 +911,10 @@ extern int get_new_info_node(node_info_msg_t **info_ptr, int force)
 	//if (working_sview_config.show_hidden)
 	show_flags |= SHOW_ALL;
 	if (g_node_info_ptr) {
-		if (show_flags != last_flags)
-			g_node_info_ptr->last_update = 0;
-		error_code = slurm_load_node(g_node_info_ptr->last_update,
-					     &new_node_ptr, show_flags);
+		/* Reload everything if the flags changed */
+		error_code = _load_nodes((show_flags != last_flags) ?
+					 NULL : g_node_info_ptr,
+					 &new_node_ptr, show_flags);
 		if (error_code == SLURM_SUCCESS) {
 			slurm_free_node_info_msg(g_node_info_ptr);
 			changed = 1;
@@ -902,8 +925,7 @@ extern int get_new_info_node(node_info_msg_t **info_ptr, int force)
 		}
 	} else {
 		new_node_ptr = NULL;
-		error_code = slurm_load_node((time_t) NULL, &new_node_ptr,
-					     show_flags);
+		error_code = _load_nodes(NULL, &new_node_ptr, show_flags);
 		changed = 1;
 	}
 
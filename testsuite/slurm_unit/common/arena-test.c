@@ -0,0 +1,166 @@
+/* Test of the xmalloc arena and unpacking into it
+ */
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/pack.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include <testsuite/dejagnu.h>
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define ARRAY_SIZE 8
+#define ENV_SIZE 8
+
+typedef struct msg {
+	char **env;
+	uint32_t envc;
+	char *str;
+	uint32_t *gtids;
+	uint32_t gtid_cnt;
+	uint16_t *tasks;
+	uint32_t task_cnt;
+} msg_t;
+
+static void _pack_msg(msg_t *msg, Buf buffer)
+{
+	packstr_array(msg->env, msg->envc, buffer);
+	packstr(msg->str, buffer);
+	pack32_array(msg->gtids, msg->gtid_cnt, buffer);
+	pack16_array(msg->tasks, msg->task_cnt, buffer);
+}
+
+static int _unpack_msg(msg_t *msg, Buf buffer)
+{
+	uint32_t uint32_tmp;
+
+	memset(msg, 0, sizeof(msg_t));
+	set_buf_offset(buffer, 0);
+	if (unpackstr_array(&msg->env, &msg->envc, buffer) ||
+	    unpackstr_xmalloc(&msg->str, &uint32_tmp, buffer) ||
+	    unpack32_array(&msg->gtids, &msg->gtid_cnt, buffer) ||
+	    unpack16_array(&msg->tasks, &msg->task_cnt, buffer))
+		return 1;
+	return 0;
+}
+
+/* Free the way slurm_free_*_msg() functions do, one piece at a time */
+static void _free_msg(msg_t *msg)
+{
+	int i;
+
+	for (i = 0; i < msg->envc; i++)
+		xfree(msg->env[i]);
+	xfree(msg->env);
+	xfree(msg->str);
+	xfree(msg->gtids);
+	xfree(msg->tasks);
+}
+
+static bool _same_msg(msg_t *a, msg_t *b)
+{
+	int i;
+
+	if ((a->envc != b->envc) || (a->gtid_cnt != b->gtid_cnt) ||
+	    (a->task_cnt != b->task_cnt))
+		return false;
+	for (i = 0; i < a->envc; i++) {
+		if (strcmp(a->env[i], b->env[i]))
+			return false;
+	}
+	if (b->env[b->envc] != NULL)
+		return false;
+	if (strcmp(a->str, b->str) ||
+	    memcmp(a->gtids, b->gtids, a->gtid_cnt * sizeof(uint32_t)) ||
+	    memcmp(a->tasks, b->tasks, a->task_cnt * sizeof(uint16_t)))
+		return false;
+	return true;
+}
+
+int
+main(int argc, char *argv[])
+{
+	note("Testing arena memory");
+	{
+		xarena_t *arena = xarena_create();
+		char *str, *big, *heap = NULL;
+
+		str = xarena_alloc(arena, 6);
+		TEST(xsize(str) == 6, "xsize of arena memory");
+		TEST((((uintptr_t) str) % 8) == 0, "arena memory aligned");
+		strcpy(str, "hello");
+		xstrcat(str, " world");		/* moves it to the heap */
+		TEST(!strcmp(str, "hello world"), "xstrcat of arena string");
+		xfree(str);
+
+		big = xarena_alloc(arena, 1024 * 1024);
+		TEST(big[1024 * 1024 - 1] == '\0', "large arena block zeroed");
+		xfree(big);
+		TEST(big == NULL, "xfree clears arena pointer");
+
+		xrealloc(heap, 16);
+		TEST(xsize(heap) == 16, "xrealloc after xfree");
+		xfree(heap);
+
+		TEST(xarena_count(arena) == 2, "arena allocation count");
+		xarena_destroy(arena);
+	}
+	note("Testing unpack into arena");
+	{
+		xarena_t *arena;
+		Buf buffer = init_buf(BUF_SIZE);
+		msg_t msg, heap_msg, arena_msg;
+		int i;
+
+		memset(&msg, 0, sizeof(msg_t));
+		msg.envc = ENV_SIZE;
+		msg.env = xmalloc(sizeof(char *) * (msg.envc + 1));
+		for (i = 0; i < msg.envc; i++)
+			msg.env[i] = xstrdup_printf("SLURM_TEST_%d=%d", i, i);
+		msg.str = xstrdup("/home/user/job/dir");
+		msg.gtid_cnt = ARRAY_SIZE;
+		msg.gtids = xmalloc(sizeof(uint32_t) * ARRAY_SIZE);
+		msg.task_cnt = ARRAY_SIZE;
+		msg.tasks = xmalloc(sizeof(uint16_t) * ARRAY_SIZE);
+		for (i = 0; i < ARRAY_SIZE; i++) {
+			msg.gtids[i] = i * 7;
+			msg.tasks[i] = i % 4;
+		}
+		_pack_msg(&msg, buffer);
+
+		TEST(_unpack_msg(&heap_msg, buffer) == 0, "unpack to heap");
+		TEST(_same_msg(&msg, &heap_msg), "heap data matches");
+		_free_msg(&heap_msg);
+
+		arena = xarena_create();
+		buffer->arena = arena;
+		TEST(_unpack_msg(&arena_msg, buffer) == 0, "unpack to arena");
+		TEST(_same_msg(&msg, &arena_msg), "arena data matches");
+		/* env array and strings, str, gtids and tasks */
+		TEST(xarena_count(arena) == ENV_SIZE + 4,
+		     "unpacked data allocated from arena");
+		_free_msg(&arena_msg);
+		TEST(arena_msg.env == NULL, "xfree clears unpacked pointer");
+		xarena_destroy(arena);
+		buffer->arena = NULL;
+
+		free_buf(buffer);
+		_free_msg(&msg);
+	}
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,223 @@
+/* Test of src/common/eio.c backends
+ */
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "src/common/eio.h"
+#include "src/common/fd.h"
+#include "src/common/xmalloc.h"
+#include <testsuite/dejagnu.h>
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define IDLE_PIPES	16
+#define ROUND_TRIPS	100
+
+typedef struct pingpong {
+	int rounds;		/* round trips completed */
+	int idle_reads;		/* reads from pipes never written */
+	bool token[2];		/* token waiting to be written to pipe i */
+	bool done;
+} pingpong_t;
+
+typedef struct pipe_end {
+	pingpong_t *pp;
+	int pipe;		/* 0 or 1 for the token pipes, -1 if idle */
+} pipe_end_t;
+
+typedef struct sink {
+	int bytes;		/* bytes read */
+	bool eof;
+} sink_t;
+
+static bool _pp_readable(eio_obj_t *obj)
+{
+	pipe_end_t *end = (pipe_end_t *) obj->arg;
+	return !end->pp->done;
+}
+
+/* Read until EAGAIN, so this works with edge triggered epoll too */
+static int _pp_read(eio_obj_t *obj, List objs)
+{
+	pipe_end_t *end = (pipe_end_t *) obj->arg;
+	pingpong_t *pp = end->pp;
+	char buf[64];
+	int n;
+
+	while ((n = read(obj->fd, buf, sizeof(buf))) > 0) {
+		if (end->pipe == 0) {
+			pp->token[1] = true;
+		} else if (end->pipe == 1) {
+			if (++pp->rounds >= ROUND_TRIPS)
+				pp->done = true;
+			else
+				pp->token[0] = true;
+		} else
+			pp->idle_reads++;
+	}
+	if ((n == 0) || ((errno != EAGAIN) && (errno != EINTR)))
+		pp->done = true;
+	return 0;
+}
+
+static bool _pp_writable(eio_obj_t *obj)
+{
+	pipe_end_t *end = (pipe_end_t *) obj->arg;
+	return (!end->pp->done && end->pp->token[end->pipe]);
+}
+
+static int _pp_write(eio_obj_t *obj, List objs)
+{
+	pipe_end_t *end = (pipe_end_t *) obj->arg;
+	char c = 't';
+
+	if (write(obj->fd, &c, 1) == 1)
+		end->pp->token[end->pipe] = false;
+	return 0;
+}
+
+static struct io_operations pp_reader_ops = {
+	.readable = &_pp_readable,
+	.handle_read = &_pp_read,
+};
+
+static struct io_operations pp_writer_ops = {
+	.writable = &_pp_writable,
+	.handle_write = &_pp_write,
+};
+
+static bool _sink_readable(eio_obj_t *obj)
+{
+	sink_t *sink = (sink_t *) obj->arg;
+	return !sink->eof;
+}
+
+static int _sink_read(eio_obj_t *obj, List objs)
+{
+	sink_t *sink = (sink_t *) obj->arg;
+	char buf[64];
+	int n;
+
+	while ((n = read(obj->fd, buf, sizeof(buf))) > 0)
+		sink->bytes += n;
+	if ((n == 0) || ((errno != EAGAIN) && (errno != EINTR)))
+		sink->eof = true;
+	return 0;
+}
+
+static struct io_operations sink_ops = {
+	.readable = &_sink_readable,
+	.handle_read = &_sink_read,
+};
+
+/* Pass a token back and forth between two pipes while idle pipes are
+ * also registered with the handle */
+static void _test_pingpong(uint16_t flags)
+{
+	eio_handle_t *eio;
+	pingpong_t pp = { 0, 0, { true, false }, false };
+	pipe_end_t ends[IDLE_PIPES + 2];
+	int fds[IDLE_PIPES + 2][2];
+	int i;
+
+	eio = eio_handle_create_flags(flags);
+	for (i = 0; i < IDLE_PIPES + 2; i++) {
+		if (pipe(fds[i]) < 0) {
+			perror("pipe");
+			exit(1);
+		}
+		fd_set_nonblocking(fds[i][0]);
+		fd_set_nonblocking(fds[i][1]);
+		ends[i].pp = &pp;
+		ends[i].pipe = (i < 2) ? i : -1;
+		eio_new_initial_obj(eio, eio_obj_create(fds[i][0],
+							&pp_reader_ops,
+							&ends[i]));
+		if (i < 2) {
+			eio_new_initial_obj(eio,
+					    eio_obj_create(fds[i][1],
+							   &pp_writer_ops,
+							   &ends[i]));
+		}
+	}
+
+	TEST(eio_handle_mainloop(eio) == 0, "mainloop returns 0");
+	TEST(pp.rounds == ROUND_TRIPS, "token passed every round trip");
+	TEST(pp.idle_reads == 0, "idle pipes not read");
+
+	eio_handle_destroy(eio);
+	for (i = 0; i < IDLE_PIPES + 2; i++) {
+		close(fds[i][0]);
+		close(fds[i][1]);
+	}
+}
+
+/* Read a closed pipe and a regular file (which epoll can not watch) to
+ * end of file */
+static void _test_eof(uint16_t flags)
+{
+	eio_handle_t *eio;
+	sink_t pipe_sink = { 0, false }, file_sink = { 0, false };
+	char tmpl[] = "/tmp/eio-test.XXXXXX";
+	int fds[2], file_fd;
+
+	if ((pipe(fds) < 0) || ((file_fd = mkstemp(tmpl)) < 0)) {
+		perror("pipe/mkstemp");
+		exit(1);
+	}
+	unlink(tmpl);
+	if ((write(fds[1], "abc", 3) != 3) ||
+	    (write(file_fd, "abcdef", 6) != 6) ||
+	    (lseek(file_fd, 0, SEEK_SET) != 0)) {
+		perror("write");
+		exit(1);
+	}
+	close(fds[1]);
+	fd_set_nonblocking(fds[0]);
+
+	eio = eio_handle_create_flags(flags);
+	eio_new_initial_obj(eio, eio_obj_create(fds[0], &sink_ops,
+						&pipe_sink));
+	eio_new_initial_obj(eio, eio_obj_create(file_fd, &sink_ops,
+						&file_sink));
+
+	TEST(eio_handle_mainloop(eio) == 0, "mainloop returns 0");
+	TEST(pipe_sink.eof && (pipe_sink.bytes == 3), "pipe read to eof");
+	TEST(file_sink.eof && (file_sink.bytes == 6), "file read to eof");
+
+	eio_handle_destroy(eio);
+	close(fds[0]);
+	close(file_fd);
+}
+
+int
+main(int argc, char *argv[])
+{
+	note("Testing poll backend");
+	_test_pingpong(EIO_FLAG_POLL);
+	_test_eof(EIO_FLAG_POLL);
+#ifdef HAVE_SYS_EPOLL_H
+	note("Testing epoll backend");
+	_test_pingpong(0);
+	_test_eof(0);
+	note("Testing edge triggered epoll backend");
+	_test_pingpong(EIO_FLAG_EDGE);
+	_test_eof(EIO_FLAG_EDGE);
+#endif
+
+	totals();
+	return failed;
+}
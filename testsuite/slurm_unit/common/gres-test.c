@@ -0,0 +1,243 @@
+/* Test of GRES job tests in src/common/gres.c
+ */
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/bitstring.h"
+#include "src/common/gres.h"
+#include "src/common/list.h"
+#include "src/common/xmalloc.h"
+#include <testsuite/dejagnu.h>
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define CPU_CNT		16	/* CPUs per node, 8 per socket */
+#define CPU_START	16	/* node's first bit in the cpu_bitmap */
+
+extern uint32_t _job_test(void *job_gres_data, void *node_gres_data,
+			  bool use_total_gres, bitstr_t *cpu_bitmap,
+			  int cpu_start_bit, int cpu_end_bit, bool *topo_set,
+			  uint32_t job_id, char *node_name, char *gres_name);
+
+/* As in gres.c, the element of job and node gres_list */
+typedef struct gres_state {
+	uint32_t	plugin_id;
+	void		*gres_data;
+} gres_state_t;
+
+/* Four GRES, two on each socket, the first one allocated */
+static void _build_node(gres_node_state_t *node)
+{
+	int i;
+
+	memset(node, 0, sizeof(gres_node_state_t));
+	node->topo_cnt = 4;
+	node->topo_cpus_bitmap = xmalloc(sizeof(bitstr_t *) * 4);
+	node->topo_gres_cnt_avail = xmalloc(sizeof(uint32_t) * 4);
+	node->topo_gres_cnt_alloc = xmalloc(sizeof(uint32_t) * 4);
+	for (i = 0; i < 4; i++) {
+		node->topo_cpus_bitmap[i] = bit_alloc(CPU_CNT);
+		if (i < 2)
+			bit_nset(node->topo_cpus_bitmap[i], 0, 7);
+		else
+			bit_nset(node->topo_cpus_bitmap[i], 8, 15);
+		node->topo_gres_cnt_avail[i] = 1;
+	}
+	node->topo_gres_cnt_alloc[0] = 1;
+	node->gres_cnt_avail = 4;
+	node->gres_cnt_alloc = 1;
+}
+
+static void _free_node(gres_node_state_t *node)
+{
+	int i;
+
+	for (i = 0; i < node->topo_cnt; i++)
+		FREE_NULL_BITMAP(node->topo_cpus_bitmap[i]);
+	xfree(node->topo_cpus_bitmap);
+	xfree(node->topo_gres_cnt_avail);
+	xfree(node->topo_gres_cnt_alloc);
+}
+
+/* Run _job_test() for a job wanting "cnt" GRES with the node's CPUs in
+ * "cpus" (a bitmap string like "0-7") available. The cpu_bitmap covers
+ * other nodes' CPUs too, all available. */
+static uint32_t _test(gres_node_state_t *node, uint32_t cnt, bool use_total,
+		      char *cpus, bool *topo_set, bitstr_t **cpu_bitmap)
+{
+	gres_job_state_t job;
+	bitstr_t *node_cpus = bit_alloc(CPU_CNT);
+	int i;
+
+	memset(&job, 0, sizeof(gres_job_state_t));
+	job.gres_cnt_alloc = cnt;
+	bit_unfmt(node_cpus, cpus);
+	*cpu_bitmap = bit_alloc(CPU_START + CPU_CNT * 2);
+	bit_nset(*cpu_bitmap, 0, bit_size(*cpu_bitmap) - 1);
+	for (i = 0; i < CPU_CNT; i++) {
+		if (!bit_test(node_cpus, i))
+			bit_clear(*cpu_bitmap, CPU_START + i);
+	}
+	FREE_NULL_BITMAP(node_cpus);
+	return _job_test(&job, node, use_total, *cpu_bitmap, CPU_START,
+			 CPU_START + CPU_CNT - 1, topo_set, 1, "tux", "gpu");
+}
+
+/* Return true if the node's CPUs left in cpu_bitmap are "cpus" and the
+ * other nodes' CPUs are untouched */
+static bool _cpus_are(bitstr_t *cpu_bitmap, char *cpus)
+{
+	bitstr_t *expect = bit_alloc(bit_size(cpu_bitmap));
+	bitstr_t *node_cpus = bit_alloc(CPU_CNT);
+	bool match;
+	int i;
+
+	bit_nset(expect, 0, bit_size(expect) - 1);
+	bit_nclear(expect, CPU_START, CPU_START + CPU_CNT - 1);
+	bit_unfmt(node_cpus, cpus);
+	for (i = 0; i < CPU_CNT; i++) {
+		if (bit_test(node_cpus, i))
+			bit_set(expect, CPU_START + i);
+	}
+	match = bit_equal(expect, cpu_bitmap);
+	FREE_NULL_BITMAP(expect);
+	FREE_NULL_BITMAP(node_cpus);
+	return match;
+}
+
+/* Run gres_plugin_job_count_test() for one job and node GRES */
+static bool _count_test(uint32_t job_cnt, uint32_t node_plugin_id,
+			bool use_total)
+{
+	gres_node_state_t node;
+	gres_job_state_t job;
+	gres_state_t job_state, node_state;
+	List job_list, node_list;
+	bool rc;
+
+	_build_node(&node);
+	memset(&job, 0, sizeof(gres_job_state_t));
+	job.gres_cnt_alloc = job_cnt;
+	job_state.plugin_id = 1;
+	job_state.gres_data = &job;
+	node_state.plugin_id = node_plugin_id;
+	node_state.gres_data = &node;
+	job_list = list_create(NULL);
+	node_list = list_create(NULL);
+	list_append(job_list, &job_state);
+	list_append(node_list, &node_state);
+	rc = gres_plugin_job_count_test(job_list, node_list, use_total);
+	list_destroy(job_list);
+	list_destroy(node_list);
+	_free_node(&node);
+	return rc;
+}
+
+int
+main(int argc, char *argv[])
+{
+	gres_node_state_t node;
+	bitstr_t *cpu_bitmap;
+	bool topo;
+
+	note("Testing _job_test without topology");
+	{
+		gres_node_state_t plain;
+		gres_job_state_t job;
+
+		memset(&plain, 0, sizeof(gres_node_state_t));
+		plain.gres_cnt_avail = 4;
+		plain.gres_cnt_alloc = 1;
+		memset(&job, 0, sizeof(gres_job_state_t));
+		topo = false;
+		job.gres_cnt_alloc = 3;
+		TEST(_job_test(&job, &plain, false, NULL, 0, 0, &topo, 1,
+			       "tux", "gpu") == NO_VAL, "free GRES fit");
+		job.gres_cnt_alloc = 4;
+		TEST(_job_test(&job, &plain, false, NULL, 0, 0, &topo, 1,
+			       "tux", "gpu") == 0,
+		     "allocated GRES do not fit");
+		TEST(_job_test(&job, &plain, true, NULL, 0, 0, &topo, 1,
+			       "tux", "gpu") == NO_VAL, "total GRES fit");
+	}
+	note("Testing _job_test picking CPUs by topology");
+	{
+		_build_node(&node);
+
+		topo = false;
+		TEST(_test(&node, 1, false, "0-15", &topo, &cpu_bitmap) == 8,
+		     "one GRES uses one socket");
+		TEST(topo, "topology set");
+		TEST(_cpus_are(cpu_bitmap, "0-7"),
+		     "first free GRES socket kept");
+		FREE_NULL_BITMAP(cpu_bitmap);
+
+		topo = false;
+		TEST(_test(&node, 2, false, "0-15", &topo, &cpu_bitmap) == 16,
+		     "second GRES on the other socket");
+		TEST(_cpus_are(cpu_bitmap, "0-15"), "both sockets kept");
+		FREE_NULL_BITMAP(cpu_bitmap);
+
+		topo = false;
+		TEST(_test(&node, 1, false, "2-6,12", &topo, &cpu_bitmap) == 5,
+		     "GRES with most available CPUs used");
+		TEST(_cpus_are(cpu_bitmap, "2-6"),
+		     "only that GRES's available CPUs kept");
+		FREE_NULL_BITMAP(cpu_bitmap);
+
+		topo = false;
+		TEST(_test(&node, 2, false, "0-7", &topo, &cpu_bitmap) == 0,
+		     "GRES without available CPUs not used");
+		TEST(!topo, "topology not set");
+		FREE_NULL_BITMAP(cpu_bitmap);
+
+		topo = false;
+		TEST(_test(&node, 3, true, "0-15", &topo, &cpu_bitmap) == 16,
+		     "allocated GRES used with total");
+		FREE_NULL_BITMAP(cpu_bitmap);
+	}
+	note("Testing _job_test with topology set");
+	{
+		topo = true;
+		TEST(_test(&node, 2, false, "8-15", &topo, &cpu_bitmap) ==
+		     NO_VAL, "GRES on available CPUs fit");
+		FREE_NULL_BITMAP(cpu_bitmap);
+
+		topo = true;
+		TEST(_test(&node, 2, false, "0-7", &topo, &cpu_bitmap) == 0,
+		     "GRES on allocated CPUs do not fit");
+		FREE_NULL_BITMAP(cpu_bitmap);
+
+		topo = true;
+		TEST(_test(&node, 2, true, "3", &topo, &cpu_bitmap) == NO_VAL,
+		     "one CPU reaches a socket's GRES");
+		FREE_NULL_BITMAP(cpu_bitmap);
+
+		_free_node(&node);
+	}
+	note("Testing gres_plugin_job_count_test");
+	{
+		TEST(_count_test(3, 1, false), "free GRES count fits");
+		TEST(!_count_test(4, 1, false), "allocated GRES count fails");
+		TEST(_count_test(4, 1, true), "total GRES count fits");
+		TEST(!_count_test(1, 2, false), "missing GRES fails");
+		TEST(_count_test(0, 2, false), "no GRES wanted fits");
+		TEST(gres_plugin_job_count_test(NULL, NULL, false),
+		     "no job GRES list fits");
+	}
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,156 @@
+/* Test of node name range conversions in src/common/node_conf.c
+ */
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/bitstring.h"
+#include "src/common/log.h"
+#include "src/common/node_conf.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include <testsuite/dejagnu.h>
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+extern struct node_record **node_hash_table;	/* in node_conf.c */
+
+static const char *mixed_names[] = {
+	"tux8", "tux9", "tux10", "tux11", "tux04", "tux05", "tux06",
+	"login", "gpu007", "gpu008", "gpu009", "gpu010", "gpu1000",
+	"a3", "a2", "a1", "b", "c0", "c1", "c2", "c001", "c002", "42",
+	"43", NULL };
+
+static void _build_table(int node_cnt, const char **names)
+{
+	int i;
+
+	node_record_table_ptr = xmalloc(sizeof(struct node_record) *
+					node_cnt);
+	for (i = 0; i < node_cnt; i++) {
+		if (names)
+			node_record_table_ptr[i].name = xstrdup(names[i]);
+		else
+			node_record_table_ptr[i].name =
+				xstrdup_printf("tux%d", i);
+		node_record_table_ptr[i].magic = NODE_MAGIC;
+	}
+	node_record_count = node_cnt;
+	rehash_node();
+}
+
+static void _free_table(void)
+{
+	int i;
+
+	for (i = 0; i < node_record_count; i++)
+		xfree(node_record_table_ptr[i].name);
+	xfree(node_record_table_ptr);
+	xfree(node_hash_table);
+	node_record_count = 0;
+	rehash_node();
+}
+
+/* Return true if node_names converts to exactly the nodes in "inx" (a
+ * bitmap string like "1,3-5") with return code "rc" */
+static bool _names_are(char *node_names, char *inx, int rc)
+{
+	bitstr_t *bitmap, *expect = bit_alloc(node_record_count);
+	bool match;
+
+	if (inx[0])
+		bit_unfmt(expect, inx);
+	match = (node_name2bitmap(node_names, false, &bitmap) == rc) &&
+		bit_equal(bitmap, expect);
+	FREE_NULL_BITMAP(bitmap);
+	FREE_NULL_BITMAP(expect);
+	return match;
+}
+
+/* Return true if the nodes in "inx" convert to node_names */
+static bool _bitmap_is(char *inx, bool sort, char *node_names)
+{
+	bitstr_t *bitmap = bit_alloc(node_record_count);
+	char *str;
+	bool match;
+
+	if (inx[0])
+		bit_unfmt(bitmap, inx);
+	str = bitmap2node_name_sortable(bitmap, sort);
+	match = !strcmp(str, node_names);
+	xfree(str);
+	FREE_NULL_BITMAP(bitmap);
+	return match;
+}
+
+int
+main(int argc, char *argv[])
+{
+	log_options_t opts = LOG_OPTS_STDERR_ONLY;
+	int node_cnt;
+
+	/* names which are not nodes are expected, don't log each one */
+	opts.stderr_level = LOG_LEVEL_QUIET;
+	log_init(argv[0], opts, 0, NULL);
+
+	note("Testing uniformly named nodes");
+	{
+		_build_table(100, NULL);
+		TEST(_bitmap_is("", true, ""), "empty bitmap to names");
+		TEST(_bitmap_is("0-99", true, "tux[0-99]"),
+		     "full bitmap to names");
+		TEST(_bitmap_is("0-9,20,22,50-99", true,
+				"tux[0-9,20,22,50-99]"), "bitmap to names");
+		TEST(_names_are("tux[0-9,20,22,50-99]", "0-9,20,22,50-99", 0),
+		     "names to bitmap");
+		TEST(_names_are("tux[90-110]", "90-99", EINVAL),
+		     "names past the table");
+		TEST(_names_are("tux[01-03]", "", EINVAL),
+		     "zero padded names are not nodes");
+		_free_table();
+	}
+	note("Testing mixed node names");
+	{
+		for (node_cnt = 0; mixed_names[node_cnt]; node_cnt++)
+			;
+		_build_table(node_cnt, mixed_names);
+		TEST(_bitmap_is("0-6", true, "tux[8-11,04-06]"),
+		     "sorted padded and unpadded names");
+		TEST(_bitmap_is("13-15", true, "a[1-3]"),
+		     "sorted out of order names");
+		TEST(_bitmap_is("13-15", false, "a[3,2,1]"),
+		     "unsorted names in table order");
+		TEST(_bitmap_is("7,16,22-23", true, "[42-43],b,login"),
+		     "sorted unnumbered names");
+		TEST(_names_are("tux[04-06]", "4-6", 0), "padded range");
+		TEST(_names_are("tux[8-11]", "0-3", 0), "unpadded range");
+		TEST(_names_are("tux[4-6]", "", EINVAL),
+		     "unpadded range of padded names");
+		TEST(_names_are("gpu[007-010,1000]", "8-12", 0),
+		     "range wider than padding");
+		TEST(_names_are("gpu[7-10]", "", EINVAL),
+		     "range narrower than padding");
+		TEST(_names_are("c[0-2],c[001-002]", "17-21", 0),
+		     "same prefix with two paddings");
+		TEST(_names_are("[42-43],a[1-3],b,login", "7,13-16,22-23", 0),
+		     "unnumbered and out of order names");
+		TEST(_names_are("c[00-02]", "", EINVAL),
+		     "range matching neither padding");
+		_free_table();
+	}
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,161 @@
+/* Test of src/common/sha256.c with the FIPS 180-2 and RFC 4231 test vectors
+ */
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/macros.h"
+#include "src/common/sha256.h"
+#include <testsuite/dejagnu.h>
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+/* Return true if digest matches the hex string */
+static bool _digest_is(unsigned char *digest, char *hex)
+{
+	char buf[SHA256_DIGEST_LEN * 2 + 1];
+	int i;
+
+	for (i = 0; i < SHA256_DIGEST_LEN; i++)
+		sprintf(buf + (i * 2), "%02x", digest[i]);
+	return !strcmp(buf, hex);
+}
+
+/* Hash data, fed to sha256_update() "chunk" bytes at a time */
+static bool _sha256_is(const void *data, size_t len, size_t chunk, char *hex)
+{
+	sha256_ctx_t ctx;
+	unsigned char digest[SHA256_DIGEST_LEN];
+	size_t i;
+
+	sha256_init(&ctx);
+	for (i = 0; i < len; i += chunk)
+		sha256_update(&ctx, (char *) data + i, MIN(chunk, len - i));
+	sha256_final(&ctx, digest);
+	return _digest_is(digest, hex);
+}
+
+static bool _hmac_is(const void *key, size_t key_len, const void *data,
+		     size_t len, char *hex)
+{
+	hmac_sha256_ctx_t ctx;
+	unsigned char digest[SHA256_DIGEST_LEN];
+
+	hmac_sha256_init(&ctx, key, key_len);
+	hmac_sha256_update(&ctx, data, len);
+	hmac_sha256_final(&ctx, digest);
+	return _digest_is(digest, hex);
+}
+
+int
+main(int argc, char *argv[])
+{
+	note("Testing SHA-256 (FIPS 180-2)");
+	{
+		char *msg2 = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmno"
+			     "mnopnopq";
+		char *million = malloc(1000000);
+
+		TEST(_sha256_is("", 0, 1, "e3b0c44298fc1c149afbf4c8996fb924"
+				"27ae41e4649b934ca495991b7852b855"),
+		     "empty message");
+		TEST(_sha256_is("abc", 3, 3, "ba7816bf8f01cfea414140de5dae2223"
+				"b00361a396177a9cb410ff61f20015ad"),
+		     "one block message");
+		TEST(_sha256_is(msg2, strlen(msg2), strlen(msg2),
+				"248d6a61d20638b8e5c026930c3e6039"
+				"a33ce45964ff2167f6ecedd419db06c1"),
+		     "two block message");
+		TEST(_sha256_is(msg2, strlen(msg2), 1,
+				"248d6a61d20638b8e5c026930c3e6039"
+				"a33ce45964ff2167f6ecedd419db06c1"),
+		     "two block message a byte at a time");
+		memset(million, 'a', 1000000);
+		TEST(_sha256_is(million, 1000000, 1000000,
+				"cdc76e5c9914fb9281a1c7e284d73e67"
+				"f1809a48a497200e046d39ccc7112cd0"),
+		     "long message");
+		TEST(_sha256_is(million, 1000000, 71,
+				"cdc76e5c9914fb9281a1c7e284d73e67"
+				"f1809a48a497200e046d39ccc7112cd0"),
+		     "long message in uneven pieces");
+		free(million);
+	}
+	note("Testing HMAC-SHA256 (RFC 4231)");
+	{
+		unsigned char key[131], data[50];
+		char *msg;
+		int i;
+
+		memset(key, 0x0b, 20);
+		TEST(_hmac_is(key, 20, "Hi There", 8,
+			      "b0344c61d8db38535ca8afceaf0bf12b"
+			      "881dc200c9833da726e9376c2e32cff7"),
+		     "test case 1");
+		msg = "what do ya want for nothing?";
+		TEST(_hmac_is("Jefe", 4, msg, strlen(msg),
+			      "5bdcc146bf60754e6a042426089575c7"
+			      "5a003f089d2739839dec58b964ec3843"),
+		     "test case 2");
+		memset(key, 0xaa, 20);
+		memset(data, 0xdd, 50);
+		TEST(_hmac_is(key, 20, data, 50,
+			      "773ea91e36800e46854db8ebd09181a7"
+			      "2959098b3ef8c122d9635514ced565fe"),
+		     "test case 3");
+		for (i = 0; i < 25; i++)
+			key[i] = i + 1;
+		memset(data, 0xcd, 50);
+		TEST(_hmac_is(key, 25, data, 50,
+			      "82558a389a443c0ea4cc819899f2083a"
+			      "85f0faa3e578f8077a2e3ff46729665b"),
+		     "test case 4");
+		memset(key, 0xaa, 131);
+		msg = "Test Using Larger Than Block-Size Key - Hash Key First";
+		TEST(_hmac_is(key, 131, msg, strlen(msg),
+			      "60e431591ee0b67f0d8a26aacbf5b77f"
+			      "8e0bc6213728c5140546040f0ee37f54"),
+		     "test case 6");
+		msg = "This is a test using a larger than block-size key and "
+		      "a larger than block-size data. The key needs to be "
+		      "hashed before being used by the HMAC algorithm.";
+		TEST(_hmac_is(key, 131, msg, strlen(msg),
+			      "9b09ffa71b942fcb27635fbcd5b0e944"
+			      "bfdc63644f0713938a7f51535c3a35e2"),
+		     "test case 7");
+	}
+	note("Testing reuse of an HMAC-SHA256 context");
+	{
+		hmac_sha256_ctx_t keyed, ctx;
+		unsigned char digest[SHA256_DIGEST_LEN];
+
+		hmac_sha256_init(&keyed, "Jefe", 4);
+		memcpy(&ctx, &keyed, sizeof(ctx));
+		hmac_sha256_update(&ctx, "what do ya want ", 16);
+		hmac_sha256_update(&ctx, "for nothing?", 12);
+		hmac_sha256_final(&ctx, digest);
+		TEST(_digest_is(digest, "5bdcc146bf60754e6a042426089575c7"
+				"5a003f089d2739839dec58b964ec3843"),
+		     "first copy of keyed context");
+		memcpy(&ctx, &keyed, sizeof(ctx));
+		hmac_sha256_update(&ctx, "what do ya want for nothing?", 28);
+		hmac_sha256_final(&ctx, digest);
+		TEST(_digest_is(digest, "5bdcc146bf60754e6a042426089575c7"
+				"5a003f089d2739839dec58b964ec3843"),
+		     "second copy of keyed context");
+	}
+
+	totals();
+	return failed;
+}
@@ -0,0 +1,135 @@
+/* Test of build_node_switch_index() in src/common/slurm_topology.c
+ */
+#if HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/bitstring.h"
+#include "src/common/slurm_topology.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+#include <testsuite/dejagnu.h>
+
+/* Test for failure:
+*/
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define LEAF_CNT	4
+#define LEAF_SIZE	3
+#define NODE_CNT	(LEAF_CNT * LEAF_SIZE)
+
+static void _add_switch(int level, char *nodes)
+{
+	struct switch_record *switch_ptr;
+
+	xrealloc(switch_record_table,
+		 sizeof(struct switch_record) * (switch_record_cnt + 1));
+	switch_ptr = &switch_record_table[switch_record_cnt];
+	switch_ptr->name = xstrdup_printf("s%d", switch_record_cnt);
+	switch_ptr->level = level;
+	if (nodes) {
+		switch_ptr->node_bitmap = bit_alloc(NODE_CNT);
+		if (nodes[0])
+			bit_unfmt(switch_ptr->node_bitmap, nodes);
+	}
+	switch_record_cnt++;
+}
+
+/* Position of switch_inx among the switches of node inx, or -1 */
+static int _switch_pos(int inx, int switch_inx)
+{
+	int k;
+
+	for (k = node_switch_offset[inx]; k < node_switch_offset[inx+1]; k++) {
+		if (node_switch_inx[k] == switch_inx)
+			return k - node_switch_offset[inx];
+	}
+	return -1;
+}
+
+int
+main(int argc, char *argv[])
+{
+	/* s0-s3 leaves, s4-s5 second level, s6 root, then one switch
+	 * without a node bitmap and one with no nodes */
+	_add_switch(0, "0-2");
+	_add_switch(0, "3-5");
+	_add_switch(0, "6-8");
+	_add_switch(0, "9-11");
+	_add_switch(1, "0-5");
+	_add_switch(1, "6-11");
+	_add_switch(2, "0-11");
+	_add_switch(0, NULL);
+	_add_switch(0, "");
+
+	note("Testing build_node_switch_index");
+	{
+		bitstr_t *b;
+		bool match = true;
+		int i, j;
+
+		build_node_switch_index(NODE_CNT);
+		TEST(node_switch_offset[0] == 0, "first offset");
+		TEST(node_switch_offset[NODE_CNT] == NODE_CNT * 3,
+		     "three switches per node");
+		TEST((node_switch_offset[5] - node_switch_offset[4] == 3) &&
+		     (_switch_pos(4, 1) == 0) && (_switch_pos(4, 4) == 1) &&
+		     (_switch_pos(4, 6) == 2), "node 4 switches in order");
+		for (i = 0; i < NODE_CNT; i++) {
+			for (j = 0; j < switch_record_cnt; j++) {
+				b = switch_record_table[j].node_bitmap;
+				if ((b && bit_test(b, i)) !=
+				    (_switch_pos(i, j) >= 0))
+					match = false;
+			}
+		}
+		TEST(match, "index matches switch bitmaps");
+	}
+	note("Testing counts from the index");
+	{
+		int switch_nodes[switch_record_cnt];
+		int i, k;
+
+		memset(switch_nodes, 0, sizeof(switch_nodes));
+		for (i = 0; i < NODE_CNT; i++) {
+			if ((i != 0) && (i != 1) && (i != 7))
+				continue;
+			for (k = node_switch_offset[i];
+			     k < node_switch_offset[i+1]; k++)
+				switch_nodes[node_switch_inx[k]]++;
+		}
+		TEST((switch_nodes[0] == 2) && (switch_nodes[1] == 0) &&
+		     (switch_nodes[2] == 1) && (switch_nodes[3] == 0),
+		     "leaf switch counts");
+		TEST((switch_nodes[4] == 2) && (switch_nodes[5] == 1),
+		     "second level switch counts");
+		TEST(switch_nodes[6] == 3, "root switch count");
+		TEST((switch_nodes[7] == 0) && (switch_nodes[8] == 0),
+		     "empty switch counts");
+	}
+	note("Testing free_node_switch_index");
+	{
+		int i;
+
+		free_node_switch_index();
+		TEST((node_switch_inx == NULL) && (node_switch_offset == NULL),
+		     "index freed");
+		for (i = 0; i < switch_record_cnt; i++) {
+			xfree(switch_record_table[i].name);
+			FREE_NULL_BITMAP(switch_record_table[i].node_bitmap);
+		}
+		xfree(switch_record_table);
+	}
+
+	totals();
+	return failed;
+}